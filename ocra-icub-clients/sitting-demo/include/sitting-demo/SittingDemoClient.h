@@ -2,6 +2,7 @@
 #define SITTINGDEMOCLIENT_H
 
 #include <ocra-icub/IcubClient.h>
+#include <ocra-icub/TaskStateBatch.h>
 #include <ocra-recipes/TrajectoryThread.h>
 #include <ocra-recipes/ControllerClient.h>
 
@@ -26,6 +27,8 @@ private:
     void moveCom();
     std::string taskName;
     ocra_recipes::TaskConnection::Ptr comTask;
+    ocra_icub::TaskStateBatch::shared_ptr comTaskStates;
+    int comTaskIndex;
     ocra_recipes::TrajectoryThread::Ptr comTrajThread;
     double xDisp, yDisp, zDisp;
     Eigen::Vector3d currentDesiredPosition;
@@ -35,6 +35,13 @@ bool SittingDemoClient::initialize()
     yarp::os::Time::delay(2.0);
     comTask = std::make_shared<ocra_recipes::TaskConnection>(taskName);
 
+    // The state and gains of the task are read in a single message
+    comTaskStates = std::make_shared<ocra_icub::TaskStateBatch>("/sitting-demo/taskStates");
+    if (!comTaskStates->initialize()) {
+        return false;
+    }
+    comTaskIndex = comTaskStates->addTask(taskName, ocra_icub::CURRENT_TASK_STATE | ocra_icub::TASK_GAINS);
+
     ocra_recipes::TRAJECTORY_TYPE trajType = ocra_recipes::MIN_JERK;
 
     currentDesiredPosition = comTask->getDesiredTaskState().getPosition().getTranslation();
@@ -58,9 +65,12 @@ void SittingDemoClient::loop()
 {
     yarp::os::Time::delay(2.0);
 
-    Eigen::Vector3d comPos = comTask->getTaskState().getPosition().getTranslation();
-    Kp = comTask->getStiffnessMatrix();
-    Kd = comTask->getDampingMatrix();
+    if (!comTaskStates->exchange()) {
+        return;
+    }
+    Eigen::Vector3d comPos = comTaskStates->getTaskState(comTaskIndex).getPosition().getTranslation();
+    Kp = comTaskStates->getStiffnessMatrix(comTaskIndex);
+    Kd = comTaskStates->getDampingMatrix(comTaskIndex);
     std::cout << "\n=============================================" << std::endl;
     std::cout << taskName << std::endl;
     std::cout << "=============================================" << std::endl;
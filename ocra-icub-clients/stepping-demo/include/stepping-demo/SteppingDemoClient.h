@@ -2,6 +2,7 @@
 #define STEPPING_DEMO_CLIENT_H
 
 #include <ocra-icub/IcubClient.h>
+#include <ocra-icub/FootContactManager.h>
 #include <ocra-recipes/TrajectoryThread.h>
 #include <ocra-recipes/ControllerClient.h>
 // #include <ocra/control/Model.h>
@@ -57,7 +58,7 @@ protected:
      1. Defines trajectory types (e.g. Min. Jerk)
      2. Defines the termination strategy
      3. Instantiates trajectory threads for the left and right foot as well as for the CoM, sets them up (max velocity, error threshold) and finally starts them.
-     4. Instantiates ocra::TaskConnection objects for the left and right feet contacts (4 per foot on each corner).
+     4. Connects to the task groups of the left and right feet contacts (4 per foot on each corner) through an ocra_icub::FootContactManager.
      
      - returns: True if everything has been initialized properly, false otherwise.
      */
@@ -78,15 +79,7 @@ private:
     void staticWalkingLoop();
     void leftToRightLoop();
     
-    ocra_recipes::TaskConnection::Ptr LeftFootContact_BackLeft;
-    ocra_recipes::TaskConnection::Ptr LeftFootContact_FrontLeft;
-    ocra_recipes::TaskConnection::Ptr LeftFootContact_BackRight;
-    ocra_recipes::TaskConnection::Ptr LeftFootContact_FrontRight;
-
-    ocra_recipes::TaskConnection::Ptr RightFootContact_BackLeft;
-    ocra_recipes::TaskConnection::Ptr RightFootContact_FrontLeft;
-    ocra_recipes::TaskConnection::Ptr RightFootContact_BackRight;
-    ocra_recipes::TaskConnection::Ptr RightFootContact_FrontRight;
+    ocra_icub::FootContactManager::shared_ptr footContacts;
 
     /**
      *  Retrieves the 3D position of the "l_sole" frame from the iCub model.
@@ -130,14 +123,14 @@ private:
     bool isBalanced();
     
     /**
-     *  Remember the right and left feet contact tasks? created in initialize(). This method acts the ocra-icub-server to deactivate one by one the feet "corner" contact tasks for the specified foot.
+     *  Asks the ocra-icub-server to deactivate the feet "corner" contact tasks of the specified foot, all of them on the same control tick.
      *
      *  @param foot LEFT_FOOT or RIGHT_FOOT.
      */
     void deactivateFootContacts(FOOT_CONTACTS foot);
     
     /**
-     *  This method asks the ocra-icub-server to activate one by one the feet "corner" contact tasks for the specified foot.
+     *  Asks the ocra-icub-server to activate the feet "corner" contact tasks of the specified foot, all of them on the same control tick.
      *
      *  @param foot LEFT_FOOT or RIGHT_FOOT.
      */
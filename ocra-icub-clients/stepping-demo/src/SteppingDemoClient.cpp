@@ -50,15 +50,8 @@ bool SteppingDemoClient::initialize()
     getInitialValues = true;
     startTime = yarp::os::Time::now();
 
-    LeftFootContact_BackLeft = std::make_shared<ocra_recipes::TaskConnection>("LeftFootContact_BackLeft");
-    LeftFootContact_FrontLeft = std::make_shared<ocra_recipes::TaskConnection>("LeftFootContact_FrontLeft");
-    LeftFootContact_BackRight = std::make_shared<ocra_recipes::TaskConnection>("LeftFootContact_BackRight");
-    LeftFootContact_FrontRight = std::make_shared<ocra_recipes::TaskConnection>("LeftFootContact_FrontRight");
-
-    RightFootContact_BackLeft = std::make_shared<ocra_recipes::TaskConnection>("RightFootContact_BackLeft");
-    RightFootContact_FrontLeft = std::make_shared<ocra_recipes::TaskConnection>("RightFootContact_FrontLeft");
-    RightFootContact_BackRight = std::make_shared<ocra_recipes::TaskConnection>("RightFootContact_BackRight");
-    RightFootContact_FrontRight = std::make_shared<ocra_recipes::TaskConnection>("RightFootContact_FrontRight");
+    footContacts = std::make_shared<ocra_icub::FootContactManager>("/stepping-demo/footContacts");
+    if (!footContacts->initialize()) return false;
 
 
     isInLeftSupportMode = true;
@@ -454,70 +447,12 @@ bool SteppingDemoClient::isBalanced()
 
 void SteppingDemoClient::deactivateFootContacts(FOOT_CONTACTS foot)
 {
-    switch (foot) {
-        case LEFT_FOOT:
-        {
-            bool res;
-            res = LeftFootContact_BackLeft->deactivate();
-            res &= LeftFootContact_FrontLeft->deactivate();
-            res &= LeftFootContact_BackRight->deactivate();
-            res &= LeftFootContact_FrontRight->deactivate();
-            if(res) {
-                std::cout << "Deactivated left foot contacts." << std::endl;
-            }
-        }break;
-
-        case RIGHT_FOOT:
-        {
-            bool res;
-            res = RightFootContact_BackLeft->deactivate();
-            res &= RightFootContact_FrontLeft->deactivate();
-            res &= RightFootContact_BackRight->deactivate();
-            res &= RightFootContact_FrontRight->deactivate();
-            if(res) {
-                std::cout << "Deactivated right foot contacts." << std::endl;
-            }
-        }break;
-
-        default:
-        break;
-    }
+    footContacts->deactivate(foot == LEFT_FOOT ? ocra_icub::LEFT_CONTACT_FOOT : ocra_icub::RIGHT_CONTACT_FOOT);
 }
 
 void SteppingDemoClient::activateFootContacts(FOOT_CONTACTS foot)
 {
-    switch (foot) {
-        case LEFT_FOOT:
-        {
-            bool res;
-            res = LeftFootContact_BackLeft->activate();
-            res &= LeftFootContact_FrontLeft->activate();
-            res &= LeftFootContact_BackRight->activate();
-            res &= LeftFootContact_FrontRight->activate();
-            if(res) {
-                std::cout << "Activated left foot contacts." << std::endl;
-            } else {
-                OCRA_ERROR("One or more contacts could not be activated");
-            }
-        }break;
-
-        case RIGHT_FOOT:
-        {
-            bool res;
-            res = RightFootContact_BackLeft->activate();
-            res &= RightFootContact_FrontLeft->activate();
-            res &= RightFootContact_BackRight->activate();
-            res &= RightFootContact_FrontRight->activate();
-            if(res) {
-                std::cout << "Activated right foot contacts." << std::endl;
-            } else {
-                OCRA_ERROR("One or more contacts could not be activated");
-            }
-        }break;
-
-        default:
-        break;
-    }
+    footContacts->activate(foot == LEFT_FOOT ? ocra_icub::LEFT_CONTACT_FOOT : ocra_icub::RIGHT_CONTACT_FOOT);
 }
 
 
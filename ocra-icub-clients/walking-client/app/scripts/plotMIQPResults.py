@@ -1,14 +1,15 @@
 import numpy as np
 import matplotlib.pyplot as plt
 import os
+import walkingLog
 
 plt.style.use('ggplot')
 
 home = "/home/jorhabib/Documents/octave/MIQP/"
-X_kn = np.loadtxt(home + "solutionInPreview.txt")
-P_kn = np.loadtxt(home + "CoPinPreview.txt")
-R_kn = np.loadtxt(home + "BoSinPreview.txt")
-H_kn = np.loadtxt(home + "CoMinPreview.txt")
+X_kn = walkingLog.load(home + "solutionInPreview.bin")[:,1:]
+P_kn = walkingLog.load(home + "CoPinPreview.bin")[:,1:]
+R_kn = walkingLog.load(home + "BoSinPreview.bin")[:,1:]
+H_kn = walkingLog.load(home + "CoMinPreview.bin")[:,1:]
 r_x = R_kn[:,0]
 r_y = R_kn[:,1]
 p_x = P_kn[:,0]
@@ -128,10 +129,10 @@ plt.show()
 
 answer = raw_input("Want to delete the data? [y/n] ")
 if answer == 'y':
-    os.remove(home + "solutionInPreview.txt")
-    os.remove(home + "CoPinPreview.txt")
-    os.remove(home + "BoSinPreview.txt")
-    os.remove(home + "CoMinPreview.txt")
+    os.remove(home + "solutionInPreview.bin")
+    os.remove(home + "CoPinPreview.bin")
+    os.remove(home + "BoSinPreview.bin")
+    os.remove(home + "CoMinPreview.bin")
 
 def functionname( plotTitle, values ):
    return;
@@ -1,19 +1,20 @@
 import numpy as np
 import matplotlib.pyplot as plt
 import os
+import walkingLog
 
 plt.style.use('ggplot')
 
 home = "/home/jorhabib/Documents/octave/zmpPreviewController/"
-# currentComLinAcc = np.loadtxt(home + "currentComLinAcc.txt")
-# refComLinAcc = np.loadtxt(home + "refComLinAcc.txt");
-intComPositionRef = np.loadtxt(home + "intComPositionRef.txt");
-currentComPos = np.loadtxt(home + "currentComPos.txt");
-currentZMP = np.loadtxt(home + "currentZMP.txt");
-referenceZMP = np.loadtxt(home + "referenceZMP.txt");
-previewedZMP = np.loadtxt(home + "previewedZMP.txt");
-optimalInput = np.loadtxt(home + "optimalInput.txt");
-# currentRightFootPosition = np.loadtxt(home + "currentRightFootPosition.txt");
+# currentComLinAcc = walkingLog.load(home + "currentComLinAcc.bin")
+# refComLinAcc = walkingLog.load(home + "refComLinAcc.bin");
+intComPositionRef = walkingLog.load(home + "intComPositionRef.bin");
+currentComPos = walkingLog.load(home + "currentComPos.bin");
+currentZMP = walkingLog.load(home + "currentZMP.bin");
+referenceZMP = walkingLog.load(home + "referenceZMP.bin");
+previewedZMP = walkingLog.load(home + "previewedZMP.bin");
+optimalInput = walkingLog.load(home + "optimalInput.bin");
+# currentRightFootPosition = walkingLog.load(home + "currentRightFootPosition.bin");
 
 time = currentComPos[:,0]
 
@@ -54,12 +55,12 @@ ax4.legend()
 # plt.tight_layout()
 plt.show()
 
-# os.remove(home + "currentComLinAcc.txt")
-# os.remove(home + "refComLinAcc.txt");
-os.remove(home + "intComPositionRef.txt");
-os.remove(home + "currentComPos.txt");
-os.remove(home + "currentZMP.txt");
-os.remove(home + "referenceZMP.txt");
-os.remove(home + "previewedZMP.txt");
-os.remove(home + "optimalInput.txt");
-# os.remove(home + "currentRightFootPosition.txt");
+# os.remove(home + "currentComLinAcc.bin")
+# os.remove(home + "refComLinAcc.bin");
+os.remove(home + "intComPositionRef.bin");
+os.remove(home + "currentComPos.bin");
+os.remove(home + "currentZMP.bin");
+os.remove(home + "referenceZMP.bin");
+os.remove(home + "previewedZMP.bin");
+os.remove(home + "optimalInput.bin");
+# os.remove(home + "currentRightFootPosition.bin");
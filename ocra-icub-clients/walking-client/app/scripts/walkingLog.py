@@ -0,0 +1,25 @@
+import numpy as np
+import struct
+
+def load(path):
+    """Loads a channel written by ExperimentLogger (see ExperimentLogger.h) as an array with one sample per row: the
+    time followed by the values, i.e. the same layout as the text files previously written by the tests. A truncated
+    last block is ignored."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:8] != b'WCLOG001':
+        raise IOError(path + ' is not a channel of an experiment log')
+    width, nameLength = struct.unpack_from('=II', data, 8)
+    offset = 16 + nameLength
+    columns = 1 + width
+    blocks = []
+    while offset + 4 <= len(data):
+        n, = struct.unpack_from('=I', data, offset)
+        offset += 4
+        if offset + 8*n*columns > len(data):
+            break
+        blocks.append(np.frombuffer(data, dtype=np.float64, count=n*columns, offset=offset).reshape(columns, n).T)
+        offset += 8*n*columns
+    if not blocks:
+        return np.zeros((0, columns))
+    return np.vstack(blocks)
@@ -0,0 +1,298 @@
+/*! \file       miqp-replay.cpp
+ *  \brief      Offline replay of the walking MIQP on recorded states.
+ *  \details    Builds MIQPController without YARP ports nor robot model, feeds it a sequence of recorded states
+ *              and CoM references and solves the problem once per recorded sample. Reports the solve-time
+ *              percentiles, the number of branch-and-bound nodes and the objective values, and optionally
+ *              compares the objectives against a reference run.
+ *
+ *              The recording is either the channel MIQP/replay.bin logged by MIQPController::run() or a text
+ *              file, e.g. as converted by walking-log-convert. Every sample (line) contains:
+ *              \f[
+ *              t \quad \xi_k^T \quad \hat{h}_k^{rT} \quad [x_{min}\; y_{min}\; x_{max}\; y_{max}]
+ *              \f]
+ *              i.e. 1 + 16 + 6 values and optionally the bounding box of the support polygon. Without the bounding
+ *              box the CoP constraints are not replayed. Lines of a text file starting with # are skipped.
+ *
+ *              When the Gurobi environment cannot be created (e.g. no license on a CI machine) only the
+ *              state-dependent updates of the problem are timed and the regression check is skipped.
+ *
+ *              Usage:
+ *              \code
+ *              miqp-replay --recording replay.bin [--from walking-client.ini] [--cz 0.53] [--repeat 10]
+ *                          [--output solves.txt] [--reference solves_ref.txt] [--tolerance 1e-6]
+ *              \endcode
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-recipes.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Property.h>
+
+#include "walking-client/MIQPController.h"
+#include "walking-client/ExperimentLogger.h"
+
+/** Number of values of a recorded sample without bounding box: t, xi_k and the CoM reference */
+static const unsigned int SAMPLE_SIZE = 1 + STATE_VECTOR_SIZE + 6;
+
+struct RecordedSample {
+    double t;
+    Eigen::VectorXd xi;
+    Eigen::VectorXd comRef;
+    bool hasBoundingBox;
+    Eigen::Matrix2d boundingBox;
+};
+
+struct SolveRecord {
+    unsigned int k;
+    double time;
+    bool solved;
+    double objective;
+    double nodes;
+};
+
+void addSample(const std::vector<double> &values, std::vector<RecordedSample> &samples) {
+    RecordedSample sample;
+    sample.t = values[0];
+    sample.xi = Eigen::Map<const Eigen::VectorXd>(&values[1], STATE_VECTOR_SIZE);
+    sample.comRef = Eigen::Map<const Eigen::VectorXd>(&values[1 + STATE_VECTOR_SIZE], 6);
+    sample.hasBoundingBox = values.size() == SAMPLE_SIZE + 4;
+    if (sample.hasBoundingBox) {
+        // Same layout as BaseOfSupport::computeBoundingBox()
+        sample.boundingBox << values[SAMPLE_SIZE], values[SAMPLE_SIZE + 1],
+                              values[SAMPLE_SIZE + 2], values[SAMPLE_SIZE + 3];
+    }
+    samples.push_back(sample);
+}
+
+bool readRecording(const std::string &path, std::vector<RecordedSample> &samples) {
+    // Channel written by the logger of MIQPController
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0) {
+        std::string name;
+        Eigen::MatrixXd rows;
+        if (!ExperimentLogger::readChannel(path, name, rows))
+            return false;
+        if (rows.cols() != SAMPLE_SIZE && rows.cols() != SAMPLE_SIZE + 4) {
+            OCRA_ERROR("Channel " << name << " of " << path << " has " << rows.cols() << " values per sample instead of "
+                       << SAMPLE_SIZE << " or " << SAMPLE_SIZE + 4);
+            return false;
+        }
+        std::vector<double> values(rows.cols());
+        for (unsigned int i = 0; i < rows.rows(); i++) {
+            Eigen::VectorXd::Map(values.data(), values.size()) = rows.row(i).transpose();
+            addSample(values, samples);
+        }
+        return !samples.empty();
+    }
+
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        OCRA_ERROR("Could not open recording " << path);
+        return false;
+    }
+    std::string line;
+    unsigned int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream iss(line);
+        std::vector<double> values;
+        double v;
+        while (iss >> v)
+            values.push_back(v);
+        if (values.empty())
+            continue;
+        if (values.size() != SAMPLE_SIZE && values.size() != SAMPLE_SIZE + 4) {
+            OCRA_ERROR("Line " << lineNumber << " of " << path << " has " << values.size() << " values instead of "
+                       << SAMPLE_SIZE << " or " << SAMPLE_SIZE + 4);
+            return false;
+        }
+        addSample(values, samples);
+    }
+    return !samples.empty();
+}
+
+bool readReference(const std::string &path, std::vector<double> &objectives) {
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        OCRA_ERROR("Could not open reference " << path);
+        return false;
+    }
+    unsigned int k, solved;
+    double time, objective, nodes;
+    while (file >> k >> time >> solved >> objective >> nodes)
+        objectives.push_back(solved ? objective : NAN);
+    return true;
+}
+
+double percentile(std::vector<double> sorted, double p) {
+    if (sorted.empty())
+        return 0;
+    unsigned int i = (unsigned int) std::ceil(p*sorted.size()) - 1;
+    return sorted[std::min(i, (unsigned int) sorted.size() - 1)];
+}
+
+int main(int argc, char * argv[])
+{
+    yarp::os::ResourceFinder rf;
+    rf.setVerbose(false);
+    rf.setDefaultConfigFile("walking-client.ini");
+    rf.setDefaultContext("walking-client");
+    rf.configure(argc, argv);
+
+    if (rf.check("help") || !rf.check("recording")) {
+        std::cout << "Usage: miqp-replay --recording <file> [--from <ini>] [--cz <m>] [--repeat <n>]" << std::endl
+                  << "                   [--output <file>] [--reference <file>] [--tolerance <value>]" << std::endl;
+        return rf.check("help") ? 0 : -1;
+    }
+
+    if (!rf.check("MIQP_CONTROLLER_PARAMS")) {
+        OCRA_ERROR("No parameters have been specified for the MIQP controller");
+        return -1;
+    }
+    MIQPParameters miqpParams;
+    yarp::os::Property miqpParamsGroup;
+    miqpParamsGroup.fromString(rf.findGroup("MIQP_CONTROLLER_PARAMS").tail().toString());
+    MIQPController::loadParameters(miqpParamsGroup, miqpParams);
+    // The height of the CoM is normally taken from the robot model
+    if (rf.check("cz")) {
+        miqpParams.cz = rf.find("cz").asDouble();
+    } else {
+        OCRA_WARNING("Option 'cz' [m] was not specified. Using default 0.5m");
+        miqpParams.cz = 0.5;
+    }
+    miqpParams.home = "";
+
+    std::vector<RecordedSample> samples;
+    if (!readRecording(rf.find("recording").asString(), samples)) {
+        OCRA_ERROR("No samples to replay");
+        return -1;
+    }
+    bool hasBoundingBoxes = std::all_of(samples.begin(), samples.end(),
+                                        [](const RecordedSample &s) { return s.hasBoundingBox; });
+    if (!hasBoundingBoxes && miqpParams.copConstraints) {
+        OCRA_WARNING("The recording has no bounding boxes of the support polygon. CoP constraints won't be replayed");
+        miqpParams.copConstraints = false;
+    }
+
+    Eigen::MatrixXd comStateRef(samples.size(), 6);
+    for (unsigned int i = 0; i < samples.size(); i++)
+        comStateRef.row(i) = samples[i].comRef.transpose();
+
+    // No robot model nor step controller: the state and the support polygon are given by the recording
+    MIQPController miqpController(miqpParams, nullptr, nullptr, comStateRef);
+    miqpController.setState(samples[0].xi, samples[0].t);
+    bool solverAvailable = miqpController.initializeProblem();
+    if (!solverAvailable)
+        OCRA_WARNING("Gurobi is not available. Only the updates of the problem will be timed");
+
+    unsigned int repeat = rf.check("repeat") ? std::max(1, rf.find("repeat").asInt()) : 1;
+    std::vector<SolveRecord> records;
+    records.reserve(repeat*samples.size());
+    for (unsigned int r = 0; r < repeat; r++) {
+        for (unsigned int k = 0; k < samples.size(); k++) {
+            miqpController.setState(samples[k].xi, samples[k].t);
+            if (hasBoundingBoxes)
+                miqpController.setRecordedBoundingBox(samples[k].boundingBox);
+
+            auto start = std::chrono::steady_clock::now();
+            bool solved = miqpController.solveProblem(k);
+            auto end = std::chrono::steady_clock::now();
+
+            SolveRecord record;
+            record.k = k;
+            record.time = std::chrono::duration<double>(end - start).count();
+            record.solved = solved;
+            record.objective = solved ? miqpController.getObjectiveValue() : NAN;
+            record.nodes = solved ? miqpController.getNodeCount() : 0;
+            records.push_back(record);
+        }
+    }
+
+    std::vector<double> times, nodes;
+    unsigned int failures = 0;
+    for (const SolveRecord &record : records) {
+        times.push_back(record.time);
+        nodes.push_back(record.nodes);
+        if (!record.solved)
+            failures++;
+    }
+    std::sort(times.begin(), times.end());
+    std::sort(nodes.begin(), nodes.end());
+
+    std::cout << "Replayed " << samples.size() << " samples " << repeat << " time(s)"
+              << (solverAvailable ? "" : " (problem updates only, no solver)") << std::endl;
+    std::cout << "Solve time [ms]  p50: " << 1e3*percentile(times, 0.5) << "  p90: " << 1e3*percentile(times, 0.9)
+              << "  p99: " << 1e3*percentile(times, 0.99) << "  max: " << 1e3*times.back() << std::endl;
+    if (solverAvailable) {
+        std::cout << "B&B nodes        p50: " << percentile(nodes, 0.5) << "  p90: " << percentile(nodes, 0.9)
+                  << "  max: " << nodes.back() << std::endl;
+        std::cout << "Failed solves: " << failures << "/" << records.size() << std::endl;
+    }
+
+    // One line per solve of the first pass: k, time, solved, objective, nodes. Can be used as --reference.
+    if (rf.check("output")) {
+        std::ofstream output(rf.find("output").asString().c_str());
+        output.precision(12);
+        for (unsigned int i = 0; i < samples.size(); i++) {
+            const SolveRecord &record = records[i];
+            output << record.k << " " << record.time << " " << record.solved << " "
+                   << record.objective << " " << record.nodes << std::endl;
+        }
+    }
+
+    if (!solverAvailable)
+        return 0;
+
+    int ret = failures > 0 ? -1 : 0;
+    if (rf.check("reference")) {
+        std::vector<double> refObjectives;
+        if (!readReference(rf.find("reference").asString(), refObjectives))
+            return -1;
+        double tolerance = rf.check("tolerance") ? rf.find("tolerance").asDouble() : 1e-6;
+        unsigned int mismatches = 0;
+        for (unsigned int i = 0; i < std::min(refObjectives.size(), samples.size()); i++) {
+            double objective = records[i].objective;
+            double ref = refObjectives[i];
+            bool ok = (std::isnan(objective) && std::isnan(ref)) ||
+                      std::abs(objective - ref) <= tolerance*std::max(1.0, std::abs(ref));
+            if (!ok) {
+                OCRA_ERROR("Objective at k = " << i << " is " << objective << " instead of " << ref);
+                mismatches++;
+            }
+        }
+        if (refObjectives.size() != samples.size()) {
+            OCRA_ERROR("The reference has " << refObjectives.size() << " solves instead of " << samples.size());
+            mismatches++;
+        }
+        std::cout << "Objective mismatches: " << mismatches << std::endl;
+        if (mismatches > 0)
+            ret = -1;
+    }
+    return ret;
+}
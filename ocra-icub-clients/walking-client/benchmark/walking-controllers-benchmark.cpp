@@ -0,0 +1,238 @@
+/*! \file       walking-controllers-benchmark.cpp
+ *  \brief      Offline comparison of the ZMP preview and DCM walking controllers on a recorded footstep plan.
+ *  \details    Runs ZmpPreviewController (fed by ZmpReferenceGenerator) and DcmController on the same footstep plan,
+ *              each closing the loop on its own LIPM (the cart-table model integrated from the CoM jerk for the
+ *              former, the CoM integrated from the commanded ZMP for the latter). Reports the construction time,
+ *              the per-tick CPU time percentiles and the ZMP and DCM tracking errors with respect to the references
+ *              of the plan.
+ *
+ *              The plan is written by the stepping and DCM tests of walking-client in
+ *              steppingTests/footstepPlan.txt, one footstep per line:
+ *              \f[
+ *              x \quad y \quad T_{ds} \quad T_{ss}
+ *              \f]
+ *              The ZMP starts at the first footstep. The controller parameters are read from the groups
+ *              ZMP_PREVIEW_CONTROLLER_PARAMS and DCM_CONTROLLER_PARAMS of walking-client.ini.
+ *
+ *              Usage:
+ *              \code
+ *              walking-controllers-benchmark --plan footstepPlan.txt [--from walking-client.ini] [--cz 0.53]
+ *                                            [--push "(t vx vy)"] [--repeat 10]
+ *              \endcode
+ *              where --push adds a CoM velocity (m/s) at time t (s) of the plan to both models.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-recipes.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Property.h>
+
+#include "walking-client/ZmpPreviewController.h"
+#include "walking-client/ZmpReferenceGenerator.h"
+#include "walking-client/DcmController.h"
+
+struct TrackingStats {
+    std::vector<double> tickTimes;
+    double setupTime;
+    double zmpSquaredError;
+    double zmpMaxError;
+    double dcmSquaredError;
+    double dcmMaxError;
+    unsigned int samples;
+
+    TrackingStats() : setupTime(0), zmpSquaredError(0), zmpMaxError(0), dcmSquaredError(0), dcmMaxError(0), samples(0) {}
+
+    void addErrors(const Eigen::Vector2d &zmpError, const Eigen::Vector2d &dcmError) {
+        zmpSquaredError += zmpError.squaredNorm();
+        zmpMaxError = std::max(zmpMaxError, zmpError.norm());
+        dcmSquaredError += dcmError.squaredNorm();
+        dcmMaxError = std::max(dcmMaxError, dcmError.norm());
+        samples++;
+    }
+};
+
+bool readPlan(const std::string &path, std::vector<ZmpFootstep> &plan) {
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        OCRA_ERROR("Could not open footstep plan " << path);
+        return false;
+    }
+    double x, y, ds, ss;
+    while (file >> x >> y >> ds >> ss)
+        plan.push_back(ZmpFootstep(Eigen::Vector2d(x, y), ds, ss));
+    return !plan.empty();
+}
+
+double percentile(std::vector<double> sorted, double p) {
+    if (sorted.empty())
+        return 0;
+    unsigned int i = (unsigned int) std::ceil(p*sorted.size()) - 1;
+    return sorted[std::min(i, (unsigned int) sorted.size() - 1)];
+}
+
+void printStats(const std::string &name, TrackingStats &stats) {
+    std::sort(stats.tickTimes.begin(), stats.tickTimes.end());
+    std::cout << name << std::endl;
+    std::cout << "  Setup time [ms]:     " << 1e3*stats.setupTime << std::endl;
+    std::cout << "  Tick time [us]       p50: " << 1e6*percentile(stats.tickTimes, 0.5)
+              << "  p99: " << 1e6*percentile(stats.tickTimes, 0.99) << "  max: " << 1e6*stats.tickTimes.back() << std::endl;
+    std::cout << "  ZMP error [mm]       rms: " << 1e3*std::sqrt(stats.zmpSquaredError/stats.samples)
+              << "  max: " << 1e3*stats.zmpMaxError << std::endl;
+    std::cout << "  DCM error [mm]       rms: " << 1e3*std::sqrt(stats.dcmSquaredError/stats.samples)
+              << "  max: " << 1e3*stats.dcmMaxError << std::endl;
+}
+
+int main(int argc, char * argv[])
+{
+    yarp::os::ResourceFinder rf;
+    rf.setVerbose(false);
+    rf.setDefaultConfigFile("walking-client.ini");
+    rf.setDefaultContext("walking-client");
+    rf.configure(argc, argv);
+
+    if (rf.check("help") || !rf.check("plan")) {
+        std::cout << "Usage: walking-controllers-benchmark --plan <file> [--from <ini>] [--cz <m>]" << std::endl
+                  << "                                     [--push \"(t vx vy)\"] [--repeat <n>]" << std::endl;
+        return rf.check("help") ? 0 : -1;
+    }
+
+    std::vector<ZmpFootstep> plan;
+    if (!readPlan(rf.find("plan").asString(), plan)) {
+        OCRA_ERROR("No footsteps to walk");
+        return -1;
+    }
+
+    double period = rf.check("period") ? rf.find("period").asInt() : 10;
+    double dt = period/1000.0;
+    // The height of the CoM is normally taken from the robot model
+    double cz = rf.check("cz") ? rf.find("cz").asDouble() : 0.5;
+
+    std::shared_ptr<ZmpPreviewParams> previewParams = std::make_shared<ZmpPreviewParams>(50, 50, cz, 1e-6, 0.0, 1.0);
+    if (rf.check("ZMP_PREVIEW_CONTROLLER_PARAMS")) {
+        yarp::os::Property group;
+        group.fromString(rf.findGroup("ZMP_PREVIEW_CONTROLLER_PARAMS").tail().toString());
+        previewParams->Np = group.check("Np", yarp::os::Value(previewParams->Np)).asInt();
+        previewParams->Nc = group.check("Nc", yarp::os::Value(previewParams->Nc)).asInt();
+        previewParams->nu = group.check("nu", yarp::os::Value(previewParams->nu)).asDouble();
+        previewParams->nw = group.check("nw", yarp::os::Value(previewParams->nw)).asDouble();
+        previewParams->nb = group.check("nb", yarp::os::Value(previewParams->nb)).asDouble();
+    }
+    DcmControllerParams dcmParams;
+    dcmParams.cz = cz;
+    if (rf.check("DCM_CONTROLLER_PARAMS")) {
+        yarp::os::Property group;
+        group.fromString(rf.findGroup("DCM_CONTROLLER_PARAMS").tail().toString());
+        dcmParams.kDcm = group.check("kDcm", yarp::os::Value(dcmParams.kDcm)).asDouble();
+    }
+
+    bool push = false;
+    double pushTime = 0;
+    Eigen::Vector2d pushVelocity = Eigen::Vector2d::Zero();
+    if (rf.check("push")) {
+        yarp::os::Bottle *pushList = rf.find("push").asList();
+        if (pushList == NULL || pushList->size() != 3) {
+            OCRA_ERROR("Option 'push' takes three values: t vx vy");
+            return -1;
+        }
+        push = true;
+        pushTime = pushList->get(0).asDouble();
+        pushVelocity << pushList->get(1).asDouble(), pushList->get(2).asDouble();
+    }
+    unsigned int repeat = rf.check("repeat") ? std::max(1, rf.find("repeat").asInt()) : 1;
+
+    const Eigen::Vector2d initialZmp = plan.front().position;
+    ComState initialState = ComState::Zero();
+    initialState.head<2>() = initialZmp;
+
+    // Both controllers are measured against the references of the plan as computed by DcmController
+    DcmController planReference(period, dcmParams);
+    planReference.setPlan(initialZmp, plan);
+    // Walk the plan and come to rest
+    const unsigned int nTicks = (unsigned int) std::ceil((planReference.getPlanDuration() + 2.0)/dt);
+    const unsigned int pushTick = (unsigned int) std::round(pushTime/dt);
+
+    TrackingStats previewStats, dcmStats;
+    for (unsigned int r = 0; r < repeat; r++) {
+        // ZMP preview controller
+        auto start = std::chrono::steady_clock::now();
+        ZmpPreviewController previewController(period, previewParams);
+        ZmpReferenceGenerator generator(period, previewParams->Np);
+        generator.reset(initialZmp);
+        for (const ZmpFootstep &footstep : plan)
+            generator.addFootstep(footstep);
+        generator.fillPreviewWindow();
+        previewStats.setupTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()/repeat;
+
+        Eigen::VectorXd zmpRef(2*previewParams->Np), comVelRef(2*previewParams->Np), optimalU(2*previewParams->Nc);
+        ComState hk = initialState, hkk;
+        Eigen::Vector2d zmp, zmpRefNow, dcmRefNow;
+        for (unsigned int k = 0; k < nTicks; k++) {
+            if (push && k == pushTick)
+                hk.segment<2>(2) += pushVelocity;
+            planReference.getReference(k*dt, zmpRefNow, dcmRefNow);
+            previewController.tableCartModel(hk, zmp);
+            previewStats.addErrors(zmp - zmpRefNow, planReference.computeDcm(hk) - dcmRefNow);
+
+            start = std::chrono::steady_clock::now();
+            generator.getPreviewWindow(zmpRef, comVelRef);
+            previewController.computeOptimalInput(zmpRef, comVelRef, hk, optimalU);
+            previewController.integrateCom(optimalU.head<2>(), hk, hkk);
+            generator.advance();
+            previewStats.tickTimes.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            hk = hkk;
+        }
+
+        // DCM controller
+        start = std::chrono::steady_clock::now();
+        DcmController dcmController(period, dcmParams);
+        dcmController.setPlan(initialZmp, plan);
+        dcmStats.setupTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()/repeat;
+
+        hk = initialState;
+        Eigen::Vector2d zmpCommand;
+        for (unsigned int k = 0; k < nTicks; k++) {
+            if (push && k == pushTick)
+                hk.segment<2>(2) += pushVelocity;
+            planReference.getReference(k*dt, zmpRefNow, dcmRefNow);
+
+            start = std::chrono::steady_clock::now();
+            dcmController.computeControl(k*dt, hk, zmpCommand, hkk);
+            dcmStats.tickTimes.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            // The ZMP of the LIPM is the commanded one
+            dcmStats.addErrors(zmpCommand - zmpRefNow, dcmController.computeDcm(hk) - dcmRefNow);
+            hk = hkk;
+        }
+    }
+
+    std::cout << "Walked " << plan.size() << " footsteps (" << nTicks << " ticks of " << period << "ms) "
+              << repeat << " time(s)" << std::endl;
+    printStats("ZMP preview controller (Np = " + std::to_string(previewParams->Np) + ")", previewStats);
+    printStats("DCM controller (kDcm = " + std::to_string(dcmParams.kDcm) + ")", dcmStats);
+    return 0;
+}
@@ -0,0 +1,217 @@
+/*! \file       zmp-preview-tick-benchmark.cpp
+ *  \brief      Micro-benchmark of the per-tick cost of the ZMP preview pipeline.
+ *  \details    Times the work done at every tick of the ZMP preview tests of walking-client: unrolling the preview
+ *              window of ZmpReferenceGenerator, computing the optimal input, integrating the cart-table model and
+ *              computing the previewed ZMP. Three variants are run on the same footstep plan, each closing the
+ *              loop on its own cart-table model:
+ *              - dynamic: the cart-table model and the CoM states as Eigen::MatrixXd and Eigen::VectorXd, with the
+ *                states allocated at every tick and the optimal input computed through temporaries, as the test
+ *                loops did before ComState.
+ *              - fixed model: ComState and the fixed-size model of ZmpPreviewController, with a runtime sized
+ *                preview window, as walking-client does since \f$N_p\f$ is read from its configuration file.
+ *              - fixed window: same with a compile-time sized ZmpPreviewWindow<PREVIEW_WINDOW_SIZE>. Skipped
+ *                when Np in the configuration file is not PREVIEW_WINDOW_SIZE.
+ *
+ *              The controller parameters are read from the group ZMP_PREVIEW_CONTROLLER_PARAMS of
+ *              walking-client.ini. The plan is a straight walk of --steps footsteps.
+ *
+ *              Usage:
+ *              \code
+ *              zmp-preview-tick-benchmark [--from walking-client.ini] [--cz 0.53] [--steps 20] [--repeat 10]
+ *              \endcode
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-recipes.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Property.h>
+
+#include "walking-client/ZmpPreviewController.h"
+#include "walking-client/ZmpReferenceGenerator.h"
+
+/** Compile-time length of the preview window of the fixed window variant, Np of the walking-client.ini files */
+static const int PREVIEW_WINDOW_SIZE = 200;
+
+/**
+ * Gives access to the gains and the cart-table model of ZmpPreviewController, to run the dynamic variant with the
+ * very same numbers.
+ */
+class ZmpPreviewControllerProbe : public ZmpPreviewController {
+public:
+    ZmpPreviewControllerProbe(const double period, std::shared_ptr<ZmpPreviewParams> parameters) :
+    ZmpPreviewController(period, parameters) {}
+
+    Eigen::MatrixXd getKZmp() const { return KZmp; };
+    Eigen::MatrixXd getKComVel() const { return KComVel; };
+    Eigen::MatrixXd getKState() const { return KState; };
+    Eigen::MatrixXd getAh() const { return Ah; };
+    Eigen::MatrixXd getBh() const { return Bh; };
+    Eigen::MatrixXd getCp() const { return Cp; };
+};
+
+struct TickStats {
+    std::vector<double> tickTimes;
+    Eigen::Vector2d finalZmp;
+
+    TickStats() : finalZmp(Eigen::Vector2d::Zero()) {}
+};
+
+double percentile(std::vector<double> sorted, double p) {
+    if (sorted.empty())
+        return 0;
+    unsigned int i = (unsigned int) std::ceil(p*sorted.size()) - 1;
+    return sorted[std::min(i, (unsigned int) sorted.size() - 1)];
+}
+
+void printStats(const std::string &name, TickStats &stats, const Eigen::Vector2d &referenceZmp) {
+    std::sort(stats.tickTimes.begin(), stats.tickTimes.end());
+    std::cout << name << std::endl;
+    std::cout << "  Tick time [us]       p50: " << 1e6*percentile(stats.tickTimes, 0.5)
+              << "  p90: " << 1e6*percentile(stats.tickTimes, 0.9)
+              << "  p99: " << 1e6*percentile(stats.tickTimes, 0.99) << "  max: " << 1e6*stats.tickTimes.back() << std::endl;
+    std::cout << "  Final ZMP deviation from the dynamic variant [m]: " << (stats.finalZmp - referenceZmp).norm() << std::endl;
+}
+
+void resetGenerator(ZmpReferenceGenerator &generator, const std::vector<ZmpFootstep> &plan) {
+    generator.reset(Eigen::Vector2d::Zero());
+    for (const ZmpFootstep &footstep : plan)
+        generator.addFootstep(footstep);
+    generator.fillPreviewWindow();
+}
+
+/**
+ * Runs the pipeline with a preview window of type Window, either Eigen::VectorXd or ZmpPreviewWindow<Np>.
+ */
+template <typename Window>
+void runFixedModel(ZmpPreviewController &controller, ZmpReferenceGenerator &generator, const int Np,
+                   const unsigned int nTicks, TickStats &stats) {
+    Window zmpRef(2*Np), comVelRef(2*Np);
+    ComState hk = ComState::Zero(), hkk;
+    Eigen::Vector2d optimalU, pk;
+    for (unsigned int k = 0; k < nTicks; k++) {
+        auto start = std::chrono::steady_clock::now();
+        generator.getPreviewWindow(zmpRef, comVelRef);
+        controller.computeOptimalInput(zmpRef, comVelRef, hk, optimalU);
+        controller.integrateCom(optimalU, hk, hkk);
+        controller.tableCartModel(hkk, pk);
+        generator.advance();
+        stats.tickTimes.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        hk = hkk;
+    }
+    stats.finalZmp = pk;
+}
+
+int main(int argc, char * argv[])
+{
+    yarp::os::ResourceFinder rf;
+    rf.setVerbose(false);
+    rf.setDefaultConfigFile("walking-client.ini");
+    rf.setDefaultContext("walking-client");
+    rf.configure(argc, argv);
+
+    if (rf.check("help")) {
+        std::cout << "Usage: zmp-preview-tick-benchmark [--from <ini>] [--cz <m>] [--steps <n>] [--repeat <n>]" << std::endl;
+        return 0;
+    }
+
+    double period = rf.check("period") ? rf.find("period").asInt() : 10;
+    double dt = period/1000.0;
+    // The height of the CoM is normally taken from the robot model
+    double cz = rf.check("cz") ? rf.find("cz").asDouble() : 0.5;
+
+    std::shared_ptr<ZmpPreviewParams> previewParams = std::make_shared<ZmpPreviewParams>(PREVIEW_WINDOW_SIZE, PREVIEW_WINDOW_SIZE, cz, 1e-6, 0.0, 1.0);
+    if (rf.check("ZMP_PREVIEW_CONTROLLER_PARAMS")) {
+        yarp::os::Property group;
+        group.fromString(rf.findGroup("ZMP_PREVIEW_CONTROLLER_PARAMS").tail().toString());
+        previewParams->Np = group.check("Np", yarp::os::Value(previewParams->Np)).asInt();
+        previewParams->Nc = group.check("Nc", yarp::os::Value(previewParams->Nc)).asInt();
+        previewParams->nu = group.check("nu", yarp::os::Value(previewParams->nu)).asDouble();
+        previewParams->nw = group.check("nw", yarp::os::Value(previewParams->nw)).asDouble();
+        previewParams->nb = group.check("nb", yarp::os::Value(previewParams->nb)).asDouble();
+    }
+    const int Np = previewParams->Np;
+
+    // Straight walk swinging the ZMP between both feet, as the stepping test
+    unsigned int nSteps = rf.check("steps") ? std::max(1, rf.find("steps").asInt()) : 20;
+    std::vector<ZmpFootstep> plan;
+    for (unsigned int i = 0; i < nSteps; i++)
+        plan.push_back(ZmpFootstep(Eigen::Vector2d(0.05*(i + 1), i % 2 == 0 ? 0.07 : -0.07), 0.2, 0.6));
+    plan.push_back(ZmpFootstep(Eigen::Vector2d(0.05*nSteps, 0.0), 0.2, 1.0));
+    double planDuration = 0;
+    for (const ZmpFootstep &footstep : plan)
+        planDuration += footstep.dsDuration + footstep.ssDuration;
+    const unsigned int nTicks = (unsigned int) std::ceil(planDuration/dt);
+    unsigned int repeat = rf.check("repeat") ? std::max(1, rf.find("repeat").asInt()) : 1;
+
+    ZmpPreviewControllerProbe controller(period, previewParams);
+    ZmpReferenceGenerator generator(period, Np);
+
+    // Dynamic variant
+    const Eigen::MatrixXd KZmp = controller.getKZmp(), KComVel = controller.getKComVel(), KState = controller.getKState();
+    const Eigen::MatrixXd Ah = controller.getAh(), Bh = controller.getBh(), Cp = controller.getCp();
+    TickStats dynamicStats, fixedModelStats, fixedWindowStats;
+    for (unsigned int r = 0; r < repeat; r++) {
+        resetGenerator(generator, plan);
+        Eigen::VectorXd zmpRef(2*Np), comVelRef(2*Np), optimalU(2*previewParams->Nc);
+        Eigen::VectorXd hk = Eigen::VectorXd::Zero(6);
+        Eigen::Vector2d pk;
+        for (unsigned int k = 0; k < nTicks; k++) {
+            auto start = std::chrono::steady_clock::now();
+            generator.getPreviewWindow(zmpRef, comVelRef);
+            Eigen::VectorXd hkCopy(6);
+            hkCopy = hk;
+            optimalU.setZero();
+            optimalU.head(2) = KZmp*zmpRef + KComVel*comVelRef + KState*hkCopy;
+            Eigen::VectorXd hkk(6);
+            hkk = Ah*hkCopy + Bh*optimalU.topRows(2);
+            pk = Cp*hkk;
+            generator.advance();
+            dynamicStats.tickTimes.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            hk = hkk;
+        }
+        dynamicStats.finalZmp = pk;
+
+        resetGenerator(generator, plan);
+        runFixedModel<Eigen::VectorXd>(controller, generator, Np, nTicks, fixedModelStats);
+
+        if (Np == PREVIEW_WINDOW_SIZE) {
+            resetGenerator(generator, plan);
+            runFixedModel<ZmpPreviewWindow<PREVIEW_WINDOW_SIZE> >(controller, generator, Np, nTicks, fixedWindowStats);
+        }
+    }
+
+    std::cout << "Walked " << plan.size() << " footsteps (" << nTicks << " ticks of " << period << "ms) "
+              << repeat << " time(s) with Np = " << Np << std::endl;
+    printStats("Dynamic cart-table model and states", dynamicStats, dynamicStats.finalZmp);
+    printStats("Fixed-size cart-table model, runtime sized window", fixedModelStats, dynamicStats.finalZmp);
+    if (Np == PREVIEW_WINDOW_SIZE)
+        printStats("Fixed-size cart-table model, ZmpPreviewWindow<" + std::to_string(PREVIEW_WINDOW_SIZE) + ">", fixedWindowStats, dynamicStats.finalZmp);
+    else
+        OCRA_WARNING("The fixed window variant is only run for Np = " << PREVIEW_WINDOW_SIZE << ", not " << Np);
+    return 0;
+}
@@ -14,7 +14,11 @@ find_library(EIGENGUROBI_LIBRARIES
              NAMES libeigen-gurobi.dylib libeigen-gurobi.a
              PATHS "$ENV{EIGENGUROBI_HOME}/build/lib"
                    "/usr/local/lib")
-set(EIGENGUROBI_FOUND true)
+if(EIGENGUROBI_INCLUDE_DIR AND EIGENGUROBI_LIBRARIES)
+    set(EIGENGUROBI_FOUND true)
+else()
+    set(EIGENGUROBI_FOUND false)
+endif()
 message("-- EIGENGUROBI_INCLUDE_DIR: " ${EIGENGUROBI_INCLUDE_DIR})
 message("-- EIGENGUROBI_LIBRARIES: " ${EIGENGUROBI_LIBRARIES})
 
@@ -86,11 +86,11 @@
 #include <boost/geometry/geometries/polygon.hpp>
 #include <boost/geometry/geometries/box.hpp>
 #include <boost/geometry/geometries/adapted/boost_tuple.hpp>
-#include "unsupported/Eigen/MatrixFunctions"
 // Eigen headers
 #include <Eigen/Core>
 #include <walking-client/MIQPState.h>
 #include <walking-client/StepController.h>
+#include <walking-client/MIQPPreviewModel.h>
 #include <walking-client/utils.h>
 #include <ocra-recipes/TaskConnection.h>
 
@@ -191,7 +191,7 @@ private:
      \end{array}\right]
      \f]
      *
-     * @see #_Ci, #_Q, #_T
+     * @see #_Ci, #_previewModel
      */
     Eigen::MatrixXd _A;
     
@@ -223,7 +223,7 @@ private:
          \end{array}\right]
      \f]
      *
-     * @see #_Ci, #_Q
+     * @see #_Ci, #_previewModel
      */
     Eigen::MatrixXd _B;
     
@@ -256,42 +256,13 @@ private:
     std::shared_ptr<StepController> _stepController;
     
     /**
-     * Matrix \f$\mathbf{Q}\f$ in preview state model:
-     \f[
-     \mathbf{\xi}_{k+1|k} = \mathbf{Q} \xi_{k|k} + \mathbf{T}\mathcal{X}_{k+1|k}
-     \f]
-     \f[
-     \mathbf{Q} = \left[\begin{array}{cc}
-     \mathbf{0}_{10\times10} & \mathbf{0}_{10\times6}\\
-     \mathbf{0}_{6\times10} & \mathbf{A_h}_{6\times6}
-     \end{array}\right]
-     \f]
-     *
-     * Size: \f$[16\times16]\f$
+     * Preview model providing \f$\mathbf{Q}_j\f$ and \f$\mathbf{T}_j\f$ over the preview window. When the window is
+     * uniformly sampled, \f$\mathbf{Q}^i\f$ in #_A and #_B is the \f$i\f$-th power of \f$\mathbf{Q}\f$, otherwise the
+     * product of the \f$\mathbf{Q}_j\f$ of the corresponding steps.
      *
-     * @see MIQPController::_Ah
+     * @see MIQPPreviewModel
      */
-    Eigen::MatrixXd _Q;
-    
-    /**
-     * Matrix \f$\mathbf{T}\f$ in preview state model:
-     *
-     \f[
-     \mathbf{\xi}_{k+1|k} = \mathbf{Q} \xi_{k|k} + \mathbf{T}\mathcal{X}_{k+1|k}
-     \f]
-     *
-     \f[
-     \mathbf{T} = \left[\begin{array}{cc}
-     \mathbf{I}_{10\times10} & \mathbf{0}_{10\times2}\\
-     \mathbf{0}_{6\times10} & \mathbf{B_h}_{6\times2}
-     \end{array}\right]
-     \f]
-     *
-     *
-     * Size: \f$[16\times12]\f$
-     * @see MIQPController::_Bh
-     */
-    Eigen::MatrixXd _T;
+    std::shared_ptr<MIQPPreviewModel> _previewModel;
     
     /** 
      * Copy of the parameters of the MIQP controller which instantiates MIQPLinearConstraints in which the BoundingBox object will be instantiated.
@@ -302,10 +273,12 @@ public:
     /**
      * Constructor. 
      * @param[in] stepController Pointer to the stepController object instantiated by `walking-client`
+     * @param[in] previewModel Preview model of the MIQP.
+     * @param[in] miqpParams MIQP parameters.
      * 
      * @warning Need to make this thread-safe as this class is running in a different thread from `walking-client`'s
      */
-    BaseOfSupport(std::shared_ptr<StepController> stepController, const Eigen::MatrixXd& Q, const Eigen::MatrixXd& T, MIQPParameters miqpParams);
+    BaseOfSupport(std::shared_ptr<StepController> stepController, std::shared_ptr<MIQPPreviewModel> previewModel, MIQPParameters miqpParams);
     
     /**
      * Destructor
@@ -326,6 +299,15 @@ public:
      * @see #_B
      */
     bool update(const Eigen::VectorXd& xi_k);
+
+    /**
+     * Same as update(const Eigen::VectorXd&) but with a given bounding box of the current support configuration
+     * instead of the one computed from the feet corners. Used to replay recorded data without a robot.
+     *
+     * @param[in] xi_k Current system state.
+     * @param[in] minMaxBoundingBox Bounding box of the support polygon, as computed by computeBoundingBox().
+     */
+    bool update(const Eigen::VectorXd& xi_k, const Eigen::Matrix2d& minMaxBoundingBox);
     
     /**
      * Computes the bounding box points (minimum and maximum points of the box of the current support 
@@ -407,20 +389,17 @@ protected:
      Builds matrix \f$\mathbf{B}\f$
 
      @param[in] Ci See #_Ci
-     @param[in] Q See #_Q
      @see #_B
      */
-    void buildB(const Eigen::MatrixXd& Ci, const Eigen::MatrixXd& Q);
+    void buildB(const Eigen::MatrixXd& Ci);
     
     /**
      Builds constraints matrix \f$\mathbf{A}\f$.
 
      @param[in] Ci See #_Ci
-     @param[in] Q See #_Q
-     @param[in] T See #_T
      @see #_A
      */
-    void buildA(const Eigen::MatrixXd& Ci, const Eigen::MatrixXd& Q, const Eigen::MatrixXd& T);
+    void buildA(const Eigen::MatrixXd& Ci);
 };
 
 #endif
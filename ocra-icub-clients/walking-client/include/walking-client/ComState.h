@@ -0,0 +1,54 @@
+/*! \file       ComState.h
+ *  \brief      Fixed-size Eigen types of the horizontal CoM state and of the cart-table model.
+ *  \details    The horizontal CoM state \f$\hat{\mathbf{h}} = (\mathbf{h}, \dot{\mathbf{h}}, \ddot{\mathbf{h}})\f$ used by
+ *              ZmpPreviewController, DcmController and FootstepAdapter always has six components, and the matrices of
+ *              the cart-table model \f$\mathbf{A}_h\f$, \f$\mathbf{B}_h\f$, \f$\mathbf{C}_p\f$ and \f$\mathbf{C}_h\f$
+ *              are always \f$6\times6\f$, \f$6\times2\f$ and \f$2\times6\f$. Using fixed-size types for them lets
+ *              Eigen unroll their products and keeps them on the stack, so that the control loops don't allocate.
+ *
+ *              The stacked references of the preview window, \f$\mathbf{P}_r\f$ and \f$\tilde{\mathbf{H}}_r\f$,
+ *              have \f$2N_p\f$ components. ZmpPreviewWindow<Np> is a compile-time sized window when \f$N_p\f$ is
+ *              known at compile time and Eigen::VectorXd when Np is Eigen::Dynamic, e.g. when it is read from
+ *              the configuration file. Both can be passed to ZmpPreviewController::computeOptimalInput() and
+ *              ZmpReferenceGenerator::getPreviewWindow().
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-recipes.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _COM_STATE_H_
+#define _COM_STATE_H_
+
+#include <Eigen/Dense>
+
+/** Horizontal CoM state \f$\hat{\mathbf{h}}\f$: position, velocity and acceleration */
+typedef Eigen::Matrix<double, 6, 1> ComState;
+/** State matrix of the cart-table model, \f$\mathbf{A}_h\f$ */
+typedef Eigen::Matrix<double, 6, 6> ComStateMatrix;
+/** Input matrix of the cart-table model, \f$\mathbf{B}_h\f$ */
+typedef Eigen::Matrix<double, 6, 2> ComInputMatrix;
+/** Output matrices of the cart-table model, \f$\mathbf{C}_p\f$ and \f$\mathbf{C}_h\f$ */
+typedef Eigen::Matrix<double, 2, 6> ComOutputMatrix;
+
+/** Stacked bidimensional references of a preview window of Np samples */
+template <int Np>
+using ZmpPreviewWindow = Eigen::Matrix<double, Np == Eigen::Dynamic ? Eigen::Dynamic : 2*Np, 1>;
+
+#endif
@@ -0,0 +1,180 @@
+/**
+ *  \class ConstrainedZmpPreviewController
+ *
+ *  \brief ZMP preview controller with the previewed ZMP bounded to the support polygon and bounded CoM jerks.
+ *
+ *  \author Jorhabib Eljaik
+ *
+ *  \warning Work in progress! This is still a barebone class in the process of being tested.
+ *
+ *  \details The unconstrained problem solved by ZmpPreviewController only tracks the ZMP references, so that the
+ previewed ZMP may leave the support polygon during fast steps. This class solves the same problem subject to
+ \f{align*}
+ \mathbf{P}_{\min} - \mathbf{G}_p \hat{\mathbf{h}}_k \leq &\mathbf{H}_p \mathbf{U} \leq \mathbf{P}_{\max} - \mathbf{G}_p \hat{\mathbf{h}}_k \\
+ -\bar{u}\mathbf{1} \leq &\mathbf{U} \leq \bar{u}\mathbf{1}
+ \f}
+ i.e. \f$ \mathbf{l} \leq \mathbf{G}\mathbf{U} \leq \mathbf{u} \f$ with \f$ \mathbf{G}^T = [\mathbf{H}_p^T \; \mathbf{I}] \f$, where
+ \f$\mathbf{P}_{\min}, \mathbf{P}_{\max}\f$ are the corners of the (per preview step) bounding box of the support polygon
+ and \f$\bar{u}\f$ is the jerk bound ZmpPreviewParams::jerkBound. Polygons are taken through their bounding box, as
+ done by BaseOfSupport, so that \f$\mathbf{G}\f$ is constant.
+
+ Since both the Hessian \f$\mathbf{A}_{\text{opt}}\f$ and \f$\mathbf{G}\f$ are constant, the dual Hessian
+ \f$\mathbf{D} = \mathbf{G}\mathbf{A}_{\text{opt}}^{-1}\mathbf{G}^T\f$ is precomputed by the constructor. The problem is
+ then solved online by an active-set method on the dual, starting from the unconstrained solution
+ \f$\mathbf{U}_0\f$ of ZmpPreviewController:
+ \f[
+ \mathbf{U} = \mathbf{U}_0 - \mathbf{A}_{\text{opt}}^{-1}\mathbf{G}^T_{\mathcal{W}}\boldsymbol{\mu}_{\mathcal{W}}, \qquad
+ \mathbf{D}_{\mathcal{W}\mathcal{W}}\boldsymbol{\mu}_{\mathcal{W}} = \mathbf{G}_{\mathcal{W}}\mathbf{U}_0 - \mathbf{c}_{\mathcal{W}}
+ \f]
+ where \f$\mathcal{W}\f$ is the working set of active bounds and \f$\mathbf{c}_{\mathcal{W}}\f$ their values. Each
+ iteration either adds the most violated bound or drops a bound whose multiplier changes sign, and only requires the
+ factorization of \f$\mathbf{D}_{\mathcal{W}\mathcal{W}}\f$, whose size is the number of active bounds. The working set
+ of the previous call, shifted by one step of the preview window, is used as warm start.
+ */
+
+#ifndef _CONSTRAINEDZMPPREVIEWCONTROLLER_
+#define _CONSTRAINEDZMPPREVIEWCONTROLLER_
+
+#include <vector>
+#include "walking-client/ZmpPreviewController.h"
+
+class ConstrainedZmpPreviewController : public ZmpPreviewController
+{
+public:
+    /**
+     *  Class constructor. Builds the matrices of ZmpPreviewController, the constraint matrix \f$\mathbf{G}\f$ and the
+     *  dual Hessian \f$\mathbf{D}\f$.
+         @param period       Period (in ms) of the thread in which an object of this class is created.
+         @param parameters   An object containing the main parameters. \see struct ZmpPreviewParams for details on the parameters.
+     */
+    ConstrainedZmpPreviewController(const double period, std::shared_ptr<ZmpPreviewParams> parameters);
+
+    virtual ~ConstrainedZmpPreviewController();
+
+    /**
+     *  Computes the optimal input (CoM jerk) subject to bounds on the previewed ZMP and on the CoM jerks.
+     *
+     *  @param zmpRef    \f$\mathbf{P}_r\f$ Horizon of \f$N_p\f$ ZMP references.
+     *  @param comVelRef \f$\tilde{\mathbf{H}}_r\f$ Horizon of \f$N_p\f$ CoM velocities.
+     *  @param hk        Current measured CoM state at time \f$k\f$, i.e. \f$\hat{\mathbf{h}}_k\f$
+     *  @param zmpMin    \f$\mathbf{P}_{\min}\f$ Lower bounds of the ZMP over the preview window. Size \f$2N_p\f$.
+     *  @param zmpMax    \f$\mathbf{P}_{\max}\f$ Upper bounds of the ZMP over the preview window. Size \f$2N_p\f$.
+     *  @param[out] optimalU  Optimal horizon of inputs. Only its first two rows, i.e. \f$\mathbf{u}_{k|k}\f$, are
+     *                        computed. The rest is set to zero.
+     *  @return False if the bounds cannot be satisfied altogether from the current state or if the solver did not
+     *          converge within ZmpPreviewParams::maxActiveSetIterations. optimalU then holds the solution for the
+     *          bounds of the current working set, or the unconstrained solution if the working set became linearly
+     *          dependent.
+     */
+    bool computeConstrainedOptimalInput(const Eigen::VectorXd &zmpRef,
+                                        const Eigen::VectorXd &comVelRef,
+                                        const ComState &hk,
+                                        const Eigen::VectorXd &zmpMin,
+                                        const Eigen::VectorXd &zmpMax,
+                                        Eigen::VectorXd &optimalU);
+
+    /**
+     *  Same as above with the same bounding box of the support polygon over the whole preview window.
+     *
+     *  @param minMaxBoundingBox Bounding box as computed by BaseOfSupport::computeBoundingBox(), i.e. the first row is
+     *                           the minimum corner and the second one the maximum corner.
+     */
+    bool computeConstrainedOptimalInput(const Eigen::VectorXd &zmpRef,
+                                        const Eigen::VectorXd &comVelRef,
+                                        const ComState &hk,
+                                        const Eigen::Matrix2d &minMaxBoundingBox,
+                                        Eigen::VectorXd &optimalU);
+
+    /**
+     *  @return Number of bounds active at the last solution.
+     */
+    unsigned int getNumberOfActiveConstraints() { return _workingRows.size(); };
+
+    /**
+     *  @return Number of active-set iterations of the last call.
+     */
+    unsigned int getNumberOfIterations() { return _iterations; };
+
+private:
+    /**
+     *  Drops the bounds of the first step of the preview window from the working set and moves the others one step
+     *  earlier, to warm start the next call.
+     */
+    void shiftWorkingSet();
+
+    /**
+     *  Computes the Cholesky factor #_L of \f$\mathbf{D}_{\mathcal{W}\mathcal{W}}\f$ from scratch, in place.
+     *
+     *  @return False if the bounds of the working set are linearly dependent.
+     */
+    bool factorizeWorkingSet();
+
+    /**
+     *  Number of rows of \f$\mathbf{G}\f$, i.e. \f$2N_p + 2N_c\f$.
+     */
+    const int nConstraints;
+    /**
+     *  Bound on every component of the CoM jerk, \f$\bar{u}\f$.
+     */
+    const double jerkBound;
+    /**
+     *  Maximum number of active-set iterations per call.
+     */
+    const unsigned int maxIterations;
+    /**
+     *  Full gains of the unconstrained solution, \f$\mathbf{U}_0 = \mathbf{K}^f_p\mathbf{P}_r + \mathbf{K}^f_h\tilde{\mathbf{H}}_r + \mathbf{K}^f_s\hat{\mathbf{h}}_k\f$.
+     */
+    Eigen::MatrixXd KZmpFull;
+    Eigen::MatrixXd KComVelFull;
+    Eigen::Matrix<double, Eigen::Dynamic, 6> KStateFull;
+    /**
+     *  \f$\mathbf{A}_{\text{opt}}^{-1}\mathbf{G}^T\f$ of size \f$2N_c \times (2N_p + 2N_c)\f$.
+     */
+    Eigen::MatrixXd AinvGt;
+    /**
+     *  Dual Hessian \f$\mathbf{D} = \mathbf{G}\mathbf{A}_{\text{opt}}^{-1}\mathbf{G}^T\f$.
+     */
+    Eigen::MatrixXd D;
+    /**
+     *  Rows of \f$\mathbf{G}\f$ in the working set.
+     */
+    std::vector<int> _workingRows;
+    /**
+     *  Side of every bound in the working set: 1 for upper bounds, -1 for lower bounds.
+     */
+    std::vector<double> _workingSides;
+    /**
+     *  Whether every row of \f$\mathbf{G}\f$ is in the working set.
+     */
+    std::vector<bool> _inWorkingSet;
+    /**
+     *  Iterations of the last call.
+     */
+    unsigned int _iterations;
+    /**
+     *  Preallocated vectors used online: \f$\mathbf{U}_0\f$, \f$\mathbf{G}\mathbf{U}_0\f$, \f$\mathbf{G}\mathbf{U}\f$, free
+     *  response \f$\mathbf{G}_p \hat{\mathbf{h}}_k\f$ and bounds.
+     */
+    Eigen::VectorXd _U0;
+    Eigen::VectorXd _freeResponse;
+    Eigen::VectorXd _y0;
+    Eigen::VectorXd _y;
+    Eigen::VectorXd _lower;
+    Eigen::VectorXd _upper;
+    Eigen::VectorXd _zmpMin;
+    Eigen::VectorXd _zmpMax;
+    /**
+     *  Multipliers of the working set and the change of the multipliers per unit of the multiplier of the bound being
+     *  added, \f$\mathbf{z} = \mathbf{L}^{-T}\mathbf{l}\f$. Only their first \f$|\mathcal{W}|\f$ entries are used.
+     */
+    Eigen::VectorXd _mu;
+    Eigen::VectorXd _l;
+    Eigen::VectorXd _z;
+    /**
+     *  Lower Cholesky factor of \f$\mathbf{D}_{\mathcal{W}\mathcal{W}}\f$ in its top-left corner. Updated when a bound is
+     *  added and recomputed when one is dropped.
+     */
+    Eigen::MatrixXd _L;
+};
+
+#endif
@@ -0,0 +1,152 @@
+/*! \file       ContactSequenceEnumerator.h
+ *  \brief      Offline enumeration of the admissible binary contact sequences of the walking MIQP.
+ *  \details    The binary variables of the walking MIQP (\f$\mathbf{\alpha}, \mathbf{\beta}, \delta, \gamma\f$)
+ *              only encode a handful of admissible contact transitions, which are restricted by the
+ *              SSDSAlternation, SingleSupport, ContactConfigHistory and ContactConfigEnforcement
+ *              constraints (see AdmissibilityConstraints). This class lists, for every possible binary
+ *              configuration at time \f$k\f$, all the binary sequences over a preview window of size
+ *              \f$N\f$ that satisfy the purely binary rows of these constraints. Online, the MIQP can then
+ *              be replaced by one continuous QP per candidate sequence (see MIQPController).
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-recipes.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CONTACT_SEQUENCE_ENUMERATOR_H_
+#define _CONTACT_SEQUENCE_ENUMERATOR_H_
+
+#include <vector>
+#include <Eigen/Dense>
+#include <ocra/util/ErrorsHelper.h>
+#include "walking-client/utils.h"
+
+/** Index of the first binary variable (\f$\alpha_x\f$) in both the state and input vectors */
+#define FIRST_BINARY_INDEX 4
+/** Number of binary variables per time step, i.e. \f$\alpha_x, \alpha_y, \beta_x, \beta_y, \delta, \gamma\f$ */
+#define BINARIES_PER_STEP 6
+/** Number of possible binary configurations per time step (\f$2^6\f$) */
+#define BINARY_CONFIGURATIONS 64
+
+class ContactSequenceEnumerator {
+public:
+    /**
+     * Constructor. Keeps only the rows of the constraints
+     * \f[
+     * \mathbf{C}_i \xi_{j} + \mathbf{C}_{ii} \xi_{j+1} \leq \mathbf{d}
+     * \f]
+     * whose coefficients are nonzero exclusively on the binary entries of the state. Rows involving
+     * continuous variables (e.g. SingleSupport) are left to the continuous QP solved per sequence.
+     *
+     * @param Ci           Matrix \f$\mathbf{C}_i\f$ acting on the previous state (see AdmissibilityConstraints).
+     * @param Cii          Matrix \f$\mathbf{C}_{ii}\f$ acting on the next state.
+     * @param d            Constant RHS \f$\mathbf{d}\f$.
+     * @param Ceq          Purely binary equality constraints \f$\mathbf{C}_{eq}\xi_j = 0\f$ (e.g. Simultaneity).
+     *                     Pass an empty matrix if none.
+     * @param N            Size of the preview window.
+     * @param decisionSteps Number of steps (\f$\leq N\f$) over which all admissible transitions are
+     *                     enumerated. The number of sequences grows roughly 4-5 times per step, so for the
+     *                     remaining \f$N - \text{decisionSteps}\f$ steps the contact configuration is held,
+     *                     i.e. no rising/falling edges are allowed (see holdConfiguration()).
+     * @param maxSequences Maximum number of sequences stored per initial binary configuration.
+     */
+    ContactSequenceEnumerator(const Eigen::MatrixXd &Ci,
+                              const Eigen::MatrixXd &Cii,
+                              const Eigen::VectorXd &d,
+                              const Eigen::MatrixXd &Ceq,
+                              unsigned int N,
+                              unsigned int decisionSteps,
+                              unsigned int maxSequences);
+
+    virtual ~ContactSequenceEnumerator();
+
+    /**
+     * Enumerates, through a depth-first search, the admissible sequences for each of the 64 possible
+     * initial binary configurations. Meant to be called once, offline.
+     *
+     * @return Total number of stored sequences.
+     */
+    unsigned int enumerate();
+
+    /**
+     * Returns the admissible sequences starting from the binary configuration contained in \f$\xi_k\f$.
+     * Every sequence is a vector of size \f$6N\f$ with the values of
+     * \f$[\alpha_x, \alpha_y, \beta_x, \beta_y, \delta, \gamma]\f$ for each step of the preview window.
+     *
+     * @param xi_k Current state vector.
+     */
+    const std::vector<Eigen::VectorXd>& getSequences(const Eigen::VectorXd &xi_k) const;
+
+    /**
+     * Encodes the binary entries of a state vector as an integer in \f$[0, 63]\f$.
+     *
+     * @param xi_k State vector of size STATE_VECTOR_SIZE.
+     */
+    static unsigned int encodeBinaries(const Eigen::VectorXd &xi_k);
+
+    /**
+     * @return True if any initial configuration hit #_maxSequences during enumerate().
+     */
+    bool isTruncated() const { return _truncated; };
+
+private:
+    /**
+     * Checks whether the transition between two binary configurations satisfies all the binary rows
+     * of the admissibility constraints and the binary equality constraints of the next configuration.
+     */
+    bool isAdmissibleTransition(unsigned int from, unsigned int to) const;
+
+    /**
+     * Returns the admissible successor of a configuration without rising/falling edges
+     * (\f$\mathbf{\alpha} = \mathbf{\beta} = 0\f$), preferring the one that keeps \f$\delta\f$ and \f$\gamma\f$.
+     *
+     * @param previous Current configuration.
+     * @param[out] next Held configuration.
+     * @return False if no such successor exists.
+     */
+    bool holdConfiguration(unsigned int previous, unsigned int &next) const;
+
+    /**
+     * Recursive depth-first search filling #_sequences[initial].
+     */
+    void search(unsigned int initial, unsigned int step, unsigned int previous, Eigen::VectorXd &sequence);
+
+    /** Binary-only rows of \f$\mathbf{C}_i\f$ restricted to the binary columns */
+    Eigen::MatrixXd _Ci;
+    /** Binary-only rows of \f$\mathbf{C}_{ii}\f$ restricted to the binary columns */
+    Eigen::MatrixXd _Cii;
+    /** Corresponding RHS */
+    Eigen::VectorXd _d;
+    /** Binary equality constraints restricted to the binary columns */
+    Eigen::MatrixXd _Ceq;
+    /** Size of the preview window */
+    unsigned int _N;
+    /** Number of enumerated steps */
+    unsigned int _decisionSteps;
+    /** Maximum number of sequences stored per initial configuration */
+    unsigned int _maxSequences;
+    /** Precomputed transition table: _transitions[from] lists every admissible next configuration */
+    std::vector<std::vector<unsigned int> > _transitions;
+    /** Admissible sequences indexed by the initial binary configuration */
+    std::vector<std::vector<Eigen::VectorXd> > _sequences;
+    /** Whether the enumeration was truncated by #_maxSequences */
+    bool _truncated;
+};
+
+#endif
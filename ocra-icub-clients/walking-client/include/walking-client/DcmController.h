@@ -0,0 +1,128 @@
+/**
+ *  \class DcmController
+ *
+ *  \brief Walking controller tracking the divergent component of motion (DCM) of a footstep plan.
+ *
+ *  \author Jorhabib Eljaik
+ *
+ *  \warning Work in progress! This is still a barebone class in the process of being tested.
+ *
+ *  \details Alternative to ZmpPreviewController for the stepping test. Under the LIPM, the DCM
+ \f$\boldsymbol{\xi} = \mathbf{c} + \dot{\mathbf{c}}/\omega\f$, \f$\omega = \sqrt{g/c_z}\f$, follows
+ \f$\dot{\boldsymbol{\xi}} = \omega(\boldsymbol{\xi} - \mathbf{p})\f$ while the CoM converges to it. The footstep plan
+ (see ZmpFootstep) is split into segments along which the ZMP reference is linear, \f$\mathbf{p}_r(t) = \mathbf{a} + \mathbf{v}t\f$:
+ a double support segment moving the ZMP from the previous footstep and a single support segment holding it. Along a
+ segment of duration \f$T\f$ the DCM reference is
+ \f[
+ \boldsymbol{\xi}_r(t) = \mathbf{a} + \mathbf{v}t + \frac{\mathbf{v}}{\omega} + \left(\boldsymbol{\xi}_0 - \mathbf{a} - \frac{\mathbf{v}}{\omega}\right)e^{\omega t},
+ \qquad
+ \boldsymbol{\xi}_0 = \mathbf{a} + \frac{\mathbf{v}}{\omega} + \left(\boldsymbol{\xi}_T - \mathbf{a} - \mathbf{v}T - \frac{\mathbf{v}}{\omega}\right)e^{-\omega T}
+ \f]
+ where the DCM at the start of every segment \f$\boldsymbol{\xi}_0\f$ is computed once per plan, backwards from the
+ last footstep where the robot comes to rest. The DCM is then tracked with
+ \f[
+ \mathbf{p}_{cmd} = \mathbf{p}_r + \left(1 + \frac{k_{\xi}}{\omega}\right)(\boldsymbol{\xi} - \boldsymbol{\xi}_r)
+ \f]
+ which makes the error decay as \f$\dot{\mathbf{e}} = -k_{\xi}\mathbf{e}\f$, and the CoM reference is integrated from
+ \f$\ddot{\mathbf{c}} = \omega^2(\mathbf{c} - \mathbf{p}_{cmd})\f$. Both only cost a handful of operations per tick.
+ */
+
+#ifndef _DCMCONTROLLER_H_
+#define _DCMCONTROLLER_H_
+
+#include <vector>
+#include <Eigen/Dense>
+#include "walking-client/ZmpReferenceGenerator.h"
+#include "walking-client/ComState.h"
+
+struct DcmControllerParams {
+    /**
+     *  Robot's CoM constant height.
+     */
+    double cz;
+    /**
+     *  DCM tracking gain \f$k_{\xi}\f$ (1/s).
+     */
+    double kDcm;
+
+    /**
+     * Constructor
+     */
+    DcmControllerParams():
+    cz(0.5),
+    kDcm(3.0)
+    {}
+};
+
+class DcmController {
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    /**
+     *  Class constructor.
+     *
+     *  @param period     Period (in ms) of the thread in which an object of this class is created.
+     *  @param parameters \see struct DcmControllerParams.
+     */
+    DcmController(const double period, const DcmControllerParams &parameters);
+
+    virtual ~DcmController();
+
+    /**
+     *  Sets the footstep plan and computes the DCM at the start of each of its segments.
+     *
+     *  @param initialZmp ZMP at the start of the plan, i.e. at time 0.
+     *  @param plan       Footsteps, in the same format accepted by ZmpReferenceGenerator.
+     */
+    void setPlan(const Eigen::Vector2d &initialZmp, const std::vector<ZmpFootstep> &plan);
+
+    /**
+     *  References at a given time of the plan. Beyond the end of the plan the last footstep is held. Successive
+     *  calls are expected with non-decreasing times, for which the cost is constant.
+     *
+     *  @param t             Time (s) since the start of the plan.
+     *  @param[out] zmpRef   \f$\mathbf{p}_r(t)\f$
+     *  @param[out] dcmRef   \f$\boldsymbol{\xi}_r(t)\f$
+     */
+    void getReference(const double t, Eigen::Vector2d &zmpRef, Eigen::Vector2d &dcmRef);
+
+    /**
+     *  Computes the ZMP command tracking the DCM reference, and the CoM state to be requested at the next tick.
+     *
+     *  @param t                Time (s) since the start of the plan.
+     *  @param hk               Current CoM state (position, velocity and acceleration) as used by ZmpPreviewController.
+     *  @param[out] zmpCommand  \f$\mathbf{p}_{cmd}\f$
+     *  @param[out] hkk         CoM state at the next tick under \f$\mathbf{p}_{cmd}\f$.
+     */
+    void computeControl(const double t, const ComState &hk, Eigen::Vector2d &zmpCommand, ComState &hkk);
+
+    /**
+     *  @param hk CoM state.
+     *  @return DCM of the CoM state, \f$\boldsymbol{\xi} = \mathbf{c} + \dot{\mathbf{c}}/\omega\f$.
+     */
+    Eigen::Vector2d computeDcm(const ComState &hk) const;
+
+    /**
+     *  @return Duration (s) of the plan.
+     */
+    double getPlanDuration() const { return _segmentStart.empty() ? 0 : _segmentStart.back() + _segmentDuration.back(); };
+
+private:
+    /** Period in seconds */
+    const double _dt;
+    /** Natural frequency of the LIPM, \f$\omega = \sqrt{g/c_z}\f$ */
+    const double _omega;
+    const double _kDcm;
+    /** Segments of the plan: start time, duration, initial ZMP, ZMP velocity and initial DCM */
+    std::vector<double> _segmentStart;
+    std::vector<double> _segmentDuration;
+    std::vector<Eigen::Vector2d> _segmentZmp;
+    std::vector<Eigen::Vector2d> _segmentZmpVelocity;
+    std::vector<Eigen::Vector2d> _segmentDcm;
+    /** Last footstep of the plan, held at its end */
+    Eigen::Vector2d _finalZmp;
+    /** Segment of the last query */
+    unsigned int _segment;
+};
+
+#endif
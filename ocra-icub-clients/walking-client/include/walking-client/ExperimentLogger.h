@@ -0,0 +1,173 @@
+/*! \file       ExperimentLogger.h
+ *  \brief      Buffered binary logger of the walking experiments.
+ *  \details    Replaces the calls to ocra::utils::writeInFile() of the control loops, each of which opened, appended
+ *              to and closed a text file. The signals to be logged are registered up front as named channels of a
+ *              fixed width, for which ring buffers are preallocated. Logging a sample only copies it into the ring
+ *              buffer of its channel, while a background thread periodically drains the buffers to disk. When a
+ *              buffer is full the sample is dropped and counted rather than blocking the control loop.
+ *
+ *              Every channel is written to <directory>/<name>.bin, created when its first samples are flushed, in
+ *              an append-only columnar format (native byte order):
+ *              \code
+ *              char[8]  "WCLOG001"
+ *              uint32   width, i.e. number of values per sample, not counting the time
+ *              uint32   length of the name
+ *              char[]   name
+ *              // blocks, one per flush
+ *              uint32   number of samples n
+ *              double[n]          time of every sample
+ *              double[n] x width  every value, one column after the other
+ *              \endcode
+ *              so that a file truncated by a crash is still readable up to its last complete block. The files are
+ *              read back with ExperimentLogger::readChannel() and converted to text, CSV or MAT files by
+ *              walking-log-convert (see tools/walking-log-convert.cpp).
+ *
+ *              Every channel is single producer: samples of a channel must always be logged from the same thread.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-recipes.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EXPERIMENT_LOGGER_H_
+#define _EXPERIMENT_LOGGER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Eigen/Dense>
+
+class ExperimentLogger {
+public:
+    /**
+     * Constructor.
+     *
+     * @param directory   Directory where the channels are written. Created by start() if needed.
+     * @param bufferSize  Number of samples buffered per channel.
+     * @param flushPeriod Period in seconds at which the buffers are written to disk.
+     */
+    ExperimentLogger(const std::string &directory, const unsigned int bufferSize = 2000, const double flushPeriod = 0.5);
+
+    /**
+     * Stops the writing thread, flushing the buffers.
+     */
+    virtual ~ExperimentLogger();
+
+    /**
+     * Registers a channel and preallocates its buffer. Channels can only be added before start().
+     *
+     * @param name  Name of the channel, used for its file name.
+     * @param width Number of values per sample, not counting the time.
+     * @return Index of the channel to be passed to log(), or -1 if the channel could not be added.
+     */
+    int addChannel(const std::string &name, const unsigned int width);
+
+    /**
+     * Starts the writing thread.
+     *
+     * @return False if the directory could not be created or the logger was already started.
+     */
+    bool start();
+
+    /**
+     * Writes the remaining samples and stops the writing thread. The logger can't be restarted.
+     */
+    void stop();
+
+    /**
+     * Buffers a sample. Does not allocate nor block.
+     *
+     * @param channel Index returned by addChannel().
+     * @param time    Timestamp of the sample.
+     * @param values  Values of the sample, of the width of the channel.
+     * @return False if the sample was dropped because the logger is not running, the channel or the width is wrong,
+     *         or the buffer of the channel is full.
+     */
+    bool log(const int channel, const double time, const Eigen::Ref<const Eigen::VectorXd> &values);
+
+    /**
+     * Same as above for channels of width 1.
+     */
+    bool log(const int channel, const double time, const double value);
+
+    /**
+     * @return Number of samples dropped so far because the buffers were full.
+     */
+    unsigned long getDroppedSamples() const { return _dropped.load(); };
+
+    /**
+     * @return True between start() and stop().
+     */
+    bool isRunning() const { return _running.load(); };
+
+    /**
+     * Reads a channel written by an ExperimentLogger.
+     *
+     * @param path          Path of the .bin file.
+     * @param[out] name     Name of the channel.
+     * @param[out] samples  One sample per row: the time followed by the values of the sample.
+     * @return False if the file could not be opened or is not a channel. A truncated last block is ignored.
+     */
+    static bool readChannel(const std::string &path, std::string &name, Eigen::MatrixXd &samples);
+
+private:
+    /**
+     * Ring buffer of a channel, written by the control thread and read by the writing thread. Row-major samples of
+     * the time followed by the values.
+     */
+    struct Channel {
+        std::string name;
+        unsigned int width;
+        std::vector<double> buffer;
+        /** Number of samples ever written and read. Only the producer stores written and the consumer read */
+        std::atomic<unsigned long> written;
+        std::atomic<unsigned long> read;
+        FILE *file;
+    };
+
+    /**
+     * Loop of the writing thread.
+     */
+    void writerLoop();
+
+    /**
+     * Writes the samples buffered by every channel.
+     */
+    void flush();
+
+    const std::string _directory;
+    const unsigned int _bufferSize;
+    const double _flushPeriod;
+    std::vector<std::unique_ptr<Channel> > _channels;
+    /** Column-major block being written by flush(), of the size of the largest buffer */
+    std::vector<double> _block;
+    std::atomic<bool> _running;
+    bool _started;
+    std::atomic<unsigned long> _dropped;
+    std::thread _writer;
+    std::mutex _mutex;
+    std::condition_variable _wakeUp;
+};
+
+#endif
@@ -0,0 +1,147 @@
+/**
+ *  \class FootstepAdapter
+ *
+ *  \brief Capture-point based adaptation of the location and duration of the next step.
+ *
+ *  \author Jorhabib Eljaik
+ *
+ *  \warning Work in progress! This is still a barebone class in the process of being tested.
+ *
+ *  \details With the ZMP held at \f$\mathbf{p}\f$, the divergent component of motion (capture point)
+ \f$\boldsymbol{\xi} = \mathbf{c} + \dot{\mathbf{c}}/\omega\f$, \f$\omega = \sqrt{g/c_z}\f$, evolves as
+ \f$\dot{\boldsymbol{\xi}} = \omega(\boldsymbol{\xi} - \mathbf{p})\f$. The error with respect to the reference
+ \f$\mathbf{e} = \boldsymbol{\xi} - \boldsymbol{\xi}_r\f$ under a ZMP tracking error \f$\Delta\mathbf{p} = \mathbf{p} - \mathbf{p}_r\f$
+ is therefore predicted at the landing of the next step, \f$\tau\f$ seconds ahead (at most
+ FootstepAdaptationParams::maxPredictionTime), as
+ \f[
+ \mathbf{e}(\tau) = (\mathbf{e}_0 - \Delta\mathbf{p})e^{\omega\tau} + \Delta\mathbf{p}
+ \f]
+ The reference \f$\boldsymbol{\xi}_r\f$ is the capture point planned by the ZMP references of the preview window,
+ i.e. the bounded solution of \f$\dot{\boldsymbol{\xi}}_r = \omega(\boldsymbol{\xi}_r - \mathbf{p}_r)\f$, see
+ computeCapturePointReference().
+ The next footstep is moved by \f$k\,\mathbf{e}(\tau)\f$, bounded by FootstepAdaptationParams::maxAdjustment and
+ keeping the feet at least FootstepAdaptationParams::minFeetWidth apart laterally. When the bound is reached, the step
+ is shortened down to FootstepAdaptationParams::minStepDuration so that the predicted error at landing matches the
+ bound. Everything is computed in closed form, without allocations, so that it can run at every tick of the walking
+ loop.
+ */
+
+#ifndef _FOOTSTEPADAPTER_H_
+#define _FOOTSTEPADAPTER_H_
+
+#include <Eigen/Dense>
+#include "walking-client/ComState.h"
+
+struct FootstepAdaptationParams {
+    /**
+     *  Adapt the steps of the stepping test.
+     */
+    bool enabled;
+    /**
+     *  Gain \f$k\f$ from the predicted capture point error at landing to the displacement of the footstep.
+     */
+    double gain;
+    /**
+     *  Maximum displacement (m) of a footstep with respect to its planned location, in \f$x\f$ and \f$y\f$.
+     */
+    Eigen::Vector2d maxAdjustment;
+    /**
+     *  Maximum time (s) over which the capture point error is predicted. The prediction assumes the ZMP error to be
+     *  held, while ZmpPreviewController keeps correcting it within the support polygon, so it is only trusted over
+     *  a short horizon.
+     */
+    double maxPredictionTime;
+    /**
+     *  Minimum duration (s) of a step.
+     */
+    double minStepDuration;
+    /**
+     *  Minimum lateral distance (m) between the stance foot and the adapted footstep.
+     */
+    double minFeetWidth;
+    /**
+     *  Robot's CoM constant height.
+     */
+    double cz;
+
+    /**
+     * Constructor
+     */
+    FootstepAdaptationParams():
+    enabled(false),
+    gain(1.0),
+    maxAdjustment(0.05, 0.03),
+    maxPredictionTime(0.3),
+    minStepDuration(0.6),
+    minFeetWidth(0.08),
+    cz(0.5)
+    {}
+};
+
+class FootstepAdapter {
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    FootstepAdapter(const FootstepAdaptationParams &params);
+
+    virtual ~FootstepAdapter();
+
+    /**
+     *  Capture point of a CoM state.
+     *
+     *  @param hk CoM state (position, velocity and acceleration) as used by ZmpPreviewController.
+     *  @return \f$\boldsymbol{\xi} = \mathbf{c} + \dot{\mathbf{c}}/\omega\f$.
+     */
+    Eigen::Vector2d computeCapturePoint(const ComState &hk) const;
+
+    /**
+     *  Capture point planned by a horizon of ZMP references, \f$\boldsymbol{\xi}_r = \omega\int_0^\infty
+     *  e^{-\omega s}\mathbf{p}_r(s)\,ds\f$, with the ZMP held over every sample and after the last one.
+     *
+     *  @param zmpRef \f$\mathbf{P}_r\f$ ZMP references of the preview window, starting at the current time.
+     *  @param dt     Sampling period (s) of the references.
+     *  @return Planned capture point at the current time.
+     */
+    Eigen::Vector2d computeCapturePointReference(const Eigen::VectorXd &zmpRef, const double dt) const;
+
+    /**
+     *  Adapts the next step to the current capture point error.
+     *
+     *  @param hk              Measured CoM state.
+     *  @param capturePointRef Planned capture point, see computeCapturePointReference().
+     *  @param zmp             Measured ZMP.
+     *  @param zmpRef          Reference ZMP.
+     *  @param timeToLanding   Time (s) left until the next step lands, with its planned duration.
+     *  @param stepDuration    Planned duration (s) of the next step.
+     *  @param plannedTarget   Planned horizontal location of the next footstep.
+     *  @param stanceFoot      Horizontal location of the foot that stays on the ground during the next step.
+     *  @param[out] target     Adapted location of the next footstep.
+     *  @param[out] duration   Adapted duration of the next step.
+     *  @return True if the adjustment reached its bounds.
+     */
+    bool adapt(const ComState &hk,
+               const Eigen::Vector2d &capturePointRef,
+               const Eigen::Vector2d &zmp,
+               const Eigen::Vector2d &zmpRef,
+               const double timeToLanding,
+               const double stepDuration,
+               const Eigen::Vector2d &plannedTarget,
+               const Eigen::Vector2d &stanceFoot,
+               Eigen::Vector2d &target,
+               double &duration);
+
+    /**
+     *  @return Capture point error \f$\mathbf{e}(\tau)\f$ predicted at landing by the last call to adapt().
+     */
+    Eigen::Vector2d getPredictedError() const { return _predictedError; };
+
+private:
+    const FootstepAdaptationParams _params;
+    /**
+     *  Natural frequency of the LIPM, \f$\omega = \sqrt{g/c_z}\f$.
+     */
+    const double _omega;
+    Eigen::Vector2d _predictedError;
+};
+
+#endif
@@ -37,7 +37,20 @@
 #include "unsupported/Eigen/MatrixFunctions"
 #include <walking-client/constraints/MIQPLinearConstraints.h>
 #include <walking-client/MIQPState.h>
+#include <walking-client/ContactSequenceEnumerator.h>
+#include <walking-client/MIQPSolutionChannel.h>
+#include <walking-client/MIQPPreviewModel.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/Searchable.h>
+#include <yarp/os/Bottle.h>
 #include "Gurobi.h" // eigen-gurobi
+#include <walking-client/MIQPSolver.h>
+#include <walking-client/ExperimentLogger.h>
+#include <thread>
+#include <atomic>
+#include <limits>
+#include <algorithm>
+#include <cmath>
 
 namespace MIQP{
     enum InputVectorIndex{
@@ -58,6 +71,8 @@ namespace MIQP{
 
 class MIQPController : public yarp::os::RateThread {
 public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
     /**
      * Constructor.
      *
@@ -69,6 +84,15 @@ public:
      */
     MIQPController(MIQPParameters params, ocra::Model::Ptr robotModel, std::shared_ptr<StepController> stepController, const Eigen::MatrixXd &comStateRef);
 
+    /**
+     * Reads the MIQP parameters from the MIQP_CONTROLLER_PARAMS group of a configuration file. MIQPParameters::cz and
+     * MIQPParameters::home are not part of the group and are left untouched.
+     *
+     * @param group          Contents of the MIQP_CONTROLLER_PARAMS group.
+     * @param[out] miqpParams Parameters read from the group, or their defaults when optional.
+     */
+    static void loadParameters(const yarp::os::Searchable &group, MIQPParameters &miqpParams);
+
     /**
      * Destructor
      */
@@ -84,6 +108,47 @@ public:
      */
     virtual bool threadInit();
 
+    /**
+     * Builds the time-invariant parts of the problem around the current state #_xi_k, i.e. everything done by
+     * threadInit() but creating the MIQPState. Offline tools set the state with setState() and call this
+     * method instead of starting the thread.
+     *
+     * @return False if the Gurobi environment could not be created (e.g. no license). The problem matrices
+     *         are built anyway and solveProblem() will only update them.
+     */
+    bool initializeProblem();
+
+    /**
+     * Updates the state-dependent terms of the problem for the current state #_xi_k and solves it. Called by run().
+     *
+     * @param k Iteration used to pick the CoM references in the preview window.
+     * @return True if a new solution was found and published.
+     * @see setCOMStateRefInPreviewWindow()
+     */
+    bool solveProblem(unsigned int k);
+
+    /**
+     * Sets the state of the problem instead of reading it from the robot through MIQPState.
+     *
+     * @param xi_k      State \f$\xi_k\f$. Size STATE_VECTOR_SIZE.
+     * @param timestamp Time (in seconds) at which xi_k was sampled.
+     */
+    void setState(const Eigen::VectorXd &xi_k, double timestamp);
+
+    /**
+     * Uses the given bounding box of the support polygon for the CoP constraints instead of the one computed
+     * from the feet of the robot, until the next call.
+     *
+     * @param minMaxBoundingBox Bounding box as computed by BaseOfSupport::computeBoundingBox().
+     */
+    void setRecordedBoundingBox(const Eigen::Matrix2d &minMaxBoundingBox);
+
+    /** @return Value of the objective function at the last solution, as seen by the solver. */
+    double getObjectiveValue() { return _lastObjective; };
+
+    /** @return Number of branch-and-bound nodes explored at the last solve. */
+    double getNodeCount() { return _lastNodeCount; };
+
     /**
      * Deallocates in memory. In particular, that of the Gurobi environment.
      */
@@ -104,7 +169,9 @@ public:
     virtual void run();
 
     /**
-     Takes \f$N\f$ elements from an original trajectory of desired CoM states from state \f$k\f$
+     Takes \f$N\f$ elements from an original trajectory of desired CoM states from state \f$k\f$. The trajectory is
+     sampled at MIQPParameters::dt, so with a multi-rate preview window the rows matching the knot times
+     MIQPPreviewModel::getPreviewTime() are picked.
 
      @param comStateRef Sets #_H_N_r for a preview window of size N from time k
      */
@@ -117,6 +184,15 @@ public:
     
     void getSolution(Eigen::VectorXd &X_kn);
 
+    /**
+     * Returns the channel through which every new solution is published, timestamped with the time at
+     * which the state \f$\xi_k\f$ was sampled. Clients should sample it through MIQPSolutionChannel::update()
+     * and MIQPSolutionChannel::sample() instead of polling getSolution().
+     *
+     * @see #_solutionChannel
+     */
+    std::shared_ptr<MIQPSolutionChannel> getSolutionChannel() { return _solutionChannel; };
+
 protected:
     // MARK: - PROTECTED METHODS
     /**
@@ -251,9 +327,11 @@ protected:
          \end{array}\right]
         \f]
      *
+     * With a multi-rate preview window \f$\mathbf{Q}^j\f$ is the product of the \f$\mathbf{Q}_j\f$ of the first \f$j\f$ steps.
+     *
      * @param C Output matrix from a state space representation.
      * @param P Output.
-     * @see #_Q, #_T
+     * @see #_previewModel, MIQPPreviewModel::buildPreviewStateMatrix()
      */
     void buildPreviewStateMatrix(const Eigen::MatrixXd &C, Eigen::MatrixXd &P);
 
@@ -269,9 +347,11 @@ protected:
          \end{array}\right]
        \f]
      *
+     * With a multi-rate preview window see MIQPPreviewModel::buildPreviewInputMatrix().
+     *
      * @param C Output matrix from a state space representation.
      * @param[out] R Output.
-     * @see #_Q, #_T
+     * @see #_previewModel
      */
     void buildPreviewInputMatrix(const Eigen::MatrixXd &C, Eigen::MatrixXd &R);
     
@@ -335,15 +415,37 @@ protected:
     void buildMinimizeSteppingReg(MIQPParameters &miqpParams);
     
     void setBinaryVariables();
+
+    /**
+     * Builds the time-invariant terms of the move-blocked problem, solved on \f$\mathbf{z}\f$ with
+     * \f$\mathcal{X}_{k,N} = \mathbf{M}\mathbf{z}\f$: \f$\mathbf{M}^T\mathbf{H}_N\mathbf{M}\f$,
+     * \f$\mathbf{A}_{\text{eq}}\mathbf{M}\f$, \f$\mathbf{A}_{\text{ineq}}\mathbf{M}\f$ and the bounds on \f$\mathbf{z}\f$.
+     * Only the linear term of the cost has to be projected at every iteration.
+     *
+     * @see MIQPPreviewModel::getBlockingMatrix(), MIQPParameters::binaryBlocks
+     */
+    void buildBlockedProblem();
+
+    /**
+     * Alternative to the MIQP solve used when MIQPParameters::explicitModeSequences is set. Retrieves the
+     * admissible contact sequences precomputed by #_sequenceEnumerator for the binary configuration of
+     * #_xi_k and, for each of them, solves the continuous QP obtained by fixing the binary variables
+     * through their lower and upper bounds. The candidates are distributed over #_qpWorkers and the
+     * solution with the lowest cost \f$\mathcal{X}^T \mathbf{H}_N \mathcal{X} + \mathbf{d}^T \mathcal{X}\f$ is kept.
+     *
+     * @param[out] X_kn Best solution among the feasible candidates.
+     * @return False if no candidate sequence was feasible.
+     * @see ContactSequenceEnumerator
+     */
+    bool solveModeSequences(Eigen::VectorXd &X_kn);
     
     /**
-     * Writes optimization result to file for plotting.
+     * Logs the optimization result for plotting, in the channel "solution" of #_logger.
      * 
      * @param time Timestamp.
      * @param X_kn result of optimization.
-     * @param home Root directory where to write the file.
      */
-    void writeToFile(const double& time, const Eigen::VectorXd& X_kn, std::string& home);
+    void writeToFile(const double& time, const Eigen::VectorXd& X_kn);
     
 private:
     // MARK: - PRIVATE VARIABLES
@@ -430,6 +532,27 @@ private:
      */
     Eigen::VectorXd _X_kn;
 
+    /** Time (in seconds) at which #_xi_k was last updated */
+    double _xi_k_timestamp;
+
+    /** Preview model over the (possibly multi-rate) preview window, shared with MIQPLinearConstraints */
+    std::shared_ptr<MIQPPreviewModel> _previewModel;
+
+    /** Lock-free channel publishing #_X_kn to the walking-client loop */
+    std::shared_ptr<MIQPSolutionChannel> _solutionChannel;
+
+    /** True if #_recordedBoundingBox is used for the CoP constraints. Set by setRecordedBoundingBox() */
+    bool _useRecordedBoundingBox;
+
+    /** Bounding box of the support polygon given by setRecordedBoundingBox() */
+    Eigen::Matrix2d _recordedBoundingBox;
+
+    /** Objective value at the last solution */
+    double _lastObjective;
+
+    /** Branch-and-bound nodes explored at the last solve */
+    double _lastNodeCount;
+
     /**
      *  State matrix \f$A_h\f$ from the CoM jerk integration scheme.
      *
@@ -805,8 +928,29 @@ private:
      */
     Eigen::MatrixXd _rhs_2_eq;
 
-    /** eigen-gurobi object */
-    Eigen::GurobiDense _eigGurobi;
+    /** eigen-gurobi object. Null if the Gurobi environment could not be created */
+    std::shared_ptr<MIQPSolver> _eigGurobi;
+
+    /** Precomputed admissible contact sequences. Only used when MIQPParameters::explicitModeSequences is set */
+    std::shared_ptr<ContactSequenceEnumerator> _sequenceEnumerator;
+
+    /** One continuous eigen-gurobi problem per solver thread. Only used when MIQPParameters::explicitModeSequences is set */
+    std::vector<std::shared_ptr<MIQPSolver> > _qpWorkers;
+
+    /** \f$\mathbf{M}^T\mathbf{H}_N\mathbf{M}\f$. Only used when the preview window is move-blocked */
+    Eigen::MatrixXd _H_N_blocked;
+
+    /** \f$\mathbf{A}_{\text{eq}}\mathbf{M}\f$. Only used when the preview window is move-blocked */
+    Eigen::MatrixXd _Aeq_blocked;
+
+    /** \f$\mathbf{A}_{\text{ineq}}\mathbf{M}\f$. Only used when the preview window is move-blocked */
+    Eigen::MatrixXd _Aineq_blocked;
+
+    /** Lower bounds of \f$\mathbf{z}\f$. Only used when the preview window is move-blocked */
+    Eigen::VectorXd _lb_blocked;
+
+    /** Upper bounds of \f$\mathbf{z}\f$. Only used when the preview window is move-blocked */
+    Eigen::VectorXd _ub_blocked;
 
     /** Linear constraints object */
     std::shared_ptr<MIQPLinearConstraints> _constraints;
@@ -819,6 +963,29 @@ private:
 
     /** Current iteration */
     unsigned int _k;   
+
+    /** Logger of run(), writing to MIQPParameters::home + "MIQP/". Started by threadInit() */
+    std::shared_ptr<ExperimentLogger> _logger;
+
+    /** Channels of #_logger: recorded states for miqp-replay, solution and first preview window */
+    int _replayChannel;
+    int _solutionLogChannel;
+    int _solutionInPreviewChannel;
+    int _copInPreviewChannel;
+    int _bosInPreviewChannel;
+    int _comInPreviewChannel;
+    int _comRefInPreviewChannel;
+
+    /** Sample of the replay channel: state vector followed by the CoM state reference. Size: [STATE_VECTOR_SIZE + 6] */
+    Eigen::VectorXd _replaySample;
+
+    /** Timestamps of the steps of the first preview window. Size: [N] */
+    std::vector<double> _tPreview;
+
+    /** Previewed CoP, center of the BoS and CoM state of the first preview window. Sizes: [2N], [2N], [6N] */
+    Eigen::VectorXd _P_kN;
+    Eigen::VectorXd _r_kN;
+    Eigen::VectorXd _H_kN;
     
     ///////////////// Regularization Variables ///////////////////////////
     Eigen::MatrixXd _S_wu;
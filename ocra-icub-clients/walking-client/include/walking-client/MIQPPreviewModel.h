@@ -0,0 +1,193 @@
+/*! \file       MIQPPreviewModel.h
+ *  \brief      Preview model of the walking MIQP over a (possibly multi-rate) preview window.
+ *  \details    The preview window of size \f$N\f$ does not need to be uniformly sampled. Given the duration
+ *              \f$\delta t_j\f$ of every step \f$j\f$ of the window (see MIQPParameters::dtPreview), the state
+ *              evolves as
+ *              \f[
+ *              \xi_{k+j+1|k} = \mathbf{Q}_j \xi_{k+j|k} + \mathbf{T}_j \mathcal{X}_{k+j+1|k}
+ *              \f]
+ *              where \f$\mathbf{Q}_j\f$ and \f$\mathbf{T}_j\f$ are built from \f$\mathbf{A}_h(\delta t_j)\f$ and
+ *              \f$\mathbf{B}_h(\delta t_j)\f$. This class builds the preview matrices shared by MIQPController,
+ *              MIQPLinearConstraints and BaseOfSupport. With a uniform window they reduce to the usual
+ *              lower-triangular Toeplitz matrices in powers of \f$\mathbf{Q}\f$.
+ *
+ *              The preview window can also be move-blocked (see MIQPParameters::binaryBlocks): the binary
+ *              variables are held constant over blocks of consecutive steps, so that the MIQP is solved on a
+ *              reduced vector \f$\mathbf{z}\f$ with \f$\mathcal{X}_{k,N} = \mathbf{M}\mathbf{z}\f$.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-recipes.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MIQP_PREVIEW_MODEL_H_
+#define _MIQP_PREVIEW_MODEL_H_
+
+#include <vector>
+#include <algorithm>
+#include <Eigen/Dense>
+#include <ocra/util/ErrorsHelper.h>
+#include "walking-client/utils.h"
+
+class MIQPPreviewModel {
+public:
+    /**
+     * Builds \f$\mathbf{Q}_j\f$ and \f$\mathbf{T}_j\f$ for every step of the preview window.
+     *
+     * @param miqpParams MIQP parameters. Uses MIQPParameters::N and MIQPParameters::dtPreview.
+     */
+    MIQPPreviewModel(const MIQPParameters &miqpParams);
+
+    virtual ~MIQPPreviewModel();
+
+    /** @return Size of the preview window. */
+    unsigned int getN() const { return _N; };
+
+    /** @return \f$\mathbf{Q}_j\f$. */
+    const Eigen::MatrixXd& getQ(unsigned int j) const { return _Q[j]; };
+
+    /** @return \f$\mathbf{T}_j\f$. */
+    const Eigen::MatrixXd& getT(unsigned int j) const { return _T[j]; };
+
+    /** @return Duration in seconds of step \f$j\f$ of the preview window. */
+    double getStepDuration(unsigned int j) const { return _dt[j]; };
+
+    /** @return Time in seconds from \f$k\f$ to the \f$j\f$-th knot of the preview window (\f$j \in [0,N]\f$). */
+    double getPreviewTime(unsigned int j) const { return _t[j]; };
+
+    /** @return Times in seconds from \f$k\f$ to every knot of the preview window. Size \f$N+1\f$. */
+    const std::vector<double>& getPreviewTimes() const { return _t; };
+
+    /**
+     * Builds a Preview State Matrix for the preview window:
+     * \f[
+     \mathbf{P} = \left[\begin{array}{c}
+     \mathbf{C} \mathbf{Q}_0 \\
+     \mathbf{C} \mathbf{Q}_1 \mathbf{Q}_0 \\
+     \vdots\\
+     \mathbf{C} \mathbf{Q}_{N-1} \cdots \mathbf{Q}_0
+     \end{array}\right]
+     \f]
+     *
+     * @param C Output matrix from a state space representation.
+     * @param[out] P Output of size \f$N\,\text{rows}(C) \times 16\f$.
+     */
+    void buildPreviewStateMatrix(const Eigen::MatrixXd &C, Eigen::MatrixXd &P) const;
+
+    /**
+     * Builds a Preview Input Matrix for the preview window, whose block \f$(j,i)\f$ for \f$i \leq j\f$ is
+     * \f$\mathbf{C}\mathbf{Q}_j \cdots \mathbf{Q}_{i+1}\mathbf{T}_i\f$.
+     *
+     * @param C Output matrix from a state space representation.
+     * @param[out] R Output of size \f$N\,\text{rows}(C) \times 12N\f$.
+     */
+    void buildPreviewInputMatrix(const Eigen::MatrixXd &C, Eigen::MatrixXd &R) const;
+
+    /**
+     * Builds the preview matrices of constraints coupling two consecutive states,
+     * \f$\mathbf{A}_{cl}\xi_{k+j} + \mathbf{A}_{cr}\xi_{k+j+1} \leq \mathbf{f}_c\f$, such that over the
+     * preview window \f$\mathbf{A}\mathcal{X}_{k,N} \leq \bar{\mathbf{f}}_c - \mathbf{B}\xi_k\f$.
+     *
+     * @param Acl Matrix acting on the previous state.
+     * @param Acr Matrix acting on the next state.
+     * @param[out] A Input matrix.
+     * @param[out] B State matrix.
+     * @see MIQPLinearConstraints::buildShapeAndAdmissibilityInPreviewWindow()
+     */
+    void buildCoupledPreviewMatrices(const Eigen::MatrixXd &Acl, const Eigen::MatrixXd &Acr, Eigen::MatrixXd &A, Eigen::MatrixXd &B) const;
+
+    /** @return True if the binary variables are held constant over blocks of steps. */
+    bool isBlocked() const { return _blocked; };
+
+    /** @return Number of blocks of the preview window. Equal to \f$N\f$ when it is not blocked. */
+    unsigned int getNumberOfBlocks() const { return _nBlocks; };
+
+    /** @return Size of the reduced vector \f$\mathbf{z}\f$: 6 continuous variables per step and 6 binaries per block. */
+    unsigned int getReducedSize() const { return _M.cols(); };
+
+    /** @return Index in \f$\mathbf{z}\f$ of the first binary variable. Binaries of block \f$b\f$ start at this index plus \f$6b\f$. */
+    unsigned int getFirstReducedBinaryIndex() const { return CONTINUOUS_PER_STEP*_N; };
+
+    /**
+     * Blocking matrix \f$\mathbf{M}\f$ of size \f$12N \times\f$ getReducedSize() such that \f$\mathcal{X}_{k,N} = \mathbf{M}\mathbf{z}\f$.
+     * The first \f$6N\f$ entries of \f$\mathbf{z}\f$ are \f$(\mathbf{a},\mathbf{b},\mathbf{u})\f$ of every step, followed by
+     * \f$(\alpha,\beta,\delta,\gamma)\f$ of every block. Every row of \f$\mathbf{M}\f$ has a single unit entry.
+     */
+    const Eigen::MatrixXd& getBlockingMatrix() const { return _M; };
+
+    /**
+     * Maps bounds on \f$\mathcal{X}_{k,N}\f$ to bounds on \f$\mathbf{z}\f$.
+     *
+     * @param lb Lower bounds on \f$\mathcal{X}_{k,N}\f$.
+     * @param ub Upper bounds on \f$\mathcal{X}_{k,N}\f$.
+     * @param[out] zlb Lower bounds on \f$\mathbf{z}\f$.
+     * @param[out] zub Upper bounds on \f$\mathbf{z}\f$.
+     */
+    void reduceBounds(const Eigen::VectorXd &lb, const Eigen::VectorXd &ub, Eigen::VectorXd &zlb, Eigen::VectorXd &zub) const;
+
+    /**
+     *  Builds \f$A_h\f$ for a sampling period dt.
+     *
+     *  @param dt Sampling period in seconds.
+     *  @param[out] Ah Output of size \f$6\times6\f$.
+     */
+    static void buildAh(double dt, Eigen::MatrixXd &Ah);
+
+    /**
+     *  Builds \f$B_h\f$ for a sampling period dt.
+     *
+     *  @param dt Sampling period in seconds.
+     *  @param[out] Bh Output of size \f$6\times2\f$.
+     */
+    static void buildBh(double dt, Eigen::MatrixXd &Bh);
+
+private:
+    /** Number of continuous variables (a, b, u) in every step */
+    static const unsigned int CONTINUOUS_PER_STEP = 6;
+
+    /**
+     * Builds #_M from MIQPParameters::binaryBlocks.
+     *
+     * @param binaryBlocks Number of steps of every block. Ignored (no blocking) if empty or if it does not sum up to \f$N\f$.
+     */
+    void buildBlockingMatrix(const std::vector<unsigned int> &binaryBlocks);
+
+    /** Size of the preview window */
+    unsigned int _N;
+    /** Step durations in seconds */
+    std::vector<double> _dt;
+    /** Knot times in seconds. Size \f$N+1\f$ */
+    std::vector<double> _t;
+    /** \f$\mathbf{Q}_j\f$ for every step */
+    std::vector<Eigen::MatrixXd> _Q;
+    /** \f$\mathbf{T}_j\f$ for every step */
+    std::vector<Eigen::MatrixXd> _T;
+    /** \f$\Phi_j = \mathbf{Q}_{j-1}\cdots\mathbf{Q}_0\f$, with \f$\Phi_0 = \mathbf{I}\f$. Size \f$N+1\f$ */
+    std::vector<Eigen::MatrixXd> _Phi;
+    /** True if the preview window is move-blocked */
+    bool _blocked;
+    /** Number of blocks */
+    unsigned int _nBlocks;
+    /** Blocking matrix */
+    Eigen::MatrixXd _M;
+    /** For every column of #_M, one row in which it has its unit entry */
+    std::vector<unsigned int> _reducedToFull;
+};
+
+#endif
@@ -0,0 +1,115 @@
+/*! \file       MIQPSolutionChannel.h
+ *  \brief      Lock-free handoff of the MIQP solution to the walking loop.
+ *  \details    The MIQP thread (producer) publishes a timestamped preview solution \f$\mathcal{X}_{k,N}\f$
+ *              together with the state \f$\xi_k\f$ it was computed from. The walking-client loop (consumer)
+ *              picks up the latest published solution and samples it at its own timestamp. Both sides work
+ *              on a triple buffer whose slots are allocated once at construction, so neither publish() nor
+ *              update()/sample() lock or allocate, and sample() is \f$O(\log N)\f$.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-recipes.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MIQP_SOLUTION_CHANNEL_H_
+#define _MIQP_SOLUTION_CHANNEL_H_
+
+#include <atomic>
+#include <vector>
+#include <Eigen/Dense>
+#include "walking-client/utils.h"
+
+class MIQPSolutionChannel {
+public:
+    /**
+     * Constructor. Allocates the three slots of the buffer.
+     *
+     * @param knotTimes Times in seconds from \f$k\f$ to every knot of the preview window (size \f$N+1\f$,
+     *                  starting at 0). They need not be uniformly spaced, see MIQPPreviewModel::getPreviewTimes().
+     */
+    MIQPSolutionChannel(const std::vector<double> &knotTimes);
+
+    virtual ~MIQPSolutionChannel();
+
+    /**
+     * Producer side. Copies a new solution into the back slot and swaps it with the middle one.
+     * Must be called from a single thread (the MIQP thread).
+     *
+     * @param timestamp Time (in seconds) at which \f$\xi_k\f$ was sampled.
+     * @param xi_k      State used to compute the solution. Size STATE_VECTOR_SIZE.
+     * @param X_kn      MIQP solution over the preview window. Size INPUT_VECTOR_SIZE*N.
+     */
+    void publish(double timestamp, const Eigen::VectorXd &xi_k, const Eigen::VectorXd &X_kn);
+
+    /**
+     * Consumer side. Swaps the front slot with the middle one if a new solution has been published.
+     * Must be called from a single thread (the walking-client loop).
+     *
+     * @return True if a new solution was picked up.
+     */
+    bool update();
+
+    /**
+     * @return True once at least one solution has been picked up by update().
+     */
+    bool isValid() const { return _buffers[_front].timestamp >= 0; };
+
+    /**
+     * Consumer side. Samples the solution in the front slot at time t. The CoM jerk is piecewise constant
+     * over each step of the preview window, while the bounds \f$\mathbf{a}\f$ and \f$\mathbf{b}\f$ of the base of support
+     * are linearly interpolated between \f$\xi_k\f$ and the previewed states. Times outside of the preview
+     * window are clamped.
+     *
+     * @param t         Time (in seconds) at which the solution is sampled.
+     * @param[out] jerk CoM jerk reference \f$\mathbf{u}\f$.
+     * @param[out] a    Upper bounds of the BoS.
+     * @param[out] b    Lower bounds of the BoS.
+     */
+    void sample(double t, Eigen::Vector2d &jerk, Eigen::Vector2d &a, Eigen::Vector2d &b) const;
+
+    /**
+     * @return Timestamp of the solution in the front slot (negative if none).
+     */
+    double getTimestamp() const { return _buffers[_front].timestamp; };
+
+private:
+    struct Slot {
+        double timestamp;
+        Eigen::VectorXd xi_k;
+        Eigen::VectorXd X_kn;
+    };
+
+    /** Flag set on #_middle when it holds a solution not yet picked up by the consumer */
+    static const unsigned int FRESH = 4;
+
+    /** Size of the preview window */
+    unsigned int _N;
+    /** Times in seconds from \f$k\f$ to every knot of the preview window */
+    std::vector<double> _knotTimes;
+    /** The three slots of the buffer */
+    Slot _buffers[3];
+    /** Slot written by the producer. Only touched by the producer */
+    unsigned int _back;
+    /** Slot exchanged between producer and consumer, plus the #FRESH flag */
+    std::atomic<unsigned int> _middle;
+    /** Slot read by the consumer. Only touched by the consumer */
+    unsigned int _front;
+};
+
+#endif
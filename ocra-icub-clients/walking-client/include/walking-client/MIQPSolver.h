@@ -0,0 +1,52 @@
+/*! \file       MIQPSolver.h
+ *  \brief      eigen-gurobi problem exposing the statistics of the last solve.
+ *  \details    Eigen::GurobiDense only reports the solution and the solver status. The MIQP benchmark and the
+ *              logs of MIQPController also need the objective value, the number of explored branch-and-bound
+ *              nodes and Gurobi's own runtime, which are read here from the underlying Gurobi model.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-recipes.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MIQP_SOLVER_H_
+#define _MIQP_SOLVER_H_
+
+#include "gurobi_c++.h"
+#include "Gurobi.h" // eigen-gurobi
+
+class MIQPSolver : public Eigen::GurobiDense {
+public:
+    /**
+     * @return Objective value of the last solve, as seen by Gurobi (i.e. \f$\frac{1}{2}x^TQx + c^Tx\f$).
+     */
+    double getObjectiveValue() { return model_.get(GRB_DoubleAttr_ObjVal); };
+
+    /**
+     * @return Number of branch-and-bound nodes explored in the last solve. Zero for continuous problems.
+     */
+    double getNodeCount() { return model_.get(GRB_IntAttr_IsMIP) ? model_.get(GRB_DoubleAttr_NodeCount) : 0; };
+
+    /**
+     * @return Wall-clock time in seconds spent by Gurobi in the last solve.
+     */
+    double getRuntime() { return model_.get(GRB_DoubleAttr_Runtime); };
+};
+
+#endif
@@ -126,14 +126,26 @@ namespace MIQP{
          */
         double _PzThreshold; // m
 
+        /*
+         * Threshold used to detect a change in the bounds of the BoS
+         */
+        double _changeThreshold; // m
+
     public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-        MIQPState (ocra::Model::Ptr robotModel, std::string robot);
+        /**
+         * Constructor.
+         *
+         * @param robotModel Robot model.
+         * @param miqpParams MIQP parameters. Uses MIQPParameters::robot and the contact and change thresholds.
+         */
+        MIQPState (ocra::Model::Ptr robotModel, const MIQPParameters &miqpParams);
 
         virtual ~MIQPState ();
 
         /**
-         * Open and connects ports to F/T sensors in the feet of the robot and sets some thresholds.
+         * Open and connects ports to F/T sensors in the feet of the robot.
          *
          * @return True if everything ends successfully.
          */
@@ -15,6 +15,7 @@
 #define _STEPCONTROLLER_H_
 
 #include <ocra-recipes/TrajectoryThread.h>
+#include <ocra-icub/FootContactManager.h>
 #include "walking-client/utils.h"
 
 class StepController {
@@ -29,17 +30,16 @@ public:
     bool initialize();
 
     /**
-     *  Remember the right and left feet contact tasks? created in initialize().
-     * This method asks the ocra-icub-server to deactivate one by one the feet
-     * "corner" contact tasks for the specified foot.
+     *  Asks the ocra-icub-server to deactivate the "corner" contact tasks of the
+     * specified foot, all of them on the same control tick.
      *
      *  @param foot LEFT_FOOT or RIGHT_FOOT.
      */
     void deactivateFeetContacts(FOOT foot);
 
     /**
-     *  This method asks the ocra-icub-server to activate one by one the feet
-     * "corner" contact tasks for the specified foot.
+     *  Asks the ocra-icub-server to activate the "corner" contact tasks of the
+     * specified foot, all of them on the same control tick.
      *
      *  @param foot LEFT_FOOT or RIGHT_FOOT.
      */
@@ -102,17 +102,16 @@ public:
      */
     Eigen::MatrixXd getContact2DCoordinates();
 
+    /**
+     * Same as above, without reallocating coordinates while the number of active contacts does not change.
+
+     @param[out] coordinates Matrix of 2D coordinates of the contact points defined at task level.
+     */
+    void getContact2DCoordinates(Eigen::MatrixXd &coordinates);
+
 
 private:
-    std::vector<ocra_recipes::TaskConnection::Ptr> _contactsCollection;
-    ocra_recipes::TaskConnection::Ptr _LeftFootContact_BackLeft;
-    ocra_recipes::TaskConnection::Ptr _LeftFootContact_FrontLeft;
-    ocra_recipes::TaskConnection::Ptr _LeftFootContact_BackRight;
-    ocra_recipes::TaskConnection::Ptr _LeftFootContact_FrontRight;
-    ocra_recipes::TaskConnection::Ptr _RightFootContact_BackLeft;
-    ocra_recipes::TaskConnection::Ptr _RightFootContact_FrontLeft;
-    ocra_recipes::TaskConnection::Ptr _RightFootContact_BackRight;
-    ocra_recipes::TaskConnection::Ptr _RightFootContact_FrontRight;
+    std::shared_ptr<ocra_icub::FootContactManager> _footContacts;
     std::shared_ptr<ocra_recipes::TrajectoryThread> _leftFoot_TrajThread;
     std::shared_ptr<ocra_recipes::TrajectoryThread> _rightFoot_TrajThread;
     Eigen::Vector3d target;
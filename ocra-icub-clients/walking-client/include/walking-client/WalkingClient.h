@@ -6,10 +6,15 @@
 #include <ocra-recipes/ControllerClient.h>
 #include <ocra/util/EigenUtilities.h>
 #include "walking-client/ZmpPreviewController.h"
+#include "walking-client/ConstrainedZmpPreviewController.h"
+#include "walking-client/ZmpReferenceGenerator.h"
+#include "walking-client/FootstepAdapter.h"
+#include "walking-client/DcmController.h"
+#include "walking-client/ExperimentLogger.h"
 #include "walking-client/StepController.h"
 #include "walking-client/utils.h"
 #include "walking-client/MIQPController.h"
-#include "walking-client/Interpolator.h"
+#include "walking-client/MIQPSolutionChannel.h"
 #include <ocra/util/FileOperations.h>
 #include <yarp/os/Time.h>
 #include "gurobi_c++.h"
@@ -20,6 +25,8 @@ class WalkingClient : public ocra_recipes::ControllerClient
 DEFINE_CLASS_POINTER_TYPEDEFS(WalkingClient)
 
 public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
     WalkingClient (std::shared_ptr<ocra::Model> modelPtr, const int loopPeriod);
     virtual ~WalkingClient ();
 
@@ -55,18 +62,6 @@ public:
     void printHelp();
 
 
-    /**
-     If miqpPeriod/clientPeriod samples have passed, this method asks for the MIQP solution.
-
-     @param miqpPeriod Period of the MIQP thread.
-     @param miqpPreviewPeriod Period used to discretize the MIQP
-     @param clientPeriod Period of the current client thread.
-     @param[out] Preview solution from the MIQP.
-     @param[out] tPreview time vector in preview used by the client
-     @return True if the right amount of time has passed, false otherwise.
-     */
-    bool queryMIQPSolution(const int miqpPeriod, const int miqpPreviewPeriod, const int clientPeriod, Eigen::VectorXd &preview, Eigen::VectorXd &tPreview);
-
     /**
      Reads the raw wrench published for the corresponding analog force/torque sensors in iCub's feet.
 
@@ -161,16 +156,54 @@ public:
     std::string composePortName(std::string portName);
 
     void findZMPPreviewControllerParams(yarp::os::ResourceFinder &rf);
+
+    /**
+     Computes optimalU for the current ZMP and CoM velocity references in the preview window. When ZmpPreviewParams::constrained
+     is set, the previewed ZMP is kept inside the support box planned for every step of the window by
+     ZmpReferenceGenerator::getSupportWindow(), or inside the bounding box of the active contacts for the tests without a
+     footstep plan. Both are shrunk by ZmpPreviewParams::zmpMargin.
+
+     @param hk Current CoM state.
+     */
+    void computeZMPPreviewInput(const ComState &hk);
     void findGeneralTestsParams(yarp::os::ResourceFinder &rf);
     void findCOMLinVelConstRefParams(yarp::os::ResourceFinder &rf);
     void findZMPConstRefParams(yarp::os::ResourceFinder &rf);
     void findSingleStepTestParams(yarp::os::ResourceFinder &rf);
     void findZMPVaryingReferenceParams(yarp::os::ResourceFinder &rf);
     void findMIQPParams(yarp::os::ResourceFinder &rf);
+
+    /**
+     Builds the CoM state reference passed to MIQPController, sampled every MIQPParameters::dt. The CoM position is held
+     at its initial value and the velocity at (MIQPParameters::dCoMxRef, MIQPParameters::dCoMyRef). With
+     MIQPParameters::comRampSamples > 0 the velocity starts at rest and ramps up linearly over that many samples. It is
+     then held, or, with MIQPParameters::comCruiseSamples > 0, held for that many samples and ramped down to rest.
+
+     @param[out] comStateRef Matrix of CoM states, one per row.
+     */
+    void buildCoMStateRef(Eigen::MatrixXd &comStateRef);
     void findSteppingTestParams(yarp::os::ResourceFinder &rf);
+    void findFootstepAdaptationParams(yarp::os::ResourceFinder &rf);
+    void findDCMControllerParams(yarp::os::ResourceFinder &rf);
+
+    /**
+     Performs the stepping test tracking the DCM of the footstep plan with DcmController instead of tracking its ZMP
+     with the preview controller. Selected with --test dcm.
+     */
+    void performDCMTest();
+
+    /**
+     Registers the channels logged by the test being run and starts the experiment logger, which writes them to the data
+     directory of the test, e.g. homeDataDir/steppingTests/. Tests other than the ZMP, single step, stepping and DCM ones
+     don't log anything here.
+
+     @return False if the logger could not be started.
+     */
+    bool startExperimentLogger();
 
     /**
      Takes an std::Vector of ZMP trajectories at time \f$k\f$ and outputs the ZMP samples from time \f$k\f$ until \f$k + N_c\f$s, i.e. the ZMP preview window.
+     Samples past the end of the trajectory take the value of its last element.
 
      @param fullTraj Vector of horizontal ZMP positions.
      @param from Index in the vector corresponding to the current time instant.
@@ -200,15 +233,31 @@ public:
     void generateStepPattern();
 
     /**
-     Generates a ZMP trajectory for the STEPPING_TEST. Uses the step pattern generated by @ref generateStepPattern.
+     Generates the ZMP footsteps of the STEPPING_TEST, also used by the DCM test. Uses the step pattern generated by
+     @ref generateStepPattern. The ZMP starts between the feet, moves to the left foot, follows the step targets and
+     comes back between the last two of them. The plan is also written to steppingTests/footstepPlan.txt in the data
+     directory, one footstep per line as x y dsDuration ssDuration.
+
+     @return Footsteps of the plan. The first one starts at the initial ZMP.
     */
-    std::vector<Eigen::Vector2d> generateZMPSteppingTrajectory();
+    std::vector<ZmpFootstep> generateSteppingTestFootsteps();
 
     /**
      Manages the step switching for the STEPPING_TEST.
     */
     void startSteppinMotherFucker(int &stepTrigger, double &error);
 
+    /**
+     Adapts the location and duration of the step following the one in progress to the capture point error, see
+     FootstepAdapter. The steps after it are moved rigidly with it, together with the queued ZMP footsteps. Does
+     nothing when no step is in progress.
+
+     @param hk Measured CoM state.
+     @param zmpRef Current ZMP reference. The capture point reference is planned from the ZMP references of the whole
+     preview window, zmpRefInPreviewWindow.
+    */
+    void adaptNextStep(const ComState &hk, const Eigen::Vector2d &zmpRef);
+
     /**
      Prepares an object of type ocra::TaskState with the com state passed to this method and when doSet is true, applies the control to the robot.
 
@@ -216,7 +265,7 @@ public:
      @param doSet True if the desired state is to be set. False otherwise.
      @todo Change input to this method to just com acceleration.
      */
-    void prepareAndsetDesiredCoMTaskState(Eigen::VectorXd comState, bool doSet);
+    void prepareAndsetDesiredCoMTaskState(const ComState &comState, bool doSet);
 
 
 
@@ -233,17 +282,32 @@ private:
     std::vector<FOOT> _stepOrder;
     Eigen::MatrixXd _stepTargets;
     Eigen::VectorXd _stepTargetDurations;
+    /** Step targets and durations as planned by generateStepPattern(), before their adaptation */
+    Eigen::MatrixXd _plannedStepTargets;
+    Eigen::VectorXd _plannedStepTargetDurations;
+    /** Time at which the step in progress started */
+    double _stepStartTime;
+    FootstepAdaptationParams _footstepAdaptationParams;
+    /** Adapts the steps of the stepping test when enabled, null otherwise */
+    std::shared_ptr<FootstepAdapter> _footstepAdapter;
     bool _currentlyStepping;
     bool _waitBeforeNextStep;
     double _waitTimeStart;
     int _currentStepIndex;
-    std::vector<Eigen::Vector2d> _steppingTrajectory;
     steppingTestParams _steppingTestParams;
+    /** ZMP footsteps of the stepping and DCM tests */
+    std::vector<ZmpFootstep> _steppingTestFootsteps;
+    DcmControllerParams _dcmControllerParams;
+    std::shared_ptr<DcmController> _dcmController;
+    /** Streams the ZMP references of the preview window from the footstep queue */
+    std::shared_ptr<ZmpReferenceGenerator> _zmpReferenceGenerator;
 
 
     // General Variables
     std::shared_ptr<ZmpPreviewParams> _zmpPreviewParams;
     std::shared_ptr<ZmpPreviewController> _zmpPreviewController;
+    /** Same object as _zmpPreviewController when the constrained variant is used, null otherwise */
+    std::shared_ptr<ConstrainedZmpPreviewController> _constrainedZmpPreviewController;
     std::shared_ptr<ocra_recipes::TaskConnection> _comTask;
     std::shared_ptr<MIQPController> _miqpController;
     std::shared_ptr<StepController> _stepController;
@@ -263,6 +327,30 @@ private:
     std::string _testType;
     ZmpTestType _zmpTestType;
     std::string _homeDataDir;
+    /** Signals logged by the tests, see startExperimentLogger() */
+    enum LogChannel {
+        LOG_REF_COM_LIN_ACC,
+        LOG_CURRENT_COM_LIN_ACC,
+        LOG_INT_COM_POSITION_REF,
+        LOG_CURRENT_COM_POS,
+        LOG_CURRENT_ZMP,
+        LOG_PREVIEWED_ZMP,
+        LOG_REFERENCE_ZMP,
+        LOG_OPTIMAL_INPUT,
+        LOG_FEET_ERROR,
+        LOG_STEP_TRIGGER,
+        LOG_PREDICTED_CAPTURE_POINT_ERROR,
+        LOG_CURRENT_DCM,
+        LOG_REFERENCE_DCM,
+        LOG_COMMANDED_ZMP,
+        LOG_MIQP_COM_JERK,
+        LOG_MIQP_BOS_UPPER,
+        LOG_MIQP_BOS_LOWER,
+        NUMBER_OF_LOG_CHANNELS
+    };
+    std::shared_ptr<ExperimentLogger> _experimentLogger;
+    /** Index in _experimentLogger of every LogChannel, -1 when not logged by the current test */
+    std::vector<int> _logChannels;
     double _comYConstVel;
     double _stopTimeConstComVel;
     double _zmpYConstRef;
@@ -286,15 +374,25 @@ private:
     yarp::os::BufferedPort<yarp::os::Bottle> _comCurrent;
     yarp::os::BufferedPort<yarp::os::Bottle> _ddcomCurrent;
     yarp::os::BufferedPort<yarp::os::Bottle> _ddcomFromZMP;
-    Eigen::VectorXd _hkkPrevious;
+    ComState _hkkPrevious;
     bool _firstLoop;
     Eigen::VectorXd zmpRefInPreviewWindow;
+    Eigen::VectorXd zmpMinInPreviewWindow;
+    Eigen::VectorXd zmpMaxInPreviewWindow;
+    /** 2D coordinates of the active contacts */
+    Eigen::MatrixXd _contacts;
     Eigen::VectorXd comVelRefInPreviewWindow;
     Eigen::VectorXd optimalU;
 
     // MIQP-related variables
-    Eigen::VectorXd _X_kn;
-    Eigen::VectorXd _t_kn;
+    /** Channel through which the MIQPController thread publishes its solutions */
+    std::shared_ptr<MIQPSolutionChannel> _miqpSolution;
+    /** CoM jerk reference sampled from the MIQP solution at the current loop time */
+    Eigen::Vector2d _miqpComJerk;
+    /** Upper bounds of the BoS sampled from the MIQP solution at the current loop time */
+    Eigen::Vector2d _miqpA;
+    /** Lower bounds of the BoS sampled from the MIQP solution at the current loop time */
+    Eigen::Vector2d _miqpB;
 };
 
 
@@ -62,6 +62,7 @@
 #include <Eigen/Dense>
 #include <vector>
 #include "walking-client/utils.h"
+#include "walking-client/ComState.h"
 
 
 struct ZmpPreviewParams {
@@ -89,6 +90,22 @@ struct ZmpPreviewParams {
      *  Weight of the balancing cost function \f$ \eta_b \f$.
      */
     double nb;
+    /**
+     *  Use ConstrainedZmpPreviewController, bounding the previewed ZMP to the support polygon.
+     */
+    bool constrained;
+    /**
+     *  Bound on the absolute value of every component of the CoM jerk. Only used when constrained.
+     */
+    double jerkBound;
+    /**
+     *  Margin (m) taken inside the bounding box of the support polygon. Only used when constrained.
+     */
+    double zmpMargin;
+    /**
+     *  Maximum number of iterations of the active-set solver. Only used when constrained.
+     */
+    int maxActiveSetIterations;
 //     std::vector<Eigen::Vector2d> Pr;
 //     std::vector<Eigen::Vector2d> Hr;
 
@@ -106,13 +123,19 @@ struct ZmpPreviewParams {
     cz(cz),
     nu(nu),
     nw(nw),
-    nb(nb){}
+    nb(nb),
+    constrained(false),
+    jerkBound(50.0),
+    zmpMargin(0.01),
+    maxActiveSetIterations(100){}
 
 };
 
 class ZmpPreviewController
 {
 public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
     /**
      *  Class constructor. Builds all the time-invariant matrices used to compute the optimal output of the preview controller.
          @param period       Period (in ms) of the thread in which an object of this class is created.
@@ -132,42 +155,36 @@ public:
     bool initialize();
 
     /**
-     *  Computes a horizon of optimal inputs (CoM jerks) to be applied to the system, i.e.:
+     *  Computes the optimal input (CoM jerk) to be applied to the system, i.e. the first input of the horizon
      *  \f{align*}
          \mathcal{U}_{k+N|k} &= (\mathbf{H}_p^T \mathbf{N}_b \mathbf{H}_p + \mathbf{N}_u + \mathbf{H}_h^T \mathbf{N}_w \mathbf{H}_h)^{-1} \left(\mathbf{H}^T_p \mathbf{N}_b (\mathbf{P}_r - \mathbf{G}_p \hat{\mathbf{h}}_k) + \mathbf{H}^T_h\mathbf{N}_w(\tilde{\mathbf{H}}_r - \mathbf{G}_h \hat{\mathbf{h}}_k)\right)\\
-         \mathcal{U}_{k+N|k} &= \mathbf{A}_{\text{opt}}^{-1} \mathbf{b}_{\text{opt}}
+         \mathcal{U}_{k+N|k} &= \mathbf{K}_p \mathbf{P}_r + \mathbf{K}_h \tilde{\mathbf{H}}_r + \mathbf{K}_s \hat{\mathbf{h}}_k
          \f}
      *
-     *  This solution is computed through standard Cholesky decomposition. See Eigen::LLT for more details. Matrix ZmpPreviewController::AOptimal is precomputed by the constructor for efficiency reasons.
+     *  The problem is unconstrained and \f$\mathbf{A}_{\text{opt}}\f$ is constant, so the gains are precomputed by the
+     *  constructor (see buildOptimalGains()) and only the rows of the first input, the only one applied, are kept.
+     *  Each call thus costs two \f$2 \times 2N_p\f$ and one \f$2 \times 6\f$ matrix-vector products.
      *
-     *  @param zmpRef    \f$\mathbf{P}_r\f$ Horizon of \f$N_c\f$ ZMP references.
-     *  @param comVelRef \f$\tilde{\mathbf{H}}_r\f$ Horizon of \f$N_c\f$ CoM velocities.
+     *  The references may be a dynamic Eigen::VectorXd or a compile-time sized ZmpPreviewWindow, independently of the
+     *  type of optimalU.
+     *
+     *  @param zmpRef    \f$\mathbf{P}_r\f$ Horizon of \f$N_p\f$ ZMP references.
+     *  @param comVelRef \f$\tilde{\mathbf{H}}_r\f$ Horizon of \f$N_p\f$ CoM velocities.
      *  @param hk        Current measured CoM state at time \f$k\f$, i.e. \f$\hat{\mathbf{h}}_k\f$
-     *  @param optimalU  Closed-form solution to the unconstrained QP problem, \f$\mathcal{U}_{k+N_c|k}\f$
-     *  @see ZmpPreviewController::AOptimal, ZmpPreviewController::bOptimal
-     *
-     *  @todo Remember that the bOptimal I have to use is actually not Weiber's because it doesn't take into account com velocity references.
-     *
-     */
-    template <typename Derived>
-    void computeOptimalInput(const Eigen::MatrixBase<Derived>& zmpRef,
-                             const Eigen::MatrixBase<Derived>& comVelRef,
-                             const Eigen::MatrixBase<Derived>& hk,
-                             Eigen::MatrixBase<Derived>& optimalU) {
-//     AOptimal = Hp.transpose()*Nb*Hp + Nu + Hh.transpose()*Nw*Hh;
-//     bOptimal = Hp.transpose()*Nb*(zmpRef - Gp*hk) + Hh.transpose()*Nw*(comVelRef - Gh*hk);
-//     optimalU = AOptimal.colPivHouseholderQr().solve(bOptimal);
-
-//         double start = yarp::os::Time::now();
-        //TODO: Remember that the bOptimal I have to use is actually the next line, not Weiber's because it doesn't take into account com velocity references.
-//         bOptimal = Hp.transpose()*Nb*(zmpRef - Gp*hk) + Hh.transpose()*Nw*(comVelRef - Gh*hk);
-//         OCRA_INFO("Time to compute bOptimal is: " << yarp::os::Time::now() - start);
-        bOptimal = Hp.transpose() * (zmpRef - Gp * hk);
-//         start = yarp::os::Time::now();
-//         optimalU = AOptimal.colPivHouseholderQr().solve(Hp.transpose() * (bOptimal));
-        // Using Cholesky decomposition
-        optimalU = (AOptimal).llt().solve(bOptimal);
-//         OCRA_INFO("Time to compute optimalU using Cholesky decomposition : " << yarp::os::Time::now() - start);
+     *  @param optimalU  Closed-form solution to the unconstrained QP problem, \f$\mathcal{U}_{k+N_c|k}\f$. Only its
+     *                   first two rows, i.e. \f$\mathbf{u}_{k|k}\f$, are computed. The rest is set to zero. May also
+     *                   be of size 2, e.g. an Eigen::Vector2d, to only get \f$\mathbf{u}_{k|k}\f$.
+     *  @see ZmpPreviewController::KZmp, ZmpPreviewController::KComVel, ZmpPreviewController::KState
+     */
+    template <typename DerivedZmp, typename DerivedComVel, typename DerivedU>
+    void computeOptimalInput(const Eigen::MatrixBase<DerivedZmp>& zmpRef,
+                             const Eigen::MatrixBase<DerivedComVel>& comVelRef,
+                             const ComState& hk,
+                             Eigen::MatrixBase<DerivedU>& optimalU) {
+        optimalU.setZero();
+        optimalU.template head<2>().noalias() = KZmp * zmpRef;
+        optimalU.template head<2>().noalias() += KComVel * comVelRef;
+        optimalU.template head<2>().noalias() += KState * hk;
     }
 
     /**
@@ -182,7 +199,9 @@ public:
      *  @param[out] hkk      Integrated COM state \f$\mathbf{h}_{k+1}\f$
      *  @see                 buildAh(), buildBh()
      */
-    void integrateCom(Eigen::VectorXd comJerk, Eigen::VectorXd hk, Eigen::VectorXd &hkk);
+    void integrateCom(const Eigen::Vector2d &comJerk, const ComState &hk, ComState &hkk) const {
+        hkk = Ah*hk + Bh*comJerk;
+    }
 
 
     /** Computes a simplified model-based ZMP.
@@ -198,7 +217,9 @@ public:
                  to see what the previewed ZMP reference is, we need to use this table-cart model whose
                  inputs are to be integrated from the optimal jerks through integrateCom().
      */
-    void tableCartModel(Eigen::Vector2d hk, Eigen::VectorXd ddhk, Eigen::Vector2d& p);
+    void tableCartModel(const Eigen::Vector2d &hk, const Eigen::Vector2d &ddhk, Eigen::Vector2d& p) const {
+        p = hk - (cz/g)*ddhk;
+    }
 
      /** Computes a simplified model-based ZMP.
 
@@ -216,7 +237,9 @@ public:
                  to see what the previewed ZMP reference is, we need to use this table-cart model whose
                  inputs are to be integrated from the optimal jerks through integrateCom().
      */
-    void tableCartModel(Eigen::VectorXd hkk, Eigen::Vector2d& p);
+    void tableCartModel(const ComState &hkk, Eigen::Vector2d& p) const {
+        p.noalias() = Cp*hkk;
+    }
 
     /**
      *  Builds \f$A_h\f$. Called during the member list initialization of the constructor of this class.
@@ -225,7 +248,7 @@ public:
      *  @return The constant matrix Ah.
      *  @see ZmpPreviewController::Ah
      */
-    Eigen::MatrixXd buildAh(const double dt);
+    ComStateMatrix buildAh(const double dt);
 
     /**
      *  Builds \f$B_h\f$. Called during the member list initialization of the constructor of this class.
@@ -234,7 +257,7 @@ public:
      *  @return The constant matrix Bh.
      *  @see ZmpPreviewController::Bh
      */
-    Eigen::MatrixXd buildBh(const double dt);
+    ComInputMatrix buildBh(const double dt);
 
     /**
      *  Builds \f$C_p\f$. Called during the member list initialization of the constructor of this class
@@ -245,7 +268,7 @@ public:
      *  @return \f$C_p\f$
      *  @see ZmpPreviewController::Cp
      */
-    Eigen::MatrixXd buildCp(const double cz, const double g);
+    ComOutputMatrix buildCp(const double cz, const double g);
 
     /**
      *  Builds \f$G_p\f$. Called during the member list initialization of the constructor of this class
@@ -257,7 +280,7 @@ public:
      *  @return \f$G_p\f$
      *  @see ZmpPreviewController::Gp
      */
-    Eigen::MatrixXd buildGp(Eigen::MatrixXd Cp, Eigen::MatrixXd Ah, const int Np);
+    Eigen::MatrixXd buildGp(const ComOutputMatrix &Cp, const ComStateMatrix &Ah, const int Np);
 
     /**
      *  Builds \f$H_p\f$. Called during the member list initialization of the constructor of this class
@@ -271,7 +294,7 @@ public:
      *  @return \f$H_p\f$
      *  @see ZmpPreviewController::Hp
      */
-    Eigen::MatrixXd buildHp(Eigen::MatrixXd Cp, Eigen::MatrixXd Bh, Eigen::MatrixXd Ah, const int Nc, const int Np);
+    Eigen::MatrixXd buildHp(const ComOutputMatrix &Cp, const ComInputMatrix &Bh, const ComStateMatrix &Ah, const int Nc, const int Np);
 
     /**
      *  Builds \f$C_h\f$. Called during the member list initialization of the constructor of this class
@@ -279,7 +302,7 @@ public:
      *  @return \f$C_h\f$
      *  @see ZmpPreviewController::Ch
      */
-    Eigen::MatrixXd buildCh();
+    ComOutputMatrix buildCh();
 
     /**
      *  Builds \f$G_h\f$. Called during the member list initialization of the constructor of this class
@@ -291,7 +314,7 @@ public:
      *  @return \f$G_h\f$
      *  @see ZmpPreviewController::Gh
      */
-    Eigen::MatrixXd buildGh(Eigen::MatrixXd Ch, Eigen::MatrixXd Ah, const int Np);
+    Eigen::MatrixXd buildGh(const ComOutputMatrix &Ch, const ComStateMatrix &Ah, const int Np);
 
     /**
      *  Builds \f$H_h\f$. Called during the member list initialization of the constructor of this class
@@ -306,7 +329,7 @@ public:
      *  @see ZmpPreviewController::Hh
      *  @todo Check the first for loop of this method. I think this should be Np - 1
      */
-    Eigen::MatrixXd buildHh(Eigen::MatrixXd Ch, Eigen::MatrixXd Bh, Eigen::MatrixXd Ah, const int Nc, const int Np);
+    Eigen::MatrixXd buildHh(const ComOutputMatrix &Ch, const ComInputMatrix &Bh, const ComStateMatrix &Ah, const int Nc, const int Np);
 
     /**
      *  Builds \f$N_u\f$. Called during the member list initialization of the constructor of this class
@@ -341,6 +364,14 @@ public:
      */
     Eigen::MatrixXd buildNb(const double nb, const int Np);
 
+    /**
+     *  Factorizes \f$\mathbf{A}_{\text{opt}}\f$ once and builds the gains of computeOptimalInput(), keeping only
+     *  the rows of the first input of the horizon. Called by the constructor of this class.
+     *
+     *  @see ZmpPreviewController::KZmp, ZmpPreviewController::KComVel, ZmpPreviewController::KState
+     */
+    void buildOptimalGains();
+
     /**
      *  Computes the ZMP for a single foot in world reference frame.
      *
@@ -418,7 +449,7 @@ public:
     void getFTSensorAdjointMatrix(FOOT whichFoot, Eigen::MatrixXd &T, Eigen::Vector3d &sensorPosition, ocra::Model::Ptr model);
 
 
-private:
+protected:
     /**
      *  CoMconstant height. It is not hardcoded but corresponds to the vertical coordinate (height) of the CoMat the beginning of execution, i.e. \f$ c_z \f$.
      */
@@ -473,7 +504,7 @@ private:
      \end{array} \right]
      \f]
      */
-    const Eigen::MatrixXd Ah;
+    const ComStateMatrix Ah;
     /**
      *  Input matrix \f$\mathbf{B}_h\f$ from the linear state process of the CoMstate \f$\hat{\mathbf{h}}\f$. It is constant of size \f$6\times2\f$ and equal to:
      \f[
@@ -484,7 +515,7 @@ private:
      \end{array} \right]
      \f]
      */
-    const Eigen::MatrixXd Bh;
+    const ComInputMatrix Bh;
     /**
      *  Output matrix \f$C_p\f$ from the linear state process relating ZMP to the CoMdynamics \f$\hat{\mathbf{h}}\f$. It is time-invariant of size \f$2\times6\f$ and equal to:
      \f[
@@ -493,7 +524,7 @@ private:
      \end{array}\right]
      \f]
      */
-    const Eigen::MatrixXd Cp;
+    const ComOutputMatrix Cp;
     /**
      *  State matrix \f$\mathbf{G}_p\f$ from the preview horizon of ZMP outputs \f$\mathbf{P}\f$. It is of size \f$2N_p \times 6\f$ and equal to:
      \f[
@@ -525,7 +556,7 @@ private:
      \end{array}\right]
      \f]
      */
-    const Eigen::MatrixXd Ch;
+    const ComOutputMatrix Ch;
     /**
      *  State matrix \f$\mathbf{G}_h\f$  of size \f$2N_p \times 6\f$ from the preview horizon of CoMvelocities. It is constant and equal to:
      \f[
@@ -551,14 +582,24 @@ private:
     const Eigen::MatrixXd Hh;
 
     /**
-     *  Matrix \f$\mathbf{A}_{\text{opt}}\f$ in computeOptimalInput().
+     *  Matrix \f$\mathbf{A}_{\text{opt}} = \mathbf{H}_p^T \mathbf{N}_b \mathbf{H}_p + \mathbf{N}_u + \mathbf{H}_h^T \mathbf{N}_w \mathbf{H}_h\f$ in computeOptimalInput().
      */
     Eigen::MatrixXd AOptimal;
 
     /**
-     *  Vector \f$\mathbf{b}_{\text{opt}}\f$ in computeOptimalInput().
+     *  Gain \f$\mathbf{K}_p\f$ of size \f$2 \times 2N_p\f$ on the ZMP references. First two rows of \f$\mathbf{A}_{\text{opt}}^{-1}\mathbf{H}_p^T\mathbf{N}_b\f$.
+     */
+    Eigen::Matrix<double, 2, Eigen::Dynamic> KZmp;
+
+    /**
+     *  Gain \f$\mathbf{K}_h\f$ of size \f$2 \times 2N_p\f$ on the CoM velocity references. First two rows of \f$\mathbf{A}_{\text{opt}}^{-1}\mathbf{H}_h^T\mathbf{N}_w\f$.
+     */
+    Eigen::Matrix<double, 2, Eigen::Dynamic> KComVel;
+
+    /**
+     *  Gain \f$\mathbf{K}_s = -\mathbf{K}_p\mathbf{G}_p - \mathbf{K}_h\mathbf{G}_h\f$ of size \f$2 \times 6\f$ on the current CoM state.
      */
-    Eigen::MatrixXd bOptimal;
+    ComOutputMatrix KState;
 
 
 
@@ -0,0 +1,200 @@
+/*! \file       ZmpReferenceGenerator.h
+ *  \brief      Streaming ZMP and CoM velocity references driven by a queue of footsteps.
+ *  \details    Instead of sampling the whole ZMP trajectory of a walk at startup, this class keeps a queue of
+ *              footsteps and generates the references one sample at a time, as the preview window of
+ *              ZmpPreviewController moves forward. The window is stored in a ring buffer of \f$N_p\f$ samples, so
+ *              that advancing it costs a single new sample and the memory used does not depend on the length
+ *              of the walk.
+ *
+ *              Every footstep moves the ZMP linearly from the previous footstep to its position during its
+ *              double support duration and then holds it there during its single support duration, i.e. the
+ *              profile that ocra::LinearInterpolationTrajectory samples through waypoints doubled at every
+ *              footstep. When the queue runs out the last position is held, so the window never goes past the
+ *              end of the plan. Footsteps can be appended at any time: they are used from the end of the current
+ *              preview window onwards.
+ *
+ *              Alongside the references, the bounding box of the support polygon planned for every sample of the
+ *              window is generated from the same footsteps: the box of the footstep the ZMP stands on, or the box
+ *              of both the previous footstep and the current one while the ZMP moves between them. See
+ *              setFootHalfSize() and getSupportWindow().
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-recipes.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _ZMP_REFERENCE_GENERATOR_H_
+#define _ZMP_REFERENCE_GENERATOR_H_
+
+#include <deque>
+#include <Eigen/Dense>
+
+/**
+ * Footstep of the ZMP plan.
+ */
+struct ZmpFootstep {
+    /** Horizontal position of the ZMP while standing on this footstep */
+    Eigen::Vector2d position;
+    /** Time in seconds spent by the ZMP to move from the previous footstep to this one */
+    double dsDuration;
+    /** Time in seconds during which the ZMP is held on this footstep */
+    double ssDuration;
+
+    ZmpFootstep() : position(Eigen::Vector2d::Zero()), dsDuration(0), ssDuration(0) {}
+    ZmpFootstep(const Eigen::Vector2d &position, double dsDuration, double ssDuration) :
+    position(position), dsDuration(dsDuration), ssDuration(ssDuration) {}
+};
+
+class ZmpReferenceGenerator {
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    /**
+     * Constructor. Allocates the ring buffer of the preview window.
+     *
+     * @param period Period in ms of the thread calling advance().
+     * @param Np     Length of the preview window, as in ZmpPreviewParams::Np.
+     */
+    ZmpReferenceGenerator(const double period, const int Np);
+
+    virtual ~ZmpReferenceGenerator();
+
+    /**
+     * Clears the footstep queue and fills the preview window holding the ZMP at the given position.
+     *
+     * @param initialZmp Current horizontal position of the ZMP.
+     */
+    void reset(const Eigen::Vector2d &initialZmp);
+
+    /**
+     * Sets the size of the support box of a single footstep, used by getSupportWindow(). To be called before reset().
+     *
+     * @param halfSize Half size along x and y of the box centered at every footstep position. Zero by default,
+     *                 i.e. the support boxes collapse to the footstep positions.
+     */
+    void setFootHalfSize(const Eigen::Vector2d &halfSize);
+
+    /**
+     * Appends a footstep to the end of the plan. Footsteps with negative durations or lasting less than one
+     * period are rejected.
+     *
+     * @param footstep Footstep to append.
+     * @return False if the footstep was rejected.
+     */
+    bool addFootstep(const ZmpFootstep &footstep);
+
+    /**
+     * Regenerates the whole preview window from the footstep queue, so that the footsteps added since reset() start
+     * at the current time instead of at the end of the window. To be called once the initial plan has been added.
+     */
+    void fillPreviewWindow();
+
+    /**
+     * Moves the footsteps not yet started, e.g. after the adaptation of the step plan. Samples already in the
+     * preview window are not modified.
+     *
+     * @param offset Horizontal displacement added to every queued footstep.
+     */
+    void offsetQueuedFootsteps(const Eigen::Vector2d &offset);
+
+    /**
+     * Moves the preview window one sample forward, generating the sample at its end from the footstep queue.
+     */
+    void advance();
+
+    /**
+     * Unrolls the preview window into the vectors used by ZmpPreviewController::computeOptimalInput(), either
+     * Eigen::VectorXd or compile-time sized ZmpPreviewWindow vectors.
+     *
+     * @param[out] zmpRef    \f$\mathbf{P}_r\f$ ZMP references in the preview window. Size \f$2N_p\f$.
+     * @param[out] comVelRef \f$\tilde{\mathbf{H}}_r\f$ CoM velocity references in the preview window. Size
+     *                       \f$2N_p\f$. The CoM velocity of a footstep is its average ZMP velocity, i.e. its
+     *                       displacement over its total duration.
+     */
+    void getPreviewWindow(Eigen::Ref<Eigen::VectorXd> zmpRef, Eigen::Ref<Eigen::VectorXd> comVelRef) const;
+
+    /**
+     * Unrolls the support boxes of the preview window into the bounds used by
+     * ConstrainedZmpPreviewController::computeConstrainedOptimalInput().
+     *
+     * @param[out] zmpMin \f$\mathbf{P}_{\min}\f$ Minimum corners of the support boxes. Size \f$2N_p\f$.
+     * @param[out] zmpMax \f$\mathbf{P}_{\max}\f$ Maximum corners of the support boxes. Size \f$2N_p\f$.
+     */
+    void getSupportWindow(Eigen::Ref<Eigen::VectorXd> zmpMin, Eigen::Ref<Eigen::VectorXd> zmpMax) const;
+
+    /**
+     * @return ZMP reference at the current time, i.e. the first sample of the preview window.
+     */
+    Eigen::Vector2d getCurrentZmpReference() const { return _zmpWindow.col(_head); };
+
+    /**
+     * @return Number of footsteps not yet started at the end of the preview window.
+     */
+    unsigned int getNumberOfQueuedFootsteps() const { return _footsteps.size(); };
+
+    /**
+     * @return True when every footstep has been consumed and the whole preview window holds the last position.
+     */
+    bool isPlanFinished() const { return _footsteps.empty() && !_inFootstep && _holdSamples >= _Np; };
+
+private:
+    /**
+     * Computes the next sample at the end of the preview window and moves the footstep cursor forward.
+     */
+    void generateSample(Eigen::Ref<Eigen::Vector2d> zmp, Eigen::Ref<Eigen::Vector2d> comVel,
+                        Eigen::Ref<Eigen::Vector2d> supportMin, Eigen::Ref<Eigen::Vector2d> supportMax);
+
+    /**
+     * Computes the support box at the position of the footstep cursor.
+     */
+    void computeSupportBox(Eigen::Ref<Eigen::Vector2d> supportMin, Eigen::Ref<Eigen::Vector2d> supportMax) const;
+
+    /**
+     * Copies a ring buffer into a vector of size \f$2N_p\f$, starting from its current sample.
+     */
+    void unrollWindow(const Eigen::Matrix2Xd &window, Eigen::Ref<Eigen::VectorXd> unrolled) const;
+
+    /** Period in seconds */
+    const double _dt;
+    /** Length of the preview window */
+    const int _Np;
+    /** Ring buffers of the preview window. Column _head is the current sample */
+    Eigen::Matrix2Xd _zmpWindow;
+    Eigen::Matrix2Xd _comVelWindow;
+    Eigen::Matrix2Xd _supportMinWindow;
+    Eigen::Matrix2Xd _supportMaxWindow;
+    int _head;
+    /** Half size of the support box of a footstep */
+    Eigen::Vector2d _footHalfSize;
+    /** Footsteps not yet started */
+    std::deque<ZmpFootstep> _footsteps;
+    /** Footstep being sampled at the end of the window, and the position it starts from */
+    ZmpFootstep _current;
+    Eigen::Vector2d _from;
+    bool _inFootstep;
+    /** Sample index within the current footstep */
+    int _sample;
+    /** Number of samples of the double support and of the whole current footstep */
+    int _dsSamples;
+    int _totalSamples;
+    /** Number of consecutive samples generated with an empty queue */
+    int _holdSamples;
+};
+
+#endif
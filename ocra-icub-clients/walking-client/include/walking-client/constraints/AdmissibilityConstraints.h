@@ -15,7 +15,7 @@ protected:
     ContactConfigHistory _contactConfigHistory;
     ContactConfigEnforcement _contactConfigEnforcement;
 public:
-    AdmissibilityConstraints();
+    AdmissibilityConstraints(const MIQPParameters &miqpParams);
     virtual ~AdmissibilityConstraints();
 protected:
     virtual void buildMatrixCi();
@@ -1,3 +1,6 @@
+#ifndef _CONSTANCY_H_
+#define _CONSTANCY_H_
+
 #include "walking-client/constraints/Constraint.h"
 
 class Constancy : public Constraint {
@@ -6,12 +9,15 @@ private:
     Eigen::Vector2d _S;
 public:
     /**
-     * @todo Upper boundaries should be input somehow from configuration file
+     * @param sx Upper bound in x (MIQPParameters::sx_constancy).
+     * @param sy Upper bound in y (MIQPParameters::sy_constancy).
      */
-    Constancy();
+    Constancy(double sx, double sy);
     virtual ~Constancy();
 protected:
     virtual void buildMatrixCi();
     virtual void buildMatrixCii();
     virtual void buildVectord();
 };
+
+#endif
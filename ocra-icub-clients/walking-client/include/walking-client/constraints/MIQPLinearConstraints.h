@@ -47,6 +47,7 @@
 #include "walking-client/constraints/AdmissibilityConstraints.h"
 #include "walking-client/StepController.h"
 #include "walking-client/BaseOfSupport.h"
+#include "walking-client/MIQPPreviewModel.h"
 #include "walking-client/utils.h"
 
 class MIQPLinearConstraints {
@@ -64,67 +65,10 @@ private:
     Eigen::MatrixXd _Acl;
     
     /**
-     * Matrix \f$\mathbf{Q}\f$ from the preview model:
-     \f[
-     \forall j \in \mathbb{N}^*, \xi_{k+j+1|k} = \mathbf{Q} \xi_{k+j|k} + \mathbf{T}\mathcal{X}_{k+j+1|k}
-     \f]
-     *
-     \f[
-     \mathbf{Q} = \left[\begin{array}{cc}
-     \mathbf{0}_{10\times10} & \mathbf{0}_{10\times6}\\
-     \mathbf{0}_{6\times10} & \mathbf{A_h}_{6\times6}
-     \end{array}\right]
-     \f]
+     * Preview model of the MIQP, shared with MIQPController. Provides \f$\mathbf{Q}_j\f$ and \f$\mathbf{T}_j\f$
+     * for every (possibly non-uniform) step of the preview window.
      */
-    Eigen::MatrixXd _Q;
-    
-    /** 
-     * Matrix \f$\mathbf{T}\f$ from the preview model:
-     \f[
-     \forall j \in \mathbb{N}^*, \xi_{k+j+1|k} = \mathbf{Q} \xi_{k+j|k} + \mathbf{T}\mathcal{X}_{k+j+1|k}
-     \f]
-     *
-     \f[
-     \mathbf{T} = \left[\begin{array}{cc}
-     \mathbf{I}_{10\times10} & \mathbf{0}_{10\times2}\\
-     \mathbf{0}_{6\times10} & \mathbf{B_h}_{6\times2}
-     \end{array}\right]
-     \f]
-     *
-     * @see #_Bh
-     */
-
-    Eigen::MatrixXd _T;
-
-    /**
-     *  Input matrix \f$\mathbf{B}_h\f$ from the linear state process of the CoMstate \f$\hat{\mathbf{h}}\f$. It is constant of size \f$6\times2\f$ and equal to:
-     \f[
-     \mathbf{B_h} = \left[ \begin{array}{c}
-     \frac{\delta^3}{6}\mathbf{I}_2 \\
-     \frac{\delta t^2}{2} \mathbf{I}_2     \\
-     \delta t \mathbf{I}_2
-     \end{array} \right]
-     \f]
-     */
-    Eigen::MatrixXd _Bh;
-    
-    /**
-     *  State matrix \f$A_h\f$ from the CoM jerk integration scheme.
-     *
-     *  \f[
-     *  \mathbf{h}_{k+1} = \mathbf{A}_h \mathbf{h}_k + \mathbf{B}_h \mathbf{u}_k
-     *  \f]
-     *
-     *  It is a constant matrix of size \f$6\times6\f$ equal to:
-     *  \f[
-     *  \mathbf{A_h} = \left[ \begin{array}{ccc}
-     *  \mathbf{I}_2  & \delta t \mathbf{I}_2  &  \frac{\delta t^2}{2} \mathbf{I}_2 \\
-     *   0  &     \mathbf{I}_2     &  \delta t \mathbf{I}_2    \\
-     *   0  &     0     &      \mathbf{I}_2
-     *  \end{array} \right]
-     *  \f]
-     */
-    Eigen::MatrixXd _Ah;
+    std::shared_ptr<MIQPPreviewModel> _previewModel;
     
     /**
      * Boolean too add shape constraints.
@@ -164,10 +108,11 @@ public:
     /**
      * @todo Once I add walking constraints this will change to include the rows added by walking constraints
      * @param[in] stepController Pointer to StepController object which is instantiated by the hosting client.
+     * @param[in] previewModel Preview model of the MIQP.
      * @param[in] miqpParams Container of the MIQP parameters. 
      * 
      */
-    MIQPLinearConstraints(std::shared_ptr<StepController> stepController, MIQPParameters &miqpParams);
+    MIQPLinearConstraints(std::shared_ptr<StepController> stepController, std::shared_ptr<MIQPPreviewModel> previewModel, MIQPParameters &miqpParams);
     
     /**
      * Default destructor
@@ -180,6 +125,15 @@ public:
      * @param[in] xi_k Current state.
      */
     void updateRHS(const Eigen::VectorXd& xi_k);
+
+    /**
+     * Updates the state-dependent RHS of the inequality constraints with a given bounding box of the support
+     * polygon for the CoP constraints, instead of the one retrieved from the StepController.
+     *
+     * @param[in] xi_k Current state.
+     * @param[in] minMaxBoundingBox Bounding box of the support polygon. See BaseOfSupport::computeBoundingBox().
+     */
+    void updateRHS(const Eigen::VectorXd& xi_k, const Eigen::Matrix2d& minMaxBoundingBox);
     
     /**
      * Retrieves the constraints matrix \f$\mathbf{A}\f$. Before passing a matrix to copy #_A allocate the space 
@@ -223,22 +177,12 @@ protected:
      \end{array}
      \f]
 
-     \see buildAShapeAdmiss()
+     With a non-uniform preview window, \f$Q^i\f$ above stands for the product of the \f$\mathbf{Q}_j\f$ of the corresponding steps.
+
+     \see MIQPPreviewModel::buildCoupledPreviewMatrices()
      \todo When walking constraints are added, matrix _A will be a stack of the two
      */
     void buildShapeAndAdmissibilityInPreviewWindow();
-    /**
-     Actually builds the matrix A referred to in buildShapeAndAdmissibilityInPreviewWindow()
-
-     \see buildShapeAndAdmissibilityInPreviewWindow
-     */
-    void buildAShapeAdmiss();
-    /**
-     Actually builds the matrix B referred to in buildShapeAndAdmissibilityInPreviewWindow()
-
-     \see buildShapeAndAdmissibilityInPreviewWindow
-     */
-    void buildBShapeAdmiss();
     /**
      Actually builds the vector \f$\bar{\mathbf{f}}_c\f$ referred to in buildShapeAndAdmissibilityInPreviewWindow()
      */
@@ -251,37 +195,5 @@ protected:
      Stacks matrices \f$C_{i}\f$ (Ci) from the shape and admissiblity constraints to set variable #_Acl
      */
     void setMatrixAcl();
-    /**
-     Builds matrix Q (#_Q) from the preview model:
-
-     \f[
-     \forall j \in \mathbb{N}^*, \xi_{k+j+1|k} = \mathbf{Q} \xi_{k+j|k} + \mathbf{T}\mathcal{X}_{k+j+1|k}
-     \f]
-     *
-     * @see #_Q
-     */
-    void buildMatrixQ();
-    /**
-     Builds matrix T (#_T) from the preview model:
-
-     \f[
-     \forall j \in \mathbb{N}^*, \xi_{k+j+1|k} = \mathbf{Q} \xi_{k+j|k} + \mathbf{T}\mathcal{X}_{k+j+1|k}
-     \f]
-     *
-     * @see #_T
-     */
-    void buildMatrixT();
-    /**
-     *  Builds \f$B_h\f$ (#_Bh) called by the constructor of this class.
-     *
-     *  @see #_Bh
-     */
-    void buildBh();
-    /**
-     *  Builds \f$A_h\f$.
-     *
-     *  @see #_Ah
-     */
-    void buildAh();
 };
 #endif
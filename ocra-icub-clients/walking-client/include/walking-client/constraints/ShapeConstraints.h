@@ -12,7 +12,7 @@ protected:
   Constancy _constancy;
   Sequentiality _sequentiality;
 public:
-  ShapeConstraints();
+  ShapeConstraints(const MIQPParameters &miqpParams);
   virtual ~ShapeConstraints();
   virtual void buildMatrixCi();
   virtual void buildMatrixCii();
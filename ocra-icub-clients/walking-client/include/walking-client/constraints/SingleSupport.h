@@ -7,12 +7,13 @@ class SingleSupport : public Constraint {
 private:
     Eigen::Vector2d _S;
 public:
-    SingleSupport();
-    virtual ~SingleSupport();
-protected:
     /**
-     * @todo Bound S must not be hardcoded
+     * @param sx Bound in x (MIQPParameters::sx_ss).
+     * @param sy Bound in y (MIQPParameters::sy_ss).
      */
+    SingleSupport(double sx, double sy);
+    virtual ~SingleSupport();
+protected:
     virtual void buildMatrixCi();
     virtual void buildMatrixCii();
     virtual void buildVectord();
@@ -1,6 +1,7 @@
 #ifndef _UTILS_H_
 #define  _UTILS_H_
 #include <string>
+#include <vector>
 
 enum FOOT {
     LEFT_FOOT,
@@ -49,6 +50,13 @@ struct MIQPParameters {
     unsigned int dtThread;
     /* MIQP discretization period */
     unsigned int dt;
+    /* Duration (ms) of every step of the preview window. Allows a fine sampling of the first steps and a
+     * coarse one afterwards. Either given as a list in the configuration file or built from dt, nFineSteps
+     * and dtCoarse. */
+    std::vector<unsigned int> dtPreview;
+    /* Number of consecutive steps of the preview window over which the binary variables are held constant
+     * (move blocking). Must sum up to N. Empty means one block per step. */
+    std::vector<unsigned int> binaryBlocks;
     /* Home directory where logged data will be saved */
     std::string home;
     /* Walking Performance Cost Weight */
@@ -93,6 +101,28 @@ struct MIQPParameters {
     std::string robot;
     /* Distance from actual CoP boundaries */
     double marginCoPBounds;
+    /* Normal force threshold (N) above which a foot is considered in contact */
+    double FzThreshold;
+    /* CoP threshold (m) used to detect single support */
+    double PzThreshold;
+    /* Minimum displacement (m) of a foot to be considered a change of the BoS bounds */
+    double changeThreshold;
+    /* Bound on the absolute value of the BoS bounds a and b */
+    double abBounds;
+    /* Bound on the absolute value of the CoM jerk */
+    double uBounds;
+    /* Number of samples of the rising (and falling) ramp of the CoM velocity reference. 0 for a constant velocity */
+    unsigned int comRampSamples;
+    /* Number of samples at constant CoM velocity before ramping down to rest. 0 to never ramp down */
+    unsigned int comCruiseSamples;
+    /* Replace the MIQP by one continuous QP per precomputed admissible contact sequence? */
+    bool explicitModeSequences;
+    /* Number of steps of the preview window over which contact sequences are enumerated */
+    unsigned int modeDecisionSteps;
+    /* Maximum number of contact sequences stored per initial contact configuration */
+    unsigned int maxModeSequences;
+    /* Number of threads solving the continuous QPs of the candidate sequences */
+    unsigned int nSolverThreads;
 };
 
 #define STATE_VECTOR_SIZE 16
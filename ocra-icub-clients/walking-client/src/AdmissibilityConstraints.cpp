@@ -1,6 +1,8 @@
 #include "walking-client/constraints/AdmissibilityConstraints.h"
 
-AdmissibilityConstraints::AdmissibilityConstraints() : Constraint() {
+AdmissibilityConstraints::AdmissibilityConstraints(const MIQPParameters &miqpParams) : Constraint(),
+_singleSupport(miqpParams.sx_ss, miqpParams.sy_ss)
+{
     _ssdsAlternation.init();
     _singleSupport.init();
     _contactConfigHistory.init();
@@ -1,26 +1,23 @@
 #include "walking-client/BaseOfSupport.h"
 
-BaseOfSupport::BaseOfSupport(std::shared_ptr<StepController> stepController, const Eigen::MatrixXd& Q, const Eigen::MatrixXd& T, MIQPParameters miqpParams):
+BaseOfSupport::BaseOfSupport(std::shared_ptr<StepController> stepController, std::shared_ptr<MIQPPreviewModel> previewModel, MIQPParameters miqpParams):
 _stepController(stepController),
 _miqpParams(miqpParams),
-_Q(Q),
-_T(T),
+_previewModel(previewModel),
 _Ab(Eigen::MatrixXd(4,2)),
 _b(Eigen::VectorXd(4)),
 _Cp(Eigen::MatrixXd(2, 6)),
 _Ci(Eigen::MatrixXd(14,STATE_VECTOR_SIZE)),
 _f(Eigen::VectorXd(14))
 {
-    _A.resize(_Ci.rows()*miqpParams.N, T.cols()*miqpParams.N); _A.setZero();
     _fbar.resize(_f.rows()*miqpParams.N); _fbar.setZero();
-    _B.resize(_Ci.rows()*miqpParams.N, _Q.cols()); _B.setZero();
     _rhs.resize(miqpParams.N); _rhs.setZero();
     // Build matrices of the bounding constraints when expressed in the terms of the state vector xi
     buildAb();
     buildCp(_miqpParams.cz, _miqpParams.g);
     buildCi(_Ab, _Cp);
-    buildA(_Ci, _Q, _T);
-    buildB(_Ci, _Q);
+    buildA(_Ci);
+    buildB(_Ci);
     _f.setZero();
 }
 
@@ -68,25 +65,13 @@ void BaseOfSupport::buildfbar(const Eigen::VectorXd& f) {
     }
 }
 
-void BaseOfSupport::buildB(const Eigen::MatrixXd& Ci, const Eigen::MatrixXd& Q){
-    for (unsigned int i=0; i < _miqpParams.N; i++) {
-        _B.block(i*Ci.rows(), 0, Ci.rows(), _Q.cols()) = Ci*_Q.pow(i+1);
-    }
+void BaseOfSupport::buildB(const Eigen::MatrixXd& Ci){
+    _previewModel->buildPreviewStateMatrix(Ci, _B);
     OCRA_INFO("Built B");
 }
 
-void BaseOfSupport::buildA(const Eigen::MatrixXd& Ci, const Eigen::MatrixXd& Q, const Eigen::MatrixXd& T){
-    // Create first column of Aeq
-    Eigen::MatrixXd AColumn(Ci.rows()*_miqpParams.N, T.cols());
-    for (unsigned int i=0; i<_miqpParams.N; i++){
-        AColumn.block(i*Ci.rows(), 0, Ci.rows(), T.cols()) = Ci * Q.pow(i) * T;
-    }
-    // Shift AeqColumn into every column of Aeq to take the form of a lower diagonal toeplitz matrix
-    unsigned int j=0;
-    while (j<_miqpParams.N){
-        _A.block(j*Ci.rows(), j*T.cols(), Ci.rows()*(_miqpParams.N-j), T.cols()) = AColumn.topRows((_miqpParams.N-j)*Ci.rows());
-        j=j+1;
-    }
+void BaseOfSupport::buildA(const Eigen::MatrixXd& Ci){
+    _previewModel->buildPreviewInputMatrix(Ci, _A);
     OCRA_INFO("Built A");
 }
 
@@ -97,6 +82,10 @@ bool BaseOfSupport::update(const Eigen::VectorXd& xi_k) {
     // Compute the bounding box of the current support configuration
     Eigen::Matrix2d minMaxBoundingBox;
     computeBoundingBox(feetCorners, minMaxBoundingBox);
+    return update(xi_k, minMaxBoundingBox);
+}
+
+bool BaseOfSupport::update(const Eigen::VectorXd& xi_k, const Eigen::Matrix2d& minMaxBoundingBox) {
     // Update right-hand side of constraints
     buildb(minMaxBoundingBox);
     buildf();
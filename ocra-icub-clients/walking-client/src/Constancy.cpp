@@ -1,10 +1,9 @@
 #include "walking-client/constraints/Constancy.h"
 
-Constancy::Constancy() : Constraint() {
-// Set bounding
-    //TODO: This should be input somehow from configuration file
-    _S(0) = 0.3;
-    _S(1) = 0.3;
+Constancy::Constancy(double sx, double sy) : Constraint() {
+    // Set bounding
+    _S(0) = sx;
+    _S(1) = sy;
 }
 Constancy::~Constancy() {}
 
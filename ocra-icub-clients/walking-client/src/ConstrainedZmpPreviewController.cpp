@@ -0,0 +1,240 @@
+#include "walking-client/ConstrainedZmpPreviewController.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+ConstrainedZmpPreviewController::ConstrainedZmpPreviewController(const double period, std::shared_ptr<ZmpPreviewParams> parameters) :
+ZmpPreviewController(period, parameters),
+nConstraints(2*parameters->Np + 2*parameters->Nc),
+jerkBound(parameters->jerkBound),
+maxIterations(std::max(0, parameters->maxActiveSetIterations)),
+_inWorkingSet(nConstraints, false),
+_iterations(0),
+_U0(2*parameters->Nc),
+_freeResponse(2*parameters->Np),
+_y0(nConstraints),
+_y(nConstraints),
+_lower(nConstraints),
+_upper(nConstraints),
+_zmpMin(2*parameters->Np),
+_zmpMax(2*parameters->Np),
+_mu(nConstraints),
+_l(nConstraints),
+_z(nConstraints),
+_L(nConstraints, nConstraints)
+{
+    Eigen::LLT<Eigen::MatrixXd> llt(AOptimal);
+    KZmpFull = llt.solve(Hp.transpose()*Nb);
+    KComVelFull = llt.solve(Hh.transpose()*Nw);
+    KStateFull = -KZmpFull*Gp - KComVelFull*Gh;
+
+    // G = [Hp; I]
+    Eigen::MatrixXd G(nConstraints, 2*Nc);
+    G << Hp, Eigen::MatrixXd::Identity(2*Nc, 2*Nc);
+    AinvGt = llt.solve(G.transpose());
+    D = G*AinvGt;
+
+    // Jerk bounds are constant
+    _lower.tail(2*Nc).setConstant(-jerkBound);
+    _upper.tail(2*Nc).setConstant(jerkBound);
+    // The working set never holds more than every bound, so that it is not reallocated online
+    _workingRows.reserve(nConstraints);
+    _workingSides.reserve(nConstraints);
+    OCRA_INFO("Constrained ZMP preview controller with " << nConstraints << " bounds and jerk bound " << jerkBound);
+}
+
+ConstrainedZmpPreviewController::~ConstrainedZmpPreviewController() {}
+
+bool ConstrainedZmpPreviewController::computeConstrainedOptimalInput(const Eigen::VectorXd &zmpRef,
+                                                                     const Eigen::VectorXd &comVelRef,
+                                                                     const ComState &hk,
+                                                                     const Eigen::Matrix2d &minMaxBoundingBox,
+                                                                     Eigen::VectorXd &optimalU) {
+    for (int j = 0; j < Np; j++) {
+        _zmpMin.segment(2*j, 2) = minMaxBoundingBox.row(0).transpose();
+        _zmpMax.segment(2*j, 2) = minMaxBoundingBox.row(1).transpose();
+    }
+    return computeConstrainedOptimalInput(zmpRef, comVelRef, hk, _zmpMin, _zmpMax, optimalU);
+}
+
+bool ConstrainedZmpPreviewController::computeConstrainedOptimalInput(const Eigen::VectorXd &zmpRef,
+                                                                     const Eigen::VectorXd &comVelRef,
+                                                                     const ComState &hk,
+                                                                     const Eigen::VectorXd &zmpMin,
+                                                                     const Eigen::VectorXd &zmpMax,
+                                                                     Eigen::VectorXd &optimalU) {
+    const double tolerance = 1e-8;
+
+    // Unconstrained solution and its image through G
+    _U0.noalias() = KZmpFull*zmpRef;
+    _U0.noalias() += KComVelFull*comVelRef;
+    _U0.noalias() += KStateFull*hk;
+    _y0.head(2*Np).noalias() = Hp*_U0;
+    _y0.tail(2*Nc) = _U0;
+
+    // ZMP bounds relative to the free response Gp*hk
+    _freeResponse.noalias() = Gp*hk;
+    _lower.head(2*Np) = zmpMin - _freeResponse;
+    _upper.head(2*Np) = zmpMax - _freeResponse;
+
+    // Warm start from the previous working set, dropping the bounds whose multipliers are not positive anymore
+    shiftWorkingSet();
+    while (!_workingRows.empty()) {
+        const unsigned int n = _workingRows.size();
+        if (!factorizeWorkingSet()) {
+            _workingRows.clear();
+            _workingSides.clear();
+            break;
+        }
+        for (unsigned int i = 0; i < n; i++) {
+            const int r = _workingRows[i];
+            _mu(i) = _workingSides[i] > 0 ? _y0(r) - _upper(r) : _lower(r) - _y0(r);
+        }
+        _L.topLeftCorner(n,n).triangularView<Eigen::Lower>().solveInPlace(_mu.head(n));
+        _L.topLeftCorner(n,n).transpose().triangularView<Eigen::Upper>().solveInPlace(_mu.head(n));
+        unsigned int worst;
+        if (_mu.head(n).minCoeff(&worst) >= 0)
+            break;
+        _workingRows.erase(_workingRows.begin() + worst);
+        _workingSides.erase(_workingSides.begin() + worst);
+    }
+    _inWorkingSet.assign(nConstraints, false);
+    _y = _y0;
+    for (unsigned int i = 0; i < _workingRows.size(); i++) {
+        _inWorkingSet[_workingRows[i]] = true;
+        _y.noalias() -= (_workingSides[i]*_mu(i))*D.col(_workingRows[i]);
+    }
+
+    // Dual active-set iterations: add the most violated bound, dropping the bounds whose multipliers vanish on the way
+    bool converged = false;
+    bool feasible = true;
+    _iterations = 0;
+    while (feasible && _iterations < maxIterations) {
+        double maxViolation = tolerance;
+        int p = -1;
+        double sideP = 0;
+        for (int r = 0; r < nConstraints; r++) {
+            if (_inWorkingSet[r])
+                continue;
+            if (_y(r) - _upper(r) > maxViolation) {
+                maxViolation = _y(r) - _upper(r);
+                p = r;
+                sideP = 1;
+            } else if (_lower(r) - _y(r) > maxViolation) {
+                maxViolation = _lower(r) - _y(r);
+                p = r;
+                sideP = -1;
+            }
+        }
+        if (p < 0) {
+            converged = true;
+            break;
+        }
+
+        double muP = 0;
+        while (_iterations < maxIterations) {
+            _iterations++;
+            const unsigned int n = _workingRows.size();
+            // Change of the multipliers of the working set per unit of muP (z) and of the violation of p (delta),
+            // using the Cholesky factor L of the working set: z = L^-T l, l = L^-1 d_wp
+            if (n > 0) {
+                for (unsigned int i = 0; i < n; i++)
+                    _l(i) = _workingSides[i]*sideP*D(_workingRows[i], p);
+                _L.topLeftCorner(n,n).triangularView<Eigen::Lower>().solveInPlace(_l.head(n));
+                _z.head(n) = _l.head(n);
+                _L.topLeftCorner(n,n).transpose().triangularView<Eigen::Upper>().solveInPlace(_z.head(n));
+            }
+            double delta = D(p,p) - _l.head(n).squaredNorm();
+            // Partial step: first multiplier of the working set reaching zero
+            double partialStep = std::numeric_limits<double>::infinity();
+            unsigned int blocking = 0;
+            for (unsigned int i = 0; i < n; i++) {
+                if (_z(i) > 0 && _mu(i)/_z(i) < partialStep) {
+                    partialStep = _mu(i)/_z(i);
+                    blocking = i;
+                }
+            }
+            // Full step: p becomes active. Infinite if p depends linearly on the working set
+            double violation = sideP > 0 ? _y(p) - _upper(p) : _lower(p) - _y(p);
+            double fullStep = delta > 1e-9*D(p,p) ? violation/delta : std::numeric_limits<double>::infinity();
+            if (std::isinf(partialStep) && std::isinf(fullStep)) {
+                // The bounds cannot be satisfied altogether
+                feasible = false;
+                break;
+            }
+
+            double step = std::min(partialStep, fullStep);
+            _y.noalias() -= (step*sideP)*D.col(p);
+            for (unsigned int i = 0; i < n; i++)
+                _y.noalias() += (step*_workingSides[i]*_z(i))*D.col(_workingRows[i]);
+            _mu.head(n) -= step*_z.head(n);
+            muP += step;
+
+            if (fullStep <= partialStep) {
+                // Append p to the Cholesky factor
+                _L.block(n, 0, 1, n) = _l.head(n).transpose();
+                _L(n,n) = std::sqrt(delta);
+                _inWorkingSet[p] = true;
+                _workingRows.push_back(p);
+                _workingSides.push_back(sideP);
+                _mu(n) = muP;
+                break;
+            }
+            _inWorkingSet[_workingRows[blocking]] = false;
+            _workingRows.erase(_workingRows.begin() + blocking);
+            _workingSides.erase(_workingSides.begin() + blocking);
+            for (unsigned int i = blocking; i + 1 < n; i++)
+                _mu(i) = _mu(i+1);
+            if (!factorizeWorkingSet()) {
+                // The multipliers are not consistent with the working set anymore: use the unconstrained solution
+                _workingRows.clear();
+                _workingSides.clear();
+                feasible = false;
+                break;
+            }
+        }
+    }
+
+    // Only the first input of the horizon is applied
+    optimalU.setZero();
+    optimalU.head(2) = _U0.head(2);
+    for (unsigned int i = 0; i < _workingRows.size(); i++)
+        optimalU.head(2) -= (_workingSides[i]*_mu(i))*AinvGt.block(0, _workingRows[i], 2, 1);
+    return converged;
+}
+
+void ConstrainedZmpPreviewController::shiftWorkingSet() {
+    unsigned int kept = 0;
+    for (unsigned int i = 0; i < _workingRows.size(); i++) {
+        const int r = _workingRows[i];
+        // ZMP bounds occupy rows [0, 2Np) and jerk bounds rows [2Np, 2Np + 2Nc), two rows per step
+        const bool firstStep = r < 2 || (r >= 2*Np && r < 2*Np + 2);
+        if (!firstStep) {
+            _workingRows[kept] = r - 2;
+            _workingSides[kept] = _workingSides[i];
+            kept++;
+        }
+    }
+    _workingRows.resize(kept);
+    _workingSides.resize(kept);
+}
+
+bool ConstrainedZmpPreviewController::factorizeWorkingSet() {
+    // Cholesky factorization of D_WW written row by row in _L, so that no matrix is allocated online. A pivot is
+    // rejected with the same tolerance as a bound added to the working set
+    const unsigned int n = _workingRows.size();
+    for (unsigned int i = 0; i < n; i++) {
+        for (unsigned int j = 0; j <= i; j++) {
+            double entry = _workingSides[i]*_workingSides[j]*D(_workingRows[i], _workingRows[j])
+                           - _L.row(i).head(j).dot(_L.row(j).head(j));
+            if (j < i) {
+                _L(i,j) = entry/_L(j,j);
+            } else {
+                if (entry <= 1e-9*D(_workingRows[i], _workingRows[i]))
+                    return false;
+                _L(i,i) = std::sqrt(entry);
+            }
+        }
+    }
+    return true;
+}
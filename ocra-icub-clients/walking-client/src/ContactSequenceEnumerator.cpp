@@ -0,0 +1,152 @@
+#include "walking-client/ContactSequenceEnumerator.h"
+
+namespace {
+    /** Returns true if row r of M has nonzero coefficients outside of the binary columns */
+    bool touchesContinuousVariables(const Eigen::MatrixXd &M, unsigned int r) {
+        for (unsigned int c = 0; c < M.cols(); c++) {
+            bool isBinaryColumn = (c >= FIRST_BINARY_INDEX) && (c < FIRST_BINARY_INDEX + BINARIES_PER_STEP);
+            if (!isBinaryColumn && M(r,c) != 0)
+                return true;
+        }
+        return false;
+    }
+
+    /** Decodes a binary configuration into a 6-vector [alpha_x alpha_y beta_x beta_y delta gamma] */
+    Eigen::VectorXd decode(unsigned int code) {
+        Eigen::VectorXd b(BINARIES_PER_STEP);
+        for (unsigned int i = 0; i < BINARIES_PER_STEP; i++)
+            b(i) = (code >> i) & 1u;
+        return b;
+    }
+}
+
+ContactSequenceEnumerator::ContactSequenceEnumerator(const Eigen::MatrixXd &Ci,
+                                                     const Eigen::MatrixXd &Cii,
+                                                     const Eigen::VectorXd &d,
+                                                     const Eigen::MatrixXd &Ceq,
+                                                     unsigned int N,
+                                                     unsigned int decisionSteps,
+                                                     unsigned int maxSequences) :
+_N(N),
+_decisionSteps(decisionSteps < N ? decisionSteps : N),
+_maxSequences(maxSequences),
+_transitions(BINARY_CONFIGURATIONS),
+_sequences(BINARY_CONFIGURATIONS),
+_truncated(false)
+{
+    // Keep only the rows that exclusively involve binary variables
+    std::vector<unsigned int> binaryRows;
+    for (unsigned int r = 0; r < Ci.rows(); r++) {
+        if (!touchesContinuousVariables(Ci, r) && !touchesContinuousVariables(Cii, r))
+            binaryRows.push_back(r);
+    }
+    _Ci.resize(binaryRows.size(), BINARIES_PER_STEP);
+    _Cii.resize(binaryRows.size(), BINARIES_PER_STEP);
+    _d.resize(binaryRows.size());
+    for (unsigned int i = 0; i < binaryRows.size(); i++) {
+        _Ci.row(i) = Ci.block(binaryRows[i], FIRST_BINARY_INDEX, 1, BINARIES_PER_STEP);
+        _Cii.row(i) = Cii.block(binaryRows[i], FIRST_BINARY_INDEX, 1, BINARIES_PER_STEP);
+        _d(i) = d(binaryRows[i]);
+    }
+    OCRA_INFO("ContactSequenceEnumerator kept " << binaryRows.size() << " out of " << Ci.rows() << " admissibility constraints");
+
+    _Ceq.resize(Ceq.rows(), BINARIES_PER_STEP);
+    for (unsigned int r = 0; r < Ceq.rows(); r++) {
+        if (touchesContinuousVariables(Ceq, r)) {
+            OCRA_WARNING("Equality constraint " << r << " involves continuous variables and will be ignored by the enumerator");
+            _Ceq.row(r).setZero();
+        } else {
+            _Ceq.row(r) = Ceq.block(r, FIRST_BINARY_INDEX, 1, BINARIES_PER_STEP);
+        }
+    }
+
+    // Precompute the 64x64 transition table once
+    for (unsigned int from = 0; from < BINARY_CONFIGURATIONS; from++) {
+        for (unsigned int to = 0; to < BINARY_CONFIGURATIONS; to++) {
+            if (isAdmissibleTransition(from, to))
+                _transitions[from].push_back(to);
+        }
+    }
+}
+
+ContactSequenceEnumerator::~ContactSequenceEnumerator() {}
+
+bool ContactSequenceEnumerator::isAdmissibleTransition(unsigned int from, unsigned int to) const {
+    Eigen::VectorXd prev = decode(from);
+    Eigen::VectorXd next = decode(to);
+    if (_Ceq.rows() > 0 && !(_Ceq*next).isZero())
+        return false;
+    if (_Ci.rows() == 0)
+        return true;
+    return ((_Ci*prev + _Cii*next - _d).array() <= 0).all();
+}
+
+bool ContactSequenceEnumerator::holdConfiguration(unsigned int previous, unsigned int &next) const {
+    // Bits 0-3 are the edges alpha and beta, bits 4-5 are delta and gamma
+    const unsigned int edgesMask = 0x0F;
+    bool found = false;
+    for (unsigned int candidate : _transitions[previous]) {
+        if (candidate & edgesMask)
+            continue;
+        if (candidate == (previous & ~edgesMask)) {
+            next = candidate;
+            return true;
+        }
+        if (!found) {
+            next = candidate;
+            found = true;
+        }
+    }
+    return found;
+}
+
+unsigned int ContactSequenceEnumerator::enumerate() {
+    unsigned int total = 0;
+    _truncated = false;
+    Eigen::VectorXd sequence(BINARIES_PER_STEP*_N);
+    for (unsigned int initial = 0; initial < BINARY_CONFIGURATIONS; initial++) {
+        _sequences[initial].clear();
+        sequence.setZero();
+        search(initial, 0, initial, sequence);
+        total += _sequences[initial].size();
+    }
+    if (_truncated)
+        OCRA_WARNING("Enumeration of contact sequences was truncated to " << _maxSequences << " sequences per initial configuration");
+    OCRA_INFO("Enumerated " << total << " admissible contact sequences with " << _decisionSteps << " decision steps over a preview window of " << _N << " steps");
+    return total;
+}
+
+void ContactSequenceEnumerator::search(unsigned int initial, unsigned int step, unsigned int previous, Eigen::VectorXd &sequence) {
+    if (_sequences[initial].size() >= _maxSequences) {
+        _truncated = true;
+        return;
+    }
+    if (step == _decisionSteps) {
+        // Hold the contact configuration over the rest of the preview window
+        unsigned int held = previous;
+        for (unsigned int j = step; j < _N; j++) {
+            if (!holdConfiguration(held, held))
+                return;
+            sequence.segment(j*BINARIES_PER_STEP, BINARIES_PER_STEP) = decode(held);
+        }
+        _sequences[initial].push_back(sequence);
+        return;
+    }
+    for (unsigned int next : _transitions[previous]) {
+        sequence.segment(step*BINARIES_PER_STEP, BINARIES_PER_STEP) = decode(next);
+        search(initial, step + 1, next, sequence);
+    }
+}
+
+const std::vector<Eigen::VectorXd>& ContactSequenceEnumerator::getSequences(const Eigen::VectorXd &xi_k) const {
+    return _sequences[encodeBinaries(xi_k)];
+}
+
+unsigned int ContactSequenceEnumerator::encodeBinaries(const Eigen::VectorXd &xi_k) {
+    unsigned int code = 0;
+    for (unsigned int i = 0; i < BINARIES_PER_STEP; i++) {
+        if (xi_k(FIRST_BINARY_INDEX + i) > 0.5)
+            code |= (1u << i);
+    }
+    return code;
+}
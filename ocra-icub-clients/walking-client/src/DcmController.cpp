@@ -0,0 +1,96 @@
+#include "walking-client/DcmController.h"
+#include <algorithm>
+#include <cmath>
+#include <ocra/util/ErrorsHelper.h>
+
+namespace {
+    // Same gravity acceleration as ZmpPreviewController
+    const double GRAVITY = 9.8;
+}
+
+DcmController::DcmController(const double period, const DcmControllerParams &parameters) :
+_dt(period/1000.0),
+_omega(std::sqrt(GRAVITY/parameters.cz)),
+_kDcm(parameters.kDcm),
+_finalZmp(Eigen::Vector2d::Zero()),
+_segment(0)
+{
+}
+
+DcmController::~DcmController() {}
+
+void DcmController::setPlan(const Eigen::Vector2d &initialZmp, const std::vector<ZmpFootstep> &plan) {
+    _segmentStart.clear();
+    _segmentDuration.clear();
+    _segmentZmp.clear();
+    _segmentZmpVelocity.clear();
+    _segment = 0;
+
+    // Forward pass: double support segment from the previous footstep, then single support segment on the footstep
+    double t = 0;
+    Eigen::Vector2d from = initialZmp;
+    for (const ZmpFootstep &footstep : plan) {
+        if (footstep.dsDuration > 0) {
+            _segmentStart.push_back(t);
+            _segmentDuration.push_back(footstep.dsDuration);
+            _segmentZmp.push_back(from);
+            _segmentZmpVelocity.push_back((footstep.position - from)/footstep.dsDuration);
+            t += footstep.dsDuration;
+        }
+        if (footstep.ssDuration > 0) {
+            _segmentStart.push_back(t);
+            _segmentDuration.push_back(footstep.ssDuration);
+            _segmentZmp.push_back(footstep.position);
+            _segmentZmpVelocity.push_back(Eigen::Vector2d::Zero());
+            t += footstep.ssDuration;
+        }
+        from = footstep.position;
+    }
+    _finalZmp = from;
+
+    // Backward pass: the robot comes to rest on the last footstep
+    _segmentDcm.resize(_segmentStart.size());
+    Eigen::Vector2d dcmEnd = _finalZmp;
+    for (int i = (int) _segmentStart.size() - 1; i >= 0; i--) {
+        const double T = _segmentDuration[i];
+        const Eigen::Vector2d offset = _segmentZmp[i] + _segmentZmpVelocity[i]/_omega;
+        _segmentDcm[i] = offset + (dcmEnd - offset - _segmentZmpVelocity[i]*T)*std::exp(-_omega*T);
+        dcmEnd = _segmentDcm[i];
+    }
+    OCRA_INFO("DCM plan with " << _segmentStart.size() << " segments lasting " << getPlanDuration() << "s");
+}
+
+void DcmController::getReference(const double t, Eigen::Vector2d &zmpRef, Eigen::Vector2d &dcmRef) {
+    if (_segmentStart.empty() || t >= getPlanDuration()) {
+        zmpRef = _finalZmp;
+        dcmRef = _finalZmp;
+        return;
+    }
+    // Times are expected to be non-decreasing, so the search rarely goes beyond the next segment
+    if (t < _segmentStart[_segment])
+        _segment = 0;
+    while (_segment + 1 < _segmentStart.size() && t >= _segmentStart[_segment + 1])
+        _segment++;
+
+    const double tau = std::max(0.0, t - _segmentStart[_segment]);
+    const Eigen::Vector2d &a = _segmentZmp[_segment];
+    const Eigen::Vector2d &v = _segmentZmpVelocity[_segment];
+    zmpRef = a + v*tau;
+    dcmRef = zmpRef + v/_omega + (_segmentDcm[_segment] - a - v/_omega)*std::exp(_omega*tau);
+}
+
+void DcmController::computeControl(const double t, const ComState &hk, Eigen::Vector2d &zmpCommand, ComState &hkk) {
+    Eigen::Vector2d zmpRef, dcmRef;
+    getReference(t, zmpRef, dcmRef);
+    zmpCommand = zmpRef + (1.0 + _kDcm/_omega)*(computeDcm(hk) - dcmRef);
+
+    // LIPM: the CoM acceleration is given by the ZMP command
+    const Eigen::Vector2d comAcceleration = _omega*_omega*(hk.head<2>() - zmpCommand);
+    hkk.head<2>() = hk.head<2>() + _dt*hk.segment<2>(2) + (_dt*_dt/2.0)*comAcceleration;
+    hkk.segment<2>(2) = hk.segment<2>(2) + _dt*comAcceleration;
+    hkk.tail<2>() = comAcceleration;
+}
+
+Eigen::Vector2d DcmController::computeDcm(const ComState &hk) const {
+    return hk.head<2>() + hk.segment<2>(2)/_omega;
+}
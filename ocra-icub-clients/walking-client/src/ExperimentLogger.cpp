@@ -0,0 +1,216 @@
+#include "walking-client/ExperimentLogger.h"
+#include <ocra/util/ErrorsHelper.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdint.h>
+#include <sys/stat.h>
+
+namespace {
+    const char MAGIC[8] = {'W', 'C', 'L', 'O', 'G', '0', '0', '1'};
+
+    /**
+     * Creates a directory and its parents, like mkdir -p.
+     */
+    bool makeDirectory(const std::string &path) {
+        for (std::string::size_type i = 1; i <= path.size(); i++) {
+            if (i < path.size() && path[i] != '/')
+                continue;
+            std::string parent = path.substr(0, i);
+            if (mkdir(parent.c_str(), 0755) != 0 && errno != EEXIST)
+                return false;
+        }
+        return true;
+    }
+}
+
+ExperimentLogger::ExperimentLogger(const std::string &directory, const unsigned int bufferSize, const double flushPeriod) :
+_directory(directory),
+_bufferSize(std::max(1u, bufferSize)),
+_flushPeriod(flushPeriod),
+_running(false),
+_started(false),
+_dropped(0)
+{}
+
+ExperimentLogger::~ExperimentLogger() {
+    stop();
+}
+
+int ExperimentLogger::addChannel(const std::string &name, const unsigned int width) {
+    if (_started) {
+        OCRA_ERROR("Channel " << name << " can't be added once the logger has been started");
+        return -1;
+    }
+    if (name.empty() || name.find('/') != std::string::npos) {
+        OCRA_ERROR("Invalid channel name '" << name << "'");
+        return -1;
+    }
+    for (unsigned int i = 0; i < _channels.size(); i++) {
+        if (_channels[i]->name == name) {
+            OCRA_ERROR("Channel " << name << " already exists");
+            return -1;
+        }
+    }
+    std::unique_ptr<Channel> channel(new Channel);
+    channel->name = name;
+    channel->width = width;
+    channel->buffer.assign(_bufferSize*(1 + width), 0.0);
+    channel->written.store(0);
+    channel->read.store(0);
+    channel->file = NULL;
+    if (_block.size() < channel->buffer.size())
+        _block.resize(channel->buffer.size());
+    _channels.push_back(std::move(channel));
+    return _channels.size() - 1;
+}
+
+bool ExperimentLogger::start() {
+    if (_started) {
+        OCRA_ERROR("The logger of " << _directory << " can only be started once");
+        return false;
+    }
+    if (!makeDirectory(_directory)) {
+        OCRA_ERROR("Could not create the log directory " << _directory << ": " << std::strerror(errno));
+        return false;
+    }
+    _started = true;
+    _running.store(true);
+    _writer = std::thread(&ExperimentLogger::writerLoop, this);
+    return true;
+}
+
+void ExperimentLogger::stop() {
+    if (!_running.exchange(false))
+        return;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _wakeUp.notify_one();
+    }
+    _writer.join();
+    flush();
+    for (unsigned int i = 0; i < _channels.size(); i++) {
+        if (_channels[i]->file) {
+            std::fclose(_channels[i]->file);
+            _channels[i]->file = NULL;
+        }
+    }
+    if (_dropped.load() > 0)
+        OCRA_WARNING(_dropped.load() << " samples were dropped by the logger of " << _directory << ". Consider a larger buffer");
+}
+
+bool ExperimentLogger::log(const int channel, const double time, const Eigen::Ref<const Eigen::VectorXd> &values) {
+    if (!_running.load(std::memory_order_relaxed) || channel < 0 || channel >= (int) _channels.size())
+        return false;
+    Channel &c = *_channels[channel];
+    if (values.size() != c.width)
+        return false;
+    const unsigned long written = c.written.load(std::memory_order_relaxed);
+    if (written - c.read.load(std::memory_order_acquire) >= _bufferSize) {
+        _dropped++;
+        return false;
+    }
+    double *sample = &c.buffer[(written % _bufferSize)*(1 + c.width)];
+    sample[0] = time;
+    Eigen::Map<Eigen::VectorXd>(sample + 1, c.width) = values;
+    c.written.store(written + 1, std::memory_order_release);
+    return true;
+}
+
+bool ExperimentLogger::log(const int channel, const double time, const double value) {
+    return log(channel, time, Eigen::Matrix<double, 1, 1>::Constant(value));
+}
+
+void ExperimentLogger::writerLoop() {
+    const std::chrono::microseconds period((long) (_flushPeriod*1e6));
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_running.load()) {
+        _wakeUp.wait_for(lock, period, [this] { return !_running.load(); });
+        flush();
+    }
+}
+
+void ExperimentLogger::flush() {
+    for (unsigned int i = 0; i < _channels.size(); i++) {
+        Channel &c = *_channels[i];
+        const unsigned long read = c.read.load(std::memory_order_relaxed);
+        const unsigned long written = c.written.load(std::memory_order_acquire);
+        const uint32_t n = written - read;
+        if (n == 0)
+            continue;
+
+        if (!c.file) {
+            std::string path = _directory + "/" + c.name + ".bin";
+            c.file = std::fopen(path.c_str(), "wb");
+            if (!c.file) {
+                OCRA_ERROR("Could not open " << path << ". Its samples are discarded");
+                c.read.store(written, std::memory_order_release);
+                continue;
+            }
+            const uint32_t width = c.width;
+            const uint32_t nameLength = c.name.size();
+            std::fwrite(MAGIC, 1, sizeof(MAGIC), c.file);
+            std::fwrite(&width, sizeof(width), 1, c.file);
+            std::fwrite(&nameLength, sizeof(nameLength), 1, c.file);
+            std::fwrite(c.name.data(), 1, nameLength, c.file);
+        }
+
+        // Transpose the buffered samples into columns
+        const unsigned int stride = 1 + c.width;
+        for (uint32_t s = 0; s < n; s++) {
+            const double *sample = &c.buffer[((read + s) % _bufferSize)*stride];
+            for (unsigned int j = 0; j < stride; j++)
+                _block[j*n + s] = sample[j];
+        }
+        c.read.store(written, std::memory_order_release);
+
+        std::fwrite(&n, sizeof(n), 1, c.file);
+        std::fwrite(_block.data(), sizeof(double), n*stride, c.file);
+        std::fflush(c.file);
+    }
+}
+
+bool ExperimentLogger::readChannel(const std::string &path, std::string &name, Eigen::MatrixXd &samples) {
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        OCRA_ERROR("Could not open " << path);
+        return false;
+    }
+    char magic[sizeof(MAGIC)];
+    uint32_t width, nameLength;
+    if (std::fread(magic, 1, sizeof(magic), file) != sizeof(magic) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0
+        || std::fread(&width, sizeof(width), 1, file) != 1 || std::fread(&nameLength, sizeof(nameLength), 1, file) != 1) {
+        OCRA_ERROR(path << " is not a channel of an experiment log");
+        std::fclose(file);
+        return false;
+    }
+    name.resize(nameLength);
+    if (nameLength > 0 && std::fread(&name[0], 1, nameLength, file) != nameLength) {
+        OCRA_ERROR(path << " is not a channel of an experiment log");
+        std::fclose(file);
+        return false;
+    }
+
+    const unsigned int stride = 1 + width;
+    std::vector<Eigen::MatrixXd> blocks;
+    unsigned int rows = 0;
+    uint32_t n;
+    while (std::fread(&n, sizeof(n), 1, file) == 1) {
+        Eigen::MatrixXd block(n, stride);
+        if (std::fread(block.data(), sizeof(double), block.size(), file) != (size_t) block.size()) {
+            OCRA_WARNING("The last block of " << path << " is truncated. Its " << n << " samples are ignored");
+            break;
+        }
+        rows += n;
+        blocks.push_back(block);
+    }
+    std::fclose(file);
+
+    samples.resize(rows, stride);
+    rows = 0;
+    for (unsigned int i = 0; i < blocks.size(); i++) {
+        samples.middleRows(rows, blocks[i].rows()) = blocks[i];
+        rows += blocks[i].rows();
+    }
+    return true;
+}
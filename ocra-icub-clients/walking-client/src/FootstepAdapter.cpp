@@ -0,0 +1,85 @@
+#include "walking-client/FootstepAdapter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Same gravity acceleration as ZmpPreviewController
+    const double GRAVITY = 9.8;
+}
+
+FootstepAdapter::FootstepAdapter(const FootstepAdaptationParams &params) :
+_params(params),
+_omega(std::sqrt(GRAVITY/params.cz)),
+_predictedError(Eigen::Vector2d::Zero())
+{
+}
+
+FootstepAdapter::~FootstepAdapter() {}
+
+Eigen::Vector2d FootstepAdapter::computeCapturePoint(const ComState &hk) const {
+    return hk.head<2>() + hk.segment<2>(2)/_omega;
+}
+
+Eigen::Vector2d FootstepAdapter::computeCapturePointReference(const Eigen::VectorXd &zmpRef, const double dt) const {
+    // Weight of every sample: integral of omega*exp(-omega*s) over its period
+    const double decay = std::exp(-_omega*dt);
+    const int n = zmpRef.size()/2;
+    double weight = 1.0;
+    Eigen::Vector2d capturePoint = Eigen::Vector2d::Zero();
+    for (int j = 0; j < n; j++) {
+        capturePoint += (weight*(1.0 - decay))*zmpRef.segment<2>(2*j);
+        weight *= decay;
+    }
+    // The last reference is held after the end of the window
+    if (n > 0)
+        capturePoint += weight*zmpRef.segment<2>(2*(n-1));
+    return capturePoint;
+}
+
+bool FootstepAdapter::adapt(const ComState &hk,
+                            const Eigen::Vector2d &capturePointRef,
+                            const Eigen::Vector2d &zmp,
+                            const Eigen::Vector2d &zmpRef,
+                            const double timeToLanding,
+                            const double stepDuration,
+                            const Eigen::Vector2d &plannedTarget,
+                            const Eigen::Vector2d &stanceFoot,
+                            Eigen::Vector2d &target,
+                            double &duration) {
+    const double tau = std::max(0.0, std::min(timeToLanding, _params.maxPredictionTime));
+    const Eigen::Vector2d dp = zmp - zmpRef;
+    const Eigen::Vector2d a = computeCapturePoint(hk) - capturePointRef - dp;
+    _predictedError = a*std::exp(_omega*tau) + dp;
+
+    // Footstep displacement, bounded by maxAdjustment
+    bool saturated = false;
+    Eigen::Vector2d adjustment = _params.gain*_predictedError;
+    for (int i = 0; i < 2; i++) {
+        if (std::abs(adjustment(i)) > _params.maxAdjustment(i)) {
+            adjustment(i) = std::copysign(_params.maxAdjustment(i), adjustment(i));
+            saturated = true;
+        }
+    }
+    target = plannedTarget + adjustment;
+
+    // Don't cross (nor get too close to) the stance foot
+    const double side = plannedTarget(1) >= stanceFoot(1) ? 1.0 : -1.0;
+    if (side*(target(1) - stanceFoot(1)) < _params.minFeetWidth)
+        target(1) = stanceFoot(1) + side*_params.minFeetWidth;
+
+    // When the displacement is saturated, land earlier: find the time to landing tau' at which the predicted error
+    // reaches the bound, i.e. a*exp(omega*tau') + dp = sign(a)*maxAdjustment/gain
+    duration = stepDuration;
+    if (saturated && _params.gain > 0) {
+        double tauBound = tau;
+        for (int i = 0; i < 2; i++) {
+            if (std::abs(_params.gain*_predictedError(i)) <= _params.maxAdjustment(i) || a(i) == 0)
+                continue;
+            const double ratio = (std::copysign(_params.maxAdjustment(i)/_params.gain, a(i)) - dp(i))/a(i);
+            // The ZMP error alone exceeds the bound: land as early as possible
+            tauBound = std::min(tauBound, ratio > 0 ? std::log(ratio)/_omega : 0.0);
+        }
+        duration = std::max(_params.minStepDuration, std::min(stepDuration, stepDuration + tauBound - tau));
+    }
+    return saturated;
+}
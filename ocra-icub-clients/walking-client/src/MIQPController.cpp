@@ -13,6 +13,12 @@ _lb(Eigen::VectorXd(INPUT_VECTOR_SIZE*_miqpParams.N)),
 _ub(Eigen::VectorXd(INPUT_VECTOR_SIZE*_miqpParams.N)),
 _xi_k(Eigen::VectorXd(STATE_VECTOR_SIZE)),
 _X_kn(Eigen::VectorXd(INPUT_VECTOR_SIZE*_miqpParams.N)),
+_xi_k_timestamp(0),
+_previewModel(std::make_shared<MIQPPreviewModel>(_miqpParams)),
+_solutionChannel(std::make_shared<MIQPSolutionChannel>(_previewModel->getPreviewTimes())),
+_useRecordedBoundingBox(false),
+_lastObjective(0),
+_lastNodeCount(0),
 _Ah(Eigen::MatrixXd(6,6)),
 _Bh(Eigen::MatrixXd(6,2)),
 _Q(Eigen::MatrixXd(STATE_VECTOR_SIZE, STATE_VECTOR_SIZE)),
@@ -27,7 +33,8 @@ _R_H(_C_H.rows()*_miqpParams.N, _T.cols()*_miqpParams.N),
 _R_P(_C_P.rows()*_miqpParams.N, _T.cols()*_miqpParams.N),
 _R_B(_C_B.rows()*_miqpParams.N, _T.cols()*_miqpParams.N),
 _Sw(_R_H.rows(), _R_H.rows()),
-_H_N_r(6*_miqpParams.N)
+_H_N_r(6*_miqpParams.N),
+_replaySample(STATE_VECTOR_SIZE + 6)
 
 {
     buildAh(_period, _Ah);
@@ -104,6 +111,76 @@ _H_N_r(6*_miqpParams.N)
     _k = 0;
 }
 
+void MIQPController::loadParameters(const yarp::os::Searchable &group, MIQPParameters &miqpParams) {
+    miqpParams.dCoMxRef = group.find("dCoMxRef").asDouble();
+    miqpParams.dCoMyRef = group.find("dCoMyRef").asDouble();
+    miqpParams.dt = (unsigned int) group.find("dt").asInt();
+    miqpParams.dtThread = (unsigned int) group.find("dtThread").asInt();
+    miqpParams.g = group.find("g").asDouble();
+    miqpParams.N = group.find("N").asInt();
+    miqpParams.sx_constancy = group.find("sx_constancy").asDouble();
+    miqpParams.sy_constancy = group.find("sy_constancy").asDouble();
+    miqpParams.sx_ss = group.find("sx_ss").asDouble();
+    miqpParams.sy_ss = group.find("sy_ss").asDouble();
+    miqpParams.hx_ref = group.find("hx_ref").asDouble();
+    miqpParams.hy_ref = group.find("hy_ref").asDouble();
+    miqpParams.dhx_ref = group.find("dhx_ref").asDouble();
+    miqpParams.dhy_ref = group.find("dhy_ref").asDouble();
+    miqpParams.ddhx_ref = group.find("ddhx_ref").asDouble();
+    miqpParams.ddhy_ref =group.find("ddhy_ref").asDouble();
+    miqpParams.ww = group.find("ww").asDouble();
+    miqpParams.wb = group.find("wb").asDouble();
+    miqpParams.wu = group.find("wu").asDouble();
+    miqpParams.wss = group.find("wss").asDouble();
+    miqpParams.wstep = group.find("wstep").asDouble();
+    miqpParams.wdelta = group.find("wdelta").asDouble();
+    miqpParams.shapeConstraints = group.find("shapeConstraints").asBool();
+    miqpParams.admissibilityConstraints = group.find("admissibilityConstraints").asBool();
+    miqpParams.copConstraints = group.find("copConstraints").asBool();
+    miqpParams.walkingConstraints = group.find("walkingConstraints").asBool();
+    miqpParams.addRegularization = group.find("addRegularization").asBool();
+    miqpParams.robot = group.find("robot").asString();
+    miqpParams.marginCoPBounds = group.find("marginCoPBounds").asDouble();
+    miqpParams.explicitModeSequences = group.check("explicitModeSequences", yarp::os::Value(false)).asBool();
+    miqpParams.modeDecisionSteps = group.check("modeDecisionSteps", yarp::os::Value(3)).asInt();
+    miqpParams.maxModeSequences = group.check("maxModeSequences", yarp::os::Value(2000)).asInt();
+    miqpParams.nSolverThreads = group.check("nSolverThreads", yarp::os::Value(4)).asInt();
+    // Multi-rate preview window. Either an explicit list of step durations or nFineSteps steps of dt followed
+    // by steps of dtCoarse. Uniform by default
+    miqpParams.dtPreview.clear();
+    yarp::os::Bottle *dtPreview = group.find("dtPreview").asList();
+    if (dtPreview) {
+        for (int i = 0; i < dtPreview->size(); i++)
+            miqpParams.dtPreview.push_back(dtPreview->get(i).asInt());
+        if (miqpParams.dtPreview.size() != miqpParams.N) {
+            OCRA_ERROR("dtPreview has " << miqpParams.dtPreview.size() << " steps instead of N = " << miqpParams.N << ". Using nFineSteps and dtCoarse instead");
+            miqpParams.dtPreview.clear();
+        }
+    }
+    if (miqpParams.dtPreview.empty()) {
+        unsigned int nFineSteps = group.check("nFineSteps", yarp::os::Value((int) miqpParams.N)).asInt();
+        unsigned int dtCoarse = group.check("dtCoarse", yarp::os::Value((int) miqpParams.dt)).asInt();
+        if (nFineSteps > miqpParams.N)
+            nFineSteps = miqpParams.N;
+        miqpParams.dtPreview.assign(miqpParams.N, dtCoarse);
+        std::fill(miqpParams.dtPreview.begin(), miqpParams.dtPreview.begin() + nFineSteps, miqpParams.dt);
+    }
+    // Move blocking of the binary variables. No blocking by default
+    miqpParams.binaryBlocks.clear();
+    yarp::os::Bottle *binaryBlocks = group.find("binaryBlocks").asList();
+    if (binaryBlocks) {
+        for (int i = 0; i < binaryBlocks->size(); i++)
+            miqpParams.binaryBlocks.push_back(binaryBlocks->get(i).asInt());
+    }
+    miqpParams.FzThreshold = group.check("FzThreshold", yarp::os::Value(5.0)).asDouble();
+    miqpParams.PzThreshold = group.check("PzThreshold", yarp::os::Value(0.05)).asDouble();
+    miqpParams.changeThreshold = group.check("changeThreshold", yarp::os::Value(0.015)).asDouble();
+    miqpParams.abBounds = group.check("abBounds", yarp::os::Value(1.0)).asDouble();
+    miqpParams.uBounds = group.check("uBounds", yarp::os::Value(10.0)).asDouble();
+    miqpParams.comRampSamples = std::max(0, group.check("comRampSamples", yarp::os::Value(0)).asInt());
+    miqpParams.comCruiseSamples = std::max(0, group.check("comCruiseSamples", yarp::os::Value(0)).asInt());
+}
+
 MIQPController::~MIQPController() {
 //    OCRA_WARNING("Built an MIQP Controller object");
 }
@@ -111,15 +188,38 @@ MIQPController::~MIQPController() {
 bool MIQPController::threadInit() {
 
     // Instantiate MIQP state object
-    _state = std::make_shared<MIQPState>(_robotModel, _miqpParams.robot);
+    _state = std::allocate_shared<MIQPState>(Eigen::aligned_allocator<MIQPState>(), _robotModel, _miqpParams);
     updateStateVector();
 
+    initializeProblem();
+
+    // The preview windows are logged once, at the first iteration
+    _logger = std::make_shared<ExperimentLogger>(_miqpParams.home + "MIQP/", std::max(2000u, _miqpParams.N));
+    _replayChannel = _logger->addChannel("replay", STATE_VECTOR_SIZE + 6);
+    _solutionLogChannel = _logger->addChannel("solution", INPUT_VECTOR_SIZE);
+    _solutionInPreviewChannel = _logger->addChannel("solutionInPreview", INPUT_VECTOR_SIZE);
+    _copInPreviewChannel = _logger->addChannel("CoPinPreview", 2);
+    _bosInPreviewChannel = _logger->addChannel("BoSinPreview", 2);
+    _comInPreviewChannel = _logger->addChannel("CoMinPreview", 6);
+    _comRefInPreviewChannel = _logger->addChannel("CoMRefinPreview", 6);
+    if (!_logger->start())
+        OCRA_WARNING("MIQPController won't log anything");
+    _tPreview.resize(_miqpParams.N);
+    _P_kN.resize(2*_miqpParams.N);
+    _r_kN.resize(2*_miqpParams.N);
+    _H_kN.resize(6*_miqpParams.N);
+
+    OCRA_WARNING("Finished MIQPController initialization. This thread will run at " << this->getRate() << " ms");
+    return true;
+}
+
+bool MIQPController::initializeProblem() {
     // Set lower and upper bounds
     setLowerAndUpperBounds();
 
     // Instantiate MIQPLinearConstraints object and update constraints matrix _Aineq
     // FIXME: Missing walking constraints.
-    _constraints = std::make_shared<MIQPLinearConstraints>(_stepController, _miqpParams);
+    _constraints = std::make_shared<MIQPLinearConstraints>(_stepController, _previewModel, _miqpParams);
     _Aineq.resize(_constraints->getTotalNumberOfConstraints(),  INPUT_VECTOR_SIZE * _miqpParams.N );
     _constraints->getConstraintsMatrixA(_Aineq);
 
@@ -135,113 +235,273 @@ bool MIQPController::threadInit() {
 
     // Setup eigen-gurobi object with 12*N variables, N equality constraints and rows-of-Aineq inequality constraints.
     try {
-        OCRA_INFO("About to build eigen-gurobi problem");
-        _eigGurobi.problem(INPUT_VECTOR_SIZE*_miqpParams.N, _Aeq.rows(), _Aineq.rows());
-
-        // In the previous initialization all variables are assumed continuous by default.
-        setBinaryVariables();
+        if (_miqpParams.explicitModeSequences) {
+            // Offline enumeration of the admissible contact sequences. Online only continuous QPs are solved.
+            AdmissibilityConstraints admissibility(_miqpParams);
+            admissibility.init();
+            _sequenceEnumerator = std::make_shared<ContactSequenceEnumerator>(admissibility.getCi(),
+                                                                              admissibility.getCii(),
+                                                                              admissibility.getd(),
+                                                                              _Ci_eq,
+                                                                              _miqpParams.N,
+                                                                              _miqpParams.modeDecisionSteps,
+                                                                              _miqpParams.maxModeSequences);
+            _sequenceEnumerator->enumerate();
+            if (_previewModel->isBlocked())
+                OCRA_WARNING("binaryBlocks is ignored when solving precomputed contact sequences");
+
+            unsigned int nThreads = std::max(1u, _miqpParams.nSolverThreads);
+            for (unsigned int i = 0; i < nThreads; i++) {
+                std::shared_ptr<MIQPSolver> worker = std::make_shared<MIQPSolver>();
+                // All variables are continuous. Binaries will be fixed through their bounds.
+                worker->problem(INPUT_VECTOR_SIZE*_miqpParams.N, _Aeq.rows(), _Aineq.rows());
+                _qpWorkers.push_back(worker);
+            }
+            OCRA_INFO("Built " << nThreads << " continuous QP workers for the precomputed contact sequences");
+        } else {
+            OCRA_INFO("About to build eigen-gurobi problem");
+            // The Gurobi environment is created here, and throws if no license is available
+            _eigGurobi = std::make_shared<MIQPSolver>();
+            if (_previewModel->isBlocked()) {
+                buildBlockedProblem();
+                _eigGurobi->problem(_previewModel->getReducedSize(), _Aeq.rows(), _Aineq.rows());
+            } else {
+                _eigGurobi->problem(INPUT_VECTOR_SIZE*_miqpParams.N, _Aeq.rows(), _Aineq.rows());
+            }
+
+            // In the previous initialization all variables are assumed continuous by default.
+            setBinaryVariables();
+        }
     }
     catch (GRBException e) {
         std::cout << "Error code = " << e.getErrorCode() << std::endl;
         std::cout << e.getMessage() << std::endl;
+        _eigGurobi.reset();
+        _qpWorkers.clear();
+        return false;
     }
-
-    OCRA_WARNING("Finished MIQPController initialization. This thread will run at " << this->getRate() << " ms");
     return true;
 }
 
 void MIQPController::threadRelease() {
+    if (_logger)
+        _logger->stop();
 }
 
 void MIQPController::run() {
     // Update state vector
     updateStateVector();
 
+    solveProblem(_k);
+
+    _k++;
+    
+    // NOTE: LOGGING SECTION
+    // Log solution for plots
+    // Recorded state and CoM reference, to be replayed offline by miqp-replay
+    _replaySample << _xi_k, _comStateRef.row(std::min(_k - 1, (unsigned int) _comStateRef.rows() - 1)).transpose();
+    _logger->log(_replayChannel, _xi_k_timestamp, _replaySample);
+//     writeToFile(_miqpParams.dt*_k, _X_kn.topRows(INPUT_VECTOR_SIZE));
+    // Log the first solution in the WHOLE preview horizon, timestamped at every step of the window
+    // FIXME: This is simply a test done in open loop to see if the solution makes sense in the first preview window.
+    if (_k==1) {
+        _tPreview[0] = _xi_k_timestamp;
+        for (unsigned int i = 1; i < _miqpParams.N; i++)
+            _tPreview[i] = _tPreview[i-1] + (double) _miqpParams.dtPreview[i-1]/1000;
+        for (unsigned int i = 0; i <= _miqpParams.N-1; i++)
+            _logger->log(_solutionInPreviewChannel, _tPreview[i], _X_kn.segment(i*INPUT_VECTOR_SIZE,INPUT_VECTOR_SIZE));
+
+        // Log the first full previewed CoP, center of BoS and CoM
+        _P_kN.noalias() = _P_P*_xi_k;
+        _P_kN.noalias() += _R_P*_X_kn;
+        _r_kN.noalias() = _P_B*_xi_k;
+        _r_kN.noalias() += _R_B*_X_kn;
+        _H_kN.noalias() = _P_H*_xi_k;
+        _H_kN.noalias() += _R_H*_X_kn;
+        for (unsigned int i = 0; i <= _miqpParams.N-1; i++){
+            _logger->log(_copInPreviewChannel, _tPreview[i], _P_kN.segment(i*2,2));
+            _logger->log(_bosInPreviewChannel, _tPreview[i], _r_kN.segment(i*2,2));
+            _logger->log(_comInPreviewChannel, _tPreview[i], _H_kN.segment(i*6,6));
+            _logger->log(_comRefInPreviewChannel, _tPreview[i], _H_N_r.segment(i*6,6));
+        }
+    }
+    //FIXME: This is temporary. Remove when allowing state feedback
+    this->askToStop();
+ }
+
+bool MIQPController::solveProblem(unsigned int k) {
     // Update constraints.
     // NOTE: _Aineq is time-invariant and thus built only once, while _Bineq is state dependant
     // (also depends on a history of states when walking constraints are included).
-    _constraints->updateRHS(_xi_k);
+    if (_useRecordedBoundingBox)
+        _constraints->updateRHS(_xi_k, _recordedBoundingBox);
+    else
+        _constraints->updateRHS(_xi_k);
     _constraints->getRHS(_Bineq);
 
     // Updates RHS of equality constraints. For now, contains only Simultaneity
     updateEqualityConstraints(_xi_k, _Beq);
 
-    setCOMStateRefInPreviewWindow(_k, _H_N_r);
+    setCOMStateRefInPreviewWindow(k, _H_N_r);
     setLinearPartObjectiveFunction();
 
+    if (_miqpParams.explicitModeSequences) {
+        if (_qpWorkers.empty())
+            return false;
+        Eigen::VectorXd X_kn(_X_kn.size());
+        if (!solveModeSequences(X_kn)) {
+            OCRA_ERROR("None of the precomputed contact sequences is feasible. Keeping the previous solution.");
+            return false;
+        }
+        this->semaphore.wait();
+        _X_kn = X_kn;
+        this->semaphore.post();
+        _lastObjective = _X_kn.dot(_H_N*_X_kn) + _linearTermTransObjFunc.dot(_X_kn);
+        _lastNodeCount = 0;
+        _solutionChannel->publish(_xi_k_timestamp, _xi_k, _X_kn);
+        return true;
+    }
+
+    if (!_eigGurobi)
+        return false;
     try {
-    // TODO: Watch out! _eigGurobi will add a 1/2. Therefore the 2. Check that this is correct.
-    _eigGurobi.solve(2*_H_N, _linearTermTransObjFunc, _Aeq, _Beq, _Aineq, _Bineq, _lb, _ub);
-
-    // Get the solution
-    this->semaphore.wait();
-    OCRA_WARNING("Updated _X_kn");
-    _X_kn = _eigGurobi.result();
-    this->semaphore.post();
-    std::cout << _X_kn.topRows(INPUT_VECTOR_SIZE).transpose() << std::endl;
+        // The solvers minimize 1/2 x'Qx + c'x while the cost is x'H_N x + c'x, hence Q = 2 H_N.
+        bool solved;
+        if (_previewModel->isBlocked()) {
+            const Eigen::MatrixXd &M = _previewModel->getBlockingMatrix();
+            Eigen::VectorXd linearTerm = M.transpose()*_linearTermTransObjFunc;
+            solved = _eigGurobi->solve(2*_H_N_blocked, linearTerm, _Aeq_blocked, _Beq, _Aineq_blocked, _Bineq, _lb_blocked, _ub_blocked);
+        } else {
+            solved = _eigGurobi->solve(2*_H_N, _linearTermTransObjFunc, _Aeq, _Beq, _Aineq, _Bineq, _lb, _ub);
+        }
+        if (!solved) {
+            OCRA_ERROR("The MIQP could not be solved. Keeping the previous solution.");
+            return false;
+        }
+
+        // Get the solution
+        this->semaphore.wait();
+        if (_previewModel->isBlocked())
+            _X_kn = _previewModel->getBlockingMatrix()*_eigGurobi->result();
+        else
+            _X_kn = _eigGurobi->result();
+        this->semaphore.post();
+        _lastObjective = _eigGurobi->getObjectiveValue();
+        _lastNodeCount = _eigGurobi->getNodeCount();
+        _solutionChannel->publish(_xi_k_timestamp, _xi_k, _X_kn);
     } catch(GRBException e) {
         std::cout << "Error code = " << e.getErrorCode() << std::endl;
         std::cout << e.getMessage() << std::endl;
+        return false;
     }
+    return true;
+}
 
-    _k++;
-    
-    // NOTE: LOGGING SECTION
-    // Write solution to file for plots
-    std::string home = std::string(_miqpParams.home + "MIQP/");
-//     writeToFile(_miqpParams.dt*_k, _X_kn.topRows(INPUT_VECTOR_SIZE), home);
-    // Write the first solution in the WHOLE preview horizon
-    // FIXME: This is simply a test done in open loop to see if the solution makes sense in the first preview window.
-    if (_k==1) {
-        for (unsigned int i = 0; i <= _miqpParams.N-1; i++)
-            ocra::utils::writeInFile(_X_kn.segment(i*INPUT_VECTOR_SIZE,INPUT_VECTOR_SIZE), std::string(home+"solutionInPreview.txt"),true);
-    }
-    // Log the first full previewed CoP, center of BoS and CoM
-    Eigen::VectorXd P_kN;
-    Eigen::VectorXd r_kN;
-    Eigen::VectorXd H_kN;
-    r_kN.resize(2*_miqpParams.N);
-    P_kN.resize(2*_miqpParams.N);
-    H_kN.resize(6*_miqpParams.N);
-    P_kN = _P_P*_xi_k + _R_P*_X_kn;
-    r_kN = _P_B*_xi_k + _R_B*_X_kn;
-    H_kN = _P_H*_xi_k + _R_H*_X_kn;
-    if (_k==1) {
-        for (unsigned int i = 0; i <= _miqpParams.N-1; i++){
-            ocra::utils::writeInFile(P_kN.segment(i*2,2), std::string(home+"CoPinPreview.txt"),true);
-            ocra::utils::writeInFile(r_kN.segment(i*2,2), std::string(home+"BoSinPreview.txt"),true);
-            ocra::utils::writeInFile(H_kN.segment(i*6,6), std::string(home+"CoMinPreview.txt"),true);
-            ocra::utils::writeInFile(_H_N_r.segment(i*6,6), std::string(home+"CoMRefinPreview.txt"), true);
-        }
-    }
-    //FIXME: This is temporary. Remove when allowing state feedback
-    this->askToStop();
- }
+void MIQPController::setState(const Eigen::VectorXd &xi_k, double timestamp) {
+    _xi_k = xi_k;
+    _xi_k_timestamp = timestamp;
+}
+
+void MIQPController::setRecordedBoundingBox(const Eigen::Matrix2d &minMaxBoundingBox) {
+    _recordedBoundingBox = minMaxBoundingBox;
+    _useRecordedBoundingBox = true;
+}
 
-void MIQPController::writeToFile(const double& time, const Eigen::VectorXd& X_kn, std::string& home) {
-    Eigen::VectorXd tmp(INPUT_VECTOR_SIZE+1);
-    tmp << time, X_kn;
-    ocra::utils::writeInFile(tmp, std::string(home + "solution.txt"), true);
+void MIQPController::writeToFile(const double& time, const Eigen::VectorXd& X_kn) {
+    _logger->log(_solutionLogChannel, time, X_kn);
 }
 
 void MIQPController::setBinaryVariables()
 {
+    if (_previewModel->isBlocked()) {
+        // Binaries of every block follow the continuous variables of all steps
+        unsigned int first = _previewModel->getFirstReducedBinaryIndex();
+        for (unsigned int i = first; i < _previewModel->getReducedSize(); i++)
+            _eigGurobi->setVariableType(i, GRB_BINARY);
+        return;
+    }
     int m = 0;
     while( m < INPUT_VECTOR_SIZE*_miqpParams.N) {
         // Set binary variables (4->9) i.e. alpha_x, alpha_y, beta_x, beta_y, delta, gamma
         for (int i = 4; i <= 9; i++) {
-            _eigGurobi.setVariableType(m+i, GRB_BINARY);
+            _eigGurobi->setVariableType(m+i, GRB_BINARY);
         }
         m += INPUT_VECTOR_SIZE;
     }
 }
 
+void MIQPController::buildBlockedProblem() {
+    const Eigen::MatrixXd &M = _previewModel->getBlockingMatrix();
+    _H_N_blocked = M.transpose()*_H_N*M;
+    _Aeq_blocked = _Aeq*M;
+    _Aineq_blocked = _Aineq*M;
+    _previewModel->reduceBounds(_lb, _ub, _lb_blocked, _ub_blocked);
+    OCRA_INFO("Built move-blocked problem with " << M.cols() << " variables, of which " << M.cols() - _previewModel->getFirstReducedBinaryIndex() << " binaries");
+}
+
+bool MIQPController::solveModeSequences(Eigen::VectorXd &X_kn) {
+    const std::vector<Eigen::VectorXd> &sequences = _sequenceEnumerator->getSequences(_xi_k);
+    if (sequences.empty())
+        return false;
+
+    // The solvers minimize 1/2 x'Qx + c'x while the cost is x'H_N x + c'x, hence Q = 2 H_N.
+    const Eigen::MatrixXd H = 2*_H_N;
+    const unsigned int nWorkers = _qpWorkers.size();
+    std::atomic<unsigned int> nextSequence(0);
+    std::vector<double> bestCost(nWorkers, std::numeric_limits<double>::infinity());
+    std::vector<Eigen::VectorXd> bestSolution(nWorkers);
+
+    // Every worker picks the next unsolved sequence until all of them have been tried
+    auto solveCandidates = [&](unsigned int w) {
+        Eigen::VectorXd lb = _lb;
+        Eigen::VectorXd ub = _ub;
+        unsigned int s;
+        while ((s = nextSequence++) < sequences.size()) {
+            for (unsigned int j = 0; j < _miqpParams.N; j++) {
+                lb.segment(j*INPUT_VECTOR_SIZE + FIRST_BINARY_INDEX, BINARIES_PER_STEP) = sequences[s].segment(j*BINARIES_PER_STEP, BINARIES_PER_STEP);
+                ub.segment(j*INPUT_VECTOR_SIZE + FIRST_BINARY_INDEX, BINARIES_PER_STEP) = sequences[s].segment(j*BINARIES_PER_STEP, BINARIES_PER_STEP);
+            }
+            try {
+                if (!_qpWorkers[w]->solve(H, _linearTermTransObjFunc, _Aeq, _Beq, _Aineq, _Bineq, lb, ub))
+                    continue;
+            } catch(GRBException e) {
+                continue;
+            }
+            const Eigen::VectorXd &x = _qpWorkers[w]->result();
+            double cost = x.dot(_H_N*x) + _linearTermTransObjFunc.dot(x);
+            if (cost < bestCost[w]) {
+                bestCost[w] = cost;
+                bestSolution[w] = x;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int w = 1; w < nWorkers; w++)
+        threads.push_back(std::thread(solveCandidates, w));
+    solveCandidates(0);
+    for (std::thread &t : threads)
+        t.join();
+
+    int best = -1;
+    for (unsigned int w = 0; w < nWorkers; w++) {
+        if (bestSolution[w].size() > 0 && (best < 0 || bestCost[w] < bestCost[best]))
+            best = w;
+    }
+    if (best < 0)
+        return false;
+    OCRA_INFO("Solved " << sequences.size() << " contact sequences. Best cost: " << bestCost[best]);
+    X_kn = bestSolution[best];
+    return true;
+}
+
 void MIQPController::setCOMStateRefInPreviewWindow(unsigned int k, Eigen::VectorXd &H_N_r) {
-    unsigned int j = 0;
-    // FIXME: Pass an actual reference of CoM states
-    for (unsigned int i = k + 1; i <= k + _miqpParams.N; i++) {
-        H_N_r.segment(j, 6) = _comStateRef.row(i);
-        j += 6;
+    // _comStateRef is sampled at the nominal period dt, while the knots of the preview window may be coarser
+    const double dt = (double) _miqpParams.dt/1000;
+    const unsigned int lastRow = _comStateRef.rows() - 1;
+    for (unsigned int j = 0; j < _miqpParams.N; j++) {
+        unsigned int i = k + (unsigned int) std::round(_previewModel->getPreviewTime(j+1)/dt);
+        H_N_r.segment(6*j, 6) = _comStateRef.row(std::min(i, lastRow));
     }
 }
 
@@ -252,24 +512,21 @@ void MIQPController::setLowerAndUpperBounds() {
     unsigned int k = 0;
     while (k < INPUT_VECTOR_SIZE*_miqpParams.N) {
         // a and b bounds
-        for (unsigned int j = 0; j < 4; j++)
-            _lb[k+j] = -1;
+        for (unsigned int j = 0; j < 4; j++) {
+            _lb[k+j] = -_miqpParams.abBounds;
+            _ub[k+j] = _miqpParams.abBounds;
+        }
         // Jerk bounds
-        for (unsigned int j = 10; j < INPUT_VECTOR_SIZE; j++)
-            _lb[k+j] = -10;
-        k += INPUT_VECTOR_SIZE;
-    }
-    k = 0;
-    while (k < INPUT_VECTOR_SIZE*_miqpParams.N) {
-        for (unsigned int j = 0; j < 4; j++)
-            _ub[k+j] = 1;
-        for (unsigned int j = 10; j < INPUT_VECTOR_SIZE; j++)
-            _ub[k+j] = 10;
+        for (unsigned int j = 10; j < INPUT_VECTOR_SIZE; j++) {
+            _lb[k+j] = -_miqpParams.uBounds;
+            _ub[k+j] = _miqpParams.uBounds;
+        }
         k += INPUT_VECTOR_SIZE;
     }
 }
 
 void MIQPController::updateStateVector() {
+    _xi_k_timestamp = yarp::os::Time::now();
     _state->updateStateVector();
     _state->getFullState(_xi_k);
     _xi_k << 0, 0, 0, -0.13, 0, 0,0,0, 1, 1, 0.0, -0.065, 0, 0, 0, 0;
@@ -425,55 +682,27 @@ void MIQPController::buildSw(Eigen::MatrixXd &Sw, MIQPParameters miqpParams) {
 
 
 void MIQPController::buildPreviewStateMatrix(const Eigen::MatrixXd &C, Eigen::MatrixXd &P) {
-    P.setZero();
-    for (unsigned int i=0; i<_miqpParams.N; i++) {
-        P.block(i*C.rows(), 0, C.rows(), _Q.cols()) = C*_Q.pow(i+1);
-    }
+    _previewModel->buildPreviewStateMatrix(C, P);
 //    OCRA_WARNING("Built P");
 }
 
 void MIQPController::buildPreviewInputMatrix(const Eigen::MatrixXd &C, Eigen::MatrixXd &R) {
-    R.setZero();
-    // Create first column
-    Eigen::MatrixXd RColumn(C.rows()*_miqpParams.N, _T.cols());
-    for (unsigned int i=0; i<_miqpParams.N; i++){
-        RColumn.block(i*C.rows(), 0, C.rows(), _T.cols()) = C * _Q.pow(i) * _T;
-    }
-    // Shift RColumn into every column of R to take the form of a lower diagonal toeplitz matrix
-    unsigned int j=0;
-    while (j<_miqpParams.N){
-        R.block(j*C.rows(), j*_T.cols(), C.rows()*(_miqpParams.N-j), _T.cols()) = RColumn.topRows((_miqpParams.N-j)*C.rows());
-        j=j+1;
-    }
+    _previewModel->buildPreviewInputMatrix(C, R);
 //    OCRA_WARNING("Built R");
 }
 
 void MIQPController::buildEqualityConstraintsMatrices(const Eigen::VectorXd &x_k, Eigen::MatrixXd &Aeq, Eigen::VectorXd &Beq) {
     _Ci_eq.resize(1,STATE_VECTOR_SIZE);
     _Ci_eq << 0,0,0,0,1,-1,1,-1, Eigen::VectorXd::Zero(8);
-    Aeq.setZero();
 
-    // Create first column of Aeq
-    Eigen::MatrixXd AeqColumn(_miqpParams.N, _T.cols());
-    for (unsigned int i=0; i<_miqpParams.N; i++){
-        AeqColumn.block(i*_Ci_eq.rows(), 0, _Ci_eq.rows(), _T.cols()) = _Ci_eq * _Q.pow(i) * _T;
-    }
-    // Shift AeqColumn into every column of Aeq to take the form of a lower diagonal toeplitz matrix
-    unsigned int j=0;
-    while (j<_miqpParams.N){
-        Aeq.block(j*_Ci_eq.rows(), j*_T.cols(), _Ci_eq.rows()*(_miqpParams.N-j), _T.cols()) = AeqColumn.topRows((_miqpParams.N-j)*_Ci_eq.rows());
-        j++;
-    }
+    buildPreviewInputMatrix(_Ci_eq, Aeq);
 
     // Build time-independent matrices in RHS of equality constraints.
     // First build vector of fc
     _fcbar_eq.resize(_miqpParams.N);
     _fcbar_eq.setZero();
 
-    _rhs_2_eq.resize(_Ci_eq.rows()*_miqpParams.N, _Q.cols());
-    for (unsigned int i=0; i < _miqpParams.N; i++) {
-        _rhs_2_eq.block(i*_Ci_eq.rows(),0,_Ci_eq.rows(),_Q.cols()) = _Ci_eq*_Q.pow(i+1);
-    }
+    buildPreviewStateMatrix(_Ci_eq, _rhs_2_eq);
     
     updateEqualityConstraints(x_k, Beq);
 }
@@ -498,8 +727,8 @@ void MIQPController::buildCoMJerkReg(MIQPParameters &miqpParams) {
     _S_wu.resize(INPUT_VECTOR_SIZE*miqpParams.N, INPUT_VECTOR_SIZE*miqpParams.N);
     
     Eigen::VectorXd vecToRepeat(INPUT_VECTOR_SIZE);
-    //FIXME: These bounds "10" should come from configuration file
-    double weight = miqpParams.wu/(10*10);
+    // Normalize the jerk by its bounds
+    double weight = miqpParams.wu/(miqpParams.uBounds*miqpParams.uBounds);
     vecToRepeat << (Eigen::VectorXd(10) << Eigen::VectorXd::Constant(10,0)).finished(), weight, weight;
     // replicate over the preview window
     Eigen::VectorXd diagonal = vecToRepeat.replicate(1,_miqpParams.N);
@@ -1,11 +1,13 @@
 #include "walking-client/constraints/MIQPLinearConstraints.h"
 
 MIQPLinearConstraints::MIQPLinearConstraints(std::shared_ptr<StepController> stepController,
+                                             std::shared_ptr<MIQPPreviewModel> previewModel,
                                              MIQPParameters &miqpParams):
 _dt(miqpParams.dt),
 _N(miqpParams.N),
 _miqpParams(miqpParams),
 _stepController(stepController),
+_previewModel(previewModel),
 _addShapeCtrs(miqpParams.shapeConstraints), 
 _addAdmissibilityCtrs(miqpParams.admissibilityConstraints),
 _addCoPConstraints(miqpParams.copConstraints),
@@ -13,18 +15,15 @@ _addWalkingCtrs(miqpParams.walkingConstraints)
  {
     if (_addShapeCtrs) {
         OCRA_WARNING("This MIQP Controller will add Shape Constraints");
-        _shapeCnstr = std::make_shared<ShapeConstraints>();
+        _shapeCnstr = std::make_shared<ShapeConstraints>(_miqpParams);
         _shapeCnstr->init();    
     }
     if (_addAdmissibilityCtrs) {
         OCRA_WARNING("This MIQP Controller will add Admissibility Constraints");
-        _admissibilityCnstr = std::make_shared<AdmissibilityConstraints>();
+        _admissibilityCnstr = std::make_shared<AdmissibilityConstraints>(_miqpParams);
         _admissibilityCnstr->init();
     }
     
-    buildMatrixQ();
-    buildMatrixT();
-
     setMatrixAcl();
     setMatrixAcr();
     
@@ -33,13 +32,13 @@ _addWalkingCtrs(miqpParams.walkingConstraints)
     // First build Shape and/or Admissibility Constraints in preview window
     buildShapeAndAdmissibilityInPreviewWindow();
     // Then build CoP constraints in preview window
-    _baseOfSupport = std::make_shared<BaseOfSupport>(_stepController,_Q,_T,_miqpParams);
+    _baseOfSupport = std::make_shared<BaseOfSupport>(_stepController,_previewModel,_miqpParams);
     // Now stack in _A the previous constraints matrices. 
     // If also CoP constraints are added, we need to resize A with the total number of constraints times the size of the input vector \mathcal{X}
      if(_addCoPConstraints) {
          OCRA_WARNING("This MIQP Controller will add CoP Constraints");
          // FIXME: Get the hardcoded 14*miqpParams from Base of Support class. Something like getnConstraints(). Also add to nConstraints those added by baseOfSupport
-         Eigen::MatrixXd ACoP(14*_N, _T.cols()*_N); 
+         Eigen::MatrixXd ACoP(14*_N, INPUT_VECTOR_SIZE*_N); 
          OCRA_INFO("ACoP has size: " << ACoP.rows() << "x" << ACoP.cols());
          _baseOfSupport->getA(ACoP);
          _A.resize(_AShapeAdmiss.rows() + ACoP.rows(), _AShapeAdmiss.cols());
@@ -118,42 +117,24 @@ void MIQPLinearConstraints::updateRHS(const Eigen::VectorXd& xi_k){
     }
 }
 
-void MIQPLinearConstraints::getRHS(Eigen::VectorXd &rhs) {
-    rhs = _rhs;
-}
-
-void MIQPLinearConstraints::buildBh() {
-    _Bh.resize(6,2);
-    double dt = (double) _dt/1000;
-    _Bh << (pow(dt,3)/6)*Eigen::Matrix2d::Identity(), (pow(dt,2)/2)*Eigen::Matrix2d::Identity(), dt*Eigen::Matrix2d::Identity();
-}
-
-void MIQPLinearConstraints::buildAh() {
-    _Ah.resize(6,6);
-    _Ah.setIdentity();
-    double dt = (double) _dt/1000;
-    _Ah.block(0,2,2,2) = dt*Eigen::Matrix2d::Identity();
-    _Ah.block(0,4,2,2) = (pow(dt,2)/2)*Eigen::Matrix2d::Identity();
-    _Ah.block(2,4,2,2) = dt*Eigen::Matrix2d::Identity();
-}
-
-void MIQPLinearConstraints::buildMatrixQ() {
-    buildAh();
-    _Q = Eigen::MatrixXd::Zero(STATE_VECTOR_SIZE, STATE_VECTOR_SIZE);
-    _Q.block(10,10,_Ah.rows(),_Ah.cols()) = _Ah;
+void MIQPLinearConstraints::updateRHS(const Eigen::VectorXd& xi_k, const Eigen::Matrix2d& minMaxBoundingBox){
+    _rhs.segment(0,_fcbarShapeAdmiss.size()) = _fcbarShapeAdmiss - _BShapeAdmiss * xi_k;
+    if (_addCoPConstraints) {
+        _baseOfSupport->update(xi_k, minMaxBoundingBox);
+        Eigen::VectorXd tmprhs(_rhs.size() - _fcbarShapeAdmiss.size());
+        _baseOfSupport->getrhs(tmprhs);
+        _rhs.segment(_fcbarShapeAdmiss.size(), tmprhs.size()) = tmprhs;
+    }
 }
 
-void MIQPLinearConstraints::buildMatrixT() {
-    buildBh();
-    _T = Eigen::MatrixXd::Identity(STATE_VECTOR_SIZE, INPUT_VECTOR_SIZE);
-    _T.block(10,10,6,2) = _Bh;
+void MIQPLinearConstraints::getRHS(Eigen::VectorXd &rhs) {
+    rhs = _rhs;
 }
 
 void MIQPLinearConstraints::buildShapeAndAdmissibilityInPreviewWindow(){
-    // This builds A in A*X <= fcbar - B*xi_k
-    buildAShapeAdmiss();
-    // This builds B in A*X <= fcbar - B*xi_k
-    buildBShapeAdmiss();
+    // This builds A and B in A*X <= fcbar - B*xi_k
+    _previewModel->buildCoupledPreviewMatrices(_Acl, _Acr, _AShapeAdmiss, _BShapeAdmiss);
+    OCRA_WARNING("Built AShapeAdmiss and BShapeAdmiss");
     // This builds fcbar in A*X <= fcbar - B*xi_k
     buildFcBarShapeAdmiss();
     
@@ -163,39 +144,6 @@ void MIQPLinearConstraints::buildShapeAndAdmissibilityInPreviewWindow(){
     // TODO: When walking constraints are added, this will be a stack of the two
 }
 
-void MIQPLinearConstraints::buildAShapeAdmiss() {
-    _AShapeAdmiss.resize(_Acr.rows()*_N, _T.cols()*_N);
-    _AShapeAdmiss.setZero();
-    // Create first column
-    Eigen::MatrixXd AColumn(_Acr.rows()*_N, _T.cols());
-    AColumn.block(0, 0, _Acr.rows(), _T.cols()) = _Acr*_T;
-    for (unsigned int i=1; i<=_N-1; i++){
-        AColumn.block(i*_Acr.rows(), 0, _Acr.rows(), _T.cols()) = _Acl*_Q.pow(i-1)*_T + _Acr*_Q.pow(i)*_T;
-    }
-    // Shift AColumn to take the form of a lower diagonal toeplitz matrix
-    unsigned int j=1;
-    Eigen::MatrixXd Aexcerpt;
-    _AShapeAdmiss.block(0,0,_N*_Acr.rows(), _T.cols()) = AColumn;
-    while (j < _N){
-        _AShapeAdmiss.block(j*_Acr.rows(), j*_T.cols(), _Acr.rows()*(_N-j), _T.cols()) = AColumn.topRows((_N-j)*_Acr.rows());
-        Aexcerpt = AColumn .topRows((_N-j)*_Acr.rows());
-        j++;
-    }
-    Aexcerpt = _AShapeAdmiss.block(0,0,_N*_Acl.rows(), _N*_T.cols());
-    OCRA_WARNING("Built AShapeAdmiss");
-}
-
-void MIQPLinearConstraints::buildBShapeAdmiss() {
-    OCRA_INFO("_Acr size is: " << _Acr.rows() << " cols: " << _Acr.cols()  << " _Q size is: " << _Q.rows() << " " << _Q.cols());
-    _BShapeAdmiss.resize(_Acr.rows()*_N, _Q.cols());
-    _BShapeAdmiss.setZero();
-
-    for (unsigned int i = 1; i <= _N; i++) {
-        _BShapeAdmiss.block((i-1)*_Acr.rows(), 0, _Acr.rows(), _Q.cols()) = _Acl*_Q.pow(i-1) + _Acr*_Q.pow(i);
-    }
-    OCRA_WARNING("Built BShapeAdmiss");
-}
-
 void MIQPLinearConstraints::buildFcBarShapeAdmiss() {
     unsigned int totalRows;
     Eigen::VectorXd fc;
@@ -0,0 +1,138 @@
+#include "walking-client/MIQPPreviewModel.h"
+#include <numeric>
+
+MIQPPreviewModel::MIQPPreviewModel(const MIQPParameters &miqpParams) :
+_N(miqpParams.N),
+_dt(miqpParams.N),
+_t(miqpParams.N + 1),
+_Q(miqpParams.N),
+_T(miqpParams.N),
+_Phi(miqpParams.N + 1),
+_blocked(false),
+_nBlocks(miqpParams.N)
+{
+    Eigen::MatrixXd Ah(6,6);
+    Eigen::MatrixXd Bh(6,2);
+    _t[0] = 0;
+    _Phi[0] = Eigen::MatrixXd::Identity(STATE_VECTOR_SIZE, STATE_VECTOR_SIZE);
+    for (unsigned int j = 0; j < _N; j++) {
+        // Steps beyond the given schedule use the nominal discretization period
+        unsigned int dtMs = j < miqpParams.dtPreview.size() ? miqpParams.dtPreview[j] : miqpParams.dt;
+        _dt[j] = (double) dtMs/1000;
+        _t[j+1] = _t[j] + _dt[j];
+
+        buildAh(_dt[j], Ah);
+        buildBh(_dt[j], Bh);
+        _Q[j] = Eigen::MatrixXd::Zero(STATE_VECTOR_SIZE, STATE_VECTOR_SIZE);
+        _Q[j].block(10,10,6,6) = Ah;
+        _T[j] = Eigen::MatrixXd::Zero(STATE_VECTOR_SIZE, INPUT_VECTOR_SIZE);
+        _T[j].block(0,0,10,10) = Eigen::MatrixXd::Identity(10, 10);
+        _T[j].block(10,10,6,2) = Bh;
+
+        _Phi[j+1] = _Q[j]*_Phi[j];
+    }
+    buildBlockingMatrix(miqpParams.binaryBlocks);
+}
+
+MIQPPreviewModel::~MIQPPreviewModel() {}
+
+void MIQPPreviewModel::buildBlockingMatrix(const std::vector<unsigned int> &binaryBlocks) {
+    std::vector<unsigned int> blocks(binaryBlocks);
+    unsigned int nSteps = std::accumulate(blocks.begin(), blocks.end(), 0u);
+    if (blocks.empty() || nSteps != _N || std::find(blocks.begin(), blocks.end(), 0u) != blocks.end()) {
+        if (!blocks.empty())
+            OCRA_WARNING("binaryBlocks must be positive and sum up to N = " << _N << ". Binaries won't be blocked");
+        blocks.assign(_N, 1);
+    }
+    _blocked = blocks.size() < _N;
+    _nBlocks = blocks.size();
+
+    const unsigned int nBinaries = INPUT_VECTOR_SIZE - CONTINUOUS_PER_STEP;
+    const unsigned int firstBinary = CONTINUOUS_PER_STEP*_N;
+    _M.setZero(INPUT_VECTOR_SIZE*_N, firstBinary + nBinaries*_nBlocks);
+    _reducedToFull.resize(_M.cols());
+    unsigned int step = 0;
+    for (unsigned int b = 0; b < _nBlocks; b++) {
+        for (unsigned int s = 0; s < blocks[b]; s++, step++) {
+            unsigned int row = step*INPUT_VECTOR_SIZE;
+            // a and b
+            for (unsigned int i = 0; i < 4; i++) {
+                _M(row + i, step*CONTINUOUS_PER_STEP + i) = 1;
+                _reducedToFull[step*CONTINUOUS_PER_STEP + i] = row + i;
+            }
+            // alpha, beta, delta and gamma are shared by every step of the block
+            for (unsigned int i = 0; i < nBinaries; i++) {
+                _M(row + 4 + i, firstBinary + b*nBinaries + i) = 1;
+                _reducedToFull[firstBinary + b*nBinaries + i] = row + 4 + i;
+            }
+            // u
+            for (unsigned int i = 0; i < 2; i++) {
+                _M(row + 10 + i, step*CONTINUOUS_PER_STEP + 4 + i) = 1;
+                _reducedToFull[step*CONTINUOUS_PER_STEP + 4 + i] = row + 10 + i;
+            }
+        }
+    }
+    if (_blocked)
+        OCRA_INFO("Binaries blocked over " << _nBlocks << " blocks: " << _M.cols() << " instead of " << _M.rows() << " variables");
+}
+
+void MIQPPreviewModel::reduceBounds(const Eigen::VectorXd &lb, const Eigen::VectorXd &ub, Eigen::VectorXd &zlb, Eigen::VectorXd &zub) const {
+    zlb.resize(_M.cols());
+    zub.resize(_M.cols());
+    for (unsigned int c = 0; c < _M.cols(); c++) {
+        zlb(c) = lb(_reducedToFull[c]);
+        zub(c) = ub(_reducedToFull[c]);
+    }
+}
+
+void MIQPPreviewModel::buildAh(double dt, Eigen::MatrixXd &Ah) {
+    Ah.setIdentity(6,6);
+    Ah.block(0,2,2,2) = dt*Eigen::Matrix2d::Identity();
+    Ah.block(0,4,2,2) = (pow(dt,2)/2)*Eigen::Matrix2d::Identity();
+    Ah.block(2,4,2,2) = dt*Eigen::Matrix2d::Identity();
+}
+
+void MIQPPreviewModel::buildBh(double dt, Eigen::MatrixXd &Bh) {
+    Bh.resize(6,2);
+    Bh << (pow(dt,3)/6)*Eigen::Matrix2d::Identity(), (pow(dt,2)/2)*Eigen::Matrix2d::Identity(), dt*Eigen::Matrix2d::Identity();
+}
+
+void MIQPPreviewModel::buildPreviewStateMatrix(const Eigen::MatrixXd &C, Eigen::MatrixXd &P) const {
+    P.resize(C.rows()*_N, STATE_VECTOR_SIZE);
+    for (unsigned int j = 0; j < _N; j++)
+        P.block(j*C.rows(), 0, C.rows(), STATE_VECTOR_SIZE) = C*_Phi[j+1];
+}
+
+void MIQPPreviewModel::buildPreviewInputMatrix(const Eigen::MatrixXd &C, Eigen::MatrixXd &R) const {
+    R.setZero(C.rows()*_N, INPUT_VECTOR_SIZE*_N);
+    // Fill column i by propagating T_i through Q_{i+1}, Q_{i+2}, ...
+    Eigen::MatrixXd G;
+    for (unsigned int i = 0; i < _N; i++) {
+        G = _T[i];
+        for (unsigned int j = i; j < _N; j++) {
+            R.block(j*C.rows(), i*INPUT_VECTOR_SIZE, C.rows(), INPUT_VECTOR_SIZE) = C*G;
+            if (j + 1 < _N)
+                G = _Q[j+1]*G;
+        }
+    }
+}
+
+void MIQPPreviewModel::buildCoupledPreviewMatrices(const Eigen::MatrixXd &Acl, const Eigen::MatrixXd &Acr, Eigen::MatrixXd &A, Eigen::MatrixXd &B) const {
+    const unsigned int rows = Acr.rows();
+    A.setZero(rows*_N, INPUT_VECTOR_SIZE*_N);
+    B.resize(rows*_N, STATE_VECTOR_SIZE);
+    Eigen::MatrixXd G;
+    for (unsigned int i = 0; i < _N; i++) {
+        G = _T[i];
+        for (unsigned int j = i; j < _N; j++) {
+            // X_i enters xi_{k+j+1} through G, hence row j through Acr and row j+1 through Acl
+            A.block(j*rows, i*INPUT_VECTOR_SIZE, rows, INPUT_VECTOR_SIZE) += Acr*G;
+            if (j + 1 < _N) {
+                A.block((j+1)*rows, i*INPUT_VECTOR_SIZE, rows, INPUT_VECTOR_SIZE) += Acl*G;
+                G = _Q[j+1]*G;
+            }
+        }
+    }
+    for (unsigned int j = 0; j < _N; j++)
+        B.block(j*rows, 0, rows, STATE_VECTOR_SIZE) = Acl*_Phi[j] + Acr*_Phi[j+1];
+}
@@ -0,0 +1,71 @@
+#include "walking-client/MIQPSolutionChannel.h"
+#include <algorithm>
+
+namespace {
+    // Offsets of a, b and u. They coincide in the state and input vectors (see MIQP::StateVectorIndex
+    // and MIQP::InputVectorIndex), which are not included here to keep this class free of the robot model.
+    const unsigned int A_OFFSET = 0;
+    const unsigned int B_OFFSET = 2;
+    const unsigned int U_OFFSET = 10;
+}
+
+MIQPSolutionChannel::MIQPSolutionChannel(const std::vector<double> &knotTimes) :
+_N(knotTimes.size() - 1),
+_knotTimes(knotTimes),
+_back(0),
+_middle(1),
+_front(2)
+{
+    for (unsigned int i = 0; i < 3; i++) {
+        _buffers[i].timestamp = -1;
+        _buffers[i].xi_k = Eigen::VectorXd::Zero(STATE_VECTOR_SIZE);
+        _buffers[i].X_kn = Eigen::VectorXd::Zero(INPUT_VECTOR_SIZE*_N);
+    }
+}
+
+MIQPSolutionChannel::~MIQPSolutionChannel() {}
+
+void MIQPSolutionChannel::publish(double timestamp, const Eigen::VectorXd &xi_k, const Eigen::VectorXd &X_kn) {
+    // Sizes match the preallocated slots, therefore these copies do not allocate
+    Slot &slot = _buffers[_back];
+    slot.timestamp = timestamp;
+    slot.xi_k = xi_k;
+    slot.X_kn = X_kn;
+    unsigned int previous = _middle.exchange(_back | FRESH, std::memory_order_acq_rel);
+    _back = previous & ~FRESH;
+}
+
+bool MIQPSolutionChannel::update() {
+    if (!(_middle.load(std::memory_order_relaxed) & FRESH))
+        return false;
+    unsigned int previous = _middle.exchange(_front, std::memory_order_acq_rel);
+    _front = previous & ~FRESH;
+    return true;
+}
+
+void MIQPSolutionChannel::sample(double t, Eigen::Vector2d &jerk, Eigen::Vector2d &a, Eigen::Vector2d &b) const {
+    const Slot &slot = _buffers[_front];
+    // Knot j is at timestamp + _knotTimes[j]. Knot 0 is xi_k, knot j>0 is the (j-1)-th element of X_kn.
+    double s = t - slot.timestamp;
+    if (s < 0)
+        s = 0;
+    if (s > _knotTimes[_N])
+        s = _knotTimes[_N];
+    // Last knot not after s, within [0, N-1]
+    unsigned int j = std::upper_bound(_knotTimes.begin() + 1, _knotTimes.begin() + _N, s) - _knotTimes.begin() - 1;
+    double lambda = (s - _knotTimes[j])/(_knotTimes[j+1] - _knotTimes[j]);
+
+    // The jerk applied between knots j and j+1 is the one of the (j)-th element of X_kn
+    jerk = slot.X_kn.segment<2>(j*INPUT_VECTOR_SIZE + U_OFFSET);
+
+    Eigen::Vector2d aStart, bStart;
+    if (j == 0) {
+        aStart = slot.xi_k.segment<2>(A_OFFSET);
+        bStart = slot.xi_k.segment<2>(B_OFFSET);
+    } else {
+        aStart = slot.X_kn.segment<2>((j-1)*INPUT_VECTOR_SIZE + A_OFFSET);
+        bStart = slot.X_kn.segment<2>((j-1)*INPUT_VECTOR_SIZE + B_OFFSET);
+    }
+    a = (1 - lambda)*aStart + lambda*slot.X_kn.segment<2>(j*INPUT_VECTOR_SIZE + A_OFFSET);
+    b = (1 - lambda)*bStart + lambda*slot.X_kn.segment<2>(j*INPUT_VECTOR_SIZE + B_OFFSET);
+}
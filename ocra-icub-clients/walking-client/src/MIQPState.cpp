@@ -2,11 +2,14 @@
 
 using namespace MIQP;
 
-MIQPState::MIQPState(ocra::Model::Ptr robotModel, std::string robot):
+MIQPState::MIQPState(ocra::Model::Ptr robotModel, const MIQPParameters &miqpParams):
 _xi_k(Eigen::VectorXd(STATE_VECTOR_SIZE)),
 _hk(Eigen::VectorXd(6)),
 _robotModel(robotModel),
-_robot(robot),
+_robot(miqpParams.robot),
+_FzThreshold(miqpParams.FzThreshold),
+_PzThreshold(miqpParams.PzThreshold),
+_changeThreshold(miqpParams.changeThreshold),
 _delta(1)
 {
     OCRA_ERROR("FROM MIQPSTATE ROBOT NAME IS: " << _robot);
@@ -25,7 +28,7 @@ bool MIQPState::initialize() {
     } else {
         // Autoconnect
         std::string src = std::string("/"+_robot+"/left_foot/analog:o");
-        if (!yarp::os::Network::connect(src, _portWrenchLeftFoot.getName().c_str())) {
+        if (!ocra_icub::connectPorts(src, _portWrenchLeftFoot.getName())) {
             OCRA_ERROR("Impossible to connect to " << src);
             return false;
         }
@@ -37,17 +40,12 @@ bool MIQPState::initialize() {
     } else {
         // Autoconnect
         std::string src = std::string("/"+_robot+"/right_foot/analog:o");
-        if (!yarp::os::Network::connect(src, _portWrenchRightFoot.getName().c_str()) ) {
+        if (!ocra_icub::connectPorts(src, _portWrenchRightFoot.getName())) {
             OCRA_ERROR("Impossible to connect to " << src);
             return false;
         }
     }
 
-    // Set thresholds
-    // FIXME: This should come from configuration file
-    _FzThreshold = 5; // N
-    _PzThreshold = 0.05; // m => 5cm
-
     // Set initial values for some of the BoS descriptors, assuming the robot always starts in double
     // support and no initial com velocity
     _alpha.setZero();
@@ -59,9 +57,7 @@ bool MIQPState::initialize() {
 }
 
 void MIQPState::updateStateVector() {
-    /* TODO: This threshold should not be hardcoded but from config file*/
-    double thresholdChange = 0.015; //1.5cm
-    updateBaseOfSupportDescriptors(_a, _b, _alpha, _beta, _delta, _gamma, thresholdChange);
+    updateBaseOfSupportDescriptors(_a, _b, _alpha, _beta, _delta, _gamma, _changeThreshold);
     updateHorizontalCoMState(_hk);
     _xi_k << _a, _b, _alpha, _beta, _delta, _gamma, _hk;
 }
@@ -1,6 +1,8 @@
 #include "walking-client/constraints/ShapeConstraints.h"
 
-ShapeConstraints::ShapeConstraints() : Constraint() {
+ShapeConstraints::ShapeConstraints(const MIQPParameters &miqpParams) : Constraint(),
+_constancy(miqpParams.sx_constancy, miqpParams.sy_constancy)
+{
     _bounding.init();
     _constancy.init();
     _sequentiality.init();
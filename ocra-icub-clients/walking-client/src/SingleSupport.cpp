@@ -1,6 +1,9 @@
 #include "walking-client/constraints/SingleSupport.h"
 
-SingleSupport::SingleSupport() : Constraint(){}
+SingleSupport::SingleSupport(double sx, double sy) : Constraint(){
+    _S(0) = sx;
+    _S(1) = sy;
+}
 
 SingleSupport::~SingleSupport(){}
 
@@ -8,11 +11,8 @@ void SingleSupport::buildMatrixCi(){
     Eigen::VectorXd zero5 = Eigen::VectorXd::Zero(5);
     Eigen::VectorXd zero6 = Eigen::VectorXd::Zero(6);
     _Ci.resize(4,STATE_VECTOR_SIZE);
-    //TODO: temporarily hardcoding this bound S
-    double sx = 0.3;
-    _S(0) = sx;
-    double sy = 0.3;
-    _S(1) = sy;
+    double sx = _S(0);
+    double sy = _S(1);
     _Ci << 1,  0,  -1, 0, zero5.transpose(), -sx, zero6.transpose(),
           -1,  0,  1,  0, zero5.transpose(), -sx, zero6.transpose(),
            0,  1,  0, -1, zero5.transpose(), -sy, zero6.transpose(),
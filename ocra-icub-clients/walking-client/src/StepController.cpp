@@ -27,24 +27,12 @@ bool StepController::initialize() {
     if (!_rightFoot_TrajThread->start()) return false;
     OCRA_INFO("Feet trajectory threads started.");
 
-    // Create task connection objects
-    _LeftFootContact_BackLeft = std::make_shared<ocra_recipes::TaskConnection>("LeftFootContact_BackLeft");
-    _contactsCollection.push_back(_LeftFootContact_BackLeft);
-    _LeftFootContact_FrontLeft = std::make_shared<ocra_recipes::TaskConnection>("LeftFootContact_FrontLeft");
-    _contactsCollection.push_back(_LeftFootContact_FrontLeft);
-    _LeftFootContact_BackRight = std::make_shared<ocra_recipes::TaskConnection>("LeftFootContact_BackRight");
-    _contactsCollection.push_back(_LeftFootContact_BackRight);
-    _LeftFootContact_FrontRight = std::make_shared<ocra_recipes::TaskConnection>("LeftFootContact_FrontRight");
-    _contactsCollection.push_back(_LeftFootContact_FrontRight);
-
-    _RightFootContact_BackLeft = std::make_shared<ocra_recipes::TaskConnection>("RightFootContact_BackLeft");
-    _contactsCollection.push_back(_RightFootContact_BackLeft);
-    _RightFootContact_FrontLeft = std::make_shared<ocra_recipes::TaskConnection>("RightFootContact_FrontLeft");
-    _contactsCollection.push_back(_RightFootContact_FrontLeft);
-    _RightFootContact_BackRight = std::make_shared<ocra_recipes::TaskConnection>("RightFootContact_BackRight");
-    _contactsCollection.push_back(_RightFootContact_BackRight);
-    _RightFootContact_FrontRight = std::make_shared<ocra_recipes::TaskConnection>("RightFootContact_FrontRight");
-    _contactsCollection.push_back(_RightFootContact_FrontRight);
+    // Feet contacts, switched through the task groups of the controller server
+    _footContacts = std::make_shared<ocra_icub::FootContactManager>("/walking-client/footContacts");
+    if (!_footContacts->initialize()) {
+        OCRA_ERROR("Could not initialize the feet contacts");
+        return false;
+    }
 
     _leftFoot_TrajThread->setGoalErrorThreshold(0.005);
     _rightFoot_TrajThread->setGoalErrorThreshold(0.005);
@@ -53,69 +41,11 @@ bool StepController::initialize() {
 }
 
 void StepController::deactivateFeetContacts(FOOT foot) {
-    switch (foot) {
-        case LEFT_FOOT:
-        {
-            bool res;
-            res = _LeftFootContact_BackLeft->deactivate();
-            res &= _LeftFootContact_FrontLeft->deactivate();
-            res &= _LeftFootContact_BackRight->deactivate();
-            res &= _LeftFootContact_FrontRight->deactivate();
-            if(res) {
-                std::cout << "Deactivated left foot contacts." << std::endl;
-            }
-        }break;
-
-        case RIGHT_FOOT:
-        {
-            bool res;
-            res = _RightFootContact_BackLeft->deactivate();
-            res &= _RightFootContact_FrontLeft->deactivate();
-            res &= _RightFootContact_BackRight->deactivate();
-            res &= _RightFootContact_FrontRight->deactivate();
-            if(res) {
-                std::cout << "Deactivated right foot contacts." << std::endl;
-            }
-        }break;
-
-        default:
-            break;
-    }
+    _footContacts->deactivate(foot == LEFT_FOOT ? ocra_icub::LEFT_CONTACT_FOOT : ocra_icub::RIGHT_CONTACT_FOOT);
 }
 
 void StepController::activateFeetContacts(FOOT foot) {
-    switch (foot) {
-        case LEFT_FOOT:
-        {
-            bool res;
-            res = _LeftFootContact_BackLeft->activate();
-            res &= _LeftFootContact_FrontLeft->activate();
-            res &= _LeftFootContact_BackRight->activate();
-            res &= _LeftFootContact_FrontRight->activate();
-            if(res) {
-                std::cout << "Activated left foot contacts." << std::endl;
-            } else {
-                OCRA_ERROR("One or more contacts could not be activated");
-            }
-        }break;
-
-        case RIGHT_FOOT:
-        {
-            bool res;
-            res = _RightFootContact_BackLeft->activate();
-            res &= _RightFootContact_FrontLeft->activate();
-            res &= _RightFootContact_BackRight->activate();
-            res &= _RightFootContact_FrontRight->activate();
-            if(res) {
-                std::cout << "Activated right foot contacts." << std::endl;
-            } else {
-                OCRA_ERROR("One or more contacts could not be activated");
-            }
-        }break;
-
-        default:
-            break;
-    }
+    _footContacts->activate(foot == LEFT_FOOT ? ocra_icub::LEFT_CONTACT_FOOT : ocra_icub::RIGHT_CONTACT_FOOT);
 }
 
 bool StepController::doStepWithMaxVelocity(FOOT foot, Eigen::Vector3d target, double stepHeight) {
@@ -264,21 +194,11 @@ Eigen::Vector3d StepController::getRightFootPosition()
 }
 
 Eigen::MatrixXd StepController::getContact2DCoordinates() {
-    Eigen::MatrixXd contactsCoordinates;
-    int activeContacts = 0;
-    for (auto const& value : _contactsCollection) {
-        if (value->isActivated())
-            activeContacts++;
-    }
-    contactsCoordinates.resize(activeContacts,2);
-    unsigned int k = 0;
-    for (auto const& value : _contactsCollection) {
-        if (value->isActivated()) {
-            contactsCoordinates.row(k) = value->getTaskState().getPosition().getTranslation().topRows(2).transpose();
-            k++;
-        }
-    }
-    return contactsCoordinates;
+    return _footContacts->getActiveContact2DCoordinates();
+}
+
+void StepController::getContact2DCoordinates(Eigen::MatrixXd &coordinates) {
+    _footContacts->getActiveContact2DCoordinates(coordinates);
 }
 
 void StepController::stop() {
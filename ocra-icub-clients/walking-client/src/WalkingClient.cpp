@@ -1,4 +1,5 @@
 #include "walking-client/WalkingClient.h"
+#include <fstream>
 
 
 using namespace Eigen;
@@ -17,7 +18,8 @@ _globalZMP(Eigen::Vector2d::Zero()),
 _isTestRun(false),
 _currentlyStepping(false),
 _waitBeforeNextStep(false),
-_currentStepIndex(0)
+_currentStepIndex(0),
+_stepStartTime(0)
 {
 
 }
@@ -59,7 +61,7 @@ bool WalkingClient::configure(yarp::os::ResourceFinder &rf) {
     }
     // Running the client for tests?
     if (!rf.check("test")) {
-        OCRA_WARNING("Option 'test' was not found. If you wanted to perform some test, please pass the option --test zmpPreview or --test zmpController");
+        OCRA_WARNING("Option 'test' was not found. If you wanted to perform some test, please pass the option --test zmpPreview, --test steppingTest or --test dcm");
         _isTestRun = false;
     } else {
         _isTestRun = true;
@@ -81,6 +83,10 @@ bool WalkingClient::configure(yarp::os::ResourceFinder &rf) {
     findSingleStepTestParams(rf);
     // Find stepping test parameters
     findSteppingTestParams(rf);
+    // Find footstep adaptation parameters
+    findFootstepAdaptationParams(rf);
+    // Find DCM controller parameters
+    findDCMControllerParams(rf);
     // Find ZMP_VARYING_REFERENCE
     findZMPVaryingReferenceParams(rf);
     // Find MIQP Parameters
@@ -99,7 +105,7 @@ bool WalkingClient::initialize()
     } else {
         // Autoconnect
         std::string src = std::string("/"+_robot+"/left_foot/analog:o");
-        if (!yarp::os::Network::connect(src, portWrenchLeftFoot.getName().c_str())) {
+        if (!ocra_icub::connectPorts(src, portWrenchLeftFoot.getName())) {
             OCRA_ERROR("Impossible to connect to " << src);
             return false;
         }
@@ -111,7 +117,7 @@ bool WalkingClient::initialize()
     } else {
         // Autoconnect
         std::string src = std::string("/"+_robot+"/right_foot/analog:o");
-        if (!yarp::os::Network::connect(src, portWrenchRightFoot.getName().c_str()) ) {
+        if (!ocra_icub::connectPorts(src, portWrenchRightFoot.getName())) {
             OCRA_ERROR("Impossible to connect to " << src);
             return false;
         }
@@ -126,6 +132,7 @@ bool WalkingClient::initialize()
 
 
     // CoM TaskConnection object. This is the task object through which the CoM acceleration will be set by this controller.
+    // The desired state is streamed at every tick through its control ports rather than exchanged over rpc.
     std::string comTaskName("ComTask");
     _comTask = std::make_shared<ocra_recipes::TaskConnection>(comTaskName);
     _comTask->openControlPorts();
@@ -144,20 +151,47 @@ bool WalkingClient::initialize()
         OCRA_WARNING("Feet separation: " << sep);
         _singleStepTrajectory = generateZMPSingleStepTrajectory(_period, feetSeparation);
     }
-    if (!_testType.compare("steppingTest")) {
+    if (!_testType.compare("steppingTest") || !_testType.compare("dcm")) {
         OCRA_WARNING("Generating trajectory for stepping test with feet separation: " << sep);
         generateStepPattern();
-        _steppingTrajectory = generateZMPSteppingTrajectory();
-//         for (auto v : _steppingTrajectory)
-//         {
-//             OCRA_INFO("stepping Trajectory \n" << v.transpose());
-//         }
+        _steppingTestFootsteps = generateSteppingTestFootsteps();
+    }
+    if (!_testType.compare("dcm")) {
+        _dcmController = std::allocate_shared<DcmController>(Eigen::aligned_allocator<DcmController>(), _period, _dcmControllerParams);
+        _dcmController->setPlan(_steppingTestFootsteps.front().position, _steppingTestFootsteps);
+    }
+    if (!_testType.compare("steppingTest")) {
+        _zmpReferenceGenerator = std::allocate_shared<ZmpReferenceGenerator>(Eigen::aligned_allocator<ZmpReferenceGenerator>(), _period, _zmpPreviewParams->Np);
+        if (_constrainedZmpPreviewController) {
+            // The ZMP bounds follow the footstep plan. The support box of a footstep is the box of the contacts of a
+            // foot around its sole, shrunk by the margin
+            Eigen::Vector2d leftSole = _stepController->getLeftFootPosition().head(2);
+            Eigen::Vector2d rightSole = _stepController->getRightFootPosition().head(2);
+            _stepController->getContact2DCoordinates(_contacts);
+            Eigen::Vector2d footHalfSize = Eigen::Vector2d::Zero();
+            for (int i=0; i<_contacts.rows(); ++i) {
+                Eigen::Vector2d contact = _contacts.row(i).transpose();
+                Eigen::Vector2d sole = (contact - leftSole).norm() < (contact - rightSole).norm() ? leftSole : rightSole;
+                footHalfSize = footHalfSize.cwiseMax((contact - sole).cwiseAbs());
+            }
+            _zmpReferenceGenerator->setFootHalfSize(footHalfSize - Eigen::Vector2d::Constant(_zmpPreviewParams->zmpMargin));
+        }
+        _zmpReferenceGenerator->reset(_steppingTestFootsteps.front().position);
+        for (const ZmpFootstep &footstep : _steppingTestFootsteps)
+            _zmpReferenceGenerator->addFootstep(footstep);
+        // The plan starts now, in sync with the steps
+        _zmpReferenceGenerator->fillPreviewWindow();
+        OCRA_INFO("Queued " << _zmpReferenceGenerator->getNumberOfQueuedFootsteps() << " ZMP footsteps for the stepping test");
+        _plannedStepTargets = _stepTargets;
+        _plannedStepTargetDurations = _stepTargetDurations;
+        if (_footstepAdaptationParams.enabled)
+            _footstepAdapter = std::allocate_shared<FootstepAdapter>(Eigen::aligned_allocator<FootstepAdapter>(), _footstepAdaptationParams);
     }
 
     Eigen::Vector3d initialCOMPosition = this->model->getCoMPosition();
     _previousCOM = initialCOMPosition.topRows(2);
     _previousCOMVel = this->model->getCoMVelocity().topRows(2);
-    _hkkPrevious.setZero(6);
+    _hkkPrevious.setZero();
     _firstLoop = true;
 
     // Read measurements
@@ -170,6 +204,9 @@ bool WalkingClient::initialize()
     // Vector of the next Np references. Size is 2*Np because every zmp reference is bidimensional
     zmpRefInPreviewWindow = Eigen::VectorXd(2*_zmpPreviewParams->Np);
     zmpRefInPreviewWindow.setZero();
+    // Bounds of the previewed ZMP, used by the constrained controller
+    zmpMinInPreviewWindow = Eigen::VectorXd::Zero(2*_zmpPreviewParams->Np);
+    zmpMaxInPreviewWindow = Eigen::VectorXd::Zero(2*_zmpPreviewParams->Np);
     // For the test the reference com velocity is set to zero. Only zmp references are considered.
     comVelRefInPreviewWindow = Eigen::VectorXd(2*_zmpPreviewParams->Np);
     comVelRefInPreviewWindow.setZero();
@@ -184,53 +221,27 @@ bool WalkingClient::initialize()
 //     }
 
     // Start MIQPController thread
-    // FIXME: Dummy initial COM velocity references. They're both ramps, to test in the preview window.
-    Eigen::MatrixXd comStateRef(100*_miqpParams.N, 6);
-    double dCoMxRef = _miqpParams.dCoMxRef; 
-    double dCoMyRef = _miqpParams.dCoMyRef;
-    Eigen::VectorXd comRefToReplicate(6); comRefToReplicate << _previousCOM, dCoMxRef, dCoMyRef, 0, 0;
-    comStateRef = comRefToReplicate.transpose().replicate(100*_miqpParams.N,1);
-    OCRA_WARNING("dCoMxRef is: " << dCoMxRef);
-    OCRA_WARNING("dCoMyRef is: " << dCoMyRef);
-    //FIXME: In this way I'm creating a velocity ramp only in the first preview window! 
-    comStateRef(0,2) = 0;
-    comStateRef(1,2) = 0;
-    comStateRef(2,2) = 0.33*_miqpParams.dCoMxRef;
-    comStateRef(3,2) = 0.66*_miqpParams.dCoMxRef;
-    comStateRef(_miqpParams.N-3,2) = 0.66*_miqpParams.dCoMxRef;
-    comStateRef(_miqpParams.N-2,2) = 0.33*_miqpParams.dCoMxRef;
-    comStateRef(_miqpParams.N-1,2) = 0;
-    comStateRef(_miqpParams.N, 2) = 0;
-    
-    comStateRef(0,3) = 0;
-    comStateRef(1,3) = 0;
-    comStateRef(2,3) = 0.33*dCoMyRef;
-    comStateRef(3,3) = 0.66*dCoMyRef;
-    comStateRef(_miqpParams.N-3,3) = 0.66*dCoMyRef;
-    comStateRef(_miqpParams.N-2,3) = 0.33*dCoMyRef;
-    comStateRef(_miqpParams.N-1,3) = 0;
-    comStateRef(_miqpParams.N, 3) = 0;
+    // FIXME: Dummy initial COM velocity references. They're trapezoidal profiles, to test in the preview window.
+    Eigen::MatrixXd comStateRef;
+    buildCoMStateRef(comStateRef);
+    OCRA_WARNING("dCoMxRef is: " << _miqpParams.dCoMxRef);
+    OCRA_WARNING("dCoMyRef is: " << _miqpParams.dCoMyRef);
 
     OCRA_INFO(">>> FIRST REFS: \n");
-    OCRA_INFO(comStateRef.block(0,0,_miqpParams.N,6));
+    OCRA_INFO(comStateRef.topRows(std::min((unsigned int) comStateRef.rows(), _miqpParams.N)));
     // Current iteration
     _k = 1;
-    // Allocate space for optimal horizon of solutions
-    int Nw;
-    // Starting sample point in the original solution from which everything will be copied as it is.
-    unsigned int fromSample = (unsigned int) std::ceil( (2*_miqpParams.dtThread - _miqpParams.dt)/_miqpParams.dt ) + 1; 
-    Nw = _miqpParams.N - fromSample + 1 + 2;
-    OCRA_ERROR("Space allocated for preview window of the walking-client: " << Nw);
-    this->_X_kn.resize(Nw*INPUT_VECTOR_SIZE);
-    this->_t_kn.resize(Nw);
     if (!_testType.compare("miqp")) {
-        _miqpController = std::make_shared<MIQPController>(_miqpParams, this->model, this->_stepController, comStateRef);
+        _miqpController = std::allocate_shared<MIQPController>(Eigen::aligned_allocator<MIQPController>(), _miqpParams, this->model, this->_stepController, comStateRef);
+        _miqpSolution = _miqpController->getSolutionChannel();
         _miqpController->start();
         // Don't run this thread before the MIQPController class has finished initializing
         while (!_miqpController->isRunning()) {
             OCRA_WARNING("Waiting for MIQPController thread to start");
         }
     }
+    if (!startExperimentLogger())
+        return false;
     OCRA_INFO("Initialization is over");
     return true;
 }
@@ -242,6 +253,9 @@ void WalkingClient::release()
 //     _comTask->setDamping(5);
     if (!_testType.compare("miqp"))
         _miqpController->stop();
+    // Write the samples still buffered
+    if (_experimentLogger)
+        _experimentLogger->stop();
     _stepController->stop();
 }
 
@@ -257,6 +271,10 @@ void WalkingClient::loop()
        if (!_testType.compare("steppingTest")) {
            this->steppingTest();
        }
+
+       if (!_testType.compare("dcm")) {
+           performDCMTest();
+       }
        
        if (!_testType.compare("singleStepTest")) {
            performSingleStepTest();
@@ -274,34 +292,17 @@ void WalkingClient::loop()
 }
 
 void WalkingClient::performMIQPTest() {
-    if ( queryMIQPSolution(_miqpParams.dtThread, _miqpParams.dt, this->getExpectedPeriod(), _X_kn, _t_kn) ) {
-        // If a new solution was retrieved from the MIQP
-        OCRA_ERROR("A new solution was retrieved after " << _k << " samples of walking-client and it was: \n ");
-        int Nw = (int) _X_kn.size()/INPUT_VECTOR_SIZE;
-        for (unsigned int i = 0; i < Nw; i++) {
-            std::cout << _X_kn.segment(i*INPUT_VECTOR_SIZE, INPUT_VECTOR_SIZE).transpose() << std::endl;
-        }
-        std::cout << "Time vector is: \n" << _t_kn.transpose() << std::endl;
-        // INTERPOLATION TO GENERATE CoP and CoM velocity reference
-        // First create vector of doubles with the times to interpolate
-        std::vector<double> timeToInterp;
-        for (unsigned int i = 0; i < _t_kn.size(); i++) {
-            timeToInterp.push_back(_t_kn(i)/1000);
-        }
-        // Then create vector of points to interpolate a and b
-        std::vector<Eigen::Vector2d> aToInterp;
-        std::vector<Eigen::Vector2d> bToInterp;
-        int samples = (int) _X_kn.size()/INPUT_VECTOR_SIZE;
-        for (unsigned int i = 0; i < samples; i++) {
-            aToInterp.push_back(_X_kn.segment(i*INPUT_VECTOR_SIZE,2));
-            bToInterp.push_back(_X_kn.segment(i*INPUT_VECTOR_SIZE + 2,2));
-        }
-        std::vector<double> intTime;       // Result of interpolation for time
-        std::vector<Eigen::Vector2d> intA; // Result of interpolation for a
-        std::vector<Eigen::Vector2d> intB; // Result of interpolation for b
-        double dt = (double) this->_period/1000;
-        linearInterpolation(timeToInterp, aToInterp, dt, intTime, intA);
-        linearInterpolation(timeToInterp, bToInterp, dt, intTime, intB);
+    // Pick up the latest solution published by the MIQP thread, if any. This neither locks nor allocates.
+    if (_miqpSolution->update())
+        OCRA_INFO("A new MIQP solution was retrieved after " << _k << " samples of walking-client");
+    if (_miqpSolution->isValid()) {
+        // Sample the CoM jerk and BoS references at the current time of this loop
+        double tnow = yarp::os::Time::now();
+        _miqpSolution->sample(tnow, _miqpComJerk, _miqpA, _miqpB);
+        // Logged to be compared offline with the solutions recorded by the MIQP thread
+        _experimentLogger->log(_logChannels[LOG_MIQP_COM_JERK], tnow, _miqpComJerk);
+        _experimentLogger->log(_logChannels[LOG_MIQP_BOS_UPPER], tnow, _miqpA);
+        _experimentLogger->log(_logChannels[LOG_MIQP_BOS_LOWER], tnow, _miqpB);
         // Now that we have interpolated a and b, we can compute the corresponding interpolated CoP
         //...
     }
@@ -311,37 +312,6 @@ void WalkingClient::performMIQPTest() {
         this->askToStop();
 }
 
-bool WalkingClient::queryMIQPSolution(const int miqpPeriod, const int miqpPreviewPeriod, const int clientPeriod, Eigen::VectorXd &preview, Eigen::VectorXd &timeVector) {
-    // If current iteration _k is a multiple of miqpPeriod/clientPeriod, then a new solution from the MIQP should be ready.
-    preview.setZero();
-    int samplesInPreview = (int) miqpPeriod/clientPeriod;
-    unsigned int fromSample = (unsigned int) std::ceil( (2*miqpPeriod - miqpPreviewPeriod)/miqpPreviewPeriod ) + 1; 
-    Eigen::VectorXd tmpXkn(INPUT_VECTOR_SIZE*_miqpParams.N);
-    if ( _k % samplesInPreview == 0 ) {
-        _miqpController->semaphore.wait();
-        _miqpController->getSolution(tmpXkn);
-        _miqpController->semaphore.post();
-        // Take only the first solution and copy it the first samplesInPreview of _X_kn (or &preview)
-        for (unsigned int i = 0; i < _miqpParams.N; i++)
-            std::cout << tmpXkn.segment(i*INPUT_VECTOR_SIZE, INPUT_VECTOR_SIZE).transpose() << std::endl;
-        // Repeat the first solution twice
-        _X_kn.segment(0,INPUT_VECTOR_SIZE) = tmpXkn.topRows(INPUT_VECTOR_SIZE);
-        _X_kn.segment(INPUT_VECTOR_SIZE,INPUT_VECTOR_SIZE) = tmpXkn.topRows(INPUT_VECTOR_SIZE);
-        // From fromSample copy every element in the preview window
-        // FIXME: The first two elements will always be X_{k+1}
-        _X_kn.segment(2*INPUT_VECTOR_SIZE, (_miqpParams.N - fromSample + 1)*INPUT_VECTOR_SIZE) = tmpXkn.segment((fromSample-1)*INPUT_VECTOR_SIZE, INPUT_VECTOR_SIZE*(_miqpParams.N - fromSample + 1));
-        // Fill-in time vector
-        timeVector(0) = 0;
-        timeVector(1) = miqpPeriod - clientPeriod;
-        for (unsigned int i = 0; i <= _miqpParams.N - fromSample; i++) {
-            timeVector(i+2)= miqpPeriod + i*miqpPreviewPeriod;
-        }
-        return true;
-    } else {
-        return false;
-    }
-}
-
 bool WalkingClient::readFootWrench(FOOT whichFoot, Eigen::VectorXd &rawWrench) {
     yarp::sig::Vector * yRawFootWrench;
     switch (whichFoot) {
@@ -445,58 +415,35 @@ void WalkingClient::generateStepPattern()
     std::cout << "Step Durations:\n" << _stepTargetDurations << std::endl;
 }
 
-std::vector<Eigen::Vector2d> WalkingClient::generateZMPSteppingTrajectory()
+std::vector<ZmpFootstep> WalkingClient::generateSteppingTestFootsteps()
 {
-    std::vector<Eigen::Vector2d> zmpTrajectory;
-    Eigen::Vector2d reference = Eigen::Vector2d::Zero();
     Eigen::Vector3d leftFootPosition = _stepController->getLeftFootPosition();
     Eigen::Vector3d rightFootPosition = _stepController->getRightFootPosition();
-    Eigen::Vector3d zmpStartPosition = (leftFootPosition + rightFootPosition)/2.0;
-    Eigen::MatrixXd zmpWaypoints;
+    Eigen::Vector2d zmpStartPosition = ((leftFootPosition + rightFootPosition)/2.0).head(2);
     int nSteps = _stepTargets.cols();
-    zmpWaypoints.resize(2, 4+2*nSteps-1);
-    zmpWaypoints.col(0) = zmpStartPosition.head(2);
-    zmpWaypoints.col(1) = zmpStartPosition.head(2);
-    zmpWaypoints.col(2) = leftFootPosition.head(2);
-    zmpWaypoints.col(3) = leftFootPosition.head(2);
-    int j=4;
-    for(int i=0; i<(_stepTargets.cols()-1); ++i )
-    {
-        zmpWaypoints.col(j) = _stepTargets.col(i).head(2);
-        zmpWaypoints.col(j+1) = _stepTargets.col(i).head(2);
-        j+=2;
-    }
-    zmpWaypoints.rightCols(1) = ((_stepTargets.col(nSteps-2) + _stepTargets.col(nSteps-1))/2.0).head(2);
-
-    Eigen::VectorXd zmpWaypointDurations = Eigen::VectorXd::Zero(zmpWaypoints.cols()-1);
     double singleSupportDuration = _steppingTestParams.stepDuration;
     double doubleSupportDuration = _steppingTestParams.stepDuration/2.0;
-    double startShiftDuration = doubleSupportDuration;
 
-    zmpWaypointDurations(0) = singleSupportDuration;
-    zmpWaypointDurations(1) = startShiftDuration;
-    for (int i=2; i<zmpWaypointDurations.size(); i+=2) {
-        zmpWaypointDurations(i) = singleSupportDuration;
-        zmpWaypointDurations(i+1) = doubleSupportDuration;
-    }
-    // zmpWaypointDurations.tail(1)(0) = _steppingTestParams.stepDuration / 2.0;
-
-    std::cout << "zmpWaypointDurations:\n" << zmpWaypointDurations.transpose() << std::endl;
-    std::cout << "zmpWaypoints:\n" << zmpWaypoints << std::endl;
-
-    ocra::LinearInterpolationTrajectory traj;
-    traj.setWaypoints(zmpWaypoints);
-    traj.setDuration(zmpWaypointDurations);
-    int period = this->getExpectedPeriod();
-    Eigen::MatrixXd zmpTrajectoryMatrixTmp = traj.getFullTrajectory(period/1000.);
-    Eigen::MatrixXd zmpTrajectoryMatrix = zmpTrajectoryMatrixTmp.leftCols(2).transpose();
-    for (int i=0; i<zmpTrajectoryMatrix.cols(); ++i)
-    {
-        zmpTrajectory.push_back(zmpTrajectoryMatrix.col(i));
+    std::vector<ZmpFootstep> footsteps;
+    // Hold the ZMP between the feet, then shift it to the left foot before the first step
+    footsteps.push_back(ZmpFootstep(zmpStartPosition, 0.0, singleSupportDuration));
+    footsteps.push_back(ZmpFootstep(leftFootPosition.head(2), doubleSupportDuration, singleSupportDuration));
+    for (int i=0; i<nSteps-1; ++i)
+        footsteps.push_back(ZmpFootstep(_stepTargets.col(i).head(2), doubleSupportDuration, singleSupportDuration));
+    // Finish between the last two step targets
+    Eigen::Vector2d zmpEndPosition = ((_stepTargets.col(nSteps-2) + _stepTargets.col(nSteps-1))/2.0).head(2);
+    footsteps.push_back(ZmpFootstep(zmpEndPosition, doubleSupportDuration, 0.0));
+
+    // Keep a copy of the plan, e.g. to benchmark the walking controllers offline on it
+    std::string planPath = std::string(_homeDataDir + "/steppingTests/footstepPlan.txt");
+    std::ofstream planFile(planPath.c_str());
+    if (planFile.is_open()) {
+        for (const ZmpFootstep &footstep : footsteps)
+            planFile << footstep.position.transpose() << " " << footstep.dsDuration << " " << footstep.ssDuration << std::endl;
+    } else {
+        OCRA_WARNING("Could not write the footstep plan to " << planPath);
     }
-
-    return zmpTrajectory;
-
+    return footsteps;
 }
 
 std::vector<Eigen::Vector2d> WalkingClient::generateZMPTrajectoryTEST(double tTrans,
@@ -541,9 +488,10 @@ bool WalkingClient::publish3dQuantity(yarp::os::BufferedPort<yarp::os::Bottle> &
 void WalkingClient::transformStdVectorToEigenVector(std::vector<Eigen::Vector2d> &fullTraj, int from, int Np, Eigen::VectorXd &output)
 {
     int k = 0;
+    int last = fullTraj.size() - 1;
     for (int i=from; i<=from+Np-1; i++) {
-        output(k) = fullTraj[i].operator()(0);
-        output(k+1) = fullTraj[i].operator()(1);
+        output(k) = fullTraj[std::min(i, last)].operator()(0);
+        output(k+1) = fullTraj[std::min(i, last)].operator()(1);
         k = k + 2;
     }
 }
@@ -557,14 +505,14 @@ void WalkingClient::performZMPPreviewTest(ZmpTestType type)
 
     Eigen::Vector2d zmpReference;
     // Retrieve current COM state
-    Eigen::VectorXd hk(6);
+    ComState hk;
     hk.head<2>() = this->model->getCoMPosition().topRows(2);
     hk.segment<2>(2) = this->model->getCoMVelocity().topRows(2);
     hk.tail<2>() = this->model->getCoMAcceleration().topRows(2);
 //     OCRA_WARNING("CoM state from model: " << hk.transpose());
     //TODO: Try to get the task state instead of pos, vel and acc individually.
     //_comTask->getTaskState();
-    Eigen::VectorXd hkk(6); hkk.setZero();
+    ComState hkk; hkk.setZero();
     Eigen::Vector2d pk; pk.setZero();
     Eigen::Vector2d intddhkk; intddhkk.setZero();
     Eigen::Vector2d inthkk; inthkk.setZero();
@@ -576,11 +524,11 @@ void WalkingClient::performZMPPreviewTest(ZmpTestType type)
     transformStdVectorToEigenVector(_zmpTrajectory, el, _zmpPreviewParams->Np, zmpRefInPreviewWindow);
 
     // Compute optimal input in preview window for the next Np zmp references
-    _zmpPreviewController->computeOptimalInput(zmpRefInPreviewWindow, comVelRefInPreviewWindow, hk, optimalU);
+    computeZMPPreviewInput(hk);
 
     // Only using the first input computed by the preview controller;
     // This input must now be integrated (since it's just the optimal com jerk)
-    _zmpPreviewController->integrateCom(optimalU.topRows(2), hk, hkk);
+    _zmpPreviewController->integrateCom(optimalU.head<2>(), hk, hkk);
 
     // Using the zmp cart model, the instantaneous zmp trajectory can now be
     // computed. For this we'll pass the current full com state hk.
@@ -612,22 +560,21 @@ void WalkingClient::performZMPPreviewTest(ZmpTestType type)
     // Write to file for plotting
     //TODO: Watch out! if the thread doesn't respect the desired period, then your plots will look horizontally scaled!
     tnow = tnow + this->getEstPeriod()/1000;
-    std::string homeDir = std::string(_homeDataDir + "/zmpPreviewController/");
-    ocra::utils::writeInFile((Eigen::VectorXd(4) << tnow, intddhkk).finished(), std::string(homeDir + "refComLinAcc.txt") ,true);
-    ocra::utils::writeInFile((Eigen::VectorXd(4) << tnow, currentAcceleration).finished(), std::string(homeDir + "currentComLinAcc.txt"),true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, inthkk).finished(), std::string(homeDir + "intComPositionRef.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(4) << tnow, currentComPos).finished(), std::string(homeDir + "currentComPos.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, _globalZMP).finished(), std::string(homeDir + "currentZMP.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, pk).finished(), std::string(homeDir + "previewedZMP.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, zmpReference).finished(), std::string(homeDir + "referenceZMP.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, optimalU.topRows(2)).finished(), std::string(homeDir + "optimalInput.txt"), true);
+    _experimentLogger->log(_logChannels[LOG_REF_COM_LIN_ACC], tnow, intddhkk);
+    _experimentLogger->log(_logChannels[LOG_CURRENT_COM_LIN_ACC], tnow, currentAcceleration);
+    _experimentLogger->log(_logChannels[LOG_INT_COM_POSITION_REF], tnow, inthkk);
+    _experimentLogger->log(_logChannels[LOG_CURRENT_COM_POS], tnow, currentComPos);
+    _experimentLogger->log(_logChannels[LOG_CURRENT_ZMP], tnow, _globalZMP);
+    _experimentLogger->log(_logChannels[LOG_PREVIEWED_ZMP], tnow, pk);
+    _experimentLogger->log(_logChannels[LOG_REFERENCE_ZMP], tnow, zmpReference);
+    _experimentLogger->log(_logChannels[LOG_OPTIMAL_INPUT], tnow, optimalU.head(2));
 
     //TODO: This way of finishing the test is not good. For some reason when the thread is asked to stop, the trajectories go to zero and the robot still tries to track them. Stpping the module with ctrl + c interruption is best.
     if ( el < _zmpTrajectory.size() )
         el++;
     else {
         OCRA_ERROR("Trajectory finished");
-        Eigen::VectorXd zeroAcc = Eigen::VectorXd::Zero(6);
+        ComState zeroAcc = ComState::Zero();
         prepareAndsetDesiredCoMTaskState(zeroAcc,true);
         this->askToStop();
     }   
@@ -647,10 +594,10 @@ void WalkingClient::performZMPPreviewTestIntCoM(ZmpTestType type)
 
     Eigen::Vector2d zmpReference;
     // Retrieve current COM state
-    Eigen::VectorXd hk(6);
+    ComState hk;
     // Get only current CoM position
     hk.head<2>() = this->model->getCoMPosition().topRows(2);
-    Eigen::VectorXd hkk(6); hkk.setZero();
+    ComState hkk; hkk.setZero();
     Eigen::Vector2d pk; pk.setZero();
     Eigen::Vector2d intddhkk; intddhkk.setZero();
     Eigen::Vector2d inthkk; inthkk.setZero();
@@ -662,11 +609,11 @@ void WalkingClient::performZMPPreviewTestIntCoM(ZmpTestType type)
     transformStdVectorToEigenVector(_zmpTrajectory, el, _zmpPreviewParams->Np, zmpRefInPreviewWindow);
 
     // Compute optimal input in preview window for the next Np zmp references
-    _zmpPreviewController->computeOptimalInput(zmpRefInPreviewWindow, comVelRefInPreviewWindow, _hkkPrevious, optimalU);
+    computeZMPPreviewInput(_hkkPrevious);
 
     // Only using the first input computed by the preview controller;
     // This input must now be integrated (since it's just the optimal com jerk)
-    _zmpPreviewController->integrateCom(optimalU.topRows(2), _hkkPrevious, hkk);
+    _zmpPreviewController->integrateCom(optimalU.head<2>(), _hkkPrevious, hkk);
 
     // Using the zmp cart model, the instantaneous zmp trajectory can now be
     // computed. For this we'll pass the current full com state hk.
@@ -701,22 +648,21 @@ void WalkingClient::performZMPPreviewTestIntCoM(ZmpTestType type)
     // Write to file for plotting
     //TODO: Watch out! if the thread doesn't respect the desired period, then your plots will look horizontally scaled!
     tnow = tnow + this->getEstPeriod()/1000;
-    std::string homeDir = std::string(_homeDataDir + "/zmpPreviewController/");
-    ocra::utils::writeInFile((Eigen::VectorXd(4) << tnow, intddhkk).finished(), std::string(homeDir + "refComLinAcc.txt") ,true);
-    ocra::utils::writeInFile((Eigen::VectorXd(4) << tnow, currentAcceleration).finished(), std::string(homeDir + "currentComLinAcc.txt"),true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, inthkk).finished(), std::string(homeDir + "intComPositionRef.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(4) << tnow, currentComPos).finished(), std::string(homeDir + "currentComPos.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, _globalZMP).finished(), std::string(homeDir + "currentZMP.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, pk).finished(), std::string(homeDir + "previewedZMP.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, zmpReference).finished(), std::string(homeDir + "referenceZMP.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, optimalU.topRows(2)).finished(), std::string(homeDir + "optimalInput.txt"), true);
+    _experimentLogger->log(_logChannels[LOG_REF_COM_LIN_ACC], tnow, intddhkk);
+    _experimentLogger->log(_logChannels[LOG_CURRENT_COM_LIN_ACC], tnow, currentAcceleration);
+    _experimentLogger->log(_logChannels[LOG_INT_COM_POSITION_REF], tnow, inthkk);
+    _experimentLogger->log(_logChannels[LOG_CURRENT_COM_POS], tnow, currentComPos);
+    _experimentLogger->log(_logChannels[LOG_CURRENT_ZMP], tnow, _globalZMP);
+    _experimentLogger->log(_logChannels[LOG_PREVIEWED_ZMP], tnow, pk);
+    _experimentLogger->log(_logChannels[LOG_REFERENCE_ZMP], tnow, zmpReference);
+    _experimentLogger->log(_logChannels[LOG_OPTIMAL_INPUT], tnow, optimalU.head(2));
 
     //TODO: This way of finishing the test is not good. For some reason when the thread is asked to stop, the trajectories go to zero and the robot still tries to track them. Stpping the module with ctrl + c interruption is best.
     if ( el < _zmpTrajectory.size() )
         el++;
     else {
         OCRA_ERROR("Trajectory finished");
-        Eigen::VectorXd zeroAcc = Eigen::VectorXd::Zero(6);
+        ComState zeroAcc = ComState::Zero();
         zeroAcc.topRows<2>() = inthkk;
         zeroAcc.segment<2>(2) << 0.0001, 0.0001;
         prepareAndsetDesiredCoMTaskState(zeroAcc,true);
@@ -733,13 +679,13 @@ void WalkingClient::performSingleStepTest() {
 
     Eigen::Vector2d zmpReference;
     // Retrieve current COM state
-    Eigen::VectorXd hk(6);
+    ComState hk;
     hk.head<2>() = this->model->getCoMPosition().topRows(2);
     hk.segment<2>(2) = this->model->getCoMVelocity().topRows(2);
     hk.tail<2>() = this->model->getCoMAcceleration().topRows(2);
     //TODO: Try to get the task state instead of pos, vel and acc individually.
     //_comTask->getTaskState();
-    Eigen::VectorXd hkk(6); hkk.setZero();
+    ComState hkk; hkk.setZero();
     Eigen::Vector2d pk; pk.setZero();
     Eigen::Vector2d intddhkk; intddhkk.setZero();
     Eigen::Vector2d inthkk; inthkk.setZero();
@@ -751,11 +697,11 @@ void WalkingClient::performSingleStepTest() {
     transformStdVectorToEigenVector(_singleStepTrajectory, el, _zmpPreviewParams->Np, zmpRefInPreviewWindow);
 
     // Compute optimal input in preview window for the next Np zmp references
-    _zmpPreviewController->computeOptimalInput(zmpRefInPreviewWindow, comVelRefInPreviewWindow, hk, optimalU);
+    computeZMPPreviewInput(hk);
 
     // Only using the first input computed by the preview controller;
     // This input must now be integrated (since it's just the optimal com jerk)
-    _zmpPreviewController->integrateCom(optimalU.topRows(2), hk, hkk);
+    _zmpPreviewController->integrateCom(optimalU.head<2>(), hk, hkk);
 
     // Using the zmp cart model, the instantaneous zmp trajectory can now be
     // computed. For this we'll pass the current full com state hk.
@@ -797,15 +743,14 @@ void WalkingClient::performSingleStepTest() {
     // Write to file for plotting
     //TODO: Watch out! if the thread doesn't respect the desired period, then your plots will look horizontally scaled!
     tnow = tnow + this->getEstPeriod()/1000;
-    std::string homeDir = std::string(_homeDataDir + "/zmpPreviewController/");
-    ocra::utils::writeInFile((Eigen::VectorXd(4) << tnow, intddhkk).finished(), std::string(homeDir + "refComLinAcc.txt") ,true);
-    ocra::utils::writeInFile((Eigen::VectorXd(4) << tnow, currentAcceleration).finished(), std::string(homeDir + "currentComLinAcc.txt"),true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, inthkk).finished(), std::string(homeDir + "intComPositionRef.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(4) << tnow, currentComPos).finished(), std::string(homeDir + "currentComPos.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, _globalZMP).finished(), std::string(homeDir + "currentZMP.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, pk).finished(), std::string(homeDir + "previewedZMP.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, zmpReference).finished(), std::string(homeDir + "referenceZMP.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, optimalU.topRows(2)).finished(), std::string(homeDir + "optimalInput.txt"), true);
+    _experimentLogger->log(_logChannels[LOG_REF_COM_LIN_ACC], tnow, intddhkk);
+    _experimentLogger->log(_logChannels[LOG_CURRENT_COM_LIN_ACC], tnow, currentAcceleration);
+    _experimentLogger->log(_logChannels[LOG_INT_COM_POSITION_REF], tnow, inthkk);
+    _experimentLogger->log(_logChannels[LOG_CURRENT_COM_POS], tnow, currentComPos);
+    _experimentLogger->log(_logChannels[LOG_CURRENT_ZMP], tnow, _globalZMP);
+    _experimentLogger->log(_logChannels[LOG_PREVIEWED_ZMP], tnow, pk);
+    _experimentLogger->log(_logChannels[LOG_REFERENCE_ZMP], tnow, zmpReference);
+    _experimentLogger->log(_logChannels[LOG_OPTIMAL_INPUT], tnow, optimalU.head(2));
 
     //FIXME: This way of finishing the test is not good. For some reason when the thread is asked to stop, the trajectories go to zero and the robot still tries to track them. Stpping the module with ctrl + c interruption is best.
     if ( el < _singleStepTrajectory.size() )
@@ -820,34 +765,32 @@ void WalkingClient::steppingTest() {
     static double initialZmpMoveTime = _steppingTestParams.stepDuration + (_steppingTestParams.stepDuration/2);
     static double tnow = yarp::os::Time::now() - steppingTestStartTime;
 
-    static int el = 0;
-
 
     Eigen::Vector2d zmpReference;
     // Retrieve current COM state
-    Eigen::VectorXd hk(6);
+    ComState hk;
     hk.head<2>() = this->model->getCoMPosition().topRows(2);
     hk.segment<2>(2) = this->model->getCoMVelocity().topRows(2);
     hk.tail<2>() = this->model->getCoMAcceleration().topRows(2);
     //TODO: Try to get the task state instead of pos, vel and acc individually.
     //_comTask->getTaskState();
-    Eigen::VectorXd hkk(6); hkk.setZero();
+    ComState hkk; hkk.setZero();
     Eigen::Vector2d pk; pk.setZero();
     Eigen::Vector2d intddhkk; intddhkk.setZero();
     Eigen::Vector2d inthkk; inthkk.setZero();
     Eigen::Vector2d intdhkk; intdhkk.setZero();
 
-    zmpReference = _steppingTrajectory[el];
+    zmpReference = _zmpReferenceGenerator->getCurrentZmpReference();
 
-    // Transform the following Np zmp references from the current time step in the std::vector container to a single Eigen::VectorXd
-    transformStdVectorToEigenVector(_steppingTrajectory, el, _zmpPreviewParams->Np, zmpRefInPreviewWindow);
+    // The following Np zmp and com velocity references from the current time step
+    _zmpReferenceGenerator->getPreviewWindow(zmpRefInPreviewWindow, comVelRefInPreviewWindow);
 
     // Compute optimal input in preview window for the next Np zmp references
-    _zmpPreviewController->computeOptimalInput(zmpRefInPreviewWindow, comVelRefInPreviewWindow, hk, optimalU);
+    computeZMPPreviewInput(hk);
 
     // Only using the first input computed by the preview controller;
     // This input must now be integrated (since it's just the optimal com jerk)
-    _zmpPreviewController->integrateCom(optimalU.topRows(2), hk, hkk);
+    _zmpPreviewController->integrateCom(optimalU.head<2>(), hk, hkk);
 
     // Using the zmp cart model, the instantaneous zmp trajectory can now be
     // computed. For this we'll pass the current full com state hk.
@@ -884,26 +827,113 @@ void WalkingClient::steppingTest() {
     // Compute ZMP
     _zmpPreviewController->computeGlobalZMPFromSensors(_rawLeftFootWrench, _rawRightFootWrench, this->model, _globalZMP);
 
+    // Move the next step according to the capture point error
+    adaptNextStep(hk, zmpReference);
+
     // Write to file for plotting
     //TODO: Watch out! if the thread doesn't respect the desired period, then your plots will look horizontally scaled!
     tnow = tnow + this->getEstPeriod()/1000;
-    std::string homeDir = std::string(_homeDataDir + "/steppingTests/");
-//     ocra::utils::writeInFile((Eigen::VectorXd(4) << tnow, intddhkk).finished(), std::string(homeDir + "refComLinAcc.txt") ,true);
-    ocra::utils::writeInFile((Eigen::VectorXd(2) << tnow, error).finished(), std::string(homeDir + "feetError.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(2) << tnow, stepTrigger).finished(), std::string(homeDir + "stepTrigger.txt"),true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, inthkk).finished(), std::string(homeDir + "intComPositionRef.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(4) << tnow, currentComPos).finished(), std::string(homeDir + "currentComPos.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, _globalZMP).finished(), std::string(homeDir + "currentZMP.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, pk).finished(), std::string(homeDir + "previewedZMP.txt"), true);
-    ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, zmpReference).finished(), std::string(homeDir + "referenceZMP.txt"), true);
-//     ocra::utils::writeInFile((Eigen::VectorXd(3) << tnow, optimalU.topRows(2)).finished(), std::string(homeDir + "optimalInput.txt"), true);
+    if (_footstepAdapter)
+        _experimentLogger->log(_logChannels[LOG_PREDICTED_CAPTURE_POINT_ERROR], tnow, _footstepAdapter->getPredictedError());
+    _experimentLogger->log(_logChannels[LOG_FEET_ERROR], tnow, error);
+    _experimentLogger->log(_logChannels[LOG_STEP_TRIGGER], tnow, stepTrigger);
+    _experimentLogger->log(_logChannels[LOG_INT_COM_POSITION_REF], tnow, inthkk);
+    _experimentLogger->log(_logChannels[LOG_CURRENT_COM_POS], tnow, currentComPos);
+    _experimentLogger->log(_logChannels[LOG_CURRENT_ZMP], tnow, _globalZMP);
+    _experimentLogger->log(_logChannels[LOG_PREVIEWED_ZMP], tnow, pk);
+    _experimentLogger->log(_logChannels[LOG_REFERENCE_ZMP], tnow, zmpReference);
+
+    // Once the plan is over the last ZMP reference is held until new footsteps arrive. The test is not stopped
+    // since the trajectories go to zero when the thread is asked to stop. Stop the module with ctrl + c instead.
+    static bool planFinished = false;
+    if (_zmpReferenceGenerator->isPlanFinished() && !planFinished)
+        OCRA_INFO("Footstep plan finished. Holding the last ZMP reference");
+    planFinished = _zmpReferenceGenerator->isPlanFinished();
+    _zmpReferenceGenerator->advance();
 
-    //TODO: This way of finishing the test is not good. For some reason when the thread is asked to stop, the trajectories go to zero and the robot still tries to track them. Stpping the module with ctrl + c interruption is best.
-    if ( el < _steppingTrajectory.size() )
-        ++el;
-    else
-        this->askToStop();
+}
+
+void WalkingClient::performDCMTest() {
+    static double dcmTestStartTime = yarp::os::Time::now();
+    static double initialZmpMoveTime = _steppingTestParams.stepDuration + (_steppingTestParams.stepDuration/2);
+    static double tnow = 0;
+
+    // Retrieve current COM state
+    ComState hk;
+    hk.head<2>() = this->model->getCoMPosition().topRows(2);
+    hk.segment<2>(2) = this->model->getCoMVelocity().topRows(2);
+    hk.tail<2>() = this->model->getCoMAcceleration().topRows(2);
+
+    // Track the DCM of the plan at the time of this loop
+    double t = yarp::os::Time::now() - dcmTestStartTime;
+    Eigen::Vector2d zmpReference, dcmReference, zmpCommand;
+    ComState hkk;
+    _dcmController->getReference(t, zmpReference, dcmReference);
+    _dcmController->computeControl(t, hk, zmpCommand, hkk);
+    prepareAndsetDesiredCoMTaskState(hkk, true);
+
+    // Same stepping sequence as the stepping test
+    int stepTrigger = 0;
+    static double error = 0;
+    if (t >= initialZmpMoveTime)
+        startSteppinMotherFucker(stepTrigger, error);
+
+    // Read Force/Torque measurements
+    readFootWrench(LEFT_FOOT, _rawLeftFootWrench);
+    readFootWrench(RIGHT_FOOT, _rawRightFootWrench);
+    _zmpPreviewController->computeGlobalZMPFromSensors(_rawLeftFootWrench, _rawRightFootWrench, this->model, _globalZMP);
 
+    // Write to file for plotting
+    tnow = tnow + this->getEstPeriod()/1000;
+    _experimentLogger->log(_logChannels[LOG_STEP_TRIGGER], tnow, stepTrigger);
+    _experimentLogger->log(_logChannels[LOG_CURRENT_DCM], tnow, _dcmController->computeDcm(hk));
+    _experimentLogger->log(_logChannels[LOG_REFERENCE_DCM], tnow, dcmReference);
+    _experimentLogger->log(_logChannels[LOG_COMMANDED_ZMP], tnow, zmpCommand);
+    _experimentLogger->log(_logChannels[LOG_REFERENCE_ZMP], tnow, zmpReference);
+    _experimentLogger->log(_logChannels[LOG_CURRENT_ZMP], tnow, _globalZMP);
+}
+
+bool WalkingClient::startExperimentLogger() {
+    std::string homeDir;
+    std::vector<LogChannel> channels;
+    if (!_testType.compare("zmpPreview") || !_testType.compare("singleStepTest")) {
+        homeDir = _homeDataDir + "/zmpPreviewController/";
+        channels = {LOG_REF_COM_LIN_ACC, LOG_CURRENT_COM_LIN_ACC, LOG_INT_COM_POSITION_REF, LOG_CURRENT_COM_POS,
+                    LOG_CURRENT_ZMP, LOG_PREVIEWED_ZMP, LOG_REFERENCE_ZMP, LOG_OPTIMAL_INPUT};
+    } else if (!_testType.compare("steppingTest")) {
+        homeDir = _homeDataDir + "/steppingTests/";
+        channels = {LOG_FEET_ERROR, LOG_STEP_TRIGGER, LOG_INT_COM_POSITION_REF, LOG_CURRENT_COM_POS,
+                    LOG_CURRENT_ZMP, LOG_PREVIEWED_ZMP, LOG_REFERENCE_ZMP};
+        if (_footstepAdapter)
+            channels.push_back(LOG_PREDICTED_CAPTURE_POINT_ERROR);
+    } else if (!_testType.compare("dcm")) {
+        homeDir = _homeDataDir + "/dcmTests/";
+        channels = {LOG_STEP_TRIGGER, LOG_CURRENT_DCM, LOG_REFERENCE_DCM, LOG_COMMANDED_ZMP, LOG_REFERENCE_ZMP,
+                    LOG_CURRENT_ZMP};
+    } else if (!_testType.compare("miqp")) {
+        homeDir = _homeDataDir + "/miqpTests/";
+        channels = {LOG_MIQP_COM_JERK, LOG_MIQP_BOS_UPPER, LOG_MIQP_BOS_LOWER};
+    }
+
+    // Names of the files previously written by the tests, without extension, and number of values per sample
+    static const char *names[NUMBER_OF_LOG_CHANNELS] = {"refComLinAcc", "currentComLinAcc", "intComPositionRef",
+        "currentComPos", "currentZMP", "previewedZMP", "referenceZMP", "optimalInput", "feetError", "stepTrigger",
+        "predictedCapturePointError", "currentDCM", "referenceDCM", "commandedZMP", "miqpComJerk", "miqpBoSUpper",
+        "miqpBoSLower"};
+    static const unsigned int widths[NUMBER_OF_LOG_CHANNELS] = {2, 3, 2, 3, 2, 2, 2, 2, 1, 1, 2, 2, 2, 2, 2, 2, 2};
+
+    _experimentLogger = std::make_shared<ExperimentLogger>(homeDir);
+    _logChannels.assign(NUMBER_OF_LOG_CHANNELS, -1);
+    if (channels.empty())
+        return true;
+    for (LogChannel channel : channels)
+        _logChannels[channel] = _experimentLogger->addChannel(names[channel], widths[channel]);
+    if (!_experimentLogger->start()) {
+        OCRA_ERROR("Could not start logging the " << _testType << " test in " << homeDir);
+        return false;
+    }
+    OCRA_INFO("Logging " << channels.size() << " channels in " << homeDir);
+    return true;
 }
 
 void WalkingClient::startSteppinMotherFucker(int &stepTrigger, double &error)
@@ -915,6 +945,7 @@ void WalkingClient::startSteppinMotherFucker(int &stepTrigger, double &error)
             auto target = _stepTargets.col(_currentStepIndex);
             double stepDuration = _stepTargetDurations(_currentStepIndex);
             _stepController->step(foot, target, stepDuration, _steppingTestParams.stepHeight);
+            _stepStartTime = yarp::os::Time::now();
             stepTrigger = 1;
             _currentlyStepping = true;
             _stepController->getFootTrajError(_stepOrder[_currentStepIndex], error);
@@ -944,21 +975,59 @@ void WalkingClient::startSteppinMotherFucker(int &stepTrigger, double &error)
     }
 }
 
-void WalkingClient::prepareAndsetDesiredCoMTaskState(VectorXd comState, bool doSet)
+void WalkingClient::adaptNextStep(const ComState &hk, const Eigen::Vector2d &zmpRef)
+{
+    int next = _currentStepIndex + 1;
+    if (!_footstepAdapter || !_currentlyStepping || next >= _stepTargets.cols())
+        return;
+
+    // Time left until the next step lands: end of the step in progress, wait for the ZMP and next step
+    double now = yarp::os::Time::now();
+    double waitDuration = _steppingTestParams.stepDuration/2.0;
+    double timeToNextStep;
+    if (_waitBeforeNextStep)
+        timeToNextStep = std::max(0.0, waitDuration - (now - _waitTimeStart));
+    else
+        timeToNextStep = std::max(0.0, _stepStartTime + _stepTargetDurations(_currentStepIndex) - now) + waitDuration;
+    double timeToLanding = timeToNextStep + _plannedStepTargetDurations(next);
+
+    // The foot landing with the step in progress is the stance foot of the next one. The planned location of the
+    // next step moves with it
+    Eigen::Vector2d stanceFoot = _stepTargets.col(_currentStepIndex).head(2);
+    Eigen::Vector2d currentOffset = (_stepTargets.col(_currentStepIndex) - _plannedStepTargets.col(_currentStepIndex)).head(2);
+    Eigen::Vector2d plannedTarget = _plannedStepTargets.col(next).head(2) + currentOffset;
+
+    Eigen::Vector2d target;
+    double duration;
+    // Capture point planned by the ZMP references of the preview window
+    Eigen::Vector2d capturePointRef = _footstepAdapter->computeCapturePointReference(zmpRefInPreviewWindow, _period/1000.0);
+    _footstepAdapter->adapt(hk, capturePointRef, _globalZMP, zmpRef, timeToLanding, _plannedStepTargetDurations(next),
+                            plannedTarget, stanceFoot, target, duration);
+
+    // The remaining steps are moved rigidly with the next one
+    Eigen::Vector2d offset = target - _plannedStepTargets.col(next).head(2);
+    Eigen::Vector2d offsetChange = offset - (_stepTargets.col(next) - _plannedStepTargets.col(next)).head(2);
+    for (int i=next; i<_stepTargets.cols(); ++i)
+        _stepTargets.col(i).head(2) = _plannedStepTargets.col(i).head(2) + offset;
+    _stepTargetDurations(next) = duration;
+    _zmpReferenceGenerator->offsetQueuedFootsteps(offsetChange);
+}
+
+void WalkingClient::prepareAndsetDesiredCoMTaskState(const ComState &comState, bool doSet)
 {
     ocra::TaskState desiredComState;
     Eigen::Vector3d comRefPosition;
     Eigen::Vector3d comRefVelocity;
     Eigen::Vector3d comRefAcceleration;
 
-    if (!_testType.compare("steppingTest") || !_testType.compare("zmpPreview")) {
+    if (!_testType.compare("steppingTest") || !_testType.compare("zmpPreview") || !_testType.compare("dcm")) {
         comRefPosition << comState.head<2>(), _zmpPreviewParams->cz;
         comRefVelocity << comState.segment<2>(2), 0;
     }
     comRefAcceleration << comState.tail<2>(), 0;
 
     if (doSet) {
-        if (!_testType.compare("steppingTest") || !_testType.compare("zmpPreview")) {
+        if (!_testType.compare("steppingTest") || !_testType.compare("zmpPreview") || !_testType.compare("dcm")) {
             desiredComState.setPosition(ocra::util::eigenVectorToDisplacementd(comRefPosition));
             desiredComState.setVelocity(ocra::util::eigenVectorToTwistd(comRefVelocity));
         }
@@ -975,6 +1044,34 @@ std::string WalkingClient::composePortName(std::string portName) {
     return tmp;
 }
 
+void WalkingClient::computeZMPPreviewInput(const ComState &hk) {
+    if (!_constrainedZmpPreviewController) {
+        _zmpPreviewController->computeOptimalInput(zmpRefInPreviewWindow, comVelRefInPreviewWindow, hk, optimalU);
+        return;
+    }
+    bool feasible;
+    if (_zmpReferenceGenerator) {
+        // Support box of every step of the preview window, from the footstep plan
+        _zmpReferenceGenerator->getSupportWindow(zmpMinInPreviewWindow, zmpMaxInPreviewWindow);
+        feasible = _constrainedZmpPreviewController->computeConstrainedOptimalInput(zmpRefInPreviewWindow, comVelRefInPreviewWindow, hk,
+                                                                                    zmpMinInPreviewWindow, zmpMaxInPreviewWindow, optimalU);
+    } else {
+        // Without a footstep plan the bounding box of the current contacts is used over the whole window
+        _stepController->getContact2DCoordinates(_contacts);
+        if (_contacts.rows() == 0) {
+            _zmpPreviewController->computeOptimalInput(zmpRefInPreviewWindow, comVelRefInPreviewWindow, hk, optimalU);
+            return;
+        }
+        Eigen::Matrix2d minMaxBoundingBox;
+        minMaxBoundingBox.row(0) = _contacts.colwise().minCoeff().array() + _zmpPreviewParams->zmpMargin;
+        minMaxBoundingBox.row(1) = _contacts.colwise().maxCoeff().array() - _zmpPreviewParams->zmpMargin;
+        feasible = _constrainedZmpPreviewController->computeConstrainedOptimalInput(zmpRefInPreviewWindow, comVelRefInPreviewWindow, hk,
+                                                                                    minMaxBoundingBox, optimalU);
+    }
+    if (!feasible)
+        OCRA_WARNING("The ZMP bounds cannot be satisfied from the current CoM state. Using the best input found");
+}
+
 void WalkingClient::findZMPPreviewControllerParams(yarp::os::ResourceFinder &rf) {
         if (!rf.check("ZMP_PREVIEW_CONTROLLER_PARAMS")) {
         OCRA_WARNING("Group of options ZMP_PREVIEW_CONTROLLER_PARAMS was not found, using default parameters Nc=3, nu=, nw=, nb= ");
@@ -987,11 +1084,20 @@ void WalkingClient::findZMPPreviewControllerParams(yarp::os::ResourceFinder &rf)
         _zmpPreviewParams->nw = zmpPreviewControllerParamsGroup.find("nw").asDouble();
         _zmpPreviewParams->nb = zmpPreviewControllerParamsGroup.find("nb").asDouble();
         _zmpPreviewParams->nu = zmpPreviewControllerParamsGroup.find("nu").asDouble();
+        _zmpPreviewParams->constrained = zmpPreviewControllerParamsGroup.check("constrained", yarp::os::Value(false)).asBool();
+        _zmpPreviewParams->jerkBound = zmpPreviewControllerParamsGroup.check("jerkBound", yarp::os::Value(_zmpPreviewParams->jerkBound)).asDouble();
+        _zmpPreviewParams->zmpMargin = zmpPreviewControllerParamsGroup.check("zmpMargin", yarp::os::Value(_zmpPreviewParams->zmpMargin)).asDouble();
+        _zmpPreviewParams->maxActiveSetIterations = zmpPreviewControllerParamsGroup.check("maxActiveSetIterations", yarp::os::Value(_zmpPreviewParams->maxActiveSetIterations)).asInt();
         OCRA_INFO(">> [ZMP_PREVIEW_CONTROLLER_PARAMS]: \n " << zmpPreviewControllerParamsGroup.toString().c_str() << " cz: " << _zmpPreviewParams->cz);
     }
 
     // Create zmpPreviewController object
-   _zmpPreviewController = std::make_shared<ZmpPreviewController>((double) this->getExpectedPeriod(), _zmpPreviewParams);
+    if (_zmpPreviewParams->constrained) {
+        _constrainedZmpPreviewController = std::allocate_shared<ConstrainedZmpPreviewController>(Eigen::aligned_allocator<ConstrainedZmpPreviewController>(), (double) this->getExpectedPeriod(), _zmpPreviewParams);
+        _zmpPreviewController = _constrainedZmpPreviewController;
+    } else {
+        _zmpPreviewController = std::allocate_shared<ZmpPreviewController>(Eigen::aligned_allocator<ZmpPreviewController>(), (double) this->getExpectedPeriod(), _zmpPreviewParams);
+    }
 }
 
 void WalkingClient::findGeneralTestsParams(yarp::os::ResourceFinder &rf) {
@@ -1079,36 +1185,8 @@ void WalkingClient::findMIQPParams(yarp::os::ResourceFinder &rf) {
         yarp::os::Property miqpParamsGroup;
         miqpParamsGroup.fromString(rf.findGroup("MIQP_CONTROLLER_PARAMS").tail().toString());
         _miqpParams.cz = this->model->getCoMPosition().operator()(2);
-        _miqpParams.dCoMxRef = miqpParamsGroup.find("dCoMxRef").asDouble();
-        _miqpParams.dCoMyRef = miqpParamsGroup.find("dCoMyRef").asDouble();
-        _miqpParams.dt = (unsigned int) miqpParamsGroup.find("dt").asInt();
-        _miqpParams.dtThread = (unsigned int) miqpParamsGroup.find("dtThread").asInt();
-        _miqpParams.g = miqpParamsGroup.find("g").asDouble();
         _miqpParams.home = _homeDataDir; // This is actually in the TESTS_GENERAL_PARAMETERS group
-        _miqpParams.N = miqpParamsGroup.find("N").asInt();
-        _miqpParams.sx_constancy = miqpParamsGroup.find("sx_constancy").asDouble();
-        _miqpParams.sy_constancy = miqpParamsGroup.find("sy_constancy").asDouble();
-        _miqpParams.sx_ss = miqpParamsGroup.find("sx_ss").asDouble();
-        _miqpParams.sy_ss = miqpParamsGroup.find("sy_ss").asDouble();
-        _miqpParams.hx_ref = miqpParamsGroup.find("hx_ref").asDouble();
-        _miqpParams.hy_ref = miqpParamsGroup.find("hy_ref").asDouble();
-        _miqpParams.dhx_ref = miqpParamsGroup.find("dhx_ref").asDouble();
-        _miqpParams.dhy_ref = miqpParamsGroup.find("dhy_ref").asDouble();
-        _miqpParams.ddhx_ref = miqpParamsGroup.find("ddhx_ref").asDouble();
-        _miqpParams.ddhy_ref =miqpParamsGroup.find("ddhy_ref").asDouble();
-        _miqpParams.ww = miqpParamsGroup.find("ww").asDouble();
-        _miqpParams.wb = miqpParamsGroup.find("wb").asDouble();
-        _miqpParams.wu = miqpParamsGroup.find("wu").asDouble();
-        _miqpParams.wss = miqpParamsGroup.find("wss").asDouble();
-        _miqpParams.wstep = miqpParamsGroup.find("wstep").asDouble();
-        _miqpParams.wdelta = miqpParamsGroup.find("wdelta").asDouble();
-        _miqpParams.shapeConstraints = miqpParamsGroup.find("shapeConstraints").asBool();
-        _miqpParams.admissibilityConstraints = miqpParamsGroup.find("admissibilityConstraints").asBool();
-        _miqpParams.copConstraints = miqpParamsGroup.find("copConstraints").asBool();
-        _miqpParams.walkingConstraints = miqpParamsGroup.find("walkingConstraints").asBool();
-        _miqpParams.addRegularization = miqpParamsGroup.find("addRegularization").asBool();
-        _miqpParams.robot = miqpParamsGroup.find("robot").asString();
-        _miqpParams.marginCoPBounds = miqpParamsGroup.find("marginCoPBounds").asDouble();
+        MIQPController::loadParameters(miqpParamsGroup, _miqpParams);
          OCRA_INFO(">> [MIQP_CONTROLLER_PARAMS in config file]: \n " << miqpParamsGroup.toString().c_str());
     }
 }
@@ -1126,3 +1204,58 @@ void WalkingClient::findSteppingTestParams(yarp::os::ResourceFinder &rf) {
         OCRA_INFO(">> [STEPPING_TEST]: \n " << steppingTestGroup.toString().c_str());
     }
 }
+
+void WalkingClient::findFootstepAdaptationParams(yarp::os::ResourceFinder &rf) {
+    _footstepAdaptationParams.cz = _zmpPreviewParams->cz;
+    if (!rf.check("FOOTSTEP_ADAPTATION")) {
+        OCRA_WARNING("Group FOOTSTEP_ADAPTATION was not found. Steps won't be adapted");
+    } else {
+        yarp::os::Property footstepAdaptationGroup;
+        footstepAdaptationGroup.fromString(rf.findGroup("FOOTSTEP_ADAPTATION").tail().toString());
+        _footstepAdaptationParams.enabled = footstepAdaptationGroup.check("enabled", yarp::os::Value(false)).asBool();
+        _footstepAdaptationParams.gain = footstepAdaptationGroup.check("gain", yarp::os::Value(_footstepAdaptationParams.gain)).asDouble();
+        _footstepAdaptationParams.maxAdjustment(0) = footstepAdaptationGroup.check("maxAdjustmentX", yarp::os::Value(_footstepAdaptationParams.maxAdjustment(0))).asDouble();
+        _footstepAdaptationParams.maxAdjustment(1) = footstepAdaptationGroup.check("maxAdjustmentY", yarp::os::Value(_footstepAdaptationParams.maxAdjustment(1))).asDouble();
+        _footstepAdaptationParams.maxPredictionTime = footstepAdaptationGroup.check("maxPredictionTime", yarp::os::Value(_footstepAdaptationParams.maxPredictionTime)).asDouble();
+        _footstepAdaptationParams.minStepDuration = footstepAdaptationGroup.check("minStepDuration", yarp::os::Value(_footstepAdaptationParams.minStepDuration)).asDouble();
+        _footstepAdaptationParams.minFeetWidth = footstepAdaptationGroup.check("minFeetWidth", yarp::os::Value(_footstepAdaptationParams.minFeetWidth)).asDouble();
+        OCRA_INFO(">> [FOOTSTEP_ADAPTATION]: \n " << footstepAdaptationGroup.toString().c_str());
+    }
+}
+
+void WalkingClient::findDCMControllerParams(yarp::os::ResourceFinder &rf) {
+    _dcmControllerParams.cz = _zmpPreviewParams->cz;
+    if (!rf.check("DCM_CONTROLLER_PARAMS")) {
+        OCRA_WARNING("Group DCM_CONTROLLER_PARAMS was not found, using default kDcm " << _dcmControllerParams.kDcm);
+    } else {
+        yarp::os::Property dcmControllerParamsGroup;
+        dcmControllerParamsGroup.fromString(rf.findGroup("DCM_CONTROLLER_PARAMS").tail().toString());
+        _dcmControllerParams.kDcm = dcmControllerParamsGroup.check("kDcm", yarp::os::Value(_dcmControllerParams.kDcm)).asDouble();
+        OCRA_INFO(">> [DCM_CONTROLLER_PARAMS]: \n " << dcmControllerParamsGroup.toString().c_str());
+    }
+}
+
+void WalkingClient::buildCoMStateRef(Eigen::MatrixXd &comStateRef) {
+    const unsigned int ramp = _miqpParams.comRampSamples;
+    const unsigned int cruise = _miqpParams.comCruiseSamples;
+    Eigen::VectorXd comRefToReplicate(6); comRefToReplicate << _previousCOM, _miqpParams.dCoMxRef, _miqpParams.dCoMyRef, 0, 0;
+    if (ramp == 0) {
+        // Constant velocity reference
+        comStateRef = comRefToReplicate.transpose().replicate(100*_miqpParams.N, 1);
+        return;
+    }
+    // At rest, then ramp up over ramp samples. Without cruise samples the profile ends at the cruise velocity,
+    // otherwise it is held for cruise samples and ramps down to rest. MIQPController holds the last row beyond the end.
+    const unsigned int nSamples = (cruise == 0) ? ramp + 2 : 2*ramp + cruise + 1;
+    comStateRef = comRefToReplicate.transpose().replicate(nSamples, 1);
+    for (unsigned int i = 0; i < nSamples; i++) {
+        double scale;
+        if (i <= ramp)
+            scale = (i == 0) ? 0.0 : (double) (i - 1)/ramp;
+        else if (cruise == 0 || i <= ramp + cruise)
+            scale = 1;
+        else
+            scale = (double) (2*ramp + cruise - i)/ramp;
+        comStateRef.block(i, 2, 1, 2) *= scale;
+    }
+}
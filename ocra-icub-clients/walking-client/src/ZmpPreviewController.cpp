@@ -1,5 +1,4 @@
 #include "walking-client/ZmpPreviewController.h"
-#include "unsupported/Eigen/MatrixFunctions"
 
 
 ZmpPreviewController::ZmpPreviewController(const double period, std::shared_ptr<ZmpPreviewParams> parameters) :
@@ -26,7 +25,7 @@ Hh(buildHh(Ch,Bh,Ah,Nc,Np))
 //  Wieber's expression    
 //     AOptimal = Hp.transpose() * Hp + Nu;
     AOptimal = Hp.transpose()*Nb*Hp + Nu + Hh.transpose()*Nw*Hh;
-    bOptimal = Eigen::MatrixXd(2*Nc,1).setZero();
+    buildOptimalGains();
     OCRA_INFO("Parameters passed to ZmpPreviewController: \n cz: " << parameters->cz << " Nc: " << parameters->Nc << " nu " << parameters->nu << " nw: " << parameters->nw << " nb: " << parameters->nb);
     OCRA_ERROR("After constructor, Ah: \n" << Ah);
     OCRA_ERROR("After constructor, Bh: \n" << Bh);
@@ -39,14 +38,6 @@ bool ZmpPreviewController::initialize() {
     return true;
 }
 
-void ZmpPreviewController::integrateCom(Eigen::VectorXd comJerk, Eigen::VectorXd hk, Eigen::VectorXd &hkk) {
-    hkk = Ah*hk + Bh*comJerk;
-}
-
-void ZmpPreviewController::tableCartModel(Eigen::Vector2d hk, Eigen::VectorXd ddhk, Eigen::Vector2d& p) {   
-    p = hk - this->cz/this->g * ddhk;
-}
-
 bool ZmpPreviewController::computeFootZMP(FOOT whichFoot,
                                    Eigen::VectorXd wrench,
                                    Eigen::Vector2d &footZMP,
@@ -126,14 +117,10 @@ void ZmpPreviewController::getFTSensorAdjointMatrix(FOOT whichFoot, Eigen::Matri
     
 }
 
-void ZmpPreviewController::tableCartModel(Eigen::VectorXd hkk, Eigen::Vector2d& p) {   
-    p = this->Cp * hkk;
-}
-    
 // ************ Output preview matrices and COM state space matrices ******************
 
-Eigen::MatrixXd ZmpPreviewController::buildAh(const double dt) {
-    Eigen::MatrixXd Ah(6,6);
+ComStateMatrix ZmpPreviewController::buildAh(const double dt) {
+    ComStateMatrix Ah;
     Ah.setIdentity();
     Ah.block(0,2,2,2) = dt*Eigen::Matrix2d::Identity();
     Ah.block(0,4,2,2) = (pow(dt,2)/2)*Eigen::Matrix2d::Identity();
@@ -142,42 +129,44 @@ Eigen::MatrixXd ZmpPreviewController::buildAh(const double dt) {
     return Ah;
 }
 
-Eigen::MatrixXd ZmpPreviewController::buildBh(const double dt){
-    Eigen::MatrixXd Bh(6,2);
+ComInputMatrix ZmpPreviewController::buildBh(const double dt){
+    ComInputMatrix Bh;
     Bh << (pow(dt,3)/6)*Eigen::Matrix2d::Identity(), (pow(dt,2)/2)*Eigen::Matrix2d::Identity(), dt*Eigen::Matrix2d::Identity();
     OCRA_ERROR("Bh is: " << Bh);
     return Bh;
 }
 
-Eigen::MatrixXd ZmpPreviewController::buildCp(const double cz, const double g) {
-    Eigen::MatrixXd Cp(2,6);
+ComOutputMatrix ZmpPreviewController::buildCp(const double cz, const double g) {
+    ComOutputMatrix Cp;
     Cp << Eigen::Matrix2d::Identity(), Eigen::Matrix2d::Zero(), (-cz/g)*Eigen::Matrix2d::Identity();
 //     OCRA_INFO("About to compute Cp with cz: " << cz << "and g: " << g);
 //     OCRA_INFO("Cp: \n" << Cp);
     return Cp;
 }
 
-Eigen::MatrixXd ZmpPreviewController::buildGp(Eigen::MatrixXd Cp, Eigen::MatrixXd Ah, const int Np) {
-    const int CpRows = Cp.rows();
-    const int AhCols = Ah.cols();
-    Eigen::MatrixXd Gp(Cp.rows()*Np, Ah.cols());
-    Gp.setZero();
+Eigen::MatrixXd ZmpPreviewController::buildGp(const ComOutputMatrix &Cp, const ComStateMatrix &Ah, const int Np) {
+    Eigen::MatrixXd Gp(2*Np, 6);
+    // Cp*Ah^(i+1), accumulating the powers of Ah
+    ComOutputMatrix CpAhPower = Cp*Ah;
     for (unsigned int i=0; i<Np; i++) {
-        Gp.block(i*CpRows, 0, CpRows, AhCols) = Cp*Ah.pow(i+1);
+        Gp.block<2,6>(2*i, 0) = CpAhPower;
+        CpAhPower = CpAhPower*Ah;
     }
 //     OCRA_INFO("Gp: \n" << Gp);
     return Gp;
 }
 
-Eigen::MatrixXd ZmpPreviewController::buildHp(Eigen::MatrixXd Cp, Eigen::MatrixXd Bh, Eigen::MatrixXd Ah, const int Nc, const int Np) {
-    const int CpRows = Cp.rows();
-    const int BhCols = Bh.cols();
+Eigen::MatrixXd ZmpPreviewController::buildHp(const ComOutputMatrix &Cp, const ComInputMatrix &Bh, const ComStateMatrix &Ah, const int Nc, const int Np) {
+    const int CpRows = 2;
+    const int BhCols = 2;
     Eigen::MatrixXd Hp(CpRows*Np, BhCols*Nc);
     Hp.setZero();
-    // Create first column
+    // Create first column, Cp*Ah^i*Bh
     Eigen::MatrixXd HpColumn(CpRows*Np, BhCols);
+    ComOutputMatrix CpAhPower = Cp;
     for (unsigned int i=0; i<Np; i++){
-        HpColumn.block(i*CpRows, 0, CpRows, BhCols) = Cp*Ah.pow(i)*Bh;
+        HpColumn.block<2,2>(i*CpRows, 0) = CpAhPower*Bh;
+        CpAhPower = CpAhPower*Ah;
     }
     // Shift HpColumn into every column of Hp to take the form of a lower diagonal toeplitz matrix
     unsigned int j=0;
@@ -189,33 +178,34 @@ Eigen::MatrixXd ZmpPreviewController::buildHp(Eigen::MatrixXd Cp, Eigen::MatrixX
     return Hp;
 }
 
-Eigen::MatrixXd ZmpPreviewController::buildCh() {
-    Eigen::MatrixXd Ch(2,6);
+ComOutputMatrix ZmpPreviewController::buildCh() {
+    ComOutputMatrix Ch;
     Ch << Eigen::Matrix2d::Zero(), Eigen::Matrix2d::Identity(), Eigen::Matrix2d::Zero();
     return Ch;
 }
 
-Eigen::MatrixXd ZmpPreviewController::buildGh(Eigen::MatrixXd Ch, Eigen::MatrixXd Ah, const int Np) {
-    const int ChRows = Ch.rows();
-    const int AhCols = Ah.cols();
-    Eigen::MatrixXd Gh(ChRows*Np, AhCols);
-    Gh.setZero();
+Eigen::MatrixXd ZmpPreviewController::buildGh(const ComOutputMatrix &Ch, const ComStateMatrix &Ah, const int Np) {
+    Eigen::MatrixXd Gh(2*Np, 6);
+    ComOutputMatrix ChAhPower = Ch*Ah;
     for (unsigned int i=0; i<Np; i++) {
-        Gh.block(i*ChRows, 0, ChRows, AhCols) = Ch*Ah.pow(i+1);
+        Gh.block<2,6>(2*i, 0) = ChAhPower;
+        ChAhPower = ChAhPower*Ah;
     }
     return Gh;
 }
 
-Eigen::MatrixXd ZmpPreviewController::buildHh(Eigen::MatrixXd Ch, Eigen::MatrixXd Bh, Eigen::MatrixXd Ah, const int Nc, const int Np) {
-    const int ChRows = Ch.rows();
-    const int BhCols = Bh.cols();
+Eigen::MatrixXd ZmpPreviewController::buildHh(const ComOutputMatrix &Ch, const ComInputMatrix &Bh, const ComStateMatrix &Ah, const int Nc, const int Np) {
+    const int ChRows = 2;
+    const int BhCols = 2;
     Eigen::MatrixXd Hh(ChRows*Np, BhCols*Nc);
     Hh.setZero();
-    // Create first column
+    // Create first column, Ch*Ah^i*Bh
     Eigen::MatrixXd HhColumn(ChRows*Np, BhCols);
+    ComOutputMatrix ChAhPower = Ch;
     //TODO: I think this should be Np - 1
     for (unsigned int i=0; i<Np; i++){
-        HhColumn.block(i*ChRows, 0, ChRows, BhCols) = Ch*Ah.pow(i)*Bh;
+        HhColumn.block<2,2>(i*ChRows, 0) = ChAhPower*Bh;
+        ChAhPower = ChAhPower*Ah;
     }
     // Shift HhColumn into every column of Hh to take the form of a lower diagonal toeplitz matrix
     unsigned int j=0;
@@ -246,3 +236,14 @@ Eigen::MatrixXd ZmpPreviewController::buildNb(const double nb, const int Np) {
     Nb = nb*Nb;
     return Nb;
 }
+
+void ZmpPreviewController::buildOptimalGains() {
+    // A^{-1} [Hp^T Nb, Hh^T Nw] with a single Cholesky factorization of the constant AOptimal
+    Eigen::LLT<Eigen::MatrixXd> llt(AOptimal);
+    Eigen::MatrixXd KZmpFull = llt.solve(Hp.transpose()*Nb);
+    Eigen::MatrixXd KComVelFull = llt.solve(Hh.transpose()*Nw);
+    // Only the first input of the horizon is applied
+    KZmp = KZmpFull.topRows(2);
+    KComVel = KComVelFull.topRows(2);
+    KState = -KZmp*Gp - KComVel*Gh;
+}
@@ -0,0 +1,144 @@
+#include "walking-client/ZmpReferenceGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <ocra/util/ErrorsHelper.h>
+
+ZmpReferenceGenerator::ZmpReferenceGenerator(const double period, const int Np) :
+_dt(period/1000.0),
+_Np(Np),
+_zmpWindow(2, Np),
+_comVelWindow(2, Np),
+_supportMinWindow(2, Np),
+_supportMaxWindow(2, Np),
+_head(0),
+_footHalfSize(Eigen::Vector2d::Zero()),
+_from(Eigen::Vector2d::Zero()),
+_inFootstep(false),
+_sample(0),
+_dsSamples(0),
+_totalSamples(0),
+_holdSamples(0)
+{
+    reset(Eigen::Vector2d::Zero());
+}
+
+ZmpReferenceGenerator::~ZmpReferenceGenerator() {}
+
+void ZmpReferenceGenerator::reset(const Eigen::Vector2d &initialZmp) {
+    _footsteps.clear();
+    _from = initialZmp;
+    _inFootstep = false;
+    _holdSamples = _Np;
+    _head = 0;
+    _zmpWindow.colwise() = initialZmp;
+    _comVelWindow.setZero();
+    _supportMinWindow.colwise() = initialZmp - _footHalfSize;
+    _supportMaxWindow.colwise() = initialZmp + _footHalfSize;
+}
+
+void ZmpReferenceGenerator::setFootHalfSize(const Eigen::Vector2d &halfSize) {
+    _footHalfSize = halfSize.cwiseMax(Eigen::Vector2d::Zero());
+}
+
+bool ZmpReferenceGenerator::addFootstep(const ZmpFootstep &footstep) {
+    if (footstep.dsDuration < 0 || footstep.ssDuration < 0 || footstep.dsDuration + footstep.ssDuration < _dt) {
+        OCRA_WARNING("Footstep at (" << footstep.position.transpose() << ") rejected. Durations are "
+                     << footstep.dsDuration << "s (double support) and " << footstep.ssDuration << "s (single support)");
+        return false;
+    }
+    _footsteps.push_back(footstep);
+    return true;
+}
+
+void ZmpReferenceGenerator::fillPreviewWindow() {
+    // The first sample is the current position of the cursor, which may be halfway through the double support of a
+    // footstep
+    _head = 0;
+    if (_inFootstep && _sample < _dsSamples)
+        _zmpWindow.col(0) = _from + (_current.position - _from)*((double) _sample/_dsSamples);
+    else
+        _zmpWindow.col(0) = _inFootstep ? _current.position : _from;
+    if (_inFootstep)
+        _comVelWindow.col(0) = (_current.position - _from)/(_totalSamples*_dt);
+    else
+        _comVelWindow.col(0).setZero();
+    computeSupportBox(_supportMinWindow.col(0), _supportMaxWindow.col(0));
+    for (int i = 1; i < _Np; i++)
+        generateSample(_zmpWindow.col(i), _comVelWindow.col(i), _supportMinWindow.col(i), _supportMaxWindow.col(i));
+}
+
+void ZmpReferenceGenerator::offsetQueuedFootsteps(const Eigen::Vector2d &offset) {
+    for (ZmpFootstep &footstep : _footsteps)
+        footstep.position += offset;
+}
+
+void ZmpReferenceGenerator::advance() {
+    // The sample at the head is now in the past. It becomes the end of the window
+    generateSample(_zmpWindow.col(_head), _comVelWindow.col(_head), _supportMinWindow.col(_head), _supportMaxWindow.col(_head));
+    _head = (_head + 1) % _Np;
+}
+
+void ZmpReferenceGenerator::getPreviewWindow(Eigen::Ref<Eigen::VectorXd> zmpRef, Eigen::Ref<Eigen::VectorXd> comVelRef) const {
+    unrollWindow(_zmpWindow, zmpRef);
+    unrollWindow(_comVelWindow, comVelRef);
+}
+
+void ZmpReferenceGenerator::getSupportWindow(Eigen::Ref<Eigen::VectorXd> zmpMin, Eigen::Ref<Eigen::VectorXd> zmpMax) const {
+    unrollWindow(_supportMinWindow, zmpMin);
+    unrollWindow(_supportMaxWindow, zmpMax);
+}
+
+void ZmpReferenceGenerator::unrollWindow(const Eigen::Matrix2Xd &window, Eigen::Ref<Eigen::VectorXd> unrolled) const {
+    const int firstPart = _Np - _head;
+    unrolled.head(2*firstPart) = Eigen::Map<const Eigen::VectorXd>(window.col(_head).data(), 2*firstPart);
+    unrolled.tail(2*_head) = Eigen::Map<const Eigen::VectorXd>(window.data(), 2*_head);
+}
+
+void ZmpReferenceGenerator::computeSupportBox(Eigen::Ref<Eigen::Vector2d> supportMin, Eigen::Ref<Eigen::Vector2d> supportMax) const {
+    if (_inFootstep && _sample < _dsSamples) {
+        // Double support: both the previous footstep and the current one are on the ground
+        supportMin = _from.cwiseMin(_current.position) - _footHalfSize;
+        supportMax = _from.cwiseMax(_current.position) + _footHalfSize;
+    } else {
+        const Eigen::Vector2d &position = _inFootstep ? _current.position : _from;
+        supportMin = position - _footHalfSize;
+        supportMax = position + _footHalfSize;
+    }
+}
+
+void ZmpReferenceGenerator::generateSample(Eigen::Ref<Eigen::Vector2d> zmp, Eigen::Ref<Eigen::Vector2d> comVel,
+                                           Eigen::Ref<Eigen::Vector2d> supportMin, Eigen::Ref<Eigen::Vector2d> supportMax) {
+    if (!_inFootstep) {
+        if (_footsteps.empty()) {
+            // End of the plan: hold the last position
+            zmp = _from;
+            comVel.setZero();
+            computeSupportBox(supportMin, supportMax);
+            if (_holdSamples < _Np)
+                _holdSamples++;
+            return;
+        }
+        _current = _footsteps.front();
+        _footsteps.pop_front();
+        _dsSamples = (int) std::round(_current.dsDuration/_dt);
+        _totalSamples = std::max(1, (int) std::round((_current.dsDuration + _current.ssDuration)/_dt));
+        _sample = 0;
+        _holdSamples = 0;
+        _inFootstep = true;
+    }
+
+    // The sample at the start of the footstep coincides with the last one of the previous footstep, hence the
+    // first sample generated for a footstep is already one period into it
+    _sample++;
+    if (_sample < _dsSamples)
+        zmp = _from + (_current.position - _from)*((double) _sample/_dsSamples);
+    else
+        zmp = _current.position;
+    comVel = (_current.position - _from)/(_totalSamples*_dt);
+    computeSupportBox(supportMin, supportMax);
+
+    if (_sample >= _totalSamples) {
+        _from = _current.position;
+        _inFootstep = false;
+    }
+}
@@ -74,7 +74,7 @@ int main (int argc, char * argv[])
         yLog.fatal() << "Model is not empty.";
     }
 
-    ctrlClient = std::make_shared<WalkingClient>(modelIni.getModel(), loopPeriod);
+    ctrlClient = std::allocate_shared<WalkingClient>(Eigen::aligned_allocator<WalkingClient>(), modelIni.getModel(), loopPeriod);
 
     std::shared_ptr<ocra_recipes::ClientManager> clientManager;
     yLog.info() << "Making client manager";
@@ -0,0 +1,193 @@
+/*! \file       walking-log-convert.cpp
+ *  \brief      Converts the channels written by ExperimentLogger to text, CSV or MAT files.
+ *  \details    Every channel <name>.bin is converted next to it (or into --output) as:
+ *              - txt: <name>.txt, one sample per line with the time followed by the values, separated by spaces,
+ *                i.e. the files previously written by ocra::utils::writeInFile().
+ *              - csv: <name>.csv, the same with a header line t, <name>_0, <name>_1, ...
+ *              - mat: <name>.mat, a MATLAB Level 5 MAT-file holding the double matrix <name> of one sample per row.
+ *
+ *              Usage:
+ *              \code
+ *              walking-log-convert [--format txt|csv|mat] [--output <dir>] <channel.bin> [<channel.bin> ...]
+ *              \endcode
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-recipes.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <ocra/util/ErrorsHelper.h>
+#include "walking-client/ExperimentLogger.h"
+
+/** Data types and array class of the MAT-file format */
+static const uint32_t miINT8 = 1;
+static const uint32_t miINT32 = 5;
+static const uint32_t miUINT32 = 6;
+static const uint32_t miDOUBLE = 9;
+static const uint32_t miMATRIX = 14;
+static const uint32_t mxDOUBLE_CLASS = 6;
+
+uint32_t padTo8(uint32_t bytes) {
+    return (bytes + 7) & ~7u;
+}
+
+void writeTag(std::ofstream &file, uint32_t type, uint32_t bytes) {
+    file.write(reinterpret_cast<const char*>(&type), sizeof(type));
+    file.write(reinterpret_cast<const char*>(&bytes), sizeof(bytes));
+}
+
+void writePadding(std::ofstream &file, uint32_t bytes) {
+    static const char zeros[8] = {0};
+    file.write(zeros, padTo8(bytes) - bytes);
+}
+
+/**
+ * MATLAB variable names start with a letter and only contain letters, digits and underscores.
+ */
+std::string toVariableName(const std::string &name) {
+    std::string variable = name;
+    for (unsigned int i = 0; i < variable.size(); i++) {
+        if (!std::isalnum((unsigned char) variable[i]))
+            variable[i] = '_';
+    }
+    if (variable.empty() || !std::isalpha((unsigned char) variable[0]))
+        variable = "v" + variable;
+    return variable.substr(0, 63);
+}
+
+bool writeMat(const std::string &path, const std::string &name, const Eigen::MatrixXd &samples) {
+    std::ofstream file(path.c_str(), std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    // 128 bytes header: description, no subsystem data, version 0x0100 and endianness indicator
+    char header[128];
+    std::memset(header, ' ', 116);
+    std::string description = "MATLAB 5.0 MAT-file, written by walking-log-convert";
+    std::memcpy(header, description.data(), description.size());
+    std::memset(header + 116, 0, 8);
+    const uint16_t version = 0x0100;
+    std::memcpy(header + 124, &version, sizeof(version));
+    header[126] = 'I';
+    header[127] = 'M';
+    file.write(header, sizeof(header));
+
+    const std::string variable = toVariableName(name);
+    const uint32_t nameBytes = variable.size();
+    const uint32_t dataBytes = sizeof(double)*samples.size();
+    const uint32_t matrixBytes = (8 + 8) + (8 + 8) + (8 + padTo8(nameBytes)) + (8 + dataBytes);
+    writeTag(file, miMATRIX, matrixBytes);
+    // Array flags
+    const uint32_t flags[2] = {mxDOUBLE_CLASS, 0};
+    writeTag(file, miUINT32, sizeof(flags));
+    file.write(reinterpret_cast<const char*>(flags), sizeof(flags));
+    // Dimensions
+    const int32_t dimensions[2] = {(int32_t) samples.rows(), (int32_t) samples.cols()};
+    writeTag(file, miINT32, sizeof(dimensions));
+    file.write(reinterpret_cast<const char*>(dimensions), sizeof(dimensions));
+    // Name
+    writeTag(file, miINT8, nameBytes);
+    file.write(variable.data(), nameBytes);
+    writePadding(file, nameBytes);
+    // Real part, column-major as Eigen
+    writeTag(file, miDOUBLE, dataBytes);
+    file.write(reinterpret_cast<const char*>(samples.data()), dataBytes);
+    return file.good();
+}
+
+bool writeText(const std::string &path, const std::string &name, const Eigen::MatrixXd &samples, bool csv) {
+    std::ofstream file(path.c_str());
+    if (!file.is_open())
+        return false;
+    const char separator = csv ? ',' : ' ';
+    if (csv) {
+        file << "t";
+        for (unsigned int j = 1; j < samples.cols(); j++)
+            file << separator << name << "_" << j - 1;
+        file << std::endl;
+    }
+    file << std::setprecision(17);
+    for (unsigned int i = 0; i < samples.rows(); i++) {
+        for (unsigned int j = 0; j < samples.cols(); j++) {
+            if (j > 0)
+                file << separator;
+            file << samples(i,j);
+        }
+        file << "\n";
+    }
+    return file.good();
+}
+
+int main(int argc, char * argv[])
+{
+    std::string format = "txt";
+    std::string output;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "--format" && i + 1 < argc) {
+            format = argv[++i];
+        } else if (arg == "--output" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--help") {
+            inputs.clear();
+            break;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty() || (format != "txt" && format != "csv" && format != "mat")) {
+        std::cout << "Usage: walking-log-convert [--format txt|csv|mat] [--output <dir>] <channel.bin> [<channel.bin> ...]" << std::endl;
+        return inputs.empty() ? 0 : -1;
+    }
+
+    int failures = 0;
+    for (unsigned int i = 0; i < inputs.size(); i++) {
+        std::string name;
+        Eigen::MatrixXd samples;
+        if (!ExperimentLogger::readChannel(inputs[i], name, samples)) {
+            failures++;
+            continue;
+        }
+        std::string base = inputs[i];
+        if (base.size() > 4 && base.compare(base.size() - 4, 4, ".bin") == 0)
+            base.erase(base.size() - 4);
+        if (!output.empty())
+            base = output + "/" + name;
+        std::string path = base + "." + format;
+
+        bool written = format == "mat" ? writeMat(path, name, samples) : writeText(path, name, samples, format == "csv");
+        if (!written) {
+            OCRA_ERROR("Could not write " << path);
+            failures++;
+            continue;
+        }
+        std::cout << inputs[i] << " -> " << path << " (" << samples.rows() << " samples of " << samples.cols() - 1 << " values)" << std::endl;
+    }
+    return failures == 0 ? 0 : -1;
+}
@@ -5,6 +5,8 @@
 #include <ocra-recipes/ControllerServer.h>
 #include <Eigen/Dense>
 #include <ocra-icub/OcraWbiModel.h>
+#include <ocra-icub/Utilities.h>
+#include <ocra-icub/CompiledTaskSet.h>
 #include <iDynTree/Estimation/SimpleLeggedOdometry.h>
 #include <ocra/util/ErrorsHelper.h>
 
@@ -26,9 +28,84 @@ public:
 
     virtual void getRobotState(Eigen::VectorXd& q, Eigen::VectorXd& qd, Eigen::Displacementd& H_root, Eigen::Twistd& T_root);
     
+    /*! Base state of the last getRobotState(), as the WBI expects it. Identity and zero for a fixed base.
+     *  \param H_root Pose of the base.
+     *  \param T_root Velocity of the base, linear then angular.
+     */
+    void getBaseState(wbi::Frame& H_root, Eigen::VectorXd& T_root) const { H_root = wbi_H_root; T_root = wbi_T_root_Vector; };
+
     // Odometry related methods
+    /*! Loads the URDF model used by the odometry. Only touches the odometry, so it can run on another thread than
+     *  initialize().
+     *  \param model_file Path of the URDF model of the robot.
+     *
+     *  \return False if the model could not be loaded.
+     */
+    bool loadOdometryModel(std::string model_file);
+    /*! Initializes the odometry on the current joint positions, loading its model first unless loadOdometryModel()
+     *  was already called.
+     */
     bool initializeOdometry(std::string model_file, std::string initialFixedFrame);
+    /*! Initializes the odometry so that it continues the one of another controller server, e.g. the one of the
+     *  previous task set: the fixed link of the other controller keeps the world pose its odometry estimated.
+     *  Loads the model first unless loadOdometryModel() was already called.
+     *  \param model_file Path of the URDF model of the robot.
+     *  \param other Controller server whose odometry is continued, not running meanwhile.
+     *
+     *  \return False if the odometry could not be initialized.
+     */
+    bool continueOdometry(std::string model_file, IcubControllerServer& other);
     std::vector<std::string> getCanonical_iCubJoints();
+
+    /*! Reads the options of the tasks of a task set, either an XML one or one compiled by ocra-task-set-compiler,
+     *  see ocra_icub::isCompiledTaskSet(). A compiled task set is checked against the joint list of the robot.
+     *  Does not touch the controller, so it can run on another thread than the control one.
+     *  \param filePath Path of the task set. No task is read if it is empty.
+     *  \param taskOptions Options of the tasks, to be passed to addTasks().
+     *
+     *  \return False if the task set could not be read.
+     */
+    bool readTaskSet(const std::string& filePath, std::vector<ocra::TaskBuilderOptions>& taskOptions);
+    /*! Same as above, with the hash of the joint list of the robot given, see ocra_icub::hashJointList(), so that
+     *  the WBI is not accessed.
+     */
+    static bool readTaskSet(const std::string& filePath, std::uint64_t jointListHash, std::vector<ocra::TaskBuilderOptions>& taskOptions);
+
+    /*! Adds the tasks of a task set, see readTaskSet().
+     *  \param filePath Path of the task set.
+     *
+     *  \return False if the task set could not be read.
+     */
+    bool addTasksFromFile(const std::string& filePath);
+
+    /*! Solves the controller on the model as of the last updateModel(), without reading the robot.
+     *  \param torques The joint torques.
+     */
+    void computeOutput(Eigen::VectorXd& torques) { this->controller->computeOutput(torques); };
+
+    /*! Activates or deactivates a set of tasks. Nothing is changed unless all of them exist.
+     *  \param taskNames Names of the tasks.
+     *  \param activate True to activate the tasks, false to deactivate them.
+     *
+     *  \return False if a task doesn't exist or could not be switched.
+     */
+    bool setTasksActivation(const std::vector<std::string>& taskNames, bool activate);
+
+    /*! Sets the desired states of a set of tasks and reads fields of another, see ocra_icub::TaskStateBatch.
+     *  Nothing is changed unless all of the tasks exist.
+     *  \param desiredTaskNames Names of the tasks whose desired state is set.
+     *  \param desiredStates Desired states of these tasks.
+     *  \param readTaskNames Names of the tasks to read.
+     *  \param readFields ocra_icub::TASK_STATE_FIELD values or-ed together, for each task to read.
+     *  \param reply One list per task to read is appended to it, holding the requested fields.
+     *
+     *  \return False if a task doesn't exist.
+     */
+    bool exchangeTaskStates(const std::vector<std::string>& desiredTaskNames,
+                            const std::vector<ocra::TaskState>& desiredStates,
+                            const std::vector<std::string>& readTaskNames,
+                            const std::vector<int>& readFields,
+                            yarp::os::Bottle& reply);
     // Not in the virtual class
     void rootFrameVelocity(Eigen::VectorXd& q,
                            Eigen::VectorXd& qd,
@@ -54,6 +131,8 @@ public:
     
     void velocityError(Eigen::MatrixXd A, Eigen::MatrixXd B, Eigen::MatrixXd X);
 private:
+    bool findTasks(const std::vector<std::string>& taskNames, std::vector<std::shared_ptr<ocra::Task> >& tasks);
+
     std::shared_ptr<wbi::wholeBodyInterface> wbi; /*!< The WBI used to talk to the robot. */
     std::string robotName;
     bool isFloatingBase;
@@ -66,6 +145,7 @@ private:
     wbi::Frame wbi_H_root;
     
     iDynTree::SimpleLeggedOdometry odometry;
+    bool odometryModelLoaded; /*!< True once loadOdometryModel() succeeded. */
     
 };
 
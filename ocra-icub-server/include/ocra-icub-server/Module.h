@@ -37,6 +37,7 @@
 #include <yarpWholeBodyInterface/yarpWholeBodyInterface.h>
 #include "ocra-icub-server/Thread.h"
 #include "ocra-icub/Utilities.h"
+#include "ocra-icub/SimulatedWholeBodyInterface.h"
 
 
 /*! \class Module
@@ -81,11 +82,20 @@ public:
      */
     void printHelp();
 
+    /*! Runs the control loop on the simulated robot until OcraControllerOptions::simulationDuration, without waiting
+     *  between ticks, then prints the control tick durations. To be called instead of runModule() after configure()
+     *  when the module is launched with --sim.
+     *  \return False if the controller could not be initialized or the simulation failed.
+     */
+    bool runSimulation();
+
 private:
     std::shared_ptr<Thread> ctrlThread; /*!< The controller thread. This is where the magic happens. */
     // Thread* ctrlThread; /*!< The controller thread. This is where the magic happens. */
     // Thread ctrlThread; /*!< The controller thread. This is where the magic happens. */
     std::shared_ptr<wbi::wholeBodyInterface> robotInterface; /*!< The yarpWBI interface used to get estimates from the robot. */
+    ocra_icub::SimulatedWholeBodyInterface::shared_ptr simulatedInterface; /*!< Same object as robotInterface with --sim, null otherwise. */
+    StartupReport::shared_ptr startupReport; /*!< Timings of the startup stages, printed once the controller thread is initialized. */
 
     yarp::os::Log yLog; /*!< A yarp logging tool. */
     OcraControllerOptions controller_options; /*!< Options used for the controller. */
@@ -0,0 +1,81 @@
+/*! \file       StartupReport.h
+ *  \brief      Timings of the startup stages of the controller server.
+ *  \details    The startup of ocra-icub-server is a small graph of stages: some of them need the devices of the
+ *              robot or the controller, others, like parsing the task set or the URDF model used by the odometry,
+ *              only need files and run on their own threads while the devices are opened. Each stage is recorded
+ *              here with the thread it ran on, and the report is printed once the robot is in torque mode.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-icub.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OCRA_CONTROLLER_SERVER_STARTUP_REPORT_H
+#define OCRA_CONTROLLER_SERVER_STARTUP_REPORT_H
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <ocra-icub/Utilities.h>
+
+/*! \class StartupReport
+ *  \brief Thread-safe record of the startup stages, timed from the construction of the report.
+ */
+class StartupReport
+{
+CLASS_POINTER_TYPEDEFS(StartupReport)
+
+public:
+    /*! Constructor. Starts the clock of the report.
+     */
+    StartupReport();
+
+    /*! \return Seconds since the construction of the report.
+     */
+    double now() const;
+
+    /*! Records a stage.
+     *  \param name Name of the stage, e.g. "task set parsing".
+     *  \param thread Name of the thread the stage ran on, e.g. "module", "control" or "startup".
+     *  \param start Time the stage started, from now().
+     *  \param end Time the stage ended, from now().
+     */
+    void addStage(const std::string& name, const std::string& thread, double start, double end);
+
+    /*! Prints the stages in the order they started, and the time of the end of the last one, i.e. the time to torque
+     *  mode once the controller thread is initialized.
+     */
+    void print() const;
+
+private:
+    struct Stage {
+        std::string name;
+        std::string thread;
+        double start;
+        double end;
+    };
+
+    std::chrono::steady_clock::time_point origin; /*!< Time of the construction of the report. */
+    mutable std::mutex stagesMutex; /*!< Stages are recorded from several threads. */
+    std::vector<Stage> stages;
+};
+
+#endif // OCRA_CONTROLLER_SERVER_STARTUP_REPORT_H
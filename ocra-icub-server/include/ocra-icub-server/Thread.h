@@ -31,6 +31,8 @@
 #include <wbi/wbi.h>
 
 #include <ocra-icub-server/IcubControllerServer.h>
+#include <ocra-icub-server/StartupReport.h>
+#include <ocra-icub-server/TorqueLoopThread.h>
 
 #include <ocra-icub/Utilities.h>
 #include <ocra/util/ErrorsHelper.h>
@@ -40,8 +42,15 @@
 #include <yarp/os/ConnectionReader.h>
 #include <yarp/os/Time.h>
 
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <future>
+#include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <iDynTree/Estimation/SimpleLeggedOdometry.h>
 
@@ -74,9 +83,18 @@ public: // Variables
     bool                    idleAnkles; /*!< A boolean which tells the controller to idle the ankles for a short period and then pass on to normal operation. This is to get the feet flush with the ground.*/
     double                  idleAnkleTime; /*!< Number of seconds to idle the ankle. By default 1.5s.*/
     bool                    maintainFinalPosture; /*!< A boolean which tells the controller to stay in its final posture when the controller is switched to position mode at the end of usage.*/
+    bool                    simulation; /*!< A boolean which tells the controller to run on a SimulatedWholeBodyInterface, headless and as fast as possible, instead of the robot. */
+    double                  simulationDuration; /*!< Simulated time in seconds after which the simulation stops. By default 10s. */
+    bool                    useInterprocessCommunication; /*!< A boolean which tells the controller server to open the task ports. False when simulating without a YARP network. */
+    int                     torqueLoopPeriod; /*!< Period in ms of the TorqueLoopThread sending the torques of the QP, solved every threadPeriod, corrected for the current joint state. 0 to send the torques from the control thread, the default. */
+    double                  taskSetBlendTime; /*!< Time in seconds over which the torques of the current task set are blended into those of a task set loaded with LOAD_TASK_SET. Both task sets are solved at each tick of the blend, so the tick time doubles meanwhile. By default 0.5s. */
+    double                  maxTorque; /*!< Torque limit in Nm of the joints which have none in jointTorqueLimits, applied in both directions. By default 24Nm. */
+    std::map<std::string, std::pair<double, double> > jointTorqueLimits; /*!< Minimum and maximum torques in Nm of some joints, by joint name. */
+    double                  maxTorqueRate; /*!< Maximum change of the torque of each joint between two control ticks, or two ticks of the torque loop, in Nm/s. 0 for no limit, the default. */
     yarp::os::Property      yarpWbiOptions; /*!< Options for the WBI used to update the model. */
     ocra_recipes::CONTROLLER_TYPE    controllerType; /*!< The type of OCRA controller to use. */
     ocra_recipes::SOLVER_TYPE    solver; /*!< The type of OCRA controller to use. */
+    std::map<std::string, std::vector<std::string> > taskGroups; /*!< Named groups of tasks which are activated and deactivated together, on the same control tick. By default the four corner contacts of each foot, `LeftFootContact` and `RightFootContact`. */
 
     double wDdq;
     double wTau;
@@ -96,9 +114,12 @@ class Thread: public yarp::os::RateThread
 public:
     /*! Constructor
      *  \param controller_options The various arguments and options used to define what type of controller and tasks to use. See \ref OcraControllerOptions.
-     *  \param wbi A shared pointer to a wholeBodyInterface object.
+     *  \param wbi A shared pointer to a wholeBodyInterface object. Its joints must be added, but it doesn't need to be initialized yet.
+     *  \param report Report the startup stages are recorded in. A new one if null.
+     *
+     *  The startup stages which only need files, i.e. reading the task set and loading the URDF model of the odometry, are started here on their own threads. They overlap with the initialization of the WBI, which opens the devices of the robot, and with the first stages of threadInit(), which waits for them.
      */
-    Thread(OcraControllerOptions& controller_options, std::shared_ptr<wbi::wholeBodyInterface> wbi);
+    Thread(OcraControllerOptions& controller_options, std::shared_ptr<wbi::wholeBodyInterface> wbi, StartupReport::shared_ptr report = nullptr);
 
     virtual ~Thread();
     bool threadInit();
@@ -165,19 +186,51 @@ private:
     void parseDebugMessage(yarp::os::Bottle& input, yarp::os::Bottle& reply);
     void writeDebugData();
     void putAnklesIntoIdle(double idleTime);
-    void sendTorqueReferenceToDebugJoint(int idx);
+    bool setTaskGroupActivation(const std::string& groupName, bool activate);
+    bool exchangeTaskStates(yarp::os::Bottle& input, int& i, yarp::os::Bottle& reply);
+    /*! Builds the controller of a task set and swaps it in between two ticks. The torques are blended from those of
+     *  the previous task set, which keeps being solved until the end of the blend, so a tick of the blend costs the
+     *  two solves. The robot is only accessed with controllerMutex held, and the odometry continues the one of the
+     *  previous task set.
+     *  \param taskSetPath Path of the task set, XML or compiled.
+     *  \param blendTime Time in seconds over which the torques are blended.
+     *
+     *  \return False if the task set could not be loaded, in which case the current one is kept.
+     */
+    bool loadTaskSet(const std::string& taskSetPath, double blendTime);
+    /*! Sends the torques of the debugged joints, with one setControlReference() per joint, or a single one when all
+     *  of the joints are debugged. The joints in position mode are not written. The WBI only writes one joint or all
+     *  of them, so a partial set, e.g. the three torso joints, costs one write per joint as before this method.
+     */
+    void sendDebugTorqueReferences();
+    void loadTorqueLimits();
+    /*! Sets the torques the rate limit starts from to the measured joint torques, or to zeros if they can't be read.
+     *  Called whenever joints are switched to torque mode, so that the first torques sent follow those the robot
+     *  applies. Takes controllerMutex.
+     */
+    void seedPreviousTorques();
     bool setDebugJointToTorqueMode(int idx);
+    /*! Switches the control mode of a set of joints, with a single call to the WBI if the set holds all of the joints.
+     *  \param joints Indexes of the joints.
+     *  \param mode The new control mode.
+     *  \param ref Reference of every joint of the robot in the new mode, also set as the control reference of the
+     *             joints. May be null.
+     *
+     *  \return False if the mode or the reference of a joint could not be set.
+     */
+    bool setJointsControlMode(const std::vector<int>& joints, wbi::ControlMode mode, double* ref);
+    std::vector<int> allJoints();
+    void setDebugJoints(const std::vector<int>& joints);
 
 private:
     ocra::Model::Ptr model;
     std::shared_ptr<IcubControllerServer> ctrlServer;
     static const int ALL_JOINTS = -1; /*!< Maximum possible actuator torques */
 
-    //TODO: Need to get the torque mins and maxs at the joint level.
-    static const int TORQUE_MIN = -24; /*!< Minimum possible actuator torques */
-    static const int TORQUE_MAX = 24; /*!< Maximum possible actuator torques */
-    Eigen::ArrayXd minTorques; /*!< An eigen array filled with the min torques. */
-    Eigen::ArrayXd maxTorques; /*!< An eigen array filled with the max torques. */
+    Eigen::ArrayXd minTorques; /*!< Minimum torque of each joint, see OcraControllerOptions::jointTorqueLimits. */
+    Eigen::ArrayXd maxTorques; /*!< Maximum torque of each joint, see OcraControllerOptions::jointTorqueLimits. */
+    double maxTorqueStep; /*!< Maximum change of the torques between two ticks, see OcraControllerOptions::maxTorqueRate. 0 for no limit. */
+    Eigen::ArrayXd previousTorques; /*!< The torques of the previous tick, seeded by seedPreviousTorques() on a switch to torque mode. */
 
 
     OcraControllerOptions ctrlOptions; /*!< The controller options. */
@@ -187,6 +240,12 @@ private:
 
 
     ocra_icub::OCRA_ICUB_MESSAGE controllerStatus;
+    std::mutex controllerMutex; /*!< Held by run() while computing the torques so that the tasks of a group are switched between two control ticks. */
+    std::shared_ptr<IcubControllerServer> outgoingCtrlServer; /*!< Controller server of the previous task set while its torques are blended out, null otherwise. See loadTaskSet(). */
+    std::shared_ptr<IcubControllerServer> retiredCtrlServer; /*!< Controller server of the previous task set once blended out. Destroyed by the next loadTaskSet(), off the control thread. */
+    Eigen::VectorXd outgoingTorques; /*!< The torques of the previous task set while it is blended out. */
+    int blendTicks; /*!< Number of ticks over which the previous task set is blended out. */
+    int blendTick; /*!< Number of ticks since the last task set was swapped in. */
     ControllerRpcServerCallback::shared_ptr rpcServerCallback; /*!< Rpc server port callback function. */
     yarp::os::RpcServer rpcServerPort; /*!< Rpc server port. */
 
@@ -199,11 +258,26 @@ private:
 
     Eigen::VectorXd measuredTorques;
     bool debuggingAllJoints;
+    std::vector<int> debugJoints; /*!< Indexes of the joints in torque mode in debug mode. Only changed by the debug rpc thread, through setDebugJoints(). */
+    std::mutex debugJointsMutex; /*!< Protects debugJoints, read by run(). */
     bool userHasSetDebugIndex;
 
     Eigen::Displacementd l_foot_disp_inverse; /*!< For gazebo visualization. You can't get the l_sole pose directly in gazebo, but you can get the l_foot, so since all poses from ocra::Model are calculated in the l_sole then we need to go from l_sole to l_foot.*/
 
     iDynTree::SimpleLeggedOdometry odometry; /*!< Odometry object */
+
+    // Multi-rate control, see OcraControllerOptions::torqueLoopPeriod.
+    TorqueLoopThread::shared_ptr torqueLoop; /*!< The fast loop the QP solutions are handed to. Null if the torques are sent by run(). */
+    Eigen::VectorXd solutionQ; /*!< Joint positions the QP was last solved at. */
+    Eigen::VectorXd solutionDq; /*!< Joint velocities the QP was last solved at. */
+    wbi::Frame solutionBase; /*!< Base pose the QP was last solved at. */
+    Eigen::VectorXd solutionBaseVelocity; /*!< Base velocity the QP was last solved at. */
+
+    // Startup, see the constructor.
+    StartupReport::shared_ptr startupReport; /*!< The startup stages are recorded here. */
+    std::vector<ocra::TaskBuilderOptions> startupTaskOptions; /*!< Options of the tasks of the startup task set, read by startupTaskSetFuture. */
+    std::future<bool> startupTaskSetFuture; /*!< Reads the startup task set. Declared after what it uses so that it is waited for first on destruction. */
+    std::future<bool> odometryModelFuture; /*!< Loads the URDF model of the odometry, if used. */
 };
 
 
@@ -0,0 +1,127 @@
+/*! \file       TorqueLoopThread.h
+ *  \brief      Fast inner torque loop of the controller server, decoupled from the QP.
+ *  \details    With --torqueLoopPeriod, the control Thread solves the QP at its own period, e.g. 10ms, and hands each
+ *              solution to this thread instead of sending it to the robot. This thread runs at a faster period,
+ *              e.g. 1ms, and sends the torques of the latest solution corrected with the joint measurements of the
+ *              current tick:
+ *              \f[
+ *                  \boldsymbol{\tau} = \boldsymbol{\tau}^* + \mathbf{h}_j(\mathbf{q}, \dot{\mathbf{q}}) - \mathbf{h}_j(\mathbf{q}^*, \dot{\mathbf{q}}^*)
+ *              \f]
+ *              where \f$\boldsymbol{\tau}^*\f$ are the torques solved for at the state \f$(\mathbf{q}^*, \dot{\mathbf{q}}^*)\f$
+ *              and \f$\mathbf{h}_j\f$ is the joint part of the generalized bias forces, i.e. gravity, Coriolis and
+ *              centrifugal effects. The accelerations and contact forces of the solution are kept, while the
+ *              inverse dynamics they were computed with follow the robot between two solutions. The base pose and
+ *              velocity are those of the latest solution.
+ *
+ *              The bias forces are computed with a yarpWbi::yarpWholeBodyModel of its own, so that this thread never
+ *              waits for the model of the controller. The joint states are read and the torques sent through a
+ *              yarpWbi::yarpWholeBodyInterface of its own too: the WBI of the control thread is not thread safe, and
+ *              sharing it would make this loop wait for every access of the control thread, including the reads of a
+ *              whole solve.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-icub.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OCRA_CONTROLLER_SERVER_TORQUE_LOOP_THREAD_H
+#define OCRA_CONTROLLER_SERVER_TORQUE_LOOP_THREAD_H
+
+#include <mutex>
+
+#include <yarp/os/RateThread.h>
+#include <yarp/os/Property.h>
+#include <yarpWholeBodyInterface/yarpWholeBodyModel.h>
+#include <yarpWholeBodyInterface/yarpWholeBodyInterface.h>
+#include <wbi/wbi.h>
+
+#include <ocra-icub/Utilities.h>
+
+/*! \class TorqueLoopThread
+ *  \brief Sends the torques of the latest QP solution to the robot, corrected for the current joint state.
+ */
+class TorqueLoopThread : public yarp::os::RateThread
+{
+CLASS_POINTER_TYPEDEFS(TorqueLoopThread)
+
+public:
+    /*! Constructor.
+     *  \param period Period of the loop in ms.
+     *  \param name Name of the interface of this loop, the prefix of its ports.
+     *  \param joints Joints of the robot, in the order of the torques.
+     *  \param wbiOptions Options of the WBI, used to open the interface of this loop and to load the model computing
+     *                    the bias forces.
+     *  \param minTorques Minimum torque of each joint.
+     *  \param maxTorques Maximum torque of each joint.
+     *  \param maxTorqueRate Maximum change of the torque of each joint in Nm/s, enforced between two ticks of this
+     *                       loop. 0 for no limit.
+     */
+    TorqueLoopThread(int period, const std::string& name, const wbi::IDList& joints, const yarp::os::Property& wbiOptions,
+                     const Eigen::ArrayXd& minTorques, const Eigen::ArrayXd& maxTorques, double maxTorqueRate = 0.0);
+
+    virtual ~TorqueLoopThread();
+
+    /*! Opens the interface and loads the model, with the joints of the robot. The rate limit starts from the
+     *  measured joint torques.
+     */
+    bool threadInit();
+
+    /*! Closes the interface.
+     */
+    void threadRelease();
+
+    /*! Sends the corrected torques of the latest solution. Sends nothing until the first one.
+     */
+    void run();
+
+    /*! Hands over a new QP solution. Called by the control thread after each solve.
+     *  \param tau Joint torques of the solution.
+     *  \param jointPositions Joint positions the QP was solved at.
+     *  \param jointVelocities Joint velocities the QP was solved at.
+     *  \param xBase Base pose the QP was solved at.
+     *  \param baseVelocity Base velocity the QP was solved at, linear then angular.
+     */
+    void setSolution(const Eigen::VectorXd& tau, const Eigen::VectorXd& jointPositions, const Eigen::VectorXd& jointVelocities,
+                     const wbi::Frame& xBase, const Eigen::VectorXd& baseVelocity);
+
+private:
+    wbi::IDList joints; /*!< Joints of the robot. */
+    yarpWbi::yarpWholeBodyInterface robot; /*!< The WBI used to talk to the robot, only used by this thread. */
+    yarpWbi::yarpWholeBodyModel model; /*!< Model computing the bias forces, only used by this thread. */
+    int nDoF;
+    Eigen::ArrayXd minTorques;
+    Eigen::ArrayXd maxTorques;
+    double maxTorqueStep; /*!< Maximum change of the torques between two ticks of this loop. 0 for no limit. */
+    Eigen::Vector3d gravity;
+
+    std::mutex solutionMutex; /*!< Protects the solution handed over by setSolution(). */
+    bool hasSolution; /*!< False until the first solution. */
+    bool hasNewSolution; /*!< True if a solution was handed over since the last run(). */
+    Eigen::VectorXd newTorques, newQ, newDq, newBaseVelocity;
+    wbi::Frame newBase;
+
+    // Only used by run()
+    Eigen::VectorXd solutionTorques, solutionQ, solutionDq, solutionBaseVelocity;
+    wbi::Frame solutionBase;
+    Eigen::VectorXd solutionBiasForces; /*!< Bias forces at the state of the solution. */
+    Eigen::VectorXd q, dq, biasForces, torques;
+    Eigen::ArrayXd previousTorques; /*!< The torques sent at the previous tick. */
+};
+
+#endif // OCRA_CONTROLLER_SERVER_TORQUE_LOOP_THREAD_H
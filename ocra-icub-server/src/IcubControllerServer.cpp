@@ -1,4 +1,5 @@
 #include <ocra-icub-server/IcubControllerServer.h>
+#include <ocra/control/TaskBuilders/TaskParser.h>
 
 // IcubControllerServer::IcubControllerServer()
 // {
@@ -19,6 +20,7 @@ IcubControllerServer::IcubControllerServer( std::shared_ptr<wbi::wholeBodyInterf
 , isFloatingBase(usingFloatingBase)
 , useOdometry(useOdometry)
 , nDoF(wbi->getDoFs())
+, odometryModelLoaded(false)
 {
     wbi_H_root = wbi::Frame();
 
@@ -111,12 +113,21 @@ void IcubControllerServer::getRobotState(Eigen::VectorXd& q, Eigen::VectorXd& qd
     }
 }
 
-bool IcubControllerServer::initializeOdometry(std::string model_file, std::string initialFixedFrame)
+bool IcubControllerServer::loadOdometryModel(std::string model_file)
 {
     // The URDF file has mode joints than those used by the yarpWholeBodyInterface, and these two should match. Therefore, the following method creates a list of joints as those that constitute ROBOT_MAIN_JOINTS in yarpWholeBodyInterface.ini
     std::vector<std::string> consideredJoints = getCanonical_iCubJoints();
     if (!odometry.loadModelFromFileWithSpecifiedDOFs(model_file, consideredJoints)) {
-        std::cout << "[ERROR] icubcontrollerServer::initializeOdometry  Could not load URDF model of the robot from the specified path: " << model_file << std::endl;
+        std::cout << "[ERROR] icubcontrollerServer::loadOdometryModel  Could not load URDF model of the robot from the specified path: " << model_file << std::endl;
+        return false;
+    }
+    odometryModelLoaded = true;
+    return true;
+}
+
+bool IcubControllerServer::initializeOdometry(std::string model_file, std::string initialFixedFrame)
+{
+    if (!odometryModelLoaded && !loadOdometryModel(model_file)) {
         return false;
     }
 
@@ -153,6 +164,36 @@ bool IcubControllerServer::initializeOdometry(std::string model_file, std::strin
     return true;
 }
 
+bool IcubControllerServer::continueOdometry(std::string model_file, IcubControllerServer& other)
+{
+    if (!odometryModelLoaded && !loadOdometryModel(model_file)) {
+        return false;
+    }
+    if (!other.odometryModelLoaded) {
+        OCRA_ERROR("The odometry to continue has no model.")
+        return false;
+    }
+
+    std::string fixedLink;
+    other.controller->getFixedLinkForOdometry(fixedLink);
+    iDynTree::FrameIndex fixedFrame = other.odometry.model().getFrameIndex(fixedLink);
+    if (fixedFrame == iDynTree::FRAME_INVALID_INDEX) {
+        OCRA_ERROR("Unknown fixed link " << fixedLink << " in the odometry to continue.")
+        return false;
+    }
+    iDynTree::Transform world_H_fixedFrame = other.odometry.getWorldFrameTransform(fixedFrame);
+    this->controller->setFixedLinkForOdometry(fixedLink);
+
+    iDynTree::JointPosDoubleArray qj(wbi->getDoFs());
+    qj.zero();
+    wbi->getEstimates(wbi::ESTIMATE_JOINT_POS, qj.data());
+    if (!odometry.updateKinematics(qj) || !odometry.init(fixedLink, world_H_fixedFrame)) {
+        OCRA_ERROR("Odometry could not be initialized on the fixed link " << fixedLink)
+        return false;
+    }
+    return true;
+}
+
 std::vector<std::string> IcubControllerServer::getCanonical_iCubJoints()
 {
     std::vector<std::string> consideredJoints;
@@ -187,6 +228,103 @@ std::vector<std::string> IcubControllerServer::getCanonical_iCubJoints()
     return consideredJoints;
 }
 
+bool IcubControllerServer::readTaskSet(const std::string& filePath, std::vector<ocra::TaskBuilderOptions>& taskOptions)
+{
+    return readTaskSet(filePath, ocra_icub::hashJointList(wbi->getJointList()), taskOptions);
+}
+
+bool IcubControllerServer::readTaskSet(const std::string& filePath, std::uint64_t jointListHash, std::vector<ocra::TaskBuilderOptions>& taskOptions)
+{
+    taskOptions.clear();
+    if (filePath.empty()) {
+        return true;
+    }
+    if (ocra_icub::isCompiledTaskSet(filePath)) {
+        return ocra_icub::readCompiledTaskSet(filePath, jointListHash, taskOptions);
+    }
+    ocra::TaskParser taskParser;
+    if (!taskParser.parseTasksXML(filePath.c_str(), taskOptions)) {
+        OCRA_ERROR("Could not parse the task set " << filePath);
+        return false;
+    }
+    return true;
+}
+
+bool IcubControllerServer::addTasksFromFile(const std::string& filePath)
+{
+    std::vector<ocra::TaskBuilderOptions> taskOptions;
+    if (!readTaskSet(filePath, taskOptions)) {
+        OCRA_ERROR("None of the tasks of " << filePath << " was added.");
+        return false;
+    }
+    addTasks(taskOptions);
+    return true;
+}
+
+bool IcubControllerServer::findTasks(const std::vector<std::string>& taskNames, std::vector<std::shared_ptr<ocra::Task> >& tasks)
+{
+    tasks.clear();
+    for (auto const& name : taskNames) {
+        std::shared_ptr<ocra::Task> task;
+        try {
+            task = this->controller->getTask(name);
+        } catch (const std::exception& e) {
+            // Unknown task, handled below
+        }
+        if (!task) {
+            OCRA_ERROR("Task " << name << " does not exist.");
+            return false;
+        }
+        tasks.push_back(task);
+    }
+    return true;
+}
+
+bool IcubControllerServer::setTasksActivation(const std::vector<std::string>& taskNames, bool activate)
+{
+    std::vector<std::shared_ptr<ocra::Task> > tasks;
+    if (!findTasks(taskNames, tasks)) {
+        OCRA_ERROR("None of the tasks was " << (activate ? "activated." : "deactivated."));
+        return false;
+    }
+    // All the tasks exist, switch them together
+    bool res = true;
+    for (auto const& task : tasks) {
+        res &= activate ? task->activate() : task->deactivate();
+    }
+    return res;
+}
+
+bool IcubControllerServer::exchangeTaskStates(const std::vector<std::string>& desiredTaskNames,
+                                              const std::vector<ocra::TaskState>& desiredStates,
+                                              const std::vector<std::string>& readTaskNames,
+                                              const std::vector<int>& readFields,
+                                              yarp::os::Bottle& reply)
+{
+    std::vector<std::shared_ptr<ocra::Task> > desiredTasks, readTasks;
+    if (!findTasks(desiredTaskNames, desiredTasks) || !findTasks(readTaskNames, readTasks)) {
+        OCRA_ERROR("None of the desired task states was set.");
+        return false;
+    }
+    for (unsigned int i=0; i<desiredTasks.size(); ++i) {
+        desiredTasks[i]->setDesiredTaskState(desiredStates[i]);
+    }
+    for (unsigned int i=0; i<readTasks.size(); ++i) {
+        yarp::os::Bottle& fields = reply.addList();
+        if (readFields[i] & ocra_icub::CURRENT_TASK_STATE) {
+            readTasks[i]->getTaskState().putIntoBottle(fields.addList());
+        }
+        if (readFields[i] & ocra_icub::DESIRED_TASK_STATE) {
+            readTasks[i]->getDesiredTaskState().putIntoBottle(fields.addList());
+        }
+        if (readFields[i] & ocra_icub::TASK_GAINS) {
+            ocra_icub::pourMatrixIntoBottle(readTasks[i]->getStiffness(), fields.addList());
+            ocra_icub::pourMatrixIntoBottle(readTasks[i]->getDamping(), fields.addList());
+        }
+    }
+    return true;
+}
+
 void IcubControllerServer::rootFrameVelocity(Eigen::VectorXd& q,
                                              Eigen::VectorXd& qd,
                                              iDynTree::Transform& wbi_H_root_Transform,
@@ -25,6 +25,7 @@
 */
 
 #include "ocra-icub-server/Module.h"
+#include <yarp/os/Network.h>
 
 
 
@@ -41,6 +42,7 @@ Module::~Module()
 
 bool Module::configure(yarp::os::ResourceFinder &rf)
 {
+    startupReport = std::make_shared<StartupReport>();
     // Parse the configuration file.
     controller_options.robotName = rf.check("robot") ? rf.find("robot").asString().c_str() : "icub";
     controller_options.threadPeriod = rf.check("threadPeriod") ? rf.find("threadPeriod").asInt() : DEFAULT_THREAD_PERIOD;
@@ -63,6 +65,33 @@ bool Module::configure(yarp::os::ResourceFinder &rf)
         }
     }
     controller_options.maintainFinalPosture = rf.check("maintainFinalPosture");
+    if ( rf.check("torqueLoopPeriod") ) {
+        controller_options.torqueLoopPeriod = std::max(0, rf.find("torqueLoopPeriod").asInt());
+        if ( controller_options.torqueLoopPeriod >= controller_options.threadPeriod ) {
+            OCRA_WARNING("The torque loop period must be shorter than the thread period. Sending the torques from the control thread.")
+            controller_options.torqueLoopPeriod = 0;
+        }
+    }
+    if ( rf.check("maxTorque") ) {
+        controller_options.maxTorque = std::abs(rf.find("maxTorque").asDouble());
+    }
+    if ( rf.check("maxTorqueRate") ) {
+        controller_options.maxTorqueRate = std::max(0.0, rf.find("maxTorqueRate").asDouble());
+    }
+    if ( rf.check("taskSetBlendTime") ) {
+        controller_options.taskSetBlendTime = std::max(0.0, rf.find("taskSetBlendTime").asDouble());
+    }
+    controller_options.simulation = rf.check("sim");
+    if ( controller_options.simulation ) {
+        // The simulation is stepped once per control tick, so there is no faster loop to run.
+        controller_options.torqueLoopPeriod = 0;
+        controller_options.simulationDuration = rf.check("simDuration") ? rf.find("simDuration").asDouble() : controller_options.simulationDuration;
+        // The task ports are only opened if clients can reach them.
+        controller_options.useInterprocessCommunication = yarp::os::Network::checkNetwork(1.0);
+        if ( !controller_options.useInterprocessCommunication ) {
+            OCRA_WARNING("No YARP network. Simulating without the task ports.")
+        }
+    }
 
     if ( rf.check("wDdq") ) {
         controller_options.wDdq = rf.find("wDdq").asDouble();
@@ -86,6 +115,7 @@ bool Module::configure(yarp::os::ResourceFinder &rf)
             controller_options.solver = ocra_recipes::QPOASES;
         }
         else{
+            OCRA_WARNING("Unknown solver " << rf.find("solver").asString() << ". Using QUADPROG.")
             controller_options.solver = ocra_recipes::QUADPROG;
         }
     }
@@ -116,7 +146,7 @@ bool Module::configure(yarp::os::ResourceFinder &rf)
             fileName += xmlExt;
         }else{
             std::string extension = fileName.substr(fileExtensionStart);
-            if (extension != xmlExt) {
+            if (extension != xmlExt && extension != ocra_icub::COMPILED_TASK_SET_EXTENSION) {
                 fileName = fileName.substr(0, fileExtensionStart) + xmlExt;
             }
         }
@@ -137,6 +167,38 @@ bool Module::configure(yarp::os::ResourceFinder &rf)
         }
     }
 
+    // Each line of the [TASK_GROUPS] group is a group name followed by the names of its tasks.
+    yarp::os::Bottle& taskGroupsConfig = rf.findGroup("TASK_GROUPS");
+    for (int i=1; i<taskGroupsConfig.size(); ++i) {
+        yarp::os::Bottle* groupConfig = taskGroupsConfig.get(i).asList();
+        if (groupConfig == NULL || groupConfig->size() < 2) {
+            OCRA_WARNING("Ignoring an invalid line of [TASK_GROUPS]. Lines are: groupName taskName1 taskName2 ...")
+            continue;
+        }
+        std::vector<std::string>& taskNames = controller_options.taskGroups[groupConfig->get(0).asString()];
+        taskNames.clear();
+        for (int j=1; j<groupConfig->size(); ++j) {
+            taskNames.push_back(groupConfig->get(j).asString());
+        }
+    }
+
+    // Each line of the [TORQUE_LIMITS] group is a joint name followed by its torque limit, or by its minimum and maximum torques.
+    yarp::os::Bottle& torqueLimitsConfig = rf.findGroup("TORQUE_LIMITS");
+    for (int i=1; i<torqueLimitsConfig.size(); ++i) {
+        yarp::os::Bottle* limitsConfig = torqueLimitsConfig.get(i).asList();
+        if (limitsConfig == NULL || limitsConfig->size() < 2 || limitsConfig->size() > 3) {
+            OCRA_WARNING("Ignoring an invalid line of [TORQUE_LIMITS]. Lines are: jointName maxTorque, or jointName minTorque maxTorque")
+            continue;
+        }
+        double minTorque = limitsConfig->size() == 2 ? -std::abs(limitsConfig->get(1).asDouble()) : limitsConfig->get(1).asDouble();
+        double maxTorque = limitsConfig->size() == 2 ? std::abs(limitsConfig->get(1).asDouble()) : limitsConfig->get(2).asDouble();
+        if (minTorque > maxTorque) {
+            OCRA_WARNING("Ignoring the torque limits of " << limitsConfig->get(0).asString() << ": the minimum is above the maximum.")
+            continue;
+        }
+        controller_options.jointTorqueLimits[limitsConfig->get(0).asString()] = std::make_pair(minTorque, maxTorque);
+    }
+
     if( rf.check("sequence") )
     {
         controller_options.startupSequence = rf.find("sequence").asString().c_str();
@@ -158,8 +220,16 @@ bool Module::configure(yarp::os::ResourceFinder &rf)
     // Overwrite the robot parameter that could be present in wbi_conf_file
     controller_options.yarpWbiOptions.put("robot", controller_options.robotName);
 
+    startupReport->addStage("configuration", "module", 0.0, startupReport->now());
+
     // Create the wholeBodyInterface.
-    robotInterface = std::make_shared<yarpWbi::yarpWholeBodyInterface>(controller_options.serverName.c_str(), controller_options.yarpWbiOptions);
+    double stageStart = startupReport->now();
+    if ( controller_options.simulation ) {
+        simulatedInterface = std::make_shared<ocra_icub::SimulatedWholeBodyInterface>(controller_options.serverName.c_str(), controller_options.yarpWbiOptions, controller_options.threadPeriod/1000.0);
+        robotInterface = simulatedInterface;
+    } else {
+        robotInterface = std::make_shared<yarpWbi::yarpWholeBodyInterface>(controller_options.serverName.c_str(), controller_options.yarpWbiOptions);
+    }
 
     // Add the robot's specific joints to the WBI.
     wbi::IDList robotJoints;
@@ -170,6 +240,8 @@ bool Module::configure(yarp::os::ResourceFinder &rf)
     }
     robotInterface->addJoints(robotJoints);
 
+    // Construct the control thread. It starts reading the task set and the URDF model of the odometry, while the devices are opened below.
+    ctrlThread = std::make_shared<Thread>(controller_options, robotInterface, startupReport);
 
     // Make sure all the add* functions are done before the "init"
     if(!robotInterface->init())
@@ -177,16 +249,22 @@ bool Module::configure(yarp::os::ResourceFinder &rf)
         yLog.error() << "Error while initializing whole body interface. Closing module.";
         return false;
     }
+    startupReport->addStage("WBI initialization", "module", stageStart, startupReport->now());
 
-    // Construct the control thread.
-    ctrlThread = std::make_shared<Thread>(controller_options, robotInterface);
+    // The simulation is clocked by runSimulation() instead of the thread.
+    if ( controller_options.simulation ) {
+        return true;
+    }
 
     // Start the control thread loop.
+    stageStart = startupReport->now();
     if(!ctrlThread->start())
     {
         yLog.error() << "Error while initializing controller server thread. Closing module.";
         return false;
     }
+    startupReport->addStage("controller thread initialization", "module", stageStart, startupReport->now());
+    startupReport->print();
 
     yLog.info() << "Controller server thread started.";
 
@@ -195,6 +273,38 @@ bool Module::configure(yarp::os::ResourceFinder &rf)
 }
 
 
+bool Module::runSimulation()
+{
+    double stageStart = startupReport->now();
+    if ( !ctrlThread->threadInit() ) {
+        yLog.error() << "Error while initializing controller server thread. Closing module.";
+        return false;
+    }
+    startupReport->addStage("controller thread initialization", "module", stageStart, startupReport->now());
+    startupReport->print();
+
+    std::vector<double> tickTimes;
+    tickTimes.reserve(controller_options.simulationDuration*1000.0/controller_options.threadPeriod + 1);
+    double startTime = yarp::os::Time::now();
+    bool ok = true;
+    while ( ok && simulatedInterface->getTime() < controller_options.simulationDuration ) {
+        double tickStart = yarp::os::Time::now();
+        ctrlThread->run();
+        tickTimes.push_back(yarp::os::Time::now() - tickStart);
+        ok = simulatedInterface->step();
+    }
+    double wallTime = yarp::os::Time::now() - startTime;
+    ctrlThread->threadRelease();
+
+    /* Print performance information */
+    std::sort(tickTimes.begin(), tickTimes.end());
+    auto percentile = [&tickTimes](double p) { return tickTimes.empty() ? 0.0 : 1000.0*tickTimes[std::min(tickTimes.size() - 1, (size_t)(p*tickTimes.size()))]; };
+    printf("[SIMULATION PERFORMANCE INFORMATION]:\n");
+    printf("Simulated %3.2f s in %3.2f s (%3.1fx real time), %zu control ticks of %d ms.\n", simulatedInterface->getTime(), wallTime, simulatedInterface->getTime()/wallTime, tickTimes.size(), controller_options.threadPeriod);
+    printf("Duration of 'run' method [ms]: p50 %3.3f, p90 %3.3f, p99 %3.3f, max %3.3f.\n", percentile(0.5), percentile(0.9), percentile(0.99), percentile(1.0));
+    return ok;
+}
+
 bool Module::interruptModule()
 {
     if(ctrlThread)
@@ -215,6 +325,11 @@ bool Module::close()
             yLog.error() << "Error while closing robot interface";
     }
 
+    if ( controller_options.simulation ) {
+        // runSimulation() printed its own performance information.
+        return true;
+    }
+
     /* Print performance information */
     printf("[PERFORMANCE INFORMATION]:\n");
     printf("Expected period %d ms.\nReal period: %3.1f+/-%3.1f ms.\n", controller_options.threadPeriod, avgTime, stdDev);
@@ -259,7 +374,7 @@ void Module::printHelp()
     std::cout<< "\t--robot :Robot name (icubSim or icub). Set to icub by default." <<std::endl;
     std::cout<< "\t--local :Prefix of the ports opened by the module. Set to the module name by default, i.e. basicWholeBodyInterfaceModule." <<std::endl;
     std::cout<< "\t--solver:Name of the solver used by the controller. Options are: QUADPROG, QPOASES." << std::endl;
-    std::cout<< "\t--taskSet :A path to an XML file containing a set of tasks. The tasks will be created when the controller is started. Set to empty by default." <<std::endl;
+    std::cout<< "\t--taskSet :A path to an XML file containing a set of tasks, or to a .tsb file compiled from it by ocra-task-set-compiler. The tasks will be created when the controller is started. Set to empty by default." <<std::endl;
     std::cout<< "\t--sequence :A string identifying a predefined scenario. The scenarios (sets of tasks and control logic) are defined in sequenceCollection and will be created when the controller is started. Set to empty by default." <<std::endl;
     std::cout<< "\t--debug :If this flag is present then the controller will run in Debug mode which allows each joint to be tested individually." <<std::endl;
     std::cout<< "\t--floatingBase :If this flag is present then the controller will run in using a floating base dynamic model and control. Defaults to false, or fixed base if no flag is present." <<std::endl;
@@ -267,4 +382,12 @@ void Module::printHelp()
     std::cout << "\t--useOdometry :This will enable odometry leavint the world reference frame attached a non-moving point." << std::endl;
     std::cout << "\t--idleAnkles :Tells the controller to idle the ankles for a short period and then pass on to normal operation. This is to get the feet flush with the ground." << std::endl;
     std::cout << "\t--maintainFinalPosture :Tells the controller to stay in its final posture when the controller is switched to position mode at the end of usage." << std::endl;
+    std::cout << "\t--sim :Runs the controller headless on a simulation of the URDF model of the robot instead of the robot, as fast as possible, and prints the control tick durations. The base is held fixed. YARP is only used if a name server is available." << std::endl;
+    std::cout << "\t--simDuration :Simulated time in seconds after which --sim stops. Set to 10s by default." << std::endl;
+    std::cout << "\t--torqueLoopPeriod :Period in ms of a second loop sending the torques of the latest QP solution, corrected with the bias forces of the current joint state, while the QP is solved every --threadPeriod. Must be shorter than the thread period. Not used with --sim, --debug or --noOutput. Disabled by default." << std::endl;
+    std::cout << "\t--taskSetBlendTime :Time in seconds over which the torques of the current task set are blended into those of a task set loaded at runtime with LOAD_TASK_SET [path] [blendTime]. Both task sets are solved during the blend, so keep it short if the thread period is tight. Set to 0.5s by default." << std::endl;
+    std::cout << "\t--maxTorque :Torque limit in Nm, in both directions, of the joints which have none in [TORQUE_LIMITS]. Set to 24Nm by default." << std::endl;
+    std::cout << "\t--maxTorqueRate :Maximum change of the torque of each joint in Nm/s, enforced against the torques of the previous control tick, and of the previous tick of the torque loop if any. Disabled by default." << std::endl;
+    std::cout << "\t[TORQUE_LIMITS] :Group of the .ini file defining the torque limits of some joints, one per line: jointName maxTorque, or jointName minTorque maxTorque." << std::endl;
+    std::cout << "\t[TASK_GROUPS] :Group of the .ini file defining task groups, one per line: groupName taskName1 taskName2 ... Each group is activated or deactivated on a single control tick with ACTIVATE_TASK_GROUP and DEACTIVATE_TASK_GROUP. LeftFootContact and RightFootContact are defined by default." << std::endl;
 }
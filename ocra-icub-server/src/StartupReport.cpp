@@ -0,0 +1,78 @@
+/*! \file       StartupReport.cpp
+ *  \brief      Timings of the startup stages of the controller server.
+ *  \details    See StartupReport.h.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-icub.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ocra-icub-server/StartupReport.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+StartupReport::StartupReport()
+: origin(std::chrono::steady_clock::now())
+{
+}
+
+double StartupReport::now() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void StartupReport::addStage(const std::string& name, const std::string& thread, double start, double end)
+{
+    std::lock_guard<std::mutex> lock(stagesMutex);
+    Stage stage;
+    stage.name = name;
+    stage.thread = thread;
+    stage.start = start;
+    stage.end = end;
+    stages.push_back(stage);
+}
+
+void StartupReport::print() const
+{
+    std::vector<Stage> sortedStages;
+    {
+        std::lock_guard<std::mutex> lock(stagesMutex);
+        sortedStages = stages;
+    }
+    std::stable_sort(sortedStages.begin(), sortedStages.end(), [](const Stage& a, const Stage& b) { return a.start < b.start; });
+
+    double lastEnd = 0.0;
+    std::cout << "-----------------------------------------------------------------" << std::endl;
+    std::cout << "Startup report (ms)" << std::endl;
+    std::cout << "-----------------------------------------------------------------" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (auto const& stage : sortedStages) {
+        std::cout << "[" << std::setw(7) << stage.thread << "] "
+                  << std::setw(8) << 1000.0*stage.start << " -> " << std::setw(8) << 1000.0*stage.end
+                  << " (" << std::setw(8) << 1000.0*(stage.end - stage.start) << ") " << stage.name << std::endl;
+        lastEnd = std::max(lastEnd, stage.end);
+    }
+    std::cout << "-----------------------------------------------------------------" << std::endl;
+    std::cout << "Time to torque mode: " << 1000.0*lastEnd << " ms" << std::endl;
+    std::cout << "-----------------------------------------------------------------" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
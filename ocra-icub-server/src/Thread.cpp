@@ -43,6 +43,14 @@ OcraControllerOptions::OcraControllerOptions()
 , useOdometry(false)
 , idleAnkles(false)
 , idleAnkleTime(1.5)
+, maintainFinalPosture(false)
+, simulation(false)
+, simulationDuration(10.0)
+, useInterprocessCommunication(true)
+, torqueLoopPeriod(0)
+, taskSetBlendTime(0.5)
+, maxTorque(24.0)
+, maxTorqueRate(0.0)
 , wDdq(1e-7)
 , wTau(1e-8)
 , wFc(1e-9)
@@ -50,6 +58,11 @@ OcraControllerOptions::OcraControllerOptions()
 , controllerType(ocra_recipes::WOCRA_CONTROLLER)
 , solver(ocra_recipes::QUADPROG)
 {
+    const std::string corners[] = {"BackLeft", "FrontLeft", "BackRight", "FrontRight"};
+    for (auto const& corner : corners) {
+        taskGroups["LeftFootContact"].push_back("LeftFootContact_" + corner);
+        taskGroups["RightFootContact"].push_back("RightFootContact_" + corner);
+    }
 }
 
 OcraControllerOptions::~OcraControllerOptions()
@@ -72,12 +85,31 @@ std::ostream& operator<<(std::ostream &out, const OcraControllerOptions& opts)
     out << "useOdometry: " << opts.useOdometry << "\n\n";
     out << "idleAnkles: " << opts.idleAnkles << "\n\n";
     out << "idleAnkleTime: " << opts.idleAnkleTime << "\n\n";
+    out << "simulation: " << opts.simulation << "\n\n";
+    out << "simulationDuration: " << opts.simulationDuration << "\n\n";
+    out << "useInterprocessCommunication: " << opts.useInterprocessCommunication << "\n\n";
+    out << "torqueLoopPeriod: " << opts.torqueLoopPeriod << "\n\n";
+    out << "taskSetBlendTime: " << opts.taskSetBlendTime << "\n\n";
+    out << "maxTorque: " << opts.maxTorque << "\n\n";
+    out << "maxTorqueRate: " << opts.maxTorqueRate << "\n\n";
+    out << "jointTorqueLimits:\n";
+    for (auto const& limits : opts.jointTorqueLimits) {
+        out << "  " << limits.first << ": " << limits.second.first << " " << limits.second.second << "\n";
+    }
     out << "wDdq: " << opts.wDdq << "\n\n";
     out << "wTau: " << opts.wTau << "\n\n";
     out << "wFc: " << opts.wFc << "\n\n";
     // out << "yarpWbiOptions: " << opts.yarpWbiOptions << "\n\n";
     out << "controllerType: " << opts.controllerType << "\n\n";
     out << "solver: " << opts.solver << "\n\n";
+    out << "taskGroups:\n";
+    for (auto const& group : opts.taskGroups) {
+        out << "  " << group.first << ":";
+        for (auto const& taskName : group.second) {
+            out << " " << taskName;
+        }
+        out << "\n";
+    }
 
     return out;
 }
@@ -87,15 +119,19 @@ std::ostream& operator<<(std::ostream &out, const OcraControllerOptions& opts)
 //                                               Thread Constructor
 //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
-Thread::Thread(OcraControllerOptions& controller_options, std::shared_ptr<wbi::wholeBodyInterface> wbi)
+Thread::Thread(OcraControllerOptions& controller_options, std::shared_ptr<wbi::wholeBodyInterface> wbi, StartupReport::shared_ptr report)
 : RateThread(controller_options.threadPeriod)
+, maxTorqueStep(0.0)
 , ctrlOptions(controller_options)
 , controllerStatus(ocra_icub::CONTROLLER_SERVER_STOPPED)
+, blendTicks(0)
+, blendTick(0)
+, startupReport(report ? report : std::make_shared<StartupReport>())
 {
     std::cout << ctrlOptions << std::endl;
 
     yarpWbi = wbi;
-    bool usingInterprocessCommunication = true;
+    bool usingInterprocessCommunication = ctrlOptions.useInterprocessCommunication;
     ctrlServer = std::make_shared<IcubControllerServer>( yarpWbi,
                                                          ctrlOptions.robotName,
                                                          ctrlOptions.isFloatingBase,
@@ -105,8 +141,22 @@ Thread::Thread(OcraControllerOptions& controller_options, std::shared_ptr<wbi::w
                                                          ctrlOptions.useOdometry
                                                        );
 
-
-
+    // These stages only need files, so they run while the devices are opened. The WBI is not thread safe, so the joint list a compiled task set is checked against is read here, before its initialization.
+    std::uint64_t jointListHash = ocra_icub::hashJointList(yarpWbi->getJointList());
+    startupTaskSetFuture = std::async(std::launch::async, [this, jointListHash]() {
+        double start = startupReport->now();
+        bool ok = IcubControllerServer::readTaskSet(ctrlOptions.startupTaskSetPath, jointListHash, startupTaskOptions);
+        startupReport->addStage("task set reading", "startup", start, startupReport->now());
+        return ok;
+    });
+    if (ctrlOptions.useOdometry && ctrlOptions.isFloatingBase) {
+        odometryModelFuture = std::async(std::launch::async, [this]() {
+            double start = startupReport->now();
+            bool ok = ctrlServer->loadOdometryModel(ctrlOptions.urdfModelPath);
+            startupReport->addStage("odometry URDF loading", "startup", start, startupReport->now());
+            return ok;
+        });
+    }
 }
 
 Thread::~Thread()
@@ -128,7 +178,9 @@ bool Thread::threadInit()
 {
     /* ======== This block was originally in the constructor of this thread ======= */
     // The server will initialize but without calling updateModel() at the end, if useOdometry is true.
+    double stageStart = startupReport->now();
     ctrlServer->initialize();
+    startupReport->addStage("controller initialization", "control", stageStart, startupReport->now());
 
     // ctrlServer->setRegularizationTermWeights(ctrlOptions.wDdq, ctrlOptions.wTau, ctrlOptions.wFc);
 
@@ -143,10 +195,14 @@ bool Thread::threadInit()
         yarp::os::Bottle wbiStateOptionsGroup = ctrlOptions.yarpWbiOptions.findGroup("WBI_STATE_OPTIONS");
         std::string initialFixedFrame = wbiStateOptionsGroup.find("localWorldReferenceFrame").asString();
         std::cout << "\033[1;31m[DEBUG-ODOMETRY Thread::threadInit]\033[0m ocra-icub-server calls initiliazeOdometry" << std::endl;
+        stageStart = startupReport->now();
+        // The URDF model is loaded by the constructor, initializeOdometry() loads it again if that failed.
+        odometryModelFuture.wait();
         if (!ctrlServer->initializeOdometry(ctrlOptions.urdfModelPath, initialFixedFrame)) {
             std::cout << "\033[1;31m[ERROR-ODOMETRY Thread::threadInit]\033[0m Odometry could not be initialized" << std::endl;
             return false;
         }
+        startupReport->addStage("odometry initialization", "control", stageStart, startupReport->now());
     } else {
         if (ctrlOptions.useOdometry && !ctrlOptions.isFloatingBase)
             std::cout << "\033[1;31m[WARNING-ODOMETRY Thread::threadInit]\033[0m You're trying to activate ODOMETRY but isFloatingBase is false. Launch ocra-icub-server again with --floatingBase" << std::endl;
@@ -165,19 +221,26 @@ bool Thread::threadInit()
     /* ============================================================================= */
 
     // TODO: Add a check to make sure the tasks get loaded in and if not - don't change the control mode. return false;
-    minTorques      = Eigen::ArrayXd::Constant(yarpWbi->getDoFs(), TORQUE_MIN);
-    maxTorques      = Eigen::ArrayXd::Constant(yarpWbi->getDoFs(), TORQUE_MAX);
+    loadTorqueLimits();
     initialPosture  = Eigen::VectorXd::Zero(yarpWbi->getDoFs());
     // torques         = Eigen::VectorXd::Zero(yarpWbi->getDoFs());
     yarpWbi->getEstimates(wbi::ESTIMATE_JOINT_POS, initialPosture.data(), ALL_JOINTS);
 
     // If the ankles need to go into idle, we do this before we create the tasks. The reason for this is because many of the tasks simply try to maintain their initial states and if we create them in one state then change that state (by say putting the ankles into idle) then the tasks will try to track the old states when the `run()` method is executed.
     if (ctrlOptions.idleAnkles) {
+        stageStart = startupReport->now();
         putAnklesIntoIdle(ctrlOptions.idleAnkleTime);
+        startupReport->addStage("ankle idling", "control", stageStart, startupReport->now());
     }
 
     // Now we can add our tasks! Yay! Yupeee!
-    ctrlServer->addTasksFromXmlFile(ctrlOptions.startupTaskSetPath);
+    stageStart = startupReport->now();
+    if (!startupTaskSetFuture.get()) {
+        OCRA_ERROR("Could not load the task set " << ctrlOptions.startupTaskSetPath << ". Not switching to torque control.")
+        return false;
+    }
+    ctrlServer->addTasks(startupTaskOptions);
+    startupReport->addStage("task creation", "control", stageStart, startupReport->now());
 
     l_foot_disp_inverse = model->getSegmentPosition("l_foot").inverse();
 
@@ -186,6 +249,7 @@ bool Thread::threadInit()
         debugJointIndex = 0;
         debuggingAllJoints = false;
         userHasSetDebugIndex = false;
+        setDebugJoints(std::vector<int>());
         std::string debugRpcPortName("/ocra-icub-server/debug/rpc:i");
         std::string debugRefOutPortName("/ocra-icub-server/debug/ref:o");
         std::string debugRealOutPortName("/ocra-icub-server/debug/real:o");
@@ -227,7 +291,21 @@ bool Thread::threadInit()
         // yarp::os::Time timer;
         // timer.delay(5.0);
         // std::cout << "First timer over" << std::endl;
-        return yarpWbi->setControlMode(wbi::CTRL_MODE_TORQUE, 0, ALL_JOINTS);
+        if (!yarpWbi->setControlMode(wbi::CTRL_MODE_TORQUE, 0, ALL_JOINTS)) {
+            return false;
+        }
+        seedPreviousTorques();
+        if (ctrlOptions.torqueLoopPeriod > 0) {
+            // The torque loop talks to the robot through an interface of its own, see TorqueLoopThread.
+            torqueLoop = std::make_shared<TorqueLoopThread>(ctrlOptions.torqueLoopPeriod, ctrlOptions.serverName + "/torqueLoop", yarpWbi->getJointList(), ctrlOptions.yarpWbiOptions, minTorques, maxTorques, ctrlOptions.maxTorqueRate);
+            if (!torqueLoop->start()) {
+                OCRA_ERROR("Could not start the torque loop.")
+                torqueLoop.reset();
+                return false;
+            }
+            OCRA_INFO("Solving the QP every " << ctrlOptions.threadPeriod << "ms and sending the torques every " << ctrlOptions.torqueLoopPeriod << "ms.")
+        }
+        return true;
 
         // jorh: This is mostly for when I'm debugging. Read current torques and set references, otherwise the robot will just fall under the action of zero torques being set when the control mode is set.
         // jorh: read current torques
@@ -255,23 +333,51 @@ void Thread::run()
     // yarpWbi->getEstimates(wbi::ESTIMATE_JOINT_POS, externalWrench.data());
     // std::cout << "externalWrench:\n" << externalWrench.transpose() << std::endl;
 
-    ctrlServer->computeTorques(torques);
-    torques = ((torques.array().max(minTorques)).min(maxTorques)).matrix().eval();
+    {
+        // Task groups and task sets are only switched between two ticks, see setTaskGroupActivation() and loadTaskSet().
+        std::lock_guard<std::mutex> lock(controllerMutex);
+        ctrlServer->computeTorques(torques);
+        if (outgoingCtrlServer) {
+            // Blend out the previous task set, still closing the loop on the robot state. The ticks of the blend solve both task sets, see OcraControllerOptions::taskSetBlendTime.
+            outgoingCtrlServer->computeTorques(outgoingTorques);
+            double alpha = double(++blendTick) / blendTicks;
+            torques = alpha * torques + (1.0 - alpha) * outgoingTorques;
+            if (blendTick >= blendTicks) {
+                retiredCtrlServer = outgoingCtrlServer;
+                outgoingCtrlServer.reset();
+            }
+        }
+        // The torques sent are final once the lock is released, see loadTaskSet().
+        if (maxTorqueStep > 0.0 && previousTorques.size() == torques.size()) {
+            // Rate limit first, so that the saturation holds even when the previous torques were beyond a limit.
+            torques = ((torques.array().max(previousTorques - maxTorqueStep)).min(previousTorques + maxTorqueStep)).matrix().eval();
+        }
+        torques = ((torques.array().max(minTorques)).min(maxTorques)).matrix().eval();
+        previousTorques = torques.array();
+        if (ctrlOptions.runInDebugMode || ctrlOptions.noOutputMode) {
+            measuredTorques = model->getJointTorques();
+        }
+        if (torqueLoop) {
+            solutionQ = model->getJointPositions();
+            solutionDq = model->getJointVelocities();
+            ctrlServer->getBaseState(solutionBase, solutionBaseVelocity);
+        }
+    }
     if (ctrlOptions.runInDebugMode || ctrlOptions.noOutputMode) {
-        measuredTorques = model->getJointTorques();
         writeDebugData();
         if (!ctrlOptions.noOutputMode || userHasSetDebugIndex) {
-            if (debuggingAllJoints) {
-                yarpWbi->setControlReference(torques.data());
-            } else {
-                sendTorqueReferenceToDebugJoint(debugJointIndex);
-            }
+            sendDebugTorqueReferences();
         }
+    } else if (torqueLoop) {
+        // The torque loop sends the torques, corrected for the joint state of each of its ticks.
+        torqueLoop->setSolution(torques, solutionQ, solutionDq, solutionBase, solutionBaseVelocity);
     } else {
         bool ok = yarpWbi->setControlReference(torques.data());
         if(!ok) {
             OCRA_WARNING("Couldn't set the control reference. Trying to put the robot back into torque control.")
-            yarpWbi->setControlMode(wbi::CTRL_MODE_TORQUE, 0, ALL_JOINTS);
+            if (yarpWbi->setControlMode(wbi::CTRL_MODE_TORQUE, 0, ALL_JOINTS)) {
+                seedPreviousTorques();
+            }
         }
     }
 }
@@ -279,6 +385,10 @@ void Thread::run()
 void Thread::threadRelease()
 {
     controllerStatus = ocra_icub::CONTROLLER_SERVER_STOPPED;
+    if (torqueLoop) {
+        // No torque must be sent once the joints are back in position mode.
+        torqueLoop->stop();
+    }
     if (ctrlOptions.maintainFinalPosture) {
         OCRA_INFO("Staying in my current posture.")
         Eigen::VectorXd finalPosture = Eigen::VectorXd::Zero(yarpWbi->getDoFs());
@@ -295,28 +405,99 @@ void Thread::threadRelease()
 
 bool Thread::setDebugJointToTorqueMode(int idx)
 {
-    bool isTorqueModeSet = true;
+    // The torso joints are coupled, so they are debugged together.
+    std::vector<int> joints;
     if ( (idx==0) || (idx==1) || (idx==2) ) {
-        isTorqueModeSet &= yarpWbi->setControlMode(wbi::CTRL_MODE_TORQUE, 0, 0);
-        isTorqueModeSet &= yarpWbi->setControlMode(wbi::CTRL_MODE_TORQUE, 0, 1);
-        isTorqueModeSet &= yarpWbi->setControlMode(wbi::CTRL_MODE_TORQUE, 0, 2);
+        joints = {0, 1, 2};
     } else {
-        isTorqueModeSet &= yarpWbi->setControlMode(wbi::CTRL_MODE_TORQUE, 0, idx);
+        joints = {idx};
     }
-
+    bool isTorqueModeSet = setJointsControlMode(joints, wbi::CTRL_MODE_TORQUE, 0);
+    seedPreviousTorques();
+    setDebugJoints(joints);
     return isTorqueModeSet;
 }
 
+void Thread::setDebugJoints(const std::vector<int>& joints)
+{
+    std::lock_guard<std::mutex> lock(debugJointsMutex);
+    debugJoints = joints;
+}
 
-void Thread::sendTorqueReferenceToDebugJoint(int idx)
+bool Thread::setJointsControlMode(const std::vector<int>& joints, wbi::ControlMode mode, double* ref)
 {
-    if ( (idx==0) || (idx==1) || (idx==2) ) {
-        yarpWbi->setControlReference(&torques(0), 0);
-        yarpWbi->setControlReference(&torques(1), 1);
-        yarpWbi->setControlReference(&torques(2), 2);
+    if ((int)joints.size() == yarpWbi->getDoFs()) {
+        bool ok = yarpWbi->setControlMode(mode, ref, ALL_JOINTS);
+        if (ref) {
+            ok &= yarpWbi->setControlReference(ref, ALL_JOINTS);
+        }
+        return ok;
+    }
+    // The WBI switches either one joint or all of them.
+    bool ok = true;
+    for (int j : joints) {
+        ok &= yarpWbi->setControlMode(mode, ref ? ref + j : 0, j);
+        if (ref) {
+            ok &= yarpWbi->setControlReference(ref + j, j);
+        }
+    }
+    return ok;
+}
+
+
+void Thread::loadTorqueLimits()
+{
+    int nDoF = yarpWbi->getDoFs();
+    minTorques = Eigen::ArrayXd::Constant(nDoF, -ctrlOptions.maxTorque);
+    maxTorques = Eigen::ArrayXd::Constant(nDoF, ctrlOptions.maxTorque);
+    std::map<std::string, std::pair<double, double> > unusedLimits = ctrlOptions.jointTorqueLimits;
+    for (int i=0; i<nDoF; ++i) {
+        wbi::ID jointId;
+        yarpWbi->getJointList().indexToID(i, jointId);
+        auto limits = unusedLimits.find(jointId.toString());
+        if (limits != unusedLimits.end()) {
+            minTorques(i) = limits->second.first;
+            maxTorques(i) = limits->second.second;
+            unusedLimits.erase(limits);
+        }
+    }
+    for (auto const& limits : unusedLimits) {
+        OCRA_WARNING("Ignoring the torque limits of " << limits.first << ", which is not a joint of the robot.")
+    }
+
+    maxTorqueStep = ctrlOptions.maxTorqueRate * ctrlOptions.threadPeriod / 1000.0;
+}
+
+void Thread::seedPreviousTorques()
+{
+    std::lock_guard<std::mutex> lock(controllerMutex);
+    previousTorques = Eigen::ArrayXd::Zero(yarpWbi->getDoFs());
+    if (!yarpWbi->getEstimates(wbi::ESTIMATE_JOINT_TORQUE, previousTorques.data(), ALL_JOINTS)) {
+        OCRA_WARNING("Could not read the joint torques. The torque rate limit starts from zero torques.")
+        previousTorques.setZero();
+    }
+}
+
+void Thread::sendDebugTorqueReferences()
+{
+    std::lock_guard<std::mutex> lock(debugJointsMutex);
+    if ((int)debugJoints.size() == yarpWbi->getDoFs()) {
+        yarpWbi->setControlReference(torques.data(), ALL_JOINTS);
     } else {
-        yarpWbi->setControlReference(&torques(idx), idx);
+        // The WBI has no multi-joint write, and writing all of the joints would reach every device, so only the debugged ones are written, one at a time.
+        for (int j : debugJoints) {
+            yarpWbi->setControlReference(&torques(j), j);
+        }
+    }
+}
+
+std::vector<int> Thread::allJoints()
+{
+    std::vector<int> joints(yarpWbi->getDoFs());
+    for (int j=0; j<(int)joints.size(); ++j) {
+        joints[j] = j;
     }
+    return joints;
 }
 
 void Thread::writeDebugData()
@@ -356,6 +537,16 @@ ocra_icub::OCRA_ICUB_MESSAGE Thread::convertStringToOcraIcubMessage(const std::s
         return ocra_icub::OCRA_ICUB_MESSAGE::GET_CONTROLLER_SERVER_STATUS;
     } else if (_s=="GET_L_FOOT_POSE") {
         return ocra_icub::OCRA_ICUB_MESSAGE::GET_L_FOOT_POSE;
+    } else if (_s=="ACTIVATE_TASK_GROUP") {
+        return ocra_icub::OCRA_ICUB_MESSAGE::ACTIVATE_TASK_GROUP;
+    } else if (_s=="DEACTIVATE_TASK_GROUP") {
+        return ocra_icub::OCRA_ICUB_MESSAGE::DEACTIVATE_TASK_GROUP;
+    } else if (_s=="GET_TASK_GROUP") {
+        return ocra_icub::OCRA_ICUB_MESSAGE::GET_TASK_GROUP;
+    } else if (_s=="BATCH_TASK_STATES") {
+        return ocra_icub::OCRA_ICUB_MESSAGE::BATCH_TASK_STATES;
+    } else if (_s=="LOAD_TASK_SET") {
+        return ocra_icub::OCRA_ICUB_MESSAGE::LOAD_TASK_SET;
     } else {
         return ocra_icub::OCRA_ICUB_MESSAGE::FAILURE;
     }
@@ -397,6 +588,56 @@ void Thread::parseIncomingMessage(yarp::os::Bottle& input, yarp::os::Bottle& rep
                     ocra::util::pourDisplacementdIntoBottle(l_foot_disp_inverse, reply);
                 }break;
 
+            case ocra_icub::ACTIVATE_TASK_GROUP:
+            case ocra_icub::DEACTIVATE_TASK_GROUP:
+                {
+                    bool activate = (tag == ocra_icub::ACTIVATE_TASK_GROUP);
+                    std::string groupName = input.get(++i).asString();
+                    std::cout << "Got message: " << (activate ? "ACTIVATE_TASK_GROUP " : "DEACTIVATE_TASK_GROUP ") << groupName << "." << std::endl;
+                    reply.addInt(setTaskGroupActivation(groupName, activate) ? ocra_icub::SUCCESS : ocra_icub::FAILURE);
+                }break;
+
+            case ocra_icub::GET_TASK_GROUP:
+                {
+                    std::string groupName = input.get(++i).asString();
+                    std::cout << "Got message: GET_TASK_GROUP " << groupName << "." << std::endl;
+                    auto group = ctrlOptions.taskGroups.find(groupName);
+                    if (group == ctrlOptions.taskGroups.end()) {
+                        reply.addInt(ocra_icub::FAILURE);
+                    } else {
+                        reply.addInt(ocra_icub::SUCCESS);
+                        for (auto const& taskName : group->second) {
+                            reply.addString(taskName);
+                        }
+                    }
+                }break;
+
+            case ocra_icub::BATCH_TASK_STATES:
+                {
+                    // Sent by the clients at every tick, so not printed.
+                    if (!exchangeTaskStates(input, i, reply)) {
+                        reply.addInt(ocra_icub::FAILURE);
+                    }
+                }break;
+
+            case ocra_icub::LOAD_TASK_SET:
+                {
+                    std::string taskSetPath = input.get(++i).asString();
+                    double blendTime = ctrlOptions.taskSetBlendTime;
+                    if (i+1 < btlSize && (input.get(i+1).isDouble() || input.get(i+1).isInt())) {
+                        blendTime = input.get(++i).asDouble();
+                    }
+                    std::cout << "Got message: LOAD_TASK_SET " << taskSetPath << " " << blendTime << "." << std::endl;
+                    // Relative paths are taken from the directory of the startup task set.
+                    if (!taskSetPath.empty() && taskSetPath[0] != '/') {
+                        std::size_t dirEnd = ctrlOptions.startupTaskSetPath.find_last_of("/");
+                        if (dirEnd != std::string::npos) {
+                            taskSetPath = ctrlOptions.startupTaskSetPath.substr(0, dirEnd+1) + taskSetPath;
+                        }
+                    }
+                    reply.addInt(loadTaskSet(taskSetPath, blendTime) ? ocra_icub::SUCCESS : ocra_icub::FAILURE);
+                }break;
+
             case ocra_icub::STRING_MESSAGE:
                 {
                     std::cout << "Got message: STRING_MESSAGE." << std::endl;
@@ -431,7 +672,9 @@ void Thread::parseDebugMessage(yarp::os::Bottle& input, yarp::os::Bottle& reply)
             int newIndex = input.get(++i).asInt();
             if (newIndex == -1) {
                 if(yarpWbi->setControlMode(wbi::CTRL_MODE_TORQUE, torques.data(), ALL_JOINTS) ) {
+                    seedPreviousTorques();
                     debuggingAllJoints = true;
+                    setDebugJoints(allJoints());
                     replyString = "Success! Setting all joints to TORQUE control mode.";
                 } else {
                     replyString = "FAILED! Could not set the control mode of the joints to TORQUE mode.";
@@ -440,14 +683,11 @@ void Thread::parseDebugMessage(yarp::os::Bottle& input, yarp::os::Bottle& reply)
                 jointName = model->getJointName(newIndex);
                 jointString = std::to_string(newIndex);
                 if (newIndex >= 0 && newIndex < initialPosture.rows()) {
-                    if (debuggingAllJoints) {
-                        yarpWbi->setControlMode(wbi::CTRL_MODE_POS, initialPosture.data(), ALL_JOINTS);
-                        yarpWbi->setControlReference(initialPosture.data(), ALL_JOINTS);
-                        debuggingAllJoints = false;
-                    } else {
-                        yarpWbi->setControlMode(wbi::CTRL_MODE_POS, &initialPosture(debugJointIndex), debugJointIndex);
-                        yarpWbi->setControlReference(&initialPosture(debugJointIndex), debugJointIndex);
-                    }
+                    // Back to the initial posture for the joints debugged so far, all of them at once if they are all debugged. run() stops sending them torques first.
+                    std::vector<int> previousJoints = debugJoints;
+                    setDebugJoints(std::vector<int>());
+                    setJointsControlMode(previousJoints, wbi::CTRL_MODE_POS, initialPosture.data());
+                    debuggingAllJoints = false;
 
                     if( setDebugJointToTorqueMode(newIndex) ) {
                         replyString = "Success! Debugging joint index: " + jointString + " (" + jointName +")";
@@ -486,6 +726,8 @@ void Thread::parseDebugMessage(yarp::os::Bottle& input, yarp::os::Bottle& reply)
                 replyString += "Switching to 'noOutputMode'.\n";
                 ctrlOptions.noOutputMode = true;
                 ctrlOptions.runInDebugMode = false;
+                debuggingAllJoints = false;
+                setDebugJoints(std::vector<int>());
                 if(yarpWbi->setControlMode(wbi::CTRL_MODE_POS, initialPosture.data(), ALL_JOINTS)) {
                     replyString += "Success! Setting all joints to POSITION control mode.";
                 } else {
@@ -496,7 +738,9 @@ void Thread::parseDebugMessage(yarp::os::Bottle& input, yarp::os::Bottle& reply)
                 ctrlOptions.noOutputMode = false;
                 ctrlOptions.runInDebugMode = true;
                 if(yarpWbi->setControlMode(wbi::CTRL_MODE_TORQUE, torques.data(), ALL_JOINTS) ) {
+                    seedPreviousTorques();
                     debuggingAllJoints = true;
+                    setDebugJoints(allJoints());
                     replyString += "Success! Setting all joints to TORQUE control mode.";
                 } else {
                     replyString += "FAILED! Could not set the control mode of the joints to TORQUE mode.";
@@ -550,6 +794,144 @@ bool Thread::ControllerRpcServerCallback::read(yarp::os::ConnectionReader& conne
     }
 }
 
+bool Thread::setTaskGroupActivation(const std::string& groupName, bool activate)
+{
+    auto group = ctrlOptions.taskGroups.find(groupName);
+    if (group == ctrlOptions.taskGroups.end()) {
+        OCRA_ERROR("Unknown task group: " << groupName);
+        return false;
+    }
+    // Waits for the tick in progress, if any, so that the whole group is switched before the next one.
+    std::lock_guard<std::mutex> lock(controllerMutex);
+    return ctrlServer->setTasksActivation(group->second, activate);
+}
+
+bool Thread::exchangeTaskStates(yarp::os::Bottle& input, int& i, yarp::os::Bottle& reply)
+{
+    std::vector<std::string> desiredTaskNames, readTaskNames;
+    std::vector<ocra::TaskState> desiredStates;
+    std::vector<int> readFields;
+
+    int nSet = input.get(++i).asInt();
+    for (int k=0; k<nSet; ++k) {
+        desiredTaskNames.push_back(input.get(++i).asString());
+        yarp::os::Bottle* stateBottle = input.get(++i).asList();
+        if (stateBottle == NULL) {
+            OCRA_ERROR("Malformed BATCH_TASK_STATES message: no desired state for " << desiredTaskNames.back());
+            i = input.size();
+            return false;
+        }
+        ocra::TaskState state;
+        int sizeOfOptions;
+        state.extractFromBottle(*stateBottle, sizeOfOptions);
+        desiredStates.push_back(state);
+    }
+    int nGet = input.get(++i).asInt();
+    for (int k=0; k<nGet; ++k) {
+        readTaskNames.push_back(input.get(++i).asString());
+        readFields.push_back(input.get(++i).asInt());
+    }
+    if (i >= input.size()) {
+        OCRA_ERROR("Malformed BATCH_TASK_STATES message: expected " << nSet << " desired states and " << nGet << " tasks to read.");
+        return false;
+    }
+
+    yarp::os::Bottle states;
+    {
+        // Waits for the tick in progress, if any, so that all the states are set and read between the same two ticks.
+        std::lock_guard<std::mutex> lock(controllerMutex);
+        if (!ctrlServer->exchangeTaskStates(desiredTaskNames, desiredStates, readTaskNames, readFields, states))
+            return false;
+    }
+    reply.addInt(ocra_icub::SUCCESS);
+    reply.append(states);
+    return true;
+}
+
+bool Thread::loadTaskSet(const std::string& taskSetPath, double blendTime)
+{
+    if (!std::ifstream(taskSetPath.c_str()).good()) {
+        OCRA_ERROR("Could not open the task set " << taskSetPath);
+        return false;
+    }
+
+    // The controller of the new task set is built here, on the rpc thread, while run() keeps controlling the robot with the current one. It has no task ports since those of the current task set are still open: clients of the new task set go through this rpc port, e.g. with ocra_icub::TaskStateBatch.
+    // The WBI is shared with run(), so it is only accessed with controllerMutex held. What only needs files or the model of the new controller, i.e. reading the task set, the URDF of the odometry, creating the tasks and the first solve, is done outside of the lock. The model is refreshed again at the swap.
+    bool useOdometry = ctrlOptions.useOdometry && ctrlOptions.isFloatingBase;
+    std::shared_ptr<IcubControllerServer> newCtrlServer;
+    std::uint64_t jointListHash;
+    int nDoF;
+    {
+        std::lock_guard<std::mutex> lock(controllerMutex);
+        newCtrlServer = std::make_shared<IcubControllerServer>( yarpWbi,
+                                                                ctrlOptions.robotName,
+                                                                ctrlOptions.isFloatingBase,
+                                                                ctrlOptions.controllerType,
+                                                                ctrlOptions.solver,
+                                                                false,
+                                                                ctrlOptions.useOdometry
+                                                              );
+        jointListHash = ocra_icub::hashJointList(yarpWbi->getJointList());
+        nDoF = yarpWbi->getDoFs();
+    }
+    std::vector<ocra::TaskBuilderOptions> taskOptions;
+    if (!IcubControllerServer::readTaskSet(taskSetPath, jointListHash, taskOptions)) {
+        OCRA_ERROR("None of the tasks of " << taskSetPath << " was added.");
+        return false;
+    }
+    if (useOdometry && !newCtrlServer->loadOdometryModel(ctrlOptions.urdfModelPath)) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(controllerMutex);
+        newCtrlServer->initialize();
+        if (useOdometry) {
+            // The world frame stays where the odometry of the current task set has brought it, instead of being reset to the current foot.
+            if (!newCtrlServer->continueOdometry(ctrlOptions.urdfModelPath, *ctrlServer)) {
+                OCRA_ERROR("Odometry could not be initialized for the task set " << taskSetPath);
+                return false;
+            }
+            newCtrlServer->updateModel();
+        }
+    }
+    newCtrlServer->addTasks(taskOptions);
+
+    // A first solve sizes the QP of the new task set, so that the first tick after the swap costs no more than the others.
+    Eigen::VectorXd newTorques;
+    newCtrlServer->computeOutput(newTorques);
+    if (newTorques.size() != nDoF || !newTorques.allFinite()) {
+        OCRA_ERROR("The controller of the task set " << taskSetPath << " does not compute valid torques. Keeping the current task set.");
+        return false;
+    }
+
+    // The previous controllers are destroyed at the end of this function, outside of the lock.
+    std::shared_ptr<IcubControllerServer> droppedCtrlServer, retired;
+    {
+        // Waits for the tick in progress, if any. The next tick runs with the new task set.
+        std::lock_guard<std::mutex> lock(controllerMutex);
+        // The robot has moved since the model of the new controller was updated, and so has the odometry of the current one.
+        if (useOdometry && !newCtrlServer->continueOdometry(ctrlOptions.urdfModelPath, *ctrlServer)) {
+            OCRA_ERROR("Odometry could not be initialized for the task set " << taskSetPath);
+            return false;
+        }
+        newCtrlServer->updateModel();
+        retired.swap(retiredCtrlServer);
+        // A task set loaded while the previous one is still blended out is blended from the current one.
+        droppedCtrlServer = outgoingCtrlServer;
+        outgoingCtrlServer = ctrlServer;
+        ctrlServer = newCtrlServer;
+        model = ctrlServer->getRobotModel();
+        blendTicks = std::round(1000.0 * blendTime / ctrlOptions.threadPeriod);
+        blendTick = 0;
+        if (blendTicks <= 0) {
+            retiredCtrlServer = outgoingCtrlServer;
+            outgoingCtrlServer.reset();
+        }
+    }
+    OCRA_INFO("Switched to the task set " << taskSetPath << ", blending over " << std::max(blendTicks, 0) << " ticks.")
+    return true;
+}
+
 void Thread::putAnklesIntoIdle(double idleTime)
 {
     // Set everything else to position mode
@@ -0,0 +1,129 @@
+/*! \file       TorqueLoopThread.cpp
+ *  \brief      Fast inner torque loop of the controller server, decoupled from the QP.
+ *  \details    See TorqueLoopThread.h.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-icub.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ocra-icub-server/TorqueLoopThread.h"
+#include <ocra/util/ErrorsHelper.h>
+
+TorqueLoopThread::TorqueLoopThread(int period, const std::string& name, const wbi::IDList& joints, const yarp::os::Property& wbiOptions,
+                                   const Eigen::ArrayXd& minTorques, const Eigen::ArrayXd& maxTorques, double maxTorqueRate)
+: RateThread(period)
+, joints(joints)
+, robot(name.c_str(), wbiOptions)
+, model("torqueLoopModel", wbiOptions)
+, nDoF(joints.size())
+, minTorques(minTorques)
+, maxTorques(maxTorques)
+, maxTorqueStep(maxTorqueRate * period / 1000.0)
+, gravity(0.0, 0.0, -9.81)
+, hasSolution(false)
+, hasNewSolution(false)
+{
+}
+
+TorqueLoopThread::~TorqueLoopThread()
+{
+}
+
+bool TorqueLoopThread::threadInit()
+{
+    robot.addJoints(joints);
+    if (!robot.init()) {
+        OCRA_ERROR("Could not open the interface of the torque loop.")
+        return false;
+    }
+    model.addJoints(joints);
+    if (!model.init()) {
+        OCRA_ERROR("Could not load the model of the torque loop.")
+        return false;
+    }
+    q = Eigen::VectorXd::Zero(nDoF);
+    dq = Eigen::VectorXd::Zero(nDoF);
+    torques = Eigen::VectorXd::Zero(nDoF);
+    biasForces = Eigen::VectorXd::Zero(nDoF + 6);
+    solutionBiasForces = Eigen::VectorXd::Zero(nDoF + 6);
+    previousTorques = Eigen::ArrayXd::Zero(nDoF);
+    if (!robot.getEstimates(wbi::ESTIMATE_JOINT_TORQUE, previousTorques.data())) {
+        OCRA_WARNING("Could not read the joint torques. The torque rate limit of the torque loop starts from zero torques.")
+        previousTorques.setZero();
+    }
+    return true;
+}
+
+void TorqueLoopThread::threadRelease()
+{
+    robot.close();
+}
+
+void TorqueLoopThread::setSolution(const Eigen::VectorXd& tau, const Eigen::VectorXd& jointPositions, const Eigen::VectorXd& jointVelocities,
+                                   const wbi::Frame& xBase, const Eigen::VectorXd& baseVelocity)
+{
+    std::lock_guard<std::mutex> lock(solutionMutex);
+    newTorques = tau;
+    newQ = jointPositions;
+    newDq = jointVelocities;
+    newBase = xBase;
+    newBaseVelocity = baseVelocity;
+    hasNewSolution = true;
+    hasSolution = true;
+}
+
+void TorqueLoopThread::run()
+{
+    bool solutionChanged = false;
+    {
+        std::lock_guard<std::mutex> lock(solutionMutex);
+        if (!hasSolution) {
+            return;
+        }
+        if (hasNewSolution) {
+            solutionTorques.swap(newTorques);
+            solutionQ.swap(newQ);
+            solutionDq.swap(newDq);
+            solutionBaseVelocity.swap(newBaseVelocity);
+            solutionBase = newBase;
+            hasNewSolution = false;
+            solutionChanged = true;
+        }
+    }
+    // The bias forces of the solution are computed once per solution, here, since the model is only used by this thread.
+    if (solutionChanged) {
+        model.computeGeneralizedBiasForces(solutionQ.data(), solutionBase, solutionDq.data(), solutionBaseVelocity.data(), gravity.data(), solutionBiasForces.data());
+    }
+
+    robot.getEstimates(wbi::ESTIMATE_JOINT_POS, q.data());
+    robot.getEstimates(wbi::ESTIMATE_JOINT_VEL, dq.data());
+    model.computeGeneralizedBiasForces(q.data(), solutionBase, dq.data(), solutionBaseVelocity.data(), gravity.data(), biasForces.data());
+
+    torques = solutionTorques + (biasForces - solutionBiasForces).tail(nDoF);
+    if (maxTorqueStep > 0.0) {
+        // Same limits as the control thread, at the rate of this loop.
+        torques = ((torques.array().max(previousTorques - maxTorqueStep)).min(previousTorques + maxTorqueStep)).matrix().eval();
+    }
+    torques = ((torques.array().max(minTorques)).min(maxTorques)).matrix().eval();
+    previousTorques = torques.array();
+    if (!robot.setControlReference(torques.data())) {
+        OCRA_WARNING("Couldn't set the control reference of the torque loop.")
+    }
+}
@@ -60,6 +60,17 @@ int main (int argc, char * argv[])
     }
 
 
+    // The simulation runs headless, with or without a YARP network.
+    if (rf.check("sim"))
+    {
+        if (!module.configure(rf)) {
+            return -1;
+        }
+        bool ok = module.runSimulation();
+        module.close();
+        return ok ? 0 : -1;
+    }
+
     double network_timeout = 10.0;
     if (!yarp.checkNetwork(network_timeout))
     {
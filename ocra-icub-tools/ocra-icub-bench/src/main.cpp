@@ -0,0 +1,327 @@
+/*! \file       main.cpp
+ *  \brief      Benchmark of the control tick of ocra-icub-server over its task sets and solvers.
+ *  \details    Loads every task set of a taskSets directory, e.g. `ocra-icub-server/app/robots/icubSim/taskSets/`,
+ *              either XML or compiled by ocra-task-set-compiler (.tsb), in an IcubControllerServer running on a
+ *              SimulatedWholeBodyInterface, once per solver (QUADPROG and QPOASES), and times the two phases of
+ *              IcubControllerServer::computeTorques() at every tick:
+ *              - updateModel: reading the joint states from the interface and updating the model,
+ *              - computeOutput: updating the tasks and solving the QP of the controller.
+ *
+ *              By default the loop is closed on the simulation, which integrates the torques between two ticks.
+ *              With --states, the joint states are instead replayed from a recording, one tick per line holding the
+ *              joint positions followed by the joint velocities, looping over the file when it is shorter than
+ *              --ticks. Simulation and replay are not timed.
+ *
+ *              The robot, the wbi configuration file and the floating base option are read from
+ *              ocra-icub-server.ini, as ocra-icub-server does. The results are written as JSON, with the p50, p90,
+ *              p99, max and mean duration in microseconds of each phase and of the whole tick, for each task set and
+ *              solver. A task set which cannot be loaded is reported with "ok": false and its error, and the others
+ *              are still run.
+ *
+ *              Usage:
+ *              \code
+ *              ocra-icub-bench [--taskSetDir <dir>] [--ticks 5000] [--warmup 100] [--states <file>] [--out bench.json]
+ *              \endcode
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-icub.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Property.h>
+#include <yarpWholeBodyInterface/yarpWholeBodyInterface.h>
+
+#include <ocra-icub/SimulatedWholeBodyInterface.h>
+#include <ocra-icub-server/IcubControllerServer.h>
+
+/**
+ * Gives access to the controller of the server, to time the phases of computeTorques() separately.
+ */
+class BenchControllerServer : public IcubControllerServer {
+public:
+    BenchControllerServer(std::shared_ptr<wbi::wholeBodyInterface> robot, const std::string& robotName,
+                          const bool usingFloatingBase, const ocra_recipes::SOLVER_TYPE solver) :
+    IcubControllerServer(robot, robotName, usingFloatingBase, ocra_recipes::WOCRA_CONTROLLER, solver, false, false) {}
+
+    void computeOutput(Eigen::VectorXd& torques) { this->controller->computeOutput(torques); };
+};
+
+struct PhaseTimes {
+    std::string name;
+    std::vector<double> times;
+};
+
+struct BenchResult {
+    std::string taskSet;
+    std::string solver;
+    bool ok;
+    std::string error;
+    PhaseTimes phases[3];
+};
+
+/**
+ * Escapes a string to be written between double quotes in JSON.
+ */
+std::string escapeJson(const std::string& value) {
+    std::ostringstream escaped;
+    for (char c : value) {
+        switch (c) {
+            case '"': escaped << "\\\""; break;
+            case '\\': escaped << "\\\\"; break;
+            case '\n': escaped << "\\n"; break;
+            case '\r': escaped << "\\r"; break;
+            case '\t': escaped << "\\t"; break;
+            default:
+                if ((unsigned char) c < 0x20)
+                    escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int) c << std::dec;
+                else
+                    escaped << c;
+        }
+    }
+    return escaped.str();
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty())
+        return 0;
+    unsigned int i = (unsigned int) std::ceil(p*sorted.size()) - 1;
+    return sorted[std::min(i, (unsigned int) sorted.size() - 1)];
+}
+
+void writePhaseJson(std::ostream& out, PhaseTimes& phase) {
+    std::sort(phase.times.begin(), phase.times.end());
+    double mean = 0;
+    for (double t : phase.times)
+        mean += t;
+    mean = phase.times.empty() ? 0 : mean/phase.times.size();
+    out << "\"" << phase.name << "\": {"
+        << "\"p50_us\": " << 1e6*percentile(phase.times, 0.5)
+        << ", \"p90_us\": " << 1e6*percentile(phase.times, 0.9)
+        << ", \"p99_us\": " << 1e6*percentile(phase.times, 0.99)
+        << ", \"max_us\": " << 1e6*percentile(phase.times, 1.0)
+        << ", \"mean_us\": " << 1e6*mean << "}";
+}
+
+/**
+ * Reads the recorded joint states, one tick per line: nDoF joint positions then nDoF joint velocities.
+ */
+bool readStates(const std::string& path, int nDoF, std::vector<Eigen::VectorXd>& positions, std::vector<Eigen::VectorXd>& velocities) {
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        std::cout << "[ERROR] Could not open " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream values(line);
+        Eigen::VectorXd q(nDoF), dq(nDoF);
+        int n = 0;
+        for (; n < 2*nDoF && values >> (n < nDoF ? q(n) : dq(n - nDoF)); ++n) {}
+        if (n == 0)
+            continue;
+        if (n != 2*nDoF) {
+            std::cout << "[ERROR] Expected " << 2*nDoF << " values per line in " << path << ", got " << n << std::endl;
+            return false;
+        }
+        positions.push_back(q);
+        velocities.push_back(dq);
+    }
+    return !positions.empty();
+}
+
+BenchResult runBenchmark(const std::string& taskSetPath, ocra_recipes::SOLVER_TYPE solver, const std::string& solverName,
+                         const yarp::os::Property& wbiOptions, const std::string& robotName, bool isFloatingBase,
+                         double period, int warmupTicks, int ticks,
+                         const std::vector<Eigen::VectorXd>& positions, const std::vector<Eigen::VectorXd>& velocities) {
+    BenchResult result;
+    result.taskSet = boost::filesystem::path(taskSetPath).filename().string();
+    result.solver = solverName;
+    result.ok = false;
+    result.phases[0].name = "updateModel";
+    result.phases[1].name = "computeOutput";
+    result.phases[2].name = "total";
+
+    std::shared_ptr<ocra_icub::SimulatedWholeBodyInterface> robot = std::make_shared<ocra_icub::SimulatedWholeBodyInterface>("ocra-icub-bench", wbiOptions, period);
+    wbi::IDList robotJoints;
+    if (!yarpWbi::loadIdListFromConfig("ROBOT_MAIN_JOINTS", wbiOptions, robotJoints) || robot->addJoints(robotJoints) == 0 || !robot->init()) {
+        result.error = "Could not initialize the simulated robot";
+        return result;
+    }
+    robot->setControlMode(wbi::CTRL_MODE_TORQUE, 0, -1);
+
+    BenchControllerServer server(robot, robotName, isFloatingBase, solver);
+    if (!server.initialize()) {
+        result.error = "Could not initialize the controller server";
+        return result;
+    }
+    // Same path as the tasks loaded by ocra-icub-server, for both XML and compiled task sets
+    if (!server.addTasksFromFile(taskSetPath)) {
+        result.error = "Could not load the task set " + taskSetPath;
+        return result;
+    }
+
+    Eigen::VectorXd torques;
+    for (int k = 0; k < warmupTicks + ticks; k++) {
+        if (!positions.empty())
+            robot->setState(positions[k % positions.size()], velocities[k % velocities.size()]);
+
+        auto start = std::chrono::steady_clock::now();
+        server.updateModel();
+        auto modelUpdated = std::chrono::steady_clock::now();
+        server.computeOutput(torques);
+        auto end = std::chrono::steady_clock::now();
+
+        if (!torques.allFinite()) {
+            result.error = "Non-finite torques at tick " + std::to_string(k);
+            return result;
+        }
+        if (k >= warmupTicks) {
+            result.phases[0].times.push_back(std::chrono::duration<double>(modelUpdated - start).count());
+            result.phases[1].times.push_back(std::chrono::duration<double>(end - modelUpdated).count());
+            result.phases[2].times.push_back(std::chrono::duration<double>(end - start).count());
+        }
+
+        if (positions.empty()) {
+            robot->setControlReference(torques.data());
+            if (!robot->step()) {
+                result.error = "The simulation failed at tick " + std::to_string(k);
+                return result;
+            }
+        }
+    }
+    result.ok = true;
+    return result;
+}
+
+int main(int argc, char * argv[])
+{
+    yarp::os::ResourceFinder rf;
+    rf.setVerbose(false);
+    rf.setDefaultConfigFile("ocra-icub-server.ini");
+    rf.setDefaultContext("ocra-icub-server");
+    rf.configure(argc, argv);
+
+    if (rf.check("help")) {
+        std::cout << "Usage: ocra-icub-bench [--taskSetDir <dir>] [--ticks <n>] [--warmup <n>] [--states <file>] [--out <json>]" << std::endl;
+        std::cout << "\t--taskSetDir :Directory of the task sets to benchmark. Defaults to the taskSets directory of the robot." << std::endl;
+        std::cout << "\t--ticks :Number of timed control ticks per task set and solver. Set to 5000 by default." << std::endl;
+        std::cout << "\t--warmup :Number of control ticks run before timing. Set to 100 by default." << std::endl;
+        std::cout << "\t--states :Text file of recorded joint states replayed instead of closing the loop on the simulation, one tick per line: positions then velocities." << std::endl;
+        std::cout << "\t--out :JSON file the results are written to. Written to the standard output by default." << std::endl;
+        return 0;
+    }
+
+    std::string robotName = rf.check("robot") ? rf.find("robot").asString().c_str() : "icub";
+    bool isFloatingBase = rf.check("floatingBase");
+    double period = (rf.check("threadPeriod") ? rf.find("threadPeriod").asInt() : 10)/1000.0;
+    int ticks = rf.check("ticks") ? std::max(1, rf.find("ticks").asInt()) : 5000;
+    int warmupTicks = rf.check("warmup") ? std::max(0, rf.find("warmup").asInt()) : 100;
+
+    if (!rf.check("wbi_conf_file")) {
+        std::cout << "[ERROR] wbi_conf_file option missing" << std::endl;
+        return -1;
+    }
+    yarp::os::Property wbiOptions;
+    wbiOptions.fromConfigFile(rf.findFile("wbi_conf_file"));
+    wbiOptions.put("robot", robotName);
+
+    std::string taskSetDir = rf.check("taskSetDir") ? rf.find("taskSetDir").asString().c_str() : rf.findPath("taskSets").c_str();
+    std::vector<std::string> taskSets;
+    if (boost::filesystem::is_directory(taskSetDir)) {
+        for (boost::filesystem::directory_iterator it(taskSetDir); it != boost::filesystem::directory_iterator(); ++it) {
+            if (it->path().extension() == ".xml" || it->path().extension() == ".tsb")
+                taskSets.push_back(it->path().string());
+        }
+    }
+    if (taskSets.empty()) {
+        std::cout << "[ERROR] No task set found in '" << taskSetDir << "'" << std::endl;
+        return -1;
+    }
+    std::sort(taskSets.begin(), taskSets.end());
+
+    std::vector<Eigen::VectorXd> positions, velocities;
+    if (rf.check("states")) {
+        wbi::IDList robotJoints;
+        yarpWbi::loadIdListFromConfig("ROBOT_MAIN_JOINTS", wbiOptions, robotJoints);
+        if (!readStates(rf.find("states").asString().c_str(), robotJoints.size(), positions, velocities))
+            return -1;
+    }
+
+    const std::pair<ocra_recipes::SOLVER_TYPE, std::string> solvers[] = {
+        std::make_pair(ocra_recipes::QUADPROG, std::string("QUADPROG")),
+        std::make_pair(ocra_recipes::QPOASES, std::string("QPOASES"))
+    };
+    std::vector<BenchResult> results;
+    for (const std::string& taskSet : taskSets) {
+        for (auto const& solver : solvers) {
+            std::cerr << "Benchmarking " << taskSet << " with " << solver.second << "..." << std::endl;
+            results.push_back(runBenchmark(taskSet, solver.first, solver.second, wbiOptions, robotName, isFloatingBase,
+                                           period, warmupTicks, ticks, positions, velocities));
+            if (!results.back().ok)
+                std::cerr << "[ERROR] " << results.back().error << std::endl;
+        }
+    }
+
+    std::ofstream outFile;
+    if (rf.check("out")) {
+        outFile.open(rf.find("out").asString().c_str());
+        if (!outFile.is_open()) {
+            std::cout << "[ERROR] Could not write " << rf.find("out").asString() << std::endl;
+            return -1;
+        }
+    }
+    std::ostream& out = outFile.is_open() ? outFile : std::cout;
+    out << "{\n  \"robot\": \"" << escapeJson(robotName) << "\",\n  \"floatingBase\": " << (isFloatingBase ? "true" : "false")
+        << ",\n  \"ticks\": " << ticks << ",\n  \"warmupTicks\": " << warmupTicks
+        << ",\n  \"states\": \"" << (positions.empty() ? "simulation" : "recorded") << "\",\n  \"results\": [\n";
+    for (unsigned int i = 0; i < results.size(); i++) {
+        BenchResult& result = results[i];
+        out << "    {\"taskSet\": \"" << escapeJson(result.taskSet) << "\", \"solver\": \"" << escapeJson(result.solver) << "\", \"ok\": "
+            << (result.ok ? "true" : "false");
+        if (result.ok) {
+            out << ", \"phases\": {";
+            for (int p = 0; p < 3; p++) {
+                writePhaseJson(out, result.phases[p]);
+                out << (p < 2 ? ", " : "");
+            }
+            out << "}";
+        } else {
+            out << ", \"error\": \"" << escapeJson(result.error) << "\"";
+        }
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}" << std::endl;
+
+    bool allOk = true;
+    for (auto const& result : results)
+        allOk &= result.ok;
+    return allOk ? 0 : -1;
+}
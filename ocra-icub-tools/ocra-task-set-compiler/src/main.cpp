@@ -0,0 +1,98 @@
+/*! \file       main.cpp
+ *  \brief      Compiles XML task sets into the binary task sets loaded by ocra-icub-server.
+ *  \details    Parses an XML task set with ocra::TaskParser and writes the resulting task options to a .tsb file,
+ *              see ocra-icub/CompiledTaskSet.h. The file is bound to the joint list of the robot, i.e. the
+ *              ROBOT_MAIN_JOINTS list of the wbi configuration file of ocra-icub-server.ini, and has to be compiled
+ *              again when this list changes. The server refuses to load it otherwise.
+ *
+ *              Usage:
+ *              \code
+ *              ocra-task-set-compiler --taskSet <file.xml> [--out <file.tsb>]
+ *              \endcode
+ *              By default the compiled task set is written next to the XML one, with the .tsb extension.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-icub.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Property.h>
+#include <yarpWholeBodyInterface/yarpWholeBodyInterface.h>
+
+#include <ocra/control/TaskBuilders/TaskParser.h>
+#include <ocra-icub/CompiledTaskSet.h>
+
+int main(int argc, char * argv[])
+{
+    yarp::os::ResourceFinder rf;
+    rf.setVerbose(false);
+    rf.setDefaultConfigFile("ocra-icub-server.ini");
+    rf.setDefaultContext("ocra-icub-server");
+    rf.configure(argc, argv);
+
+    if (rf.check("help") || !rf.check("taskSet")) {
+        std::cout << "Usage: ocra-task-set-compiler --taskSet <file.xml> [--out <file.tsb>]" << std::endl;
+        std::cout << "\t--taskSet :XML task set to compile. Looked for in the taskSets directory of the robot if it is not found as is." << std::endl;
+        std::cout << "\t--out :Compiled task set. Written next to the XML task set, with the " << ocra_icub::COMPILED_TASK_SET_EXTENSION << " extension, by default." << std::endl;
+        return rf.check("help") ? 0 : -1;
+    }
+
+    std::string taskSetPath = rf.find("taskSet").asString().c_str();
+    if (!boost::filesystem::exists(taskSetPath)) {
+        taskSetPath = rf.findFileByName("taskSets/" + boost::filesystem::path(taskSetPath).filename().string()).c_str();
+    }
+    if (taskSetPath.empty() || !boost::filesystem::exists(taskSetPath)) {
+        std::cout << "[ERROR] Could not find the task set " << rf.find("taskSet").asString() << std::endl;
+        return -1;
+    }
+    std::string outPath = rf.check("out") ? rf.find("out").asString().c_str()
+                        : boost::filesystem::path(taskSetPath).replace_extension(ocra_icub::COMPILED_TASK_SET_EXTENSION).string();
+
+    // The compiled task set is bound to the joint list the server will run with.
+    if (!rf.check("wbi_conf_file")) {
+        std::cout << "[ERROR] wbi_conf_file option missing" << std::endl;
+        return -1;
+    }
+    yarp::os::Property wbiOptions;
+    wbiOptions.fromConfigFile(rf.findFile("wbi_conf_file"));
+    wbi::IDList robotJoints;
+    if (!yarpWbi::loadIdListFromConfig("ROBOT_MAIN_JOINTS", wbiOptions, robotJoints)) {
+        std::cout << "[ERROR] Impossible to load the joint list ROBOT_MAIN_JOINTS" << std::endl;
+        return -1;
+    }
+
+    ocra::TaskParser taskParser;
+    std::vector<ocra::TaskBuilderOptions> taskOptions;
+    if (!taskParser.parseTasksXML(taskSetPath.c_str(), taskOptions) || taskOptions.empty()) {
+        std::cout << "[ERROR] Could not parse any task from " << taskSetPath << std::endl;
+        return -1;
+    }
+
+    if (!ocra_icub::writeCompiledTaskSet(outPath, taskOptions, ocra_icub::hashJointList(robotJoints))) {
+        return -1;
+    }
+    std::cout << "Compiled " << taskOptions.size() << " tasks of " << taskSetPath << " for " << robotJoints.size() << " joints into " << outPath << std::endl;
+    return 0;
+}
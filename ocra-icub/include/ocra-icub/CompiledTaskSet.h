@@ -0,0 +1,82 @@
+/*! \file       CompiledTaskSet.h
+ *  \brief      Binary task sets, compiled from the XML ones by ocra-task-set-compiler.
+ *  \details    An XML task set is read by ocra::TaskParser, which looks up the options of each task among the xml
+ *              elements and converts every value from its text. A compiled task set holds the same
+ *              ocra::TaskBuilderOptions, already parsed, as a single yarp bottle in its binary encoding. Loading it is
+ *              one memory-mapped read followed by the decoding of the bottle.
+ *
+ *              The options refer to the joints by their index in the joint list of the robot, so a compiled task
+ *              set is only valid for the joint list it was compiled against. A hash of this list is stored in the
+ *              file and checked at load time:
+ *              \code
+ *              "OCRATSB\0" | version (uint32) | number of tasks (uint32) | joint list hash (uint64) | size (uint64) | bottle
+ *              \endcode
+ *              with the integers in the byte order of the machine which compiled the file.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-icub.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OCRA_ICUB_COMPILED_TASK_SET_H
+#define OCRA_ICUB_COMPILED_TASK_SET_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <ocra-icub/Utilities.h>
+#include <ocra/control/TaskBuilders/TaskBuilderOptions.h>
+
+namespace ocra_icub
+{
+
+/*! Extension of the compiled task sets. The server loads a task set with this extension as a compiled one.
+ */
+static const std::string COMPILED_TASK_SET_EXTENSION = ".tsb";
+
+/*! \return True if the file has the COMPILED_TASK_SET_EXTENSION.
+ */
+bool isCompiledTaskSet(const std::string& filePath);
+
+/*! Hashes the names of the joints of a list, in their order, with FNV-1a.
+ *  \param joints Joint list of the robot, e.g. wbi::wholeBodyInterface::getJointList().
+ *  \return The hash, which changes if a joint is added, removed, renamed or moved in the list.
+ */
+std::uint64_t hashJointList(const wbi::IDList& joints);
+
+/*! Writes a compiled task set.
+ *  \param filePath Path of the file, overwritten.
+ *  \param taskOptions Options of the tasks, e.g. parsed from an XML task set by ocra::TaskParser.
+ *  \param jointListHash Hash of the joint list the options refer to, see hashJointList().
+ *  \return False if the file could not be written.
+ */
+bool writeCompiledTaskSet(const std::string& filePath, std::vector<ocra::TaskBuilderOptions>& taskOptions, std::uint64_t jointListHash);
+
+/*! Reads a compiled task set.
+ *  \param filePath Path of the file.
+ *  \param jointListHash Hash of the joint list of the running robot, see hashJointList().
+ *  \param taskOptions Options of the tasks, replaced.
+ *  \return False if the file could not be read, is not a compiled task set of this version or was compiled against
+ *          another joint list.
+ */
+bool readCompiledTaskSet(const std::string& filePath, std::uint64_t jointListHash, std::vector<ocra::TaskBuilderOptions>& taskOptions);
+
+} /* ocra_icub */
+#endif // OCRA_ICUB_COMPILED_TASK_SET_H
@@ -0,0 +1,112 @@
+/*! \file       FootContactManager.h
+ *  \brief      Client-side state machine of the foot contacts.
+ *  \details    The contact of each foot is made of the four corner contact tasks of the sole, e.g.
+ *              `LeftFootContact_BackLeft`, grouped on the controller server in the task groups `LeftFootContact` and
+ *              `RightFootContact` (see the [TASK_GROUPS] option of ocra-icub-server). A foot contact change is a
+ *              single ACTIVATE_TASK_GROUP or DEACTIVATE_TASK_GROUP message to the server, which switches the four
+ *              tasks on the same control tick, instead of one round-trip per task.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-icub.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OCRA_ICUB_FOOT_CONTACT_MANAGER_H
+#define OCRA_ICUB_FOOT_CONTACT_MANAGER_H
+
+#include <ocra-icub/Utilities.h>
+#include <ocra-recipes/TaskConnection.h>
+
+namespace ocra_icub
+{
+
+enum CONTACT_FOOT
+{
+    LEFT_CONTACT_FOOT = 0,
+    RIGHT_CONTACT_FOOT
+};
+
+/*! \class FootContactManager
+ *  \brief Activates and deactivates the contacts of each foot through the task groups of the controller server.
+ *
+ *  Keeps track of which feet are in contact, so that activating a foot which is already in contact (or
+ *  deactivating one which is not) costs nothing. The corner contact tasks of each foot are retrieved from the
+ *  server with GET_TASK_GROUP and are only used to read their states, see getActiveContact2DCoordinates().
+ */
+class FootContactManager
+{
+CLASS_POINTER_TYPEDEFS(FootContactManager)
+
+public:
+    /*! Constructor. Does not communicate with the server, see initialize().
+     *  \param portPrefix Prefix of the rpc port opened to talk to the server, e.g. "/walking-client/footContacts".
+     *  \param leftFootGroup Name of the task group of the left foot contacts on the server.
+     *  \param rightFootGroup Name of the task group of the right foot contacts on the server.
+     */
+    FootContactManager(const std::string& portPrefix,
+                       const std::string& leftFootGroup = "LeftFootContact",
+                       const std::string& rightFootGroup = "RightFootContact");
+
+    virtual ~FootContactManager();
+
+    /*! Connects to the controller server, retrieves the tasks of both groups and reads whether each foot is
+     *  currently in contact.
+     *  \return False if the server could not be reached or doesn't know the task groups.
+     */
+    bool initialize();
+
+    /*! Activates all the contacts of a foot on a single control tick.
+     *  \param foot LEFT_CONTACT_FOOT or RIGHT_CONTACT_FOOT.
+     *  \return True if the foot is in contact.
+     */
+    bool activate(CONTACT_FOOT foot);
+
+    /*! Deactivates all the contacts of a foot on a single control tick.
+     *  \param foot LEFT_CONTACT_FOOT or RIGHT_CONTACT_FOOT.
+     *  \return True if the foot is not in contact anymore.
+     */
+    bool deactivate(CONTACT_FOOT foot);
+
+    /*! \param foot LEFT_CONTACT_FOOT or RIGHT_CONTACT_FOOT.
+     *  \return True if the contacts of the foot are active.
+     */
+    bool isInContact(CONTACT_FOOT foot) const;
+
+    /*! \return The 2D coordinates of the contact points of the feet in contact, one per row.
+     */
+    Eigen::MatrixXd getActiveContact2DCoordinates();
+
+    /*! Same as above, writing in a matrix that is only reallocated when the number of active contacts changes.
+     *  \param[out] coordinates The 2D coordinates of the contact points of the feet in contact, one per row.
+     */
+    void getActiveContact2DCoordinates(Eigen::MatrixXd& coordinates);
+
+private:
+    bool sendGroupMessage(OCRA_ICUB_MESSAGE message, const std::string& groupName, yarp::os::Bottle& reply);
+    bool setContact(CONTACT_FOOT foot, bool activate);
+
+    std::string portName; /*!< Name of the rpc port connected to the server. */
+    yarp::os::RpcClient serverPort; /*!< Rpc port connected to /ocra-icub-server/info/rpc:i. */
+    std::string groupNames[2]; /*!< Task groups of the left and right foot contacts. */
+    std::vector<ocra_recipes::TaskConnection::Ptr> contacts[2]; /*!< Corner contact tasks of the left and right foot. */
+    bool inContact[2]; /*!< Current contact state of the left and right foot. */
+};
+
+} /* ocra_icub */
+#endif // OCRA_ICUB_FOOT_CONTACT_MANAGER_H
@@ -0,0 +1,157 @@
+/*! \file       SimulatedWholeBodyInterface.h
+ *  \brief      In-process whole body interface simulating the robot from its URDF model.
+ *  \details    Everything that runs the controller needs a wbi::wholeBodyInterface, normally a
+ *              yarpWbi::yarpWholeBodyInterface talking to the robot or to Gazebo over YARP. This one keeps the joint
+ *              states in memory and integrates the torques written with setControlReference() through the rigid-body
+ *              dynamics of the URDF model, computed by a yarpWbi::yarpWholeBodyModel which only needs the model
+ *              file. It is used by `ocra-icub-server --sim` to run the control loop without a robot and as fast as
+ *              the controller can go.
+ *
+ *              The joint dynamics are
+ *              \f[
+ *                  \mathbf{M}_{jj}(\mathbf{q}) \ddot{\mathbf{q}} + \mathbf{h}_j(\mathbf{q}, \dot{\mathbf{q}}) = \boldsymbol{\tau}
+ *              \f]
+ *              integrated with a semi-implicit Euler scheme at every step(), the joint positions being clamped to
+ *              their limits. The base is held at its initial pose, i.e. the robot is simulated as if hung from its
+ *              root link: there are no contacts. Joints in position mode follow their reference through a
+ *              gravity-compensated PD, joints in torque mode apply their reference.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-icub.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OCRA_ICUB_SIMULATED_WHOLE_BODY_INTERFACE_H
+#define OCRA_ICUB_SIMULATED_WHOLE_BODY_INTERFACE_H
+
+#include <mutex>
+
+#include <ocra-icub/Utilities.h>
+#include <yarpWholeBodyInterface/yarpWholeBodyModel.h>
+
+namespace ocra_icub
+{
+
+/*! \class SimulatedWholeBodyInterface
+ *  \brief wbi::wholeBodyInterface whose states come from a simulation of the URDF model instead of the robot.
+ *
+ *  Joints are added with addJoints() and the model is loaded by init(), as for yarpWbi::yarpWholeBodyInterface.
+ *  Nothing moves until step() is called: the owner of the simulation steps it once per control tick.
+ */
+class SimulatedWholeBodyInterface : public wbi::wholeBodyInterface
+{
+CLASS_POINTER_TYPEDEFS(SimulatedWholeBodyInterface)
+
+public:
+    /*! Constructor.
+     *  \param interfaceName Name of the interface, forwarded to the model.
+     *  \param wbiOptions Options of the yarpWholeBodyInterface configuration file. Only the model ones, e.g.
+     *         `urdf`, are used.
+     *  \param timeStep Time in seconds integrated by each step().
+     */
+    SimulatedWholeBodyInterface(const char* interfaceName, const yarp::os::Property& wbiOptions, double timeStep);
+
+    virtual ~SimulatedWholeBodyInterface();
+
+    /*! Loads the model and puts the joints at rest, in the middle of their limits when zero is out of them.
+     *  \return False if the model could not be loaded.
+     */
+    virtual bool init();
+    virtual bool close();
+
+    virtual bool removeJoint(const wbi::ID &j);
+    virtual bool addJoint(const wbi::ID &j);
+    virtual int addJoints(const wbi::IDList &j);
+    virtual const wbi::IDList& getJointList();
+    virtual int getDoFs();
+
+    // States
+    virtual bool addEstimate(const wbi::EstimateType st, const wbi::ID &sid);
+    virtual int addEstimates(const wbi::EstimateType st, const wbi::IDList &sids);
+    virtual bool removeEstimate(const wbi::EstimateType st, const wbi::ID &sid);
+    virtual const wbi::IDList& getEstimateList(const wbi::EstimateType st);
+    virtual bool getEstimate(const wbi::EstimateType et, const int numeric_id, double *data, double time=-1.0, bool blocking=true);
+    virtual bool getEstimates(const wbi::EstimateType et, double *data, double time=-1.0, bool blocking=true);
+    virtual bool setEstimationParameter(const wbi::EstimateType et, const wbi::EstimationParameter ep, const void *value);
+
+    // Actuators
+    virtual bool setControlMode(wbi::ControlMode controlMode, double *ref=0, int joint=-1);
+    virtual bool setControlReference(double *ref, int joint=-1);
+    virtual bool setControlParam(wbi::ControlParam paramId, const void *value, int joint=-1);
+
+    // Model, forwarded to the yarpWholeBodyModel
+    virtual const wbi::IDList& getFrameList();
+    virtual bool getJointLimits(double *qMin, double *qMax, int joint=-1);
+    virtual bool computeH(double *q, const wbi::Frame &xB, int linkId, wbi::Frame &H, double *pos=0);
+    virtual bool computeJacobian(double *q, const wbi::Frame &xB, int linkId, double *J, double *pos=0);
+    virtual bool computeDJdq(double *q, const wbi::Frame &xB, double *dq, double *dxB, int linkId, double *dJdq, double *pos=0);
+    virtual bool forwardKinematics(double *q, const wbi::Frame &xB, int linkId, double *x, double *pos=0);
+    virtual bool inverseDynamics(double *q, const wbi::Frame &xB, double *dq, double *dxB, double *ddq, double *ddxB, double *g, double *tau);
+    virtual bool computeMassMatrix(double *q, const wbi::Frame &xB, double *M);
+    virtual bool computeGeneralizedBiasForces(double *q, const wbi::Frame &xB, double *dq, double *dxB, double *g, double *h);
+    virtual bool computeCentroidalMomentum(double *q, const wbi::Frame &xB, double *dq, double *dxB, double *h);
+
+    /*! Integrates the joint dynamics over one time step with the current references.
+     *  \return False if the dynamics of the model could not be computed.
+     */
+    bool step();
+
+    /*! Overwrites the joint states, e.g. to replay states recorded on the robot.
+     *  \param jointPositions Joint positions, size getDoFs().
+     *  \param jointVelocities Joint velocities, size getDoFs().
+     *  \return False if the sizes don't match the number of joints.
+     */
+    bool setState(const Eigen::VectorXd& jointPositions, const Eigen::VectorXd& jointVelocities);
+
+    /*! \return Simulated time in seconds, i.e. the number of steps times the time step.
+     */
+    double getTime() const { return simulatedTime; };
+
+    /*! Gains of the PD followed by the joints in position mode. Default 100 Nm/rad and 10 Nms/rad.
+     *  \param kp Stiffness.
+     *  \param kd Damping.
+     */
+    void setPositionGains(double kp, double kd);
+
+private:
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMajorMatrixXd;
+
+    yarpWbi::yarpWholeBodyModel model; /*!< Rigid-body model loaded from the URDF file. */
+    const double dt; /*!< Integration time step in seconds. */
+    double simulatedTime; /*!< Simulated time in seconds. */
+    int nDoF;
+    wbi::IDList emptyList; /*!< Estimates are always available, so the estimate lists are empty. */
+    wbi::Frame xBase; /*!< Pose of the base, held fixed. */
+    Eigen::VectorXd baseVelocity; /*!< Velocity of the base, always zero. */
+    Eigen::Vector3d gravity;
+
+    std::mutex stateMutex; /*!< Protects the states and references, read by the clients of the interface while stepping. */
+    Eigen::VectorXd q, dq, ddq, tau;
+    Eigen::VectorXd qMin, qMax;
+    Eigen::VectorXd torqueReference, positionReference;
+    std::vector<wbi::ControlMode> controlModes;
+    double kp, kd;
+
+    RowMajorMatrixXd massMatrix; /*!< Mass matrix of the model, base included. */
+    Eigen::VectorXd biasForces; /*!< Generalized bias forces of the model, base included. */
+    Eigen::VectorXd gravityForces; /*!< Gravity part of biasForces, for the position mode. */
+};
+
+} /* ocra_icub */
+#endif // OCRA_ICUB_SIMULATED_WHOLE_BODY_INTERFACE_H
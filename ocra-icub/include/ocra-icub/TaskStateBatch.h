@@ -0,0 +1,139 @@
+/*! \file       TaskStateBatch.h
+ *  \brief      Sets and reads the states of many tasks in a single message to the controller server.
+ *  \details    With one ocra_recipes::TaskConnection per task, a client which sets the desired states of N tasks and
+ *              reads the current states of M tasks at every tick makes O(N+M) round-trips to the server. A
+ *              TaskStateBatch packs all of them in a single BATCH_TASK_STATES message to
+ *              /ocra-icub-server/info/rpc:i, answered on the same round-trip. The server applies the desired states
+ *              and reads the requested fields between two control ticks, so they are all consistent with each other.
+ *
+ *              The message and its reply are yarp bottles, sent in binary on the wire:
+ *              \code
+ *              BATCH_TASK_STATES nSet name_1 (desiredState_1) ... name_nSet (desiredState_nSet)
+ *                                nGet name_1 fields_1 ... name_nGet fields_nGet
+ *              SUCCESS ((state_1) (desiredState_1) (Kp_1) (Kd_1)) ... ((state_nGet) ...)
+ *              \endcode
+ *              where `fields` or-es the TASK_STATE_FIELD values and each reply list only holds the requested
+ *              fields, in this order. Task states are written with ocra::TaskState::putIntoBottle() and gain
+ *              matrices with pourMatrixIntoBottle(). If one of the tasks doesn't exist the reply is FAILURE and
+ *              no desired state is set.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-icub.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OCRA_ICUB_TASK_STATE_BATCH_H
+#define OCRA_ICUB_TASK_STATE_BATCH_H
+
+#include <ocra-icub/Utilities.h>
+#include <ocra/control/TaskState.h>
+
+namespace ocra_icub
+{
+
+/*! \class TaskStateBatch
+ *  \brief Client side of the BATCH_TASK_STATES message.
+ *
+ *  Tasks are registered once with addTask(). The desired states of some of them are queued with
+ *  setDesiredTaskState() and exchange() sends them while reading back the fields registered for each task.
+ *
+ *  exchange() blocks on an rpc round-trip, so the batch is meant for one-shot changes and consistent snapshots, with
+ *  its result checked. Setpoints streamed at every tick of a client loop go through
+ *  ocra_recipes::TaskConnection::setDesiredTaskStateDirect() instead.
+ */
+class TaskStateBatch
+{
+CLASS_POINTER_TYPEDEFS(TaskStateBatch)
+
+public:
+    /*! Constructor. Does not communicate with the server, see initialize().
+     *  \param portPrefix Prefix of the rpc port opened to talk to the server, e.g. "/sitting-demo/taskStates".
+     */
+    TaskStateBatch(const std::string& portPrefix);
+
+    virtual ~TaskStateBatch();
+
+    /*! Opens the rpc port and connects it to the controller server.
+     *  \return False if the server could not be reached.
+     */
+    bool initialize();
+
+    /*! Registers a task of the controller server.
+     *  \param taskName Name of the task on the server, e.g. "ComTask".
+     *  \param fields TASK_STATE_FIELD values or-ed together, read back by every exchange(). 0 for a task whose
+     *         desired state is only set.
+     *  \return Index of the task in the batch.
+     */
+    int addTask(const std::string& taskName, int fields = CURRENT_TASK_STATE);
+
+    /*! Queues the desired state of a task for the next exchange(). Queuing the same task twice keeps the last state.
+     *  \param task Index returned by addTask().
+     *  \param state Desired state of the task.
+     */
+    void setDesiredTaskState(int task, const ocra::TaskState& state);
+
+    /*! Sends the queued desired states and reads back the registered fields of every task in a single round-trip.
+     *  The queue is emptied even on failure.
+     *  \return False if the server could not be reached or rejected the message.
+     */
+    bool exchange();
+
+    /*! \param task Index returned by addTask().
+     *  \return Current state of the task at the last exchange(). Requires CURRENT_TASK_STATE.
+     */
+    const ocra::TaskState& getTaskState(int task) const { return tasks[task].state; };
+
+    /*! \param task Index returned by addTask().
+     *  \return Desired state of the task at the last exchange(). Requires DESIRED_TASK_STATE.
+     */
+    const ocra::TaskState& getDesiredTaskState(int task) const { return tasks[task].desiredState; };
+
+    /*! \param task Index returned by addTask().
+     *  \return Stiffness matrix of the task at the last exchange(). Requires TASK_GAINS.
+     */
+    const Eigen::MatrixXd& getStiffnessMatrix(int task) const { return tasks[task].stiffness; };
+
+    /*! \param task Index returned by addTask().
+     *  \return Damping matrix of the task at the last exchange(). Requires TASK_GAINS.
+     */
+    const Eigen::MatrixXd& getDampingMatrix(int task) const { return tasks[task].damping; };
+
+private:
+    struct BatchTask {
+        std::string name;
+        int fields;
+        bool hasDesiredState; /*!< True if a desired state is queued for the next exchange. */
+        ocra::TaskState queuedDesiredState;
+        ocra::TaskState state;
+        ocra::TaskState desiredState;
+        Eigen::MatrixXd stiffness;
+        Eigen::MatrixXd damping;
+    };
+
+    bool extractReply();
+
+    std::string portName; /*!< Name of the rpc port connected to the server. */
+    yarp::os::RpcClient serverPort; /*!< Rpc port connected to /ocra-icub-server/info/rpc:i. */
+    std::vector<BatchTask> tasks; /*!< Registered tasks, in the order of addTask(). */
+    yarp::os::Bottle request; /*!< Reused from one exchange to the next. */
+    yarp::os::Bottle reply; /*!< Reused from one exchange to the next. */
+};
+
+} /* ocra_icub */
+#endif // OCRA_ICUB_TASK_STATE_BATCH_H
@@ -104,12 +104,49 @@ enum OCRA_ICUB_MESSAGE
 
     GET_L_FOOT_POSE,
 
-    HELP
+    HELP,
+
+    ACTIVATE_TASK_GROUP,
+    DEACTIVATE_TASK_GROUP,
+    GET_TASK_GROUP,
+
+    BATCH_TASK_STATES,
+
+    LOAD_TASK_SET
+};
+
+/*! Fields of a task read back by a BATCH_TASK_STATES message, to be or-ed together. See TaskStateBatch.h.
+ */
+enum TASK_STATE_FIELD
+{
+    CURRENT_TASK_STATE = 1,
+    DESIRED_TASK_STATE = 2,
+    TASK_GAINS = 4
 };
 
 void getNominalPosture(const ocra::Model &model, Eigen::VectorXd &q);
 void getHomePosture(const ocra::Model &model, Eigen::VectorXd &q);
 
+/*! Connects two yarp ports, through a local carrier when both of them are on the same machine. The name server is
+ *  asked for the host of each port: if they match, the connection is first tried with \p localCarrier, e.g. the
+ *  shared memory carrier of yarp which spares the messages the network stack. When the ports are on different
+ *  machines, or the carrier is not available in the yarp installation, the default network carrier is used.
+ *  \param src Name of the source port.
+ *  \param dst Name of the destination port.
+ *  \param localCarrier Carrier used between local ports, an empty string to always use the network.
+ *  \return False if the ports could not be connected at all.
+ */
+bool connectPorts(const std::string& src, const std::string& dst, const std::string& localCarrier = "shmem");
+
+/*! Appends a matrix to a bottle: its number of rows and columns followed by its coefficients in row-major order.
+ */
+void pourMatrixIntoBottle(const Eigen::MatrixXd& matrix, yarp::os::Bottle& bottle);
+
+/*! Reads a matrix written by pourMatrixIntoBottle().
+ *  \return False if the bottle is too short for the announced size.
+ */
+bool extractMatrixFromBottle(const yarp::os::Bottle& bottle, Eigen::MatrixXd& matrix);
+
 
 } /* ocra_icub */
 #endif //OCRA_ICUB_UTILITIES_H
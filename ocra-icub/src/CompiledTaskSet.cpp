@@ -0,0 +1,152 @@
+/*! \file       CompiledTaskSet.cpp
+ *  \brief      Binary task sets, compiled from the XML ones by ocra-task-set-compiler.
+ *  \details    See CompiledTaskSet.h.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-icub.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ocra-icub/CompiledTaskSet.h"
+#include <ocra/util/ErrorsHelper.h>
+
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+const char MAGIC[8] = {'O', 'C', 'R', 'A', 'T', 'S', 'B', '\0'};
+const std::uint32_t VERSION = 1;
+const std::size_t HEADER_SIZE = sizeof(MAGIC) + 2*sizeof(std::uint32_t) + 2*sizeof(std::uint64_t);
+}
+
+bool ocra_icub::isCompiledTaskSet(const std::string& filePath)
+{
+    std::size_t extensionStart = filePath.find_last_of(".");
+    return extensionStart != std::string::npos && filePath.substr(extensionStart) == COMPILED_TASK_SET_EXTENSION;
+}
+
+std::uint64_t ocra_icub::hashJointList(const wbi::IDList& joints)
+{
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (int i=0; i<(int)joints.size(); ++i) {
+        wbi::ID jointId;
+        joints.indexToID(i, jointId);
+        // The terminating null byte separates the names, so that "a" "bc" and "ab" "c" differ.
+        std::string name = jointId.toString();
+        for (std::size_t c=0; c<=name.size(); ++c) {
+            hash ^= (unsigned char)name.c_str()[c];
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+bool ocra_icub::writeCompiledTaskSet(const std::string& filePath, std::vector<ocra::TaskBuilderOptions>& taskOptions, std::uint64_t jointListHash)
+{
+    yarp::os::Bottle tasksBottle;
+    for (auto& options : taskOptions) {
+        options.putIntoBottle(tasksBottle.addList());
+    }
+    std::size_t bottleSize = 0;
+    const char* bottleData = tasksBottle.toBinary(&bottleSize);
+
+    std::ofstream file(filePath.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        OCRA_ERROR("Could not open " << filePath << " for writing.");
+        return false;
+    }
+    std::uint32_t nTasks = taskOptions.size();
+    std::uint64_t payloadSize = bottleSize;
+    file.write(MAGIC, sizeof(MAGIC));
+    file.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+    file.write(reinterpret_cast<const char*>(&nTasks), sizeof(nTasks));
+    file.write(reinterpret_cast<const char*>(&jointListHash), sizeof(jointListHash));
+    file.write(reinterpret_cast<const char*>(&payloadSize), sizeof(payloadSize));
+    file.write(bottleData, bottleSize);
+    if (!file.good()) {
+        OCRA_ERROR("Could not write " << filePath);
+        return false;
+    }
+    return true;
+}
+
+bool ocra_icub::readCompiledTaskSet(const std::string& filePath, std::uint64_t jointListHash, std::vector<ocra::TaskBuilderOptions>& taskOptions)
+{
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        OCRA_ERROR("Could not open " << filePath);
+        return false;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < (off_t)HEADER_SIZE) {
+        OCRA_ERROR(filePath << " is not a compiled task set.");
+        close(fd);
+        return false;
+    }
+    std::size_t fileSize = fileStat.st_size;
+    void* mapped = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        OCRA_ERROR("Could not map " << filePath << " into memory.");
+        return false;
+    }
+    const char* data = static_cast<const char*>(mapped);
+
+    std::uint32_t version, nTasks;
+    std::uint64_t fileJointListHash, payloadSize;
+    const char* header = data + sizeof(MAGIC);
+    std::memcpy(&version, header, sizeof(version));
+    header += sizeof(version);
+    std::memcpy(&nTasks, header, sizeof(nTasks));
+    header += sizeof(nTasks);
+    std::memcpy(&fileJointListHash, header, sizeof(fileJointListHash));
+    header += sizeof(fileJointListHash);
+    std::memcpy(&payloadSize, header, sizeof(payloadSize));
+
+    bool ok = false;
+    if (std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION) {
+        OCRA_ERROR(filePath << " is not a compiled task set of version " << VERSION << ". Compile it again with ocra-task-set-compiler.");
+    } else if (fileJointListHash != jointListHash) {
+        OCRA_ERROR(filePath << " was compiled against another joint list than the one of the robot. Compile it again with ocra-task-set-compiler.");
+    } else if (payloadSize != fileSize - HEADER_SIZE) {
+        OCRA_ERROR(filePath << " is truncated.");
+    } else {
+        yarp::os::Bottle tasksBottle;
+        tasksBottle.fromBinary(data + HEADER_SIZE, payloadSize);
+        taskOptions.clear();
+        ok = (tasksBottle.size() == (int)nTasks);
+        for (int i=0; ok && i<tasksBottle.size(); ++i) {
+            yarp::os::Bottle* optionsBottle = tasksBottle.get(i).asList();
+            ocra::TaskBuilderOptions options;
+            int sizeOfOptions;
+            ok = (optionsBottle != NULL) && options.extractFromBottle(*optionsBottle, sizeOfOptions);
+            taskOptions.push_back(options);
+        }
+        if (!ok) {
+            OCRA_ERROR("Malformed task options in " << filePath);
+            taskOptions.clear();
+        }
+    }
+    munmap(mapped, fileSize);
+    return ok;
+}
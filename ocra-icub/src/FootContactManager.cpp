@@ -0,0 +1,140 @@
+/*! \file       FootContactManager.cpp
+ *  \brief      Client-side state machine of the foot contacts.
+ *  \details    See FootContactManager.h.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-icub.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ocra-icub/FootContactManager.h"
+#include <ocra/util/ErrorsHelper.h>
+#include <yarp/os/Network.h>
+
+using namespace ocra_icub;
+
+FootContactManager::FootContactManager(const std::string& portPrefix,
+                                       const std::string& leftFootGroup,
+                                       const std::string& rightFootGroup)
+: portName(portPrefix + "/rpc:o")
+{
+    groupNames[LEFT_CONTACT_FOOT] = leftFootGroup;
+    groupNames[RIGHT_CONTACT_FOOT] = rightFootGroup;
+    inContact[LEFT_CONTACT_FOOT] = false;
+    inContact[RIGHT_CONTACT_FOOT] = false;
+}
+
+FootContactManager::~FootContactManager()
+{
+    serverPort.close();
+}
+
+bool FootContactManager::initialize()
+{
+    if (!serverPort.open(portName.c_str())) {
+        OCRA_ERROR("Could not open " << portName);
+        return false;
+    }
+    if (!connectPorts(portName, "/ocra-icub-server/info/rpc:i")) {
+        OCRA_ERROR("Could not connect to /ocra-icub-server/info/rpc:i. Is the controller server running?");
+        return false;
+    }
+
+    for (int foot = LEFT_CONTACT_FOOT; foot <= RIGHT_CONTACT_FOOT; ++foot) {
+        yarp::os::Bottle reply;
+        if (!sendGroupMessage(GET_TASK_GROUP, groupNames[foot], reply) || reply.size() < 2) {
+            OCRA_ERROR("The controller server has no task group named " << groupNames[foot]);
+            return false;
+        }
+        contacts[foot].clear();
+        for (int i=1; i<reply.size(); ++i) {
+            contacts[foot].push_back(std::make_shared<ocra_recipes::TaskConnection>(reply.get(i).asString()));
+        }
+        // The tasks of a group are always switched together
+        inContact[foot] = contacts[foot].front()->isActivated();
+    }
+    return true;
+}
+
+bool FootContactManager::activate(CONTACT_FOOT foot)
+{
+    return setContact(foot, true);
+}
+
+bool FootContactManager::deactivate(CONTACT_FOOT foot)
+{
+    return !setContact(foot, false);
+}
+
+bool FootContactManager::isInContact(CONTACT_FOOT foot) const
+{
+    return inContact[foot];
+}
+
+Eigen::MatrixXd FootContactManager::getActiveContact2DCoordinates()
+{
+    Eigen::MatrixXd contactsCoordinates;
+    getActiveContact2DCoordinates(contactsCoordinates);
+    return contactsCoordinates;
+}
+
+void FootContactManager::getActiveContact2DCoordinates(Eigen::MatrixXd& contactsCoordinates)
+{
+    int activeContacts = 0;
+    for (int foot = LEFT_CONTACT_FOOT; foot <= RIGHT_CONTACT_FOOT; ++foot) {
+        if (inContact[foot])
+            activeContacts += contacts[foot].size();
+    }
+    contactsCoordinates.resize(activeContacts, 2);
+    int k = 0;
+    for (int foot = LEFT_CONTACT_FOOT; foot <= RIGHT_CONTACT_FOOT; ++foot) {
+        if (!inContact[foot])
+            continue;
+        for (auto const& contact : contacts[foot]) {
+            contactsCoordinates.row(k) = contact->getTaskState().getPosition().getTranslation().topRows(2).transpose();
+            k++;
+        }
+    }
+}
+
+bool FootContactManager::setContact(CONTACT_FOOT foot, bool activate)
+{
+    if (inContact[foot] == activate)
+        return inContact[foot];
+
+    yarp::os::Bottle reply;
+    OCRA_ICUB_MESSAGE message = activate ? ACTIVATE_TASK_GROUP : DEACTIVATE_TASK_GROUP;
+    if (sendGroupMessage(message, groupNames[foot], reply)) {
+        inContact[foot] = activate;
+        std::cout << (activate ? "Activated " : "Deactivated ") << groupNames[foot] << " contacts." << std::endl;
+    } else {
+        OCRA_ERROR("The contacts of " << groupNames[foot] << " could not be " << (activate ? "activated" : "deactivated"));
+    }
+    return inContact[foot];
+}
+
+bool FootContactManager::sendGroupMessage(OCRA_ICUB_MESSAGE message, const std::string& groupName, yarp::os::Bottle& reply)
+{
+    yarp::os::Bottle request;
+    request.addInt(message);
+    request.addString(groupName);
+    reply.clear();
+    if (!serverPort.write(request, reply) || reply.size() == 0)
+        return false;
+    return reply.get(0).asInt() == SUCCESS;
+}
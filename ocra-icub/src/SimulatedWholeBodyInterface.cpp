@@ -0,0 +1,319 @@
+/*! \file       SimulatedWholeBodyInterface.cpp
+ *  \brief      In-process whole body interface simulating the robot from its URDF model.
+ *  \details    See SimulatedWholeBodyInterface.h.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-icub.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ocra-icub/SimulatedWholeBodyInterface.h"
+#include <ocra/util/ErrorsHelper.h>
+#include <algorithm>
+
+using namespace ocra_icub;
+
+SimulatedWholeBodyInterface::SimulatedWholeBodyInterface(const char* interfaceName, const yarp::os::Property& wbiOptions, double timeStep)
+: model(interfaceName, wbiOptions)
+, dt(timeStep)
+, simulatedTime(0.0)
+, nDoF(0)
+, xBase(wbi::Frame())
+, baseVelocity(Eigen::VectorXd::Zero(6))
+, gravity(0.0, 0.0, -9.81)
+, kp(100.0)
+, kd(10.0)
+{
+}
+
+SimulatedWholeBodyInterface::~SimulatedWholeBodyInterface()
+{
+}
+
+bool SimulatedWholeBodyInterface::init()
+{
+    if (!model.init()) {
+        OCRA_ERROR("Could not load the model of the simulated robot");
+        return false;
+    }
+    nDoF = model.getJointList().size();
+
+    q = Eigen::VectorXd::Zero(nDoF);
+    dq = Eigen::VectorXd::Zero(nDoF);
+    ddq = Eigen::VectorXd::Zero(nDoF);
+    tau = Eigen::VectorXd::Zero(nDoF);
+    qMin.resize(nDoF);
+    qMax.resize(nDoF);
+    model.getJointLimits(qMin.data(), qMax.data(), -1);
+    for (int i=0; i<nDoF; ++i) {
+        if (q(i) < qMin(i) || q(i) > qMax(i))
+            q(i) = 0.5*(qMin(i) + qMax(i));
+    }
+
+    // Like a robot which has just been switched on, all the joints hold their position
+    positionReference = q;
+    torqueReference = Eigen::VectorXd::Zero(nDoF);
+    controlModes.assign(nDoF, wbi::CTRL_MODE_POS);
+
+    massMatrix = RowMajorMatrixXd::Zero(nDoF + 6, nDoF + 6);
+    biasForces = Eigen::VectorXd::Zero(nDoF + 6);
+    gravityForces = Eigen::VectorXd::Zero(nDoF + 6);
+    simulatedTime = 0.0;
+    return true;
+}
+
+bool SimulatedWholeBodyInterface::close()
+{
+    return model.close();
+}
+
+bool SimulatedWholeBodyInterface::removeJoint(const wbi::ID &j)
+{
+    return model.removeJoint(j);
+}
+
+bool SimulatedWholeBodyInterface::addJoint(const wbi::ID &j)
+{
+    return model.addJoint(j);
+}
+
+int SimulatedWholeBodyInterface::addJoints(const wbi::IDList &j)
+{
+    return model.addJoints(j);
+}
+
+const wbi::IDList& SimulatedWholeBodyInterface::getJointList()
+{
+    return model.getJointList();
+}
+
+int SimulatedWholeBodyInterface::getDoFs()
+{
+    return model.getJointList().size();
+}
+
+bool SimulatedWholeBodyInterface::addEstimate(const wbi::EstimateType st, const wbi::ID &sid)
+{
+    return true;
+}
+
+int SimulatedWholeBodyInterface::addEstimates(const wbi::EstimateType st, const wbi::IDList &sids)
+{
+    return sids.size();
+}
+
+bool SimulatedWholeBodyInterface::removeEstimate(const wbi::EstimateType st, const wbi::ID &sid)
+{
+    return true;
+}
+
+const wbi::IDList& SimulatedWholeBodyInterface::getEstimateList(const wbi::EstimateType st)
+{
+    return emptyList;
+}
+
+bool SimulatedWholeBodyInterface::getEstimate(const wbi::EstimateType et, const int numeric_id, double *data, double time, bool blocking)
+{
+    if (numeric_id < 0 || numeric_id >= nDoF)
+        return false;
+    std::lock_guard<std::mutex> lock(stateMutex);
+    switch (et) {
+        case wbi::ESTIMATE_JOINT_POS:       *data = q(numeric_id); return true;
+        case wbi::ESTIMATE_JOINT_VEL:       *data = dq(numeric_id); return true;
+        case wbi::ESTIMATE_JOINT_ACC:       *data = ddq(numeric_id); return true;
+        case wbi::ESTIMATE_JOINT_TORQUE:    *data = tau(numeric_id); return true;
+        default: return false;
+    }
+}
+
+bool SimulatedWholeBodyInterface::getEstimates(const wbi::EstimateType et, double *data, double time, bool blocking)
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    switch (et) {
+        case wbi::ESTIMATE_JOINT_POS:       Eigen::Map<Eigen::VectorXd>(data, nDoF) = q; return true;
+        case wbi::ESTIMATE_JOINT_VEL:       Eigen::Map<Eigen::VectorXd>(data, nDoF) = dq; return true;
+        case wbi::ESTIMATE_JOINT_ACC:       Eigen::Map<Eigen::VectorXd>(data, nDoF) = ddq; return true;
+        case wbi::ESTIMATE_JOINT_TORQUE:    Eigen::Map<Eigen::VectorXd>(data, nDoF) = tau; return true;
+        case wbi::ESTIMATE_BASE_POS:        wbi::serializationFromFrame(xBase, data); return true;
+        case wbi::ESTIMATE_BASE_VEL:
+        case wbi::ESTIMATE_BASE_ACC:        Eigen::Map<Eigen::VectorXd>(data, 6).setZero(); return true;
+        default:
+            OCRA_WARNING("Estimate " << et << " is not simulated")
+            return false;
+    }
+}
+
+bool SimulatedWholeBodyInterface::setEstimationParameter(const wbi::EstimateType et, const wbi::EstimationParameter ep, const void *value)
+{
+    // There is no estimation, the states are exact
+    return true;
+}
+
+bool SimulatedWholeBodyInterface::setControlMode(wbi::ControlMode controlMode, double *ref, int joint)
+{
+    if (controlMode != wbi::CTRL_MODE_POS && controlMode != wbi::CTRL_MODE_TORQUE) {
+        OCRA_ERROR("Only the position and torque control modes are simulated")
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (joint < 0) {
+            controlModes.assign(nDoF, controlMode);
+        } else if (joint < nDoF) {
+            controlModes[joint] = controlMode;
+        } else {
+            return false;
+        }
+    }
+    return ref == 0 || setControlReference(ref, joint);
+}
+
+bool SimulatedWholeBodyInterface::setControlReference(double *ref, int joint)
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    int first = joint < 0 ? 0 : joint;
+    int last = joint < 0 ? nDoF : joint + 1;
+    if (last > nDoF)
+        return false;
+    for (int i=first; i<last; ++i) {
+        double value = ref[i - first];
+        if (controlModes[i] == wbi::CTRL_MODE_POS)
+            positionReference(i) = value;
+        else
+            torqueReference(i) = value;
+    }
+    return true;
+}
+
+bool SimulatedWholeBodyInterface::setControlParam(wbi::ControlParam paramId, const void *value, int joint)
+{
+    // The simulated joints have no low-level controller to tune
+    return true;
+}
+
+const wbi::IDList& SimulatedWholeBodyInterface::getFrameList()
+{
+    return model.getFrameList();
+}
+
+bool SimulatedWholeBodyInterface::getJointLimits(double *qMin, double *qMax, int joint)
+{
+    return model.getJointLimits(qMin, qMax, joint);
+}
+
+bool SimulatedWholeBodyInterface::computeH(double *q, const wbi::Frame &xB, int linkId, wbi::Frame &H, double *pos)
+{
+    return model.computeH(q, xB, linkId, H, pos);
+}
+
+bool SimulatedWholeBodyInterface::computeJacobian(double *q, const wbi::Frame &xB, int linkId, double *J, double *pos)
+{
+    return model.computeJacobian(q, xB, linkId, J, pos);
+}
+
+bool SimulatedWholeBodyInterface::computeDJdq(double *q, const wbi::Frame &xB, double *dq, double *dxB, int linkId, double *dJdq, double *pos)
+{
+    return model.computeDJdq(q, xB, dq, dxB, linkId, dJdq, pos);
+}
+
+bool SimulatedWholeBodyInterface::forwardKinematics(double *q, const wbi::Frame &xB, int linkId, double *x, double *pos)
+{
+    return model.forwardKinematics(q, xB, linkId, x, pos);
+}
+
+bool SimulatedWholeBodyInterface::inverseDynamics(double *q, const wbi::Frame &xB, double *dq, double *dxB, double *ddq, double *ddxB, double *g, double *tau)
+{
+    return model.inverseDynamics(q, xB, dq, dxB, ddq, ddxB, g, tau);
+}
+
+bool SimulatedWholeBodyInterface::computeMassMatrix(double *q, const wbi::Frame &xB, double *M)
+{
+    return model.computeMassMatrix(q, xB, M);
+}
+
+bool SimulatedWholeBodyInterface::computeGeneralizedBiasForces(double *q, const wbi::Frame &xB, double *dq, double *dxB, double *g, double *h)
+{
+    return model.computeGeneralizedBiasForces(q, xB, dq, dxB, g, h);
+}
+
+bool SimulatedWholeBodyInterface::computeCentroidalMomentum(double *q, const wbi::Frame &xB, double *dq, double *dxB, double *h)
+{
+    return model.computeCentroidalMomentum(q, xB, dq, dxB, h);
+}
+
+bool SimulatedWholeBodyInterface::setState(const Eigen::VectorXd& jointPositions, const Eigen::VectorXd& jointVelocities)
+{
+    if (jointPositions.size() != nDoF || jointVelocities.size() != nDoF) {
+        OCRA_ERROR("Expected " << nDoF << " joint positions and velocities, got " << jointPositions.size() << " and " << jointVelocities.size())
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(stateMutex);
+    q = jointPositions;
+    dq = jointVelocities;
+    ddq.setZero();
+    return true;
+}
+
+void SimulatedWholeBodyInterface::setPositionGains(double kp, double kd)
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    this->kp = kp;
+    this->kd = kd;
+}
+
+bool SimulatedWholeBodyInterface::step()
+{
+    std::lock_guard<std::mutex> lock(stateMutex);
+    if (!model.computeMassMatrix(q.data(), xBase, massMatrix.data())
+        || !model.computeGeneralizedBiasForces(q.data(), xBase, dq.data(), baseVelocity.data(), gravity.data(), biasForces.data())) {
+        OCRA_ERROR("Could not compute the dynamics of the simulated robot")
+        return false;
+    }
+
+    bool positionControlled = false;
+    for (int i=0; i<nDoF; ++i) {
+        positionControlled |= (controlModes[i] == wbi::CTRL_MODE_POS);
+    }
+    if (positionControlled) {
+        Eigen::VectorXd zeroVelocity = Eigen::VectorXd::Zero(nDoF);
+        model.computeGeneralizedBiasForces(q.data(), xBase, zeroVelocity.data(), baseVelocity.data(), gravity.data(), gravityForces.data());
+    }
+
+    for (int i=0; i<nDoF; ++i) {
+        if (controlModes[i] == wbi::CTRL_MODE_POS)
+            tau(i) = gravityForces(6 + i) + kp*(positionReference(i) - q(i)) - kd*dq(i);
+        else
+            tau(i) = torqueReference(i);
+    }
+
+    // The base is fixed, only the joint block of the dynamics is integrated
+    ddq = massMatrix.bottomRightCorner(nDoF, nDoF).ldlt().solve(tau - biasForces.tail(nDoF));
+    dq += dt*ddq;
+    q += dt*dq;
+    for (int i=0; i<nDoF; ++i) {
+        if (q(i) < qMin(i)) {
+            q(i) = qMin(i);
+            dq(i) = std::max(dq(i), 0.0);
+        } else if (q(i) > qMax(i)) {
+            q(i) = qMax(i);
+            dq(i) = std::min(dq(i), 0.0);
+        }
+    }
+    simulatedTime += dt;
+    return true;
+}
@@ -0,0 +1,138 @@
+/*! \file       TaskStateBatch.cpp
+ *  \brief      Sets and reads the states of many tasks in a single message to the controller server.
+ *  \details    See TaskStateBatch.h.
+ *  \author     [Jorhabib Eljaik](https://github.com/jeljaik)
+ *  \date       Feb 2017
+ *  \copyright  GNU General Public License.
+ */
+/*
+ *  This file is part of ocra-icub.
+ *  Copyright (C) 2016 Institut des Systèmes Intelligents et de Robotique (ISIR)
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ocra-icub/TaskStateBatch.h"
+#include <ocra/util/ErrorsHelper.h>
+#include <yarp/os/Network.h>
+
+using namespace ocra_icub;
+
+TaskStateBatch::TaskStateBatch(const std::string& portPrefix)
+: portName(portPrefix + "/rpc:o")
+{
+}
+
+TaskStateBatch::~TaskStateBatch()
+{
+    serverPort.close();
+}
+
+bool TaskStateBatch::initialize()
+{
+    if (!serverPort.open(portName.c_str())) {
+        OCRA_ERROR("Could not open " << portName);
+        return false;
+    }
+    if (!connectPorts(portName, "/ocra-icub-server/info/rpc:i")) {
+        OCRA_ERROR("Could not connect to /ocra-icub-server/info/rpc:i. Is the controller server running?");
+        return false;
+    }
+    return true;
+}
+
+int TaskStateBatch::addTask(const std::string& taskName, int fields)
+{
+    BatchTask task;
+    task.name = taskName;
+    task.fields = fields;
+    task.hasDesiredState = false;
+    tasks.push_back(task);
+    return tasks.size() - 1;
+}
+
+void TaskStateBatch::setDesiredTaskState(int task, const ocra::TaskState& state)
+{
+    tasks[task].queuedDesiredState = state;
+    tasks[task].hasDesiredState = true;
+}
+
+bool TaskStateBatch::exchange()
+{
+    request.clear();
+    request.addInt(BATCH_TASK_STATES);
+
+    int nSet = 0, nGet = 0;
+    for (auto const& task : tasks) {
+        nSet += task.hasDesiredState;
+        nGet += (task.fields != 0);
+    }
+    request.addInt(nSet);
+    for (auto& task : tasks) {
+        if (task.hasDesiredState) {
+            request.addString(task.name);
+            task.queuedDesiredState.putIntoBottle(request.addList());
+            task.hasDesiredState = false;
+        }
+    }
+    request.addInt(nGet);
+    for (auto const& task : tasks) {
+        if (task.fields != 0) {
+            request.addString(task.name);
+            request.addInt(task.fields);
+        }
+    }
+
+    reply.clear();
+    if (!serverPort.write(request, reply) || reply.size() == 0 || reply.get(0).asInt() != SUCCESS) {
+        OCRA_ERROR("The controller server rejected the batch of task states");
+        return false;
+    }
+    if (!extractReply()) {
+        OCRA_ERROR("Malformed reply to the batch of task states");
+        return false;
+    }
+    return true;
+}
+
+bool TaskStateBatch::extractReply()
+{
+    int i = 1;
+    for (auto& task : tasks) {
+        if (task.fields == 0)
+            continue;
+        if (i >= reply.size() || !reply.get(i).isList())
+            return false;
+        yarp::os::Bottle* fields = reply.get(i++).asList();
+        int j = 0;
+        int sizeOfOptions;
+        if (task.fields & CURRENT_TASK_STATE) {
+            if (j >= fields->size() || !fields->get(j).isList())
+                return false;
+            task.state.extractFromBottle(*fields->get(j++).asList(), sizeOfOptions);
+        }
+        if (task.fields & DESIRED_TASK_STATE) {
+            if (j >= fields->size() || !fields->get(j).isList())
+                return false;
+            task.desiredState.extractFromBottle(*fields->get(j++).asList(), sizeOfOptions);
+        }
+        if (task.fields & TASK_GAINS) {
+            if (j + 1 >= fields->size() || !fields->get(j).isList() || !fields->get(j + 1).isList())
+                return false;
+            if (!extractMatrixFromBottle(*fields->get(j++).asList(), task.stiffness)
+                || !extractMatrixFromBottle(*fields->get(j++).asList(), task.damping))
+                return false;
+        }
+    }
+    return true;
+}
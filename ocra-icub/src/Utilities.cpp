@@ -23,6 +23,9 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "ocra-icub/Utilities.h"
+#include <yarp/os/Network.h>
+#include <yarp/os/Contact.h>
+#include <ocra/util/ErrorsHelper.h>
 
 using namespace ocra_icub;
 
@@ -53,3 +56,46 @@ void getHomePosture(const ocra::Model& model, Eigen::VectorXd &q)
     q[model.getDofIndex("l_elbow")]        =   50.0*DEG_TO_RAD;//PI/4.0;
     q[model.getDofIndex("r_elbow")]        =   50.0*DEG_TO_RAD;//PI/4.0;
 }
+
+void ocra_icub::pourMatrixIntoBottle(const Eigen::MatrixXd& matrix, yarp::os::Bottle& bottle)
+{
+    bottle.addInt(matrix.rows());
+    bottle.addInt(matrix.cols());
+    for (int i=0; i<matrix.rows(); ++i) {
+        for (int j=0; j<matrix.cols(); ++j) {
+            bottle.addDouble(matrix(i,j));
+        }
+    }
+}
+
+bool ocra_icub::extractMatrixFromBottle(const yarp::os::Bottle& bottle, Eigen::MatrixXd& matrix)
+{
+    if (bottle.size() < 2)
+        return false;
+    int rows = bottle.get(0).asInt();
+    int cols = bottle.get(1).asInt();
+    if (rows < 0 || cols < 0 || bottle.size() < 2 + rows*cols)
+        return false;
+    matrix.resize(rows, cols);
+    for (int i=0; i<rows; ++i) {
+        for (int j=0; j<cols; ++j) {
+            matrix(i,j) = bottle.get(2 + i*cols + j).asDouble();
+        }
+    }
+    return true;
+}
+
+bool ocra_icub::connectPorts(const std::string& src, const std::string& dst, const std::string& localCarrier)
+{
+    if (!localCarrier.empty()) {
+        yarp::os::Contact srcContact = yarp::os::Network::queryName(src);
+        yarp::os::Contact dstContact = yarp::os::Network::queryName(dst);
+        if (srcContact.isValid() && dstContact.isValid() && srcContact.getHost() == dstContact.getHost()) {
+            if (yarp::os::Network::connect(src, dst, localCarrier)) {
+                return true;
+            }
+            OCRA_WARNING("Could not connect " << src << " to " << dst << " through " << localCarrier << ". Falling back to the network.");
+        }
+    }
+    return yarp::os::Network::connect(src, dst);
+}